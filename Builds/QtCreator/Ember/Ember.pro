@@ -27,12 +27,17 @@ HEADERS += \
     ../../../Source/Ember/CarToRas.h \
     ../../../Source/Ember/DensityFilter.h \
     ../../../Source/Ember/Ember.h \
+    ../../../Source/Ember/EmberBinary.h \
     ../../../Source/Ember/EmberDefines.h \
     ../../../Source/Ember/EmberPch.h \
     ../../../Source/Ember/EmberToXml.h \
+    ../../../Source/Ember/FilterCache.h \
+    ../../../Source/Ember/HugePages.h \
     ../../../Source/Ember/Interpolate.h \
     ../../../Source/Ember/Isaac.h \
+    ../../../Source/Ember/IterProfile.h \
     ../../../Source/Ember/Iterator.h \
+    ../../../Source/Ember/Numa.h \
     ../../../Source/Ember/Palette.h \
     ../../../Source/Ember/PaletteList.h \
     ../../../Source/Ember/Point.h \
@@ -45,6 +50,7 @@ HEADERS += \
     ../../../Source/Ember/Utils.h \
     ../../../Source/Ember/Variation.h \
     ../../../Source/Ember/VariationList.h \
+    ../../../Source/Ember/VariationPool.h \
     ../../../Source/Ember/Variations01.h \
     ../../../Source/Ember/Variations02.h \
     ../../../Source/Ember/Variations03.h \
@@ -23,7 +23,7 @@ done
 
 DIR=$( cd "$(dirname "${BASH_SOURCE[0]}" )" && pwd )
 
-for PROJ in ${DIR}/{Ember,EmberCL,EmberGenome,EmberRender,EmberAnimate,Fractorium}
+for PROJ in ${DIR}/{Ember,EmberCL,EmberGenome,EmberRender,EmberAnimate,EmberBench,Fractorium}
 do
   pushd $PROJ
   if [ "x1" = "x$REBUILD" ]; then
@@ -39,6 +39,7 @@ debug:DESTDIR = $$(HOME)/Dev/fractorium/Dbg
 
 LIBS += -L/usr/lib -ljpeg
 LIBS += -L/usr/lib -lpng
+LIBS += -L/usr/lib -lz
 LIBS += -L/usr/lib -ltbb
 LIBS += -L/usr/lib/x86_64-linux-gnu -lxml2
 
@@ -25,6 +25,7 @@ template<> unique_ptr<QTIsaac<ISAAC_SIZE, ISAAC_INT>> QTIsaac<ISAAC_SIZE, ISAAC_
 #include "Affine2D.h"
 #include "Xform.h"
 #include "EmberToXml.h"
+#include "EmberBinary.h"
 #include "XmlToEmber.h"
 #include "SpatialFilter.h"
 #include "DensityFilter.h"
@@ -32,6 +33,10 @@ template<> unique_ptr<QTIsaac<ISAAC_SIZE, ISAAC_INT>> QTIsaac<ISAAC_SIZE, ISAAC_
 #include "Interpolate.h"
 #include "Renderer.h"
 #include "Timing.h"
+#include "Numa.h"
+#include "HugePages.h"
+#include "VariationPool.h"
+#include "FilterCache.h"
 #include "SheepTools.h"
 
 /// <summary>
@@ -44,6 +49,25 @@ namespace EmberNs
 {
 bool Timing::m_TimingInit = false;
 uint Timing::m_ProcessorCount;
+std::once_flag NumaTopology::m_NumaOnce;
+vector<vector<uint>> NumaTopology::m_NodeProcessors;
+vector<uint> NumaTopology::m_AllowedProcessors;
+eHugePagePolicy HugePages::m_Policy = HUGE_PAGES_TRANSPARENT;
+std::atomic<size_t> HugePages::m_ExplicitBytes(0);
+std::atomic<size_t> HugePages::m_TransparentBytes(0);
+VariationPool::FreeBlock* VariationPool::m_FreeLists[VAR_POOL_CLASSES];
+std::atomic_flag VariationPool::m_Lock = ATOMIC_FLAG_INIT;
+size_t VariationPool::m_BlocksInUse = 0;
+size_t VariationPool::m_ChunkBytes = 0;
+template <typename T> list<pair<typename FilterCache<T>::DensityKey, shared_ptr<DensityFilter<T>>>> FilterCache<T>::m_DensityFilters;
+template <typename T> list<pair<typename FilterCache<T>::SpatialKey, shared_ptr<SpatialFilter<T>>>> FilterCache<T>::m_SpatialFilters;
+template <typename T> list<pair<typename FilterCache<T>::TemporalKey, shared_ptr<TemporalFilter<T>>>> FilterCache<T>::m_TemporalFilters;
+template <typename T> size_t FilterCache<T>::m_Capacity = FILTER_CACHE_SIZE;
+template <typename T> size_t FilterCache<T>::m_Hits = 0;
+template <typename T> size_t FilterCache<T>::m_Misses = 0;
+template <typename T> CriticalSection FilterCache<T>::m_Cs;
+template <typename T> map<string, shared_ptr<PaletteCache>> PaletteList<T>::m_Caches;
+template <typename T> CriticalSection PaletteList<T>::m_Cs;
 
 #define EXPORTPREPOSTREGVAR(varName, T) \
 	template EMBER_API class varName##Variation<T>; \
@@ -55,8 +79,8 @@ uint Timing::m_ProcessorCount;
 	template<> map<string, vector<Palette<T>>> PaletteList<T>::m_Palettes = map<string, vector<Palette<T>>>(); \
 	template<> bool XmlToEmber<T>::m_Init = false; \
 	template<> vector<string> XmlToEmber<T>::m_FlattenNames = vector<string>(); \
-	template<> vector<pair<string, string>> XmlToEmber<T>::m_BadParamNames = vector<pair<string, string>>(); \
-	template<> vector<pair<pair<string, string>, vector<string>>> XmlToEmber<T>::m_BadVariationNames = vector<pair<pair<string, string>, vector<string>>>(); \
+	template<> unordered_map<string, string, NameHash, NameEqual> XmlToEmber<T>::m_BadParamNames = unordered_map<string, string, NameHash, NameEqual>(); \
+	template<> unordered_map<string, pair<string, vector<string>>, NameHash, NameEqual> XmlToEmber<T>::m_BadVariationNames = unordered_map<string, pair<string, vector<string>>, NameHash, NameEqual>(); \
 	template EMBER_API class Point<T>; \
 	template EMBER_API struct Color<T>; \
 	template EMBER_API class Palette<T>; \
@@ -392,13 +416,16 @@ uint Timing::m_ProcessorCount;
 	template EMBER_API class BoxTemporalFilter<T>; \
 	template EMBER_API class SpatialFilterCreator<T>; \
 	template EMBER_API class TemporalFilterCreator<T>; \
+	template EMBER_API class FilterCache<T>; \
 	template EMBER_API class Interpolater<T>; \
 	template EMBER_API class Ember<T>; \
 	/*template EMBER_API class RenderCallback<T>;*/ \
 	template EMBER_API class CarToRas<T>; \
 	template EMBER_API class Curves<T>; \
 	template EMBER_API class XmlToEmber<T>; \
-	template EMBER_API class EmberToXml<T>;
+	template EMBER_API class EmberToXml<T>; \
+	template EMBER_API class EmberToBinary<T>; \
+	template EMBER_API class BinaryToEmber<T>;
 
 EXPORT_SINGLE_TYPE_EMBER(float)
 
@@ -50,24 +50,31 @@ public:
 	/// </summary>
 	/// <param name="ember">The Ember object to copy</param>
 	Ember(const Ember<T>& ember)
-		: m_Edits(nullptr)
 	{
 		Ember<T>::operator=<T>(ember);
 	}
 
+	/// <summary>
+	/// Move constructor which takes the xforms and edit doc of an Ember object rather than copying them.
+	/// </summary>
+	/// <param name="ember">The Ember object to move, which is left with no xforms.</param>
+	Ember(Ember<T>&& ember) NOEXCEPT
+	{
+		Ember<T>::operator=(std::move(ember));
+	}
+
 	/// <summary>
 	/// Copy constructor to copy an Ember object of type U, where T is usually the same type as U.
 	/// </summary>
 	/// <param name="ember">The Ember object to copy</param>
 	template <typename U>
 	Ember(const Ember<U>& ember)
-		: m_Edits(nullptr)
 	{
 		Ember<T>::operator=<U>(ember);
 	}
 
 	/// <summary>
-	/// Destructor which clears the Xml edits.
+	/// Destructor which releases this ember's reference to the Xml edits.
 	/// </summary>
 	~Ember()
 	{
@@ -88,13 +95,84 @@ public:
 		return *this;
 	}
 
+	/// <summary>
+	/// Move assignment operator which takes the xforms and edit doc of an Ember object rather than copying them.
+	/// The variations of each xform are moved along with it, so none are cloned.
+	/// </summary>
+	/// <param name="ember">The Ember object to move, which is left with no xforms.</param>
+	/// <returns>Reference to updated self</returns>
+	Ember<T>& operator = (Ember<T>&& ember) NOEXCEPT
+	{
+		if (this != &ember)
+		{
+			bool useFinal = ember.UseFinalXform();
+
+			CopyVals(ember);
+			m_Xforms = std::move(ember.m_Xforms);
+			m_FinalXform = std::move(ember.m_FinalXform);
+
+			//The xforms still point to the ember they were moved from.
+			for (auto& xform : m_Xforms)
+				xform.ParentEmber(this);
+
+			m_FinalXform.ParentEmber(this);
+
+			//Interpolated-against final xforms need animate & color speed set to 0.
+			if (!useFinal)
+			{
+				m_FinalXform.m_Motion.clear();
+				m_FinalXform.m_Animate = 0;
+				m_FinalXform.m_ColorSpeed = 0;
+			}
+
+			SetProjFunc();
+			m_Edits = std::move(ember.m_Edits);
+		}
+
+		return *this;
+	}
+
 	/// <summary>
 	/// Assignment operator to assign an Ember object of type U, where T is usually the same type as U.
+	/// The edit doc is never modified once created, so it's shared with ember rather than copied.
 	/// </summary>
 	/// <param name="ember">The Ember object to copy.</param>
 	/// <returns>Reference to updated self</returns>
 	template <typename U>
 	Ember<T>& operator = (const Ember<U>& ember)
+	{
+		CopyVals(ember);
+		m_Xforms.clear();
+
+		for (size_t i = 0; i < ember.XformCount(); i++)
+			if (Xform<U>* p = ember.GetXform(i))
+				AddXform(Xform<T>(*p));//Will call the copy constructor to convert between types T and U, then move it into place.
+
+		Xform<T> finalXform = *ember.FinalXform();//Will call assignment operator to convert between types T and U.
+
+		SetFinalXform(finalXform);
+
+		//Interpolated-against final xforms need animate & color speed set to 0.
+		if (!ember.UseFinalXform())
+		{
+			m_FinalXform.m_Motion.clear();
+			m_FinalXform.m_Animate = 0;
+			m_FinalXform.m_ColorSpeed = 0;
+		}
+
+		SetProjFunc();
+		m_Edits = ember.m_Edits;
+		return *this;
+	}
+
+private:
+	/// <summary>
+	/// Copy all values of an Ember object of type U other than its xforms and edit doc.
+	/// Shared by the copy and move assignment operators.
+	/// </summary>
+	/// <param name="ember">The Ember object to copy the values of</param>
+	template <typename U>
+	void CopyVals(const Ember<U>& ember)
 	{
 		m_FinalRasW			  = ember.m_FinalRasW;
 		m_FinalRasH			  = ember.m_FinalRasH;
@@ -152,40 +230,9 @@ public:
 		m_ScaleType	  = ember.ScaleType();
 		m_Palette	  = ember.m_Palette;
 		m_Curves	  = ember.m_Curves;
-
-		m_Xforms.clear();
-
-		for (size_t i = 0; i < ember.XformCount(); i++)
-		{
-			if (Xform<U>* p = ember.GetXform(i))
-			{
-				Xform<T> xform = *p;//Will call assignment operator to convert between types T and U.
-
-				AddXform(xform);
-			}
-		}
-
-		Xform<T> finalXform = *ember.FinalXform();//Will call assignment operator to convert between types T and U.
-
-		SetFinalXform(finalXform);
-
-		//Interpolated-against final xforms need animate & color speed set to 0.
-		if (!ember.UseFinalXform())
-		{
-			m_FinalXform.m_Motion.clear();
-			m_FinalXform.m_Animate = 0;
-			m_FinalXform.m_ColorSpeed = 0;
-		}
-
-		SetProjFunc();
-		ClearEdit();
-
-		if (ember.m_Edits != nullptr)
-			m_Edits = xmlCopyDoc(ember.m_Edits, 1);
-
-		return *this;
 	}
 
+public:
 	/// <summary>
 	/// Set common default values.
 	/// </summary>
@@ -256,7 +303,7 @@ public:
 		m_ScaleType = eScaleType::SCALE_NONE;
 		m_Xforms.reserve(12);
 
-		m_Edits = nullptr;
+		m_Edits.reset();
 	}
 
 	/// <summary>
@@ -270,6 +317,17 @@ public:
 		m_Xforms[m_Xforms.size() - 1].ParentEmber(this);
 	}
 
+	/// <summary>
+	/// Add a new xform to the xforms vector by moving it rather than copying it.
+	/// </summary>
+	/// <param name="xform">The xform to move and add</param>
+	void AddXform(Xform<T>&& xform)
+	{
+		m_Xforms.push_back(std::move(xform));
+		m_Xforms[m_Xforms.size() - 1].CacheColorVals();
+		m_Xforms[m_Xforms.size() - 1].ParentEmber(this);
+	}
+
 	/// <summary>
 	/// Add the specified number of empty xforms.
 	/// </summary>
@@ -1375,16 +1433,33 @@ public:
 	}
 
 	/// <summary>
-	/// Thin wrapper to clear edit doc if not nullptr and set to nullptr.
+	/// Release this ember's reference to the edit doc.
+	/// The doc itself is only freed once no other ember refers to it.
 	/// </summary>
 	void ClearEdit()
 	{
-		if (m_Edits != nullptr)
-			xmlFreeDoc(m_Edits);
+		m_Edits.reset();
+	}
 
-		m_Edits = nullptr;
+	/// <summary>
+	/// Replace the edit doc, taking ownership of the one passed in.
+	/// The doc must not be modified afterward since it will be shared with every copy of this ember.
+	/// </summary>
+	/// <param name="edits">The new edit doc, which may be nullptr to clear it.</param>
+	void SetEdit(xmlDocPtr edits)
+	{
+		if (edits)
+			m_Edits = shared_ptr<xmlDoc>(edits, xmlFreeDoc);
+		else
+			m_Edits.reset();
 	}
 
+	/// <summary>
+	/// Get the edit doc.
+	/// </summary>
+	/// <returns>The edit doc if present, else nullptr.</returns>
+	xmlDocPtr Edits() const { return m_Edits.get(); }
+
 	/// <summary>
 	/// Return a string representation of this ember.
 	/// </summary>
@@ -1674,8 +1749,9 @@ public:
 	string m_ParentFilename;
 
 	//An Xml edit document describing information about the author as well as an edit history of the ember.
+	//It's never modified after creation, so copies of an ember share it rather than copying it. Replace it with SetEdit().
 	//Xml field: "edit".
-	xmlDocPtr m_Edits;
+	shared_ptr<xmlDoc> m_Edits;
 
 	//The 0-based position of this ember in the file it was contained in.
 	size_t m_Index;
@@ -0,0 +1,794 @@
+#pragma once
+
+#include "Utils.h"
+#include "VariationList.h"
+#include "Ember.h"
+
+/// <summary>
+/// EmberBinaryHeader struct, EmberToBinary and BinaryToEmber classes.
+/// </summary>
+
+namespace EmberNs
+{
+#define EMBER_BINARY_MAGIC "EMBERBIN"//Exactly 8 characters, the null terminator is not stored.
+#define EMBER_BINARY_VERSION 1//Increment whenever the layout of a record changes.
+#define EMBER_BINARY_ENDIAN 0x01020304u//Files are written in native byte order, so a reader with the other order sees this reversed.
+
+/// <summary>
+/// The header at the start of a binary ember file.
+/// The file layout is:
+///		The header.
+///		One record per ember, each of which is self contained.
+///		The index, which is m_Count pairs of uint64_t holding the offset from the start of the file and the size of each record.
+/// Since the index gives the location of every record, a single ember can be read out of a
+/// memory mapped file without touching any of the others.
+/// Records hold every value which is saved to Xml plus the few which are only kept in memory, such as the
+/// original size and the hue. All real values are stored as doubles regardless of the type of the ember,
+/// so a file written from Ember<double> can be read into Ember<float> and vice versa. Variations are stored
+/// by ID and name, and params by name, so a file remains readable when variations are added or reordered.
+/// </summary>
+struct EMBER_API EmberBinaryHeader
+{
+	char m_Magic[8];//EMBER_BINARY_MAGIC.
+	uint32_t m_Version;//EMBER_BINARY_VERSION of the writer.
+	uint32_t m_Endian;//EMBER_BINARY_ENDIAN as written by the writer.
+	uint64_t m_Count;//The number of embers in the file.
+	uint64_t m_IndexOffset;//The offset of the index from the start of the file.
+};
+
+/// <summary>
+/// Class for converting ember objects to the binary format described in EmberBinaryHeader.
+/// This is meant for quickly reloading embers which have already been parsed, such as genome
+/// pools and animation key frames, rather than as a replacement for Xml as an interchange format.
+/// Template argument expected to be float or double.
+/// </summary>
+template <typename T>
+class EMBER_API EmberToBinary : public EmberReport
+{
+public:
+	/// <summary>
+	/// Empty constructor.
+	/// </summary>
+	EmberToBinary()
+	{
+	}
+
+	/// <summary>
+	/// Save a vector of embers to the specified file, overwriting it if it exists.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="embers">The vector of embers to save</param>
+	/// <returns>True if successful, else false</returns>
+	bool Save(const string& filename, const vector<Ember<T>>& embers)
+	{
+		bool b = false;
+		string buf;
+		vector<uint64_t> index;
+		EmberBinaryHeader header;
+		ofstream f;
+
+		m_ErrorReport.clear();
+		memcpy(header.m_Magic, EMBER_BINARY_MAGIC, sizeof(header.m_Magic));
+		header.m_Version = EMBER_BINARY_VERSION;
+		header.m_Endian = EMBER_BINARY_ENDIAN;
+		header.m_Count = embers.size();
+		index.reserve(embers.size() * 2);
+
+		try
+		{
+			f.open(filename, std::ofstream::out | std::ofstream::binary);
+
+			if (f.is_open())
+			{
+				uint64_t offset = sizeof(header);
+
+				f.write(reinterpret_cast<const char*>(&header), sizeof(header));//Written again below once the index offset is known.
+
+				for (auto& ember : embers)
+				{
+					buf.clear();
+					ToBuffer(ember, buf);
+					f.write(buf.data(), buf.size());
+					index.push_back(offset);
+					index.push_back(buf.size());
+					offset += buf.size();
+				}
+
+				header.m_IndexOffset = offset;
+
+				if (!index.empty())
+					f.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(index[0]));
+
+				f.seekp(0);
+				f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				b = f.good();
+				f.close();
+			}
+
+			if (!b)
+				m_ErrorReport.push_back(string(__FUNCTION__) + " : Writing flame " + filename + " failed.");
+		}
+		catch (...)
+		{
+			if (f.is_open())
+				f.close();
+
+			m_ErrorReport.push_back(string(__FUNCTION__) + " : Writing flame " + filename + " failed.");
+			b = false;
+		}
+
+		return b;
+	}
+
+	/// <summary>
+	/// Append the binary record of an ember to a buffer.
+	/// </summary>
+	/// <param name="ember">The ember to convert</param>
+	/// <param name="buf">The buffer to append to</param>
+	void ToBuffer(const Ember<T>& ember, string& buf)
+	{
+		size_t i, j;
+
+		Put<uint64_t>(buf, ember.m_FinalRasW);
+		Put<uint64_t>(buf, ember.m_FinalRasH);
+		Put<uint64_t>(buf, ember.m_OrigFinalRasW);
+		Put<uint64_t>(buf, ember.m_OrigFinalRasH);
+		Put<uint64_t>(buf, ember.m_SubBatchSize);
+		Put<uint64_t>(buf, ember.m_FuseCount);
+		Put<uint64_t>(buf, ember.m_Supersample);
+		Put<uint64_t>(buf, ember.m_TemporalSamples);
+		Put<uint64_t>(buf, ember.m_Index);
+		Put<int32_t>(buf, ember.m_Symmetry);
+		Put<int32_t>(buf, ember.m_Interp);
+		Put<int32_t>(buf, ember.m_AffineInterp);
+		Put<int32_t>(buf, ember.m_PaletteInterp);
+		Put<int32_t>(buf, ember.m_TemporalFilterType);
+		Put<int32_t>(buf, ember.m_SpatialFilterType);
+		Put<int32_t>(buf, ember.m_PaletteMode);
+		Put<double>(buf, ember.m_OrigPixPerUnit);
+		Put<double>(buf, ember.m_Quality);
+		Put<double>(buf, ember.m_PixelsPerUnit);
+		Put<double>(buf, ember.m_Zoom);
+		Put<double>(buf, ember.m_CamZPos);
+		Put<double>(buf, ember.m_CamPerspective);
+		Put<double>(buf, ember.m_CamYaw);
+		Put<double>(buf, ember.m_CamPitch);
+		Put<double>(buf, ember.m_CamDepthBlur);
+		Put<double>(buf, ember.m_CenterX);
+		Put<double>(buf, ember.m_CenterY);
+		Put<double>(buf, ember.m_RotCenterY);
+		Put<double>(buf, ember.m_Rotate);
+		Put<double>(buf, ember.m_Hue);
+		Put<double>(buf, ember.m_Brightness);
+		Put<double>(buf, ember.m_Gamma);
+		Put<double>(buf, ember.m_Vibrancy);
+		Put<double>(buf, ember.m_GammaThresh);
+		Put<double>(buf, ember.m_HighlightPower);
+		Put<double>(buf, ember.m_Time);
+		Put<double>(buf, ember.m_Background.r);
+		Put<double>(buf, ember.m_Background.g);
+		Put<double>(buf, ember.m_Background.b);
+		Put<double>(buf, ember.m_Background.a);
+		Put<double>(buf, ember.m_MinRadDE);
+		Put<double>(buf, ember.m_MaxRadDE);
+		Put<double>(buf, ember.m_CurveDE);
+		Put<double>(buf, ember.m_SpatialFilterRadius);
+		Put<double>(buf, ember.m_TemporalFilterExp);
+		Put<double>(buf, ember.m_TemporalFilterWidth);
+		PutString(buf, ember.m_Name);
+		PutString(buf, ember.m_ParentFilename);
+
+		for (glm::length_t ci = 0; ci < 4; ci++)
+		{
+			for (glm::length_t cj = 0; cj < 4; cj++)
+			{
+				Put<double>(buf, ember.m_Curves.m_Points[ci][cj].x);
+				Put<double>(buf, ember.m_Curves.m_Points[ci][cj].y);
+				Put<double>(buf, ember.m_Curves.m_Weights[ci][cj]);
+			}
+		}
+
+		Put<int32_t>(buf, ember.m_Palette.m_Index);
+		PutString(buf, ember.m_Palette.m_Name);
+		Put<uint32_t>(buf, uint32_t(ember.m_Palette.m_Entries.size()));
+
+		for (i = 0; i < ember.m_Palette.m_Entries.size(); i++)
+			for (j = 0; j < 4; j++)
+				Put<double>(buf, ember.m_Palette.m_Entries[i][glm::length_t(j)]);
+
+		if (ember.Edits())
+		{
+			xmlChar* mem = nullptr;
+			int size = 0;
+
+			xmlDocDumpMemory(ember.Edits(), &mem, &size);
+			PutString(buf, mem ? string(CCX(mem), size_t(size)) : string());
+
+			if (mem)
+				xmlFree(mem);
+		}
+		else
+			PutString(buf, string());
+
+		Put<uint32_t>(buf, uint32_t(ember.XformCount()));
+
+		for (i = 0; i < ember.XformCount(); i++)
+			PutXform(buf, *ember.GetXform(i));
+
+		Put<uint8_t>(buf, ember.UseFinalXform() ? 1 : 0);
+
+		if (ember.UseFinalXform())
+			PutXform(buf, *ember.FinalXform());
+	}
+
+private:
+	/// <summary>
+	/// Append the binary record of an xform, including its motion elements, to a buffer.
+	/// </summary>
+	/// <param name="buf">The buffer to append to</param>
+	/// <param name="xform">The xform to convert</param>
+	void PutXform(string& buf, const Xform<T>& xform)
+	{
+		size_t i, j;
+
+		Put<double>(buf, xform.m_Weight);
+		Put<double>(buf, xform.m_ColorX);
+		Put<double>(buf, xform.m_ColorY);
+		Put<double>(buf, xform.m_DirectColor);
+		Put<double>(buf, xform.m_ColorSpeed);
+		Put<double>(buf, xform.m_Opacity);
+		Put<double>(buf, xform.m_Animate);
+		Put<double>(buf, xform.m_Wind[0]);
+		Put<double>(buf, xform.m_Wind[1]);
+		Put<double>(buf, xform.m_Affine.A());
+		Put<double>(buf, xform.m_Affine.B());
+		Put<double>(buf, xform.m_Affine.C());
+		Put<double>(buf, xform.m_Affine.D());
+		Put<double>(buf, xform.m_Affine.E());
+		Put<double>(buf, xform.m_Affine.F());
+		Put<double>(buf, xform.m_Post.A());
+		Put<double>(buf, xform.m_Post.B());
+		Put<double>(buf, xform.m_Post.C());
+		Put<double>(buf, xform.m_Post.D());
+		Put<double>(buf, xform.m_Post.E());
+		Put<double>(buf, xform.m_Post.F());
+		Put<int32_t>(buf, xform.m_MotionFunc);
+		Put<int64_t>(buf, xform.m_MotionFreq);
+		PutString(buf, xform.m_Name);
+		Put<uint32_t>(buf, uint32_t(xform.XaosVec().size()));
+
+		for (auto xaos : xform.XaosVec())
+			Put<double>(buf, xaos);
+
+		Put<uint32_t>(buf, uint32_t(xform.TotalVariationCount()));
+
+		for (i = 0; i < xform.TotalVariationCount(); i++)
+		{
+			Variation<T>* var = xform.GetVariation(i);
+			ParametricVariation<T>* parVar = dynamic_cast<ParametricVariation<T>*>(var);
+			size_t paramCount = 0;
+
+			Put<uint32_t>(buf, var->VariationId());
+			PutString(buf, var->Name());
+			Put<double>(buf, var->m_Weight);
+
+			if (parVar)
+				for (j = 0; j < parVar->ParamCount(); j++)
+					if (!parVar->Params()[j].IsPrecalc())
+						paramCount++;
+
+			Put<uint32_t>(buf, uint32_t(paramCount));
+
+			if (parVar)
+			{
+				ParamWithName<T>* params = parVar->Params();
+
+				for (j = 0; j < parVar->ParamCount(); j++)
+				{
+					if (!params[j].IsPrecalc())
+					{
+						PutString(buf, params[j].Name());
+						Put<double>(buf, params[j].ParamVal());
+					}
+				}
+			}
+		}
+
+		Put<uint32_t>(buf, uint32_t(xform.m_Motion.size()));
+
+		for (auto& motion : xform.m_Motion)
+			PutXform(buf, motion);
+	}
+
+	/// <summary>
+	/// Append the bytes of a value to a buffer.
+	/// </summary>
+	/// <param name="buf">The buffer to append to</param>
+	/// <param name="val">The value to append, which is converted to type U first</param>
+	template <typename U>
+	static void Put(string& buf, U val)
+	{
+		buf.append(reinterpret_cast<const char*>(&val), sizeof(val));
+	}
+
+	/// <summary>
+	/// Append a string to a buffer, preceded by its length.
+	/// </summary>
+	/// <param name="buf">The buffer to append to</param>
+	/// <param name="s">The string to append</param>
+	static void PutString(string& buf, const string& s)
+	{
+		Put<uint32_t>(buf, uint32_t(s.size()));
+		buf.append(s);
+	}
+};
+
+/// <summary>
+/// Class for reading embers from the binary format described in EmberBinaryHeader.
+/// The file is memory mapped when opened, and each ember is only read when requested,
+/// so any one of them can be retrieved from a large file quickly.
+/// Every read is bounds checked, so a truncated or corrupt file results in an error rather than a crash.
+/// Template argument expected to be float or double.
+/// </summary>
+template <typename T>
+class EMBER_API BinaryToEmber : public EmberReport
+{
+public:
+	/// <summary>
+	/// Constructor which does not open anything.
+	/// </summary>
+	BinaryToEmber()
+		: m_Index(nullptr), m_Count(0)
+	{
+	}
+
+	/// <summary>
+	/// Map the specified file and validate its header and index, closing any previously opened file first.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <returns>True if the file was a valid binary ember file, else false.</returns>
+	bool Open(const string& filename)
+	{
+		const char* loc = __FUNCTION__;
+		EmberBinaryHeader header;
+
+		Close();
+		m_ErrorReport.clear();
+
+		if (!m_File.Open(filename.c_str()))
+		{
+			m_ErrorReport.push_back(string(loc) + " : Could not open " + filename);
+			return false;
+		}
+
+		if (m_File.Size() < sizeof(header))
+		{
+			m_ErrorReport.push_back(string(loc) + " : " + filename + " is too small to be a binary ember file");
+			Close();
+			return false;
+		}
+
+		memcpy(&header, m_File.Data(), sizeof(header));
+
+		if (memcmp(header.m_Magic, EMBER_BINARY_MAGIC, sizeof(header.m_Magic)))
+			m_ErrorReport.push_back(string(loc) + " : " + filename + " is not a binary ember file");
+		else if (header.m_Endian != EMBER_BINARY_ENDIAN)
+			m_ErrorReport.push_back(string(loc) + " : " + filename + " was written on a system with a different byte order");
+		else if (header.m_Version > EMBER_BINARY_VERSION)
+			m_ErrorReport.push_back(string(loc) + " : " + filename + " is version " + std::to_string(header.m_Version) + ", only up to " + std::to_string(EMBER_BINARY_VERSION) + " is supported");
+		else if (header.m_IndexOffset > m_File.Size() || header.m_Count > (m_File.Size() - header.m_IndexOffset) / (sizeof(uint64_t) * 2))
+			m_ErrorReport.push_back(string(loc) + " : " + filename + " has a truncated index");
+
+		if (!m_ErrorReport.empty())
+		{
+			Close();
+			return false;
+		}
+
+		m_Index = m_File.Data() + header.m_IndexOffset;
+		m_Count = size_t(header.m_Count);
+		return true;
+	}
+
+	/// <summary>
+	/// Determine whether a file is in the binary ember format by checking the start of its header.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <returns>True if the file starts with EMBER_BINARY_MAGIC, else false.</returns>
+	static bool IsBinaryFile(const string& filename)
+	{
+		char magic[8];
+		ifstream f(filename, std::ifstream::in | std::ifstream::binary);
+
+		return f.read(magic, sizeof(magic)) && !memcmp(magic, EMBER_BINARY_MAGIC, sizeof(magic));
+	}
+
+	/// <summary>
+	/// Unmap the file if one is open.
+	/// </summary>
+	void Close()
+	{
+		m_File.Close();
+		m_Index = nullptr;
+		m_Count = 0;
+	}
+
+	/// <summary>
+	/// Get the number of embers in the open file.
+	/// </summary>
+	/// <returns>The number of embers, 0 if no file is open.</returns>
+	size_t Count() const { return m_Count; }
+
+	/// <summary>
+	/// Read the ember at the specified index in the open file.
+	/// </summary>
+	/// <param name="i">The index of the ember to read</param>
+	/// <param name="ember">The ember to store the result in</param>
+	/// <returns>True if success, else false.</returns>
+	bool Get(size_t i, Ember<T>& ember)
+	{
+		uint64_t entry[2];
+
+		if (i >= m_Count)
+		{
+			m_ErrorReport.push_back(string(__FUNCTION__) + " : Index " + std::to_string(i) + " is out of range");
+			return false;
+		}
+
+		memcpy(entry, m_Index + (i * sizeof(entry)), sizeof(entry));
+
+		if (entry[0] > m_File.Size() || entry[1] > m_File.Size() - entry[0])
+		{
+			m_ErrorReport.push_back(string(__FUNCTION__) + " : Record " + std::to_string(i) + " is out of bounds");
+			return false;
+		}
+
+		return FromBuffer(m_File.Data() + entry[0], size_t(entry[1]), ember);
+	}
+
+	/// <summary>
+	/// Read all embers from the specified file.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="embers">The vector to store the embers in, which is cleared first</param>
+	/// <returns>True if all embers were read, else false.</returns>
+	bool Load(const string& filename, vector<Ember<T>>& embers)
+	{
+		embers.clear();
+
+		if (!Open(filename))
+			return false;
+
+		embers.resize(m_Count);
+
+		for (size_t i = 0; i < m_Count; i++)
+		{
+			if (!Get(i, embers[i]))
+			{
+				embers.resize(i);
+				Close();
+				return false;
+			}
+		}
+
+		Close();
+		return true;
+	}
+
+	/// <summary>
+	/// Read an ember from a single binary record, such as one produced by EmberToBinary::ToBuffer().
+	/// </summary>
+	/// <param name="data">The record</param>
+	/// <param name="size">The size of the record in bytes</param>
+	/// <param name="ember">The ember to store the result in</param>
+	/// <returns>True if success, else false.</returns>
+	bool FromBuffer(const byte* data, size_t size, Ember<T>& ember)
+	{
+		size_t i, j;
+		Cursor cur(data, data + size);
+		string edits;
+
+		ember.Clear();
+		ember.m_FinalRasW = size_t(cur.Get<uint64_t>());
+		ember.m_FinalRasH = size_t(cur.Get<uint64_t>());
+		ember.m_OrigFinalRasW = size_t(cur.Get<uint64_t>());
+		ember.m_OrigFinalRasH = size_t(cur.Get<uint64_t>());
+		ember.m_SubBatchSize = size_t(cur.Get<uint64_t>());
+		ember.m_FuseCount = size_t(cur.Get<uint64_t>());
+		ember.m_Supersample = size_t(cur.Get<uint64_t>());
+		ember.m_TemporalSamples = size_t(cur.Get<uint64_t>());
+		ember.m_Index = size_t(cur.Get<uint64_t>());
+		ember.m_Symmetry = cur.Get<int32_t>();
+		ember.m_Interp = eInterp(cur.Get<int32_t>());
+		ember.m_AffineInterp = eAffineInterp(cur.Get<int32_t>());
+		ember.m_PaletteInterp = ePaletteInterp(cur.Get<int32_t>());
+		ember.m_TemporalFilterType = eTemporalFilterType(cur.Get<int32_t>());
+		ember.m_SpatialFilterType = eSpatialFilterType(cur.Get<int32_t>());
+		ember.m_PaletteMode = ePaletteMode(cur.Get<int32_t>());
+		ember.m_OrigPixPerUnit = cur.GetReal<T>();
+		ember.m_Quality = cur.GetReal<T>();
+		ember.m_PixelsPerUnit = cur.GetReal<T>();
+		ember.m_Zoom = cur.GetReal<T>();
+		ember.m_CamZPos = cur.GetReal<T>();
+		ember.m_CamPerspective = cur.GetReal<T>();
+		ember.m_CamYaw = cur.GetReal<T>();
+		ember.m_CamPitch = cur.GetReal<T>();
+		ember.m_CamDepthBlur = cur.GetReal<T>();
+		ember.m_CenterX = cur.GetReal<T>();
+		ember.m_CenterY = cur.GetReal<T>();
+		ember.m_RotCenterY = cur.GetReal<T>();
+		ember.m_Rotate = cur.GetReal<T>();
+		ember.m_Hue = cur.GetReal<T>();
+		ember.m_Brightness = cur.GetReal<T>();
+		ember.m_Gamma = cur.GetReal<T>();
+		ember.m_Vibrancy = cur.GetReal<T>();
+		ember.m_GammaThresh = cur.GetReal<T>();
+		ember.m_HighlightPower = cur.GetReal<T>();
+		ember.m_Time = cur.GetReal<T>();
+		ember.m_Background.r = cur.GetReal<T>();
+		ember.m_Background.g = cur.GetReal<T>();
+		ember.m_Background.b = cur.GetReal<T>();
+		ember.m_Background.a = cur.GetReal<T>();
+		ember.m_MinRadDE = cur.GetReal<T>();
+		ember.m_MaxRadDE = cur.GetReal<T>();
+		ember.m_CurveDE = cur.GetReal<T>();
+		ember.m_SpatialFilterRadius = cur.GetReal<T>();
+		ember.m_TemporalFilterExp = cur.GetReal<T>();
+		ember.m_TemporalFilterWidth = cur.GetReal<T>();
+		ember.m_Name = cur.GetString();
+		ember.m_ParentFilename = cur.GetString();
+
+		for (glm::length_t ci = 0; ci < 4; ci++)
+		{
+			for (glm::length_t cj = 0; cj < 4; cj++)
+			{
+				ember.m_Curves.m_Points[ci][cj].x = cur.GetReal<T>();
+				ember.m_Curves.m_Points[ci][cj].y = cur.GetReal<T>();
+				ember.m_Curves.m_Weights[ci][cj] = cur.GetReal<T>();
+			}
+		}
+
+		ember.m_Palette.m_Index = cur.Get<int32_t>();
+		ember.m_Palette.m_Name = cur.GetString();
+		ember.m_Palette.m_Entries.resize(cur.GetCount(sizeof(double) * 4));
+
+		for (i = 0; i < ember.m_Palette.m_Entries.size(); i++)
+			for (j = 0; j < 4; j++)
+				ember.m_Palette.m_Entries[i][glm::length_t(j)] = cur.GetReal<T>();
+
+		edits = cur.GetString();
+
+		if (!edits.empty())
+		{
+			if (xmlDocPtr doc = xmlReadMemory(edits.data(), int(edits.size()), nullptr, nullptr, XML_PARSE_NONET))
+				ember.SetEdit(doc);
+			else
+				m_ErrorReport.push_back(string(__FUNCTION__) + " : Could not parse edit doc of " + ember.m_Name);
+		}
+
+		size_t xformCount = cur.GetCount(1);
+
+		for (i = 0; i < xformCount && cur.Ok(); i++)
+		{
+			Xform<T> xform;
+
+			GetXform(cur, xform);
+			ember.AddXform(std::move(xform));
+		}
+
+		if (cur.Get<uint8_t>() && cur.Ok())
+		{
+			Xform<T> xform;
+
+			GetXform(cur, xform);
+			ember.SetFinalXform(xform);
+		}
+
+		if (!cur.Ok())
+		{
+			m_ErrorReport.push_back(string(__FUNCTION__) + " : Record is truncated or corrupt");
+			return false;
+		}
+
+		ember.CacheXforms();
+		ember.SetProjFunc();
+		return true;
+	}
+
+private:
+	/// <summary>
+	/// Bounds checked reading of values from a record.
+	/// Once any read runs past the end, all subsequent reads return zero and Ok() returns false,
+	/// so a record can be read in one pass and checked once at the end.
+	/// </summary>
+	class Cursor
+	{
+	public:
+		/// <summary>
+		/// Constructor which starts reading at the beginning of a record.
+		/// </summary>
+		/// <param name="p">The start of the record</param>
+		/// <param name="end">One past the end of the record</param>
+		Cursor(const byte* p, const byte* end)
+			: m_P(p), m_End(end), m_Ok(true)
+		{
+		}
+
+		/// <summary>
+		/// Read a value.
+		/// </summary>
+		/// <returns>The value, or 0 if past the end.</returns>
+		template <typename U>
+		U Get()
+		{
+			U val = U();
+
+			if (m_Ok && size_t(m_End - m_P) >= sizeof(U))
+			{
+				memcpy(&val, m_P, sizeof(U));//The map is not aligned for U, so don't dereference.
+				m_P += sizeof(U);
+			}
+			else
+				m_Ok = false;
+
+			return val;
+		}
+
+		/// <summary>
+		/// Read a real value, which is always stored as a double.
+		/// </summary>
+		/// <returns>The value converted to type U, or 0 if past the end.</returns>
+		template <typename U>
+		U GetReal() { return U(Get<double>()); }
+
+		/// <summary>
+		/// Read a string, which is stored as its length followed by its characters.
+		/// </summary>
+		/// <returns>The string, or an empty string if past the end.</returns>
+		string GetString()
+		{
+			size_t size = GetCount(1);
+			string s(reinterpret_cast<const char*>(m_P), m_Ok ? size : 0);
+
+			m_P += s.size();
+			return s;
+		}
+
+		/// <summary>
+		/// Read a count of elements, failing if the remaining bytes can't hold that many of the minimum size.
+		/// This keeps a corrupt count from causing a huge allocation.
+		/// </summary>
+		/// <param name="minSize">The minimum size in bytes of each element</param>
+		/// <returns>The count, or 0 if past the end or too large.</returns>
+		size_t GetCount(size_t minSize)
+		{
+			size_t count = size_t(Get<uint32_t>());
+
+			if (count > size_t(m_End - m_P) / minSize)
+			{
+				m_Ok = false;
+				count = 0;
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// Get whether all reads so far were within the record.
+		/// </summary>
+		/// <returns>True if none went past the end, else false.</returns>
+		bool Ok() const { return m_Ok; }
+
+	private:
+		const byte* m_P;
+		const byte* m_End;
+		bool m_Ok;
+	};
+
+	/// <summary>
+	/// Read an xform, including its motion elements.
+	/// Variations unknown to this build are skipped with a warning in the error report.
+	/// </summary>
+	/// <param name="cur">The cursor to read from</param>
+	/// <param name="xform">The xform to store the result in</param>
+	void GetXform(Cursor& cur, Xform<T>& xform)
+	{
+		size_t i, j;
+
+		xform.m_Weight = cur.GetReal<T>();
+		xform.m_ColorX = cur.GetReal<T>();
+		xform.m_ColorY = cur.GetReal<T>();
+		xform.m_DirectColor = cur.GetReal<T>();
+		xform.m_ColorSpeed = cur.GetReal<T>();
+		xform.m_Opacity = cur.GetReal<T>();
+		xform.m_Animate = cur.GetReal<T>();
+		xform.m_Wind[0] = cur.GetReal<T>();
+		xform.m_Wind[1] = cur.GetReal<T>();
+		xform.m_Affine.A(cur.GetReal<T>());
+		xform.m_Affine.B(cur.GetReal<T>());
+		xform.m_Affine.C(cur.GetReal<T>());
+		xform.m_Affine.D(cur.GetReal<T>());
+		xform.m_Affine.E(cur.GetReal<T>());
+		xform.m_Affine.F(cur.GetReal<T>());
+		xform.m_Post.A(cur.GetReal<T>());
+		xform.m_Post.B(cur.GetReal<T>());
+		xform.m_Post.C(cur.GetReal<T>());
+		xform.m_Post.D(cur.GetReal<T>());
+		xform.m_Post.E(cur.GetReal<T>());
+		xform.m_Post.F(cur.GetReal<T>());
+		xform.m_MotionFunc = eMotion(cur.Get<int32_t>());
+		xform.m_MotionFreq = intmax_t(cur.Get<int64_t>());
+		xform.m_Name = cur.GetString();
+
+		size_t xaosCount = cur.GetCount(sizeof(double));
+
+		for (i = 0; i < xaosCount; i++)
+			xform.SetXaos(i, cur.GetReal<T>());
+
+		size_t varCount = cur.GetCount(sizeof(uint32_t) * 4);
+
+		for (i = 0; i < varCount && cur.Ok(); i++)
+		{
+			eVariationId id = eVariationId(cur.Get<uint32_t>());
+			string name = cur.GetString();
+			T weight = cur.GetReal<T>();
+			size_t paramCount = cur.GetCount(sizeof(uint32_t) + sizeof(double));
+			Variation<T>* var = m_VariationList.GetVariation(id);
+
+			if (!var || var->Name() != name)//IDs are only stable within a build, so fall back to the name.
+				var = m_VariationList.GetVariation(name);
+
+			Variation<T>* varCopy = var ? var->Copy() : nullptr;
+			ParametricVariation<T>* parVar = dynamic_cast<ParametricVariation<T>*>(varCopy);
+
+			if (varCopy)
+				varCopy->m_Weight = weight;
+			else
+				m_ErrorReport.push_back(string(__FUNCTION__) + " : Skipping unsupported variation " + name);
+
+			for (j = 0; j < paramCount; j++)
+			{
+				string paramName = cur.GetString();
+				T val = cur.GetReal<T>();
+
+				if (parVar)
+				{
+					ParamWithName<T>* params = parVar->Params();
+					size_t k = j;
+
+					if (k >= parVar->ParamCount() || params[k].Name() != paramName)//Params are almost always in the same order they were written.
+						for (k = 0; k < parVar->ParamCount() && params[k].Name() != paramName; k++) ;
+
+					if (k < parVar->ParamCount())
+						params[k].Set(val);
+				}
+			}
+
+			if (varCopy)
+			{
+				varCopy->Precalc();
+
+				if (!xform.AddVariation(varCopy))
+					delete varCopy;
+			}
+		}
+
+		size_t motionCount = cur.GetCount(1);
+
+		for (i = 0; i < motionCount && cur.Ok(); i++)
+		{
+			Xform<T> motion;
+
+			GetXform(cur, motion);
+			xform.m_Motion.push_back(std::move(motion));
+		}
+
+		xform.CacheColorVals();
+	}
+
+	MappedFile m_File;
+	const byte* m_Index;//Points into m_File, so is only valid while it's open.
+	size_t m_Count;
+	VariationList<T> m_VariationList;
+};
+}
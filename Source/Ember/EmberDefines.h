@@ -27,6 +27,13 @@
 #define RESTRICT __restrict//This might make things faster, unsure if it really does though.
 //#define RESTRICT
 
+//Visual Studio 2013 does not support noexcept. It must be used on move constructors, else vectors copy rather than move when growing.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+	#define NOEXCEPT throw()
+#else
+	#define NOEXCEPT noexcept
+#endif
+
 //Wrap the sincos function for Macs and PC.
 #if defined(__APPLE__) || defined(_MSC_VER)
 	#define sincos(x, s, c) *(s)=sin(x); *(c)=cos(x);
@@ -61,6 +68,8 @@ namespace EmberNs
 #define COLORMAP_LENGTH_MINUS_1 255
 #define WHITE 255
 #define DEFAULT_SBS (1024 * 10)
+#define PARALLEL_CLEAR_BYTES (size_t(4) * 1024 * 1024)//Buffers smaller than this are cleared on a single thread.
+#define ZERO_PAGE_BYTES (size_t(64) * 1024 * 1024)//Buffers at least this large may be cleared by replacing them with fresh zero pages.
 //#define XC(c) ((const xmlChar*)(c))
 #define XC(c) (reinterpret_cast<const xmlChar*>(c))
 #define CX(c) (reinterpret_cast<char*>(c))
@@ -85,12 +94,26 @@ static inline size_t NowMs()
 	return duration_cast<milliseconds>(Clock::now().time_since_epoch()).count();
 }
 
+/// <summary>
+/// Thin wrapper around reading the processor's time stamp counter, for timing sections of code
+/// too short to be measured with Clock. Falls back to nanoseconds from Clock on processors without one.
+/// </summary>
+static inline uint64_t CycleCount()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return duration_cast<nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+}
+
 #ifndef byte
 	typedef unsigned char byte;
 #endif
 
 #define DO_DOUBLE 1//Comment this out for shorter build times during development. Always uncomment for release.
 //#define ISAAC_FLAM3_DEBUG 1//This is almost never needed, but is very useful when troubleshooting difficult bugs. Enable it to do a side by side comparison with flam3.
+//#define ITER_PROFILE 1//Enable to count xform selections, bad values and out of bounds points, and sample the cost of each variation while iterating. Slows iteration down, so never enable for release.
 
 #if GLM_VERSION >= 96
 	#define v2T  glm::tvec2<T, glm::defaultp>
@@ -115,9 +138,11 @@ enum eAffineInterp : uint { INTERP_LINEAR = 0, INTERP_LOG = 1, INTERP_COMPAT = 2
 enum ePaletteMode : uint { PALETTE_STEP = 0, PALETTE_LINEAR = 1 };
 enum ePaletteInterp : uint { INTERP_HSV = 0, INTERP_SWEEP = 1 };
 enum eMotion : uint { MOTION_SIN = 1, MOTION_TRIANGLE = 2, MOTION_HILL = 3 };
-enum eProcessAction : uint { NOTHING = 0, ACCUM_ONLY = 1, FILTER_AND_ACCUM = 2, KEEP_ITERATING = 3, FULL_RENDER = 4 };
+enum eProcessAction : uint { NOTHING = 0, ACCUM_ONLY = 1, FILTER_AND_ACCUM = 2, PALETTE_AND_ACCUM = 3, KEEP_ITERATING = 4, FULL_RENDER = 5 };
 enum eProcessState : uint { NONE = 0, ITER_STARTED = 1, ITER_DONE = 2, FILTER_DONE = 3, ACCUM_DONE = 4 };
 enum eInteractiveFilter : uint { FILTER_LOG = 0, FILTER_DE = 1 };
 enum eScaleType : uint { SCALE_NONE = 0, SCALE_WIDTH = 1, SCALE_HEIGHT = 2 };
 enum eRenderStatus : uint { RENDER_OK = 0, RENDER_ERROR = 1, RENDER_ABORT = 2 };
+enum eResetStrategy : uint { RESET_UNKNOWN = 0, RESET_CLEAR = 1, RESET_DISCARD = 2 };
+enum eHugePagePolicy : uint { HUGE_PAGES_NONE = 0, HUGE_PAGES_TRANSPARENT = 1, HUGE_PAGES_EXPLICIT = 2 };
 }
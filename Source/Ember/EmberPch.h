@@ -17,24 +17,41 @@
 	#include <SDKDDKVer.h>
 	#include <windows.h>
 #elif __APPLE__
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
 	#define EMBER_OS "OSX"
 #else
+	#include <fcntl.h>
 	#include <libgen.h>
+	#include <sched.h>
+	#include <sys/mman.h>
 	#include <unistd.h>
 	#define EMBER_OS "LNX"
 #endif
 
+//Processor intrinsics, used to read the time stamp counter.
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
 //Standard headers.
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <complex>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <inttypes.h>
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <list>
 #ifdef __APPLE__
 #include <malloc/malloc.h>
 #else
@@ -43,6 +60,7 @@
 #include <map>
 #include <math.h>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <sstream>
@@ -50,13 +68,17 @@
 #include <sys/stat.h>
 #include <thread>
 #include <time.h>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 //Third party headers.
 #ifdef _WIN32
 #include "libxml/parser.h"
+#include "libxml/xmlreader.h"
 #else
 #include "libxml2/libxml/parser.h"
+#include "libxml2/libxml/xmlreader.h"
 #endif
 
 //Intel's Threading Building Blocks is what's used for all threading.
@@ -11,9 +11,15 @@
 
 namespace EmberNs
 {
+#define EMBER_XML_RESERVE 16384//Enough for the Xml of a typical ember with a hex palette, including a few edits.
+#define EMBER_XML_BATCH_SIZE 256//The number of embers converted in parallel before writing them out.
+
 /// <summary>
 /// Class for converting ember objects to Xml documents.
 /// Support for saving one or more to a single file.
+/// Numbers are written with ToChars(), so they're no longer than needed to read back as exactly the same value.
+/// ToBuffer(), Save() and Write() reuse buffers held by the object, so an instance must not be used by
+/// more than one thread at a time. Give each thread its own, or call Append() with a buffer per thread.
 /// Template argument expected to be float or double.
 /// </summary>
 template <typename T>
@@ -42,14 +48,12 @@ public:
 	/// <returns>True if successful, else false</returns>
 	bool Save(const string& filename, Ember<T>& ember, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette, bool append = false, bool start = false, bool finish = false)
 	{
-		vector<Ember<T>> vec;
-
-		vec.push_back(ember);
-		return Save(filename, vec, printEditDepth, doEdits, intPalette, hexPalette, append, start, finish);
+		return Save(filename, &ember, 1, printEditDepth, doEdits, intPalette, hexPalette, append, start, finish);
 	}
 
 	/// <summary>
 	/// Save a vector of embers to the specified file.
+	/// The embers are converted to Xml in parallel, see Write().
 	/// </summary>
 	/// <param name="filename">Full path and filename</param>
 	/// <param name="embers">The vector of embers to save</param>
@@ -63,56 +67,26 @@ public:
 	/// <returns>True if successful, else false</returns>
 	bool Save(const string& filename, vector<Ember<T>>& embers, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette, bool append = false, bool start = false, bool finish = false)
 	{
-		bool b = false;
-		string temp;
-		ofstream f;
-
-		try
-		{
-			if (append)
-				f.open(filename, std::ofstream::out | std::ofstream::app);//Appending allows us to write multiple embers to a single file.
-			else
-				f.open(filename);
-
-			if (f.is_open())
-			{
-				if ((append && start) || !append)
-				{
-					temp = "<flames>\n";
-					//temp = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n<flames>\n";
-					f.write(temp.c_str(), temp.size());
-				}
-
-				for (auto& ember : embers)
-				{
-					string s = ToString(ember, "", printEditDepth, doEdits, intPalette, hexPalette);
-					f.write(s.c_str(), s.size());
-				}
-
-				if ((append && finish) || !append)
-				{
-					temp = "</flames>\n";
-					f.write(temp.c_str(), temp.size());
-				}
-
-				f.close();
-				b = true;
-			}
-			else
-			{
-				cout << "Error: Writing flame " << filename << " failed." << endl;
-				b = false;
-			}
-		}
-		catch (...)
-		{
-			if (f.is_open())
-				f.close();
-
-			b = false;
-		}
+		return Save(filename, embers.data(), embers.size(), printEditDepth, doEdits, intPalette, hexPalette, append, start, finish);
+	}
 
-		return b;
+	/// <summary>
+	/// Write the Xml string representations of a vector of embers to a stream, in order.
+	/// The embers are converted in parallel in batches of EMBER_XML_BATCH_SIZE, each into its own buffer,
+	/// and each batch is written once it's complete. The buffers are kept and reused by later calls, so
+	/// memory use is bounded by the batch size no matter how many embers there are.
+	/// </summary>
+	/// <param name="os">The stream to write to</param>
+	/// <param name="embers">The vector of embers to write</param>
+	/// <param name="extraAttributes">Extra attributes to add to each flame tag, or empty for none.</param>
+	/// <param name="printEditDepth">How deep the edit depth goes</param>
+	/// <param name="doEdits">If true included edit tags, else don't.</param>
+	/// <param name="intPalette">If true use integers instead of floating point numbers when embedding a non-hex formatted palette, else use floating point numbers.</param>
+	/// <param name="hexPalette">If true, embed a hexadecimal palette instead of Xml Color tags, else use Xml color tags.</param>
+	/// <returns>True if the stream is still good afterward, else false.</returns>
+	bool Write(ostream& os, vector<Ember<T>>& embers, const string& extraAttributes, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette)
+	{
+		return Write(os, embers.data(), embers.size(), extraAttributes, printEditDepth, doEdits, intPalette, hexPalette);
 	}
 
 	/// <summary>
@@ -127,9 +101,48 @@ public:
 	/// <returns>The Xml string representation of the passed in ember</returns>
 	string ToString(Ember<T>& ember, string extraAttributes, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette = true)
 	{
-		size_t i, j;
 		string s;
-		ostringstream os;
+
+		s.reserve(EMBER_XML_RESERVE);
+		Append(ember, extraAttributes, printEditDepth, doEdits, intPalette, hexPalette, s);
+		return s;
+	}
+
+	/// <summary>
+	/// Return the Xml string representation of an ember in a buffer which is kept by this object.
+	/// This is the same as ToString(), but avoids allocating a new string for every ember when
+	/// converting many of them one after another, such as when writing the frames of a sequence.
+	/// </summary>
+	/// <param name="ember">The ember to create the Xml with</param>
+	/// <param name="extraAttributes">If true, add extra attributes, else don't</param>
+	/// <param name="printEditDepth">How deep the edit depth goes</param>
+	/// <param name="doEdits">If true included edit tags, else don't.</param>
+	/// <param name="intPalette">If true use integers instead of floating point numbers when embedding a non-hex formatted palette, else use floating point numbers.</param>
+	/// <param name="hexPalette">If true, embed a hexadecimal palette instead of Xml Color tags, else use Xml color tags.</param>
+	/// <returns>The Xml string representation of the passed in ember, which is only valid until the next call.</returns>
+	const string& ToBuffer(Ember<T>& ember, const string& extraAttributes, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette = true)
+	{
+		m_Buf.clear();
+		m_Buf.reserve(EMBER_XML_RESERVE);
+		Append(ember, extraAttributes, printEditDepth, doEdits, intPalette, hexPalette, m_Buf);
+		return m_Buf;
+	}
+
+	/// <summary>
+	/// Append the Xml string representation of an ember to a buffer.
+	/// This doesn't use any members, so it's safe to call on multiple threads at once with different buffers.
+	/// </summary>
+	/// <param name="ember">The ember to create the Xml with</param>
+	/// <param name="extraAttributes">If true, add extra attributes, else don't</param>
+	/// <param name="printEditDepth">How deep the edit depth goes</param>
+	/// <param name="doEdits">If true included edit tags, else don't.</param>
+	/// <param name="intPalette">If true use integers instead of floating point numbers when embedding a non-hex formatted palette, else use floating point numbers.</param>
+	/// <param name="hexPalette">If true, embed a hexadecimal palette instead of Xml Color tags, else use Xml color tags.</param>
+	/// <param name="buf">The buffer to append to</param>
+	void Append(Ember<T>& ember, const string& extraAttributes, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette, string& buf)
+	{
+		size_t i, j;
+		StringWriter os(buf);
 		vector<Variation<T>*> variations;
 
 		os << "<flame version=\"EMBER-" << EmberVersion() << "\" time=\"" << ember.m_Time << "\"";
@@ -226,10 +239,10 @@ public:
 		//	os << "   <symmetry kind=\"" << ember.m_Symmetry << "\"/>\n";
 
 		for (i = 0; i < ember.XformCount(); i++)
-			os << ToString(*ember.GetXform(i), ember.XformCount(), false, false);//Not final, don't do motion.
+			Append(*ember.GetXform(i), ember.XformCount(), false, false, os);//Not final, don't do motion.
 
 		if (ember.UseFinalXform())
-			os << ToString(*ember.NonConstFinalXform(), ember.XformCount(), true, false);//Final, don't do motion.
+			Append(*ember.NonConstFinalXform(), ember.XformCount(), true, false, os);//Final, don't do motion.
 
 		if (hexPalette)
 		{
@@ -243,12 +256,12 @@ public:
 				{
 					size_t idx = 8 * i + j;
 
-					os << hex << setw(2) << setfill('0') << int(Rint(ember.m_Palette[idx][0] * 255));
-					os << hex << setw(2) << setfill('0') << int(Rint(ember.m_Palette[idx][1] * 255));
-					os << hex << setw(2) << setfill('0') << int(Rint(ember.m_Palette[idx][2] * 255));
+					os.Hex(uint(Clamp<int>(int(Rint(ember.m_Palette[idx][0] * 255)), 0, 255)));
+					os.Hex(uint(Clamp<int>(int(Rint(ember.m_Palette[idx][1] * 255)), 0, 255)));
+					os.Hex(uint(Clamp<int>(int(Rint(ember.m_Palette[idx][2] * 255)), 0, 255)));
 				}
 
-				os << endl;
+				os << "\n";
 			}
 
 			os << "   </palette>\n";
@@ -269,28 +282,45 @@ public:
 					if (intPalette)
 						os << "<color index=\"" << i << "\" rgb=\"" << int(Rint(r)) << " " << int(Rint(g)) << " " << int(Rint(b)) << "\"/>";
 					else
-						os << "<color index=\"" << i << "\" rgb=\"" << std::fixed << std::setprecision(2) << r << " " << g << " " << b << "\"/>";
+					{
+						os << "<color index=\"" << i << "\" rgb=\"";
+						os.Fixed(r, 2);
+						os << " ";
+						os.Fixed(g, 2);
+						os << " ";
+						os.Fixed(b, 2);
+						os << "\"/>";
+					}
 				}
 				else
 				{
 					if (intPalette)
 						os << "   <color index=\"" << i << "\" rgba=\"" << int(Rint(r)) << " " << int(Rint(g)) << " " << int(Rint(b)) << " " << int(Rint(a)) << "\"/>";
 					else
-						os << "   <color index=\"" << i << "\" rgba=\"" << std::fixed << std::setprecision(2) << r << " " << g << " " << b << " " << a << "\"/>";
+					{
+						os << "   <color index=\"" << i << "\" rgba=\"";
+						os.Fixed(r, 2);
+						os << " ";
+						os.Fixed(g, 2);
+						os << " ";
+						os.Fixed(b, 2);
+						os << " ";
+						os.Fixed(a, 2);
+						os << "\"/>";
+					}
 				}
 
 				os << "\n";
 			}
 		}
 
-		if (doEdits && ember.m_Edits != nullptr)
-			os << ToString(xmlDocGetRootElement(ember.m_Edits), 1, true, printEditDepth);
+		if (doEdits && ember.Edits() != nullptr)
+			Append(xmlDocGetRootElement(ember.Edits()), 1, true, printEditDepth, os);
 
 		os << "</flame>\n";
-
-		return os.str();
 	}
 
+
 	/// <summary>
 	/// Create a new editdoc optionally based on parents passed in.
 	/// This is used when an ember is made out of some mutation or edit from one or two existing embers and
@@ -374,10 +404,10 @@ public:
 			os << parent0->m_Index;
 			s = os.str();
 
-			if (parent0->m_Edits)
+			if (parent0->Edits())
 			{
 				//Copy the node from the parent.
-				node = xmlDocGetRootElement(parent0->m_Edits);
+				node = xmlDocGetRootElement(parent0->Edits());
 				nodeCopy = xmlCopyNode(node, 1);
 				AddFilenameWithoutAmpersand(nodeCopy, parent0->m_ParentFilename);
 
@@ -400,10 +430,10 @@ public:
 			os << parent1->m_Index;
 			s = os.str();
 
-			if (parent1->m_Edits)
+			if (parent1->Edits())
 			{
 				//Copy the node from the parent.
-				node = xmlDocGetRootElement(parent1->m_Edits);
+				node = xmlDocGetRootElement(parent1->Edits());
 				nodeCopy = xmlCopyNode(node, 1);
 				AddFilenameWithoutAmpersand(nodeCopy, parent1->m_ParentFilename);
 				xmlNewProp(nodeCopy, XC("index"), XC(s.c_str()));
@@ -462,17 +492,125 @@ public:
 
 private:
 	/// <summary>
-	/// Return the Xml string representation of an xform.
+	/// Save embers to the specified file.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="embers">Pointer to the first ember to save</param>
+	/// <param name="count">The number of embers to save</param>
+	/// <param name="printEditDepth">How deep the edit depth goes</param>
+	/// <param name="doEdits">If true included edit tags, else don't.</param>
+	/// <param name="intPalette">If true use integers instead of floating point numbers when embedding a non-hex formatted palette, else use floating point numbers.</param>
+	/// <param name="hexPalette">If true, embed a hexadecimal palette instead of Xml Color tags, else use Xml color tags.</param>
+	/// <param name="append">If true, append to the file if it already exists, else create a new file.</param>
+	/// <param name="start">Whether a new file is to be started</param>
+	/// <param name="finish">Whether an existing file is to be ended</param>
+	/// <returns>True if successful, else false</returns>
+	bool Save(const string& filename, Ember<T>* embers, size_t count, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette, bool append, bool start, bool finish)
+	{
+		bool b = false;
+		string temp;
+		ofstream f;
+
+		try
+		{
+			if (append)
+				f.open(filename, std::ofstream::out | std::ofstream::app);//Appending allows us to write multiple embers to a single file.
+			else
+				f.open(filename);
+
+			if (f.is_open())
+			{
+				if ((append && start) || !append)
+				{
+					temp = "<flames>\n";
+					//temp = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n<flames>\n";
+					f.write(temp.c_str(), temp.size());
+				}
+
+				Write(f, embers, count, "", printEditDepth, doEdits, intPalette, hexPalette);
+
+				if ((append && finish) || !append)
+				{
+					temp = "</flames>\n";
+					f.write(temp.c_str(), temp.size());
+				}
+
+				f.close();
+				b = true;
+			}
+			else
+			{
+				cout << "Error: Writing flame " << filename << " failed." << endl;
+				b = false;
+			}
+		}
+		catch (...)
+		{
+			if (f.is_open())
+				f.close();
+
+			b = false;
+		}
+
+		return b;
+	}
+
+	/// <summary>
+	/// Write the Xml string representations of embers to a stream, in order.
+	/// See the public overload for details.
+	/// </summary>
+	/// <param name="os">The stream to write to</param>
+	/// <param name="embers">Pointer to the first ember to write</param>
+	/// <param name="count">The number of embers to write</param>
+	/// <param name="extraAttributes">Extra attributes to add to each flame tag, or empty for none.</param>
+	/// <param name="printEditDepth">How deep the edit depth goes</param>
+	/// <param name="doEdits">If true included edit tags, else don't.</param>
+	/// <param name="intPalette">If true use integers instead of floating point numbers when embedding a non-hex formatted palette, else use floating point numbers.</param>
+	/// <param name="hexPalette">If true, embed a hexadecimal palette instead of Xml Color tags, else use Xml color tags.</param>
+	/// <returns>True if the stream is still good afterward, else false.</returns>
+	bool Write(ostream& os, Ember<T>* embers, size_t count, const string& extraAttributes, size_t printEditDepth, bool doEdits, bool intPalette, bool hexPalette)
+	{
+		if (count == 1)//Nothing to gain from threads.
+		{
+			const string& s = ToBuffer(*embers, extraAttributes, printEditDepth, doEdits, intPalette, hexPalette);
+			os.write(s.data(), s.size());
+		}
+		else
+		{
+			for (size_t start = 0; start < count; start += EMBER_XML_BATCH_SIZE)
+			{
+				size_t batchSize = std::min<size_t>(EMBER_XML_BATCH_SIZE, count - start);
+
+				if (m_Bufs.size() < batchSize)
+					m_Bufs.resize(batchSize);
+
+				xmlInitParser();//Must be called once before using libxml2 from multiple threads, since Append() reads the edit docs.
+				parallel_for(size_t(0), batchSize, [&](size_t i)
+				{
+					m_Bufs[i].clear();
+					m_Bufs[i].reserve(EMBER_XML_RESERVE);
+					Append(embers[start + i], extraAttributes, printEditDepth, doEdits, intPalette, hexPalette, m_Bufs[i]);
+				});
+
+				for (size_t i = 0; i < batchSize; i++)
+					os.write(m_Bufs[i].data(), m_Bufs[i].size());
+			}
+		}
+
+		return os.good();
+	}
+
+	/// <summary>
+	/// Append the Xml string representation of an xform.
 	/// </summary>
 	/// <param name="xform">The xform to create the Xml with</param>
 	/// <param name="xformCount">The number of non-final xforms in the ember to which this xform belongs. Used for xaos.</param>
 	/// <param name="isFinal">True if the xform is the final xform in the ember, else false.</param>
 	/// <param name="doMotion">If true, include motion elements in the Xml string, else omit.</param>
-	/// <returns>The Xml string representation of the passed in xform</returns>
-	string ToString(Xform<T>& xform, size_t xformCount, bool isFinal, bool doMotion)
+	/// <param name="os">The writer to append to</param>
+	void Append(Xform<T>& xform, size_t xformCount, bool isFinal, bool doMotion, StringWriter& os)
 	{
 		size_t i, j;
-		ostringstream os;
 
 		if (doMotion)
 		{
@@ -566,7 +704,7 @@ private:
 			os << ">\n";
 
 			for (i = 0; i < xform.m_Motion.size(); i++)
-				os << ToString(xform.m_Motion[i], 0, false, true);
+				Append(xform.m_Motion[i], 0, false, true, os);
 
 			if (isFinal)//Fixed to properly close final.//SMOULDER
 				os << "   </finalxform>\n";
@@ -575,19 +713,17 @@ private:
 		}
 		else
 			os << "/>\n";
-
-		return os.str();
 	}
 
 	/// <summary>
-	/// Return an edit node Xml string.
+	/// Append the Xml string of an edit node.
 	/// </summary>
 	/// <param name="editNode">The edit node to get the string for</param>
 	/// <param name="tabs">How many tabs to use</param>
 	/// <param name="formatting">If true, include newlines and tabs, else don't.</param>
 	/// <param name="printEditDepth">How deep the edit depth goes</param>
-	/// <returns>The edit node Xml string</returns>
-	string ToString(xmlNodePtr editNode, size_t tabs, bool formatting, size_t printEditDepth)
+	/// <param name="os">The writer to append to</param>
+	void Append(xmlNodePtr editNode, size_t tabs, bool formatting, size_t printEditDepth, StringWriter& os)
 	{
 		bool indentPrinted = false;
 		const char* tabString = "   ", *attStr;
@@ -596,10 +732,9 @@ private:
 		size_t ti;//, editOrSheep = 0;
 		xmlAttrPtr attPtr = nullptr, curAtt = nullptr;
 		xmlNodePtr childPtr = nullptr, curChild = nullptr;
-		ostringstream os;
 
 		if (printEditDepth > 0 && tabs > printEditDepth)
-			return "";
+			return;
 
 		//If this node is an XML_ELEMENT_NODE, print it and its attributes.
 		if (editNode->type == XML_ELEMENT_NODE)
@@ -668,7 +803,7 @@ private:
 							os << "\n";
 						}
 
-						os << ToString(curChild, tabs, true, printEditDepth);
+						Append(curChild, tabs, true, printEditDepth, os);
 					}
 					else
 					{
@@ -685,7 +820,7 @@ private:
 						}
 
 						//Print nodes without formatting.
-						os << ToString(curChild, tabs, false, printEditDepth);
+						Append(curChild, tabs, false, printEditDepth, os);
 					}
 				}
 
@@ -706,11 +841,14 @@ private:
 		}
 		else if (editNode->type == XML_TEXT_NODE)
 		{
-			string s(reinterpret_cast<char*>(xmlNodeGetContent(editNode)));
-			os << Trim(s);
-		}
+			xmlChar* content = xmlNodeGetContent(editNode);
 
-		return os.str();
+			if (content)
+			{
+				os << Trim(string(CX(content)));
+				xmlFree(content);
+			}
+		}
 	}
 
 	void AddFilenameWithoutAmpersand(xmlNodePtr node, string& filename)
@@ -727,5 +865,8 @@ private:
 			xmlNewProp(node, XC("filename"), XC(filename.c_str()));
 		}
 	}
+
+	string m_Buf;//Reused by ToBuffer().
+	vector<string> m_Bufs;//Reused by Write(), one per ember in a batch.
 };
 }
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "DensityFilter.h"
+#include "TemporalFilter.h"
+#include "Timing.h"
+
+/// <summary>
+/// FilterCache class.
+/// </summary>
+
+namespace EmberNs
+{
+#define FILTER_CACHE_SIZE 16//Default number of filters of each kind kept alive after their last use.
+
+/// <summary>
+/// Process wide cache of density, spatial and temporal filters.
+/// Building a filter means evaluating its kernel for every cell, which for the density filter
+/// is done for every radius between the min and max. Every renderer used to build its own
+/// copy whenever the parameters changed, so an animation whose frames alternate between a few
+/// settings, or several renderers working on the same flame, kept rebuilding identical filters.
+/// Here, each filter is created once per unique set of parameters and handed out as a shared
+/// pointer. Filters are never modified after Create() has been called on them, so they can be
+/// read by any number of renderers and threads at once without locking.
+/// Each kind is kept in its own list ordered from most to least recently used. When a list
+/// grows past the capacity, the least recently used entry is dropped from the cache, however
+/// the filter itself lives on until the last renderer using it lets go of it.
+/// Lookups are keyed on the parameters requested, not the ones the filter may have adjusted
+/// internally, so a request with the same parameters always finds the same filter.
+/// The lists are static, one set per precision, so that renderers which know nothing of each other,
+/// such as one per OpenCL device in EmberAnimate or those leased from a RendererPool, still share
+/// filters. They are only touched while holding a single critical section.
+/// Template argument expected to be float or double.
+/// </summary>
+template <typename T>
+class EMBER_API FilterCache
+{
+public:
+	/// <summary>
+	/// Get a density filter with the specified parameters, creating it if it's not in the cache.
+	/// </summary>
+	/// <param name="minRad">The minimum filter radius</param>
+	/// <param name="maxRad">The maximum filter radius</param>
+	/// <param name="curve">The curve of the filter</param>
+	/// <param name="supersample">The supersample of the ember the filter will be used with</param>
+	/// <returns>The filter if successful, else nullptr if filter creation failed.</returns>
+	static shared_ptr<DensityFilter<T>> GetDensityFilter(T minRad, T maxRad, T curve, size_t supersample)
+	{
+		return Find(m_DensityFilters, std::make_tuple(minRad, maxRad, curve, supersample), [&]() -> DensityFilter<T>*
+		{
+			unique_ptr<DensityFilter<T>> filter(new DensityFilter<T>(minRad, maxRad, curve, supersample));
+			return filter->Create() ? filter.release() : nullptr;
+		});
+	}
+
+	/// <summary>
+	/// Get a spatial filter with the specified parameters, creating it if it's not in the cache.
+	/// </summary>
+	/// <param name="filterType">The type of filter to create</param>
+	/// <param name="filterRadius">The filter radius</param>
+	/// <param name="superSample">The supersample value of the ember using the filter</param>
+	/// <param name="pixelAspectRatio">The aspect ratio of the ember using the filter</param>
+	/// <returns>The filter</returns>
+	static shared_ptr<SpatialFilter<T>> GetSpatialFilter(eSpatialFilterType filterType, T filterRadius, size_t superSample, T pixelAspectRatio)
+	{
+		return Find(m_SpatialFilters, std::make_tuple(filterType, filterRadius, superSample, pixelAspectRatio), [&]()
+		{
+			return SpatialFilterCreator<T>::Create(filterType, filterRadius, superSample, pixelAspectRatio);
+		});
+	}
+
+	/// <summary>
+	/// Get a temporal filter with the specified parameters, creating it if it's not in the cache.
+	/// </summary>
+	/// <param name="filterType">The type of filter to create</param>
+	/// <param name="temporalSamples">The number of temporal samples in the ember being rendered</param>
+	/// <param name="filterWidth">The width of the filter</param>
+	/// <param name="filterExp">The filter exponent, only used with Exp filter, otherwise ignored.</param>
+	/// <returns>The filter</returns>
+	static shared_ptr<TemporalFilter<T>> GetTemporalFilter(eTemporalFilterType filterType, size_t temporalSamples, T filterWidth, T filterExp)
+	{
+		return Find(m_TemporalFilters, std::make_tuple(filterType, temporalSamples, filterWidth, filterExp), [&]()
+		{
+			return TemporalFilterCreator<T>::Create(filterType, temporalSamples, filterWidth, filterExp);
+		});
+	}
+
+	/// <summary>
+	/// Get the number of filters of each kind kept in the cache.
+	/// </summary>
+	/// <returns>The capacity</returns>
+	static size_t Capacity() { return m_Capacity; }
+
+	/// <summary>
+	/// Set the number of filters of each kind kept in the cache.
+	/// Entries beyond the new capacity are dropped immediately.
+	/// </summary>
+	/// <param name="capacity">The capacity, 0 to disable caching.</param>
+	static void Capacity(size_t capacity)
+	{
+		m_Cs.Enter();
+		m_Capacity = capacity;
+		Trim(m_DensityFilters);
+		Trim(m_SpatialFilters);
+		Trim(m_TemporalFilters);
+		m_Cs.Leave();
+	}
+
+	/// <summary>
+	/// Drop all entries from the cache.
+	/// Filters still in use by renderers are not affected.
+	/// </summary>
+	static void Clear()
+	{
+		m_Cs.Enter();
+		m_DensityFilters.clear();
+		m_SpatialFilters.clear();
+		m_TemporalFilters.clear();
+		m_Cs.Leave();
+	}
+
+	/// <summary>
+	/// Get the number of lookups which were satisfied from the cache.
+	/// </summary>
+	/// <returns>The number of hits</returns>
+	static size_t Hits() { return m_Hits; }
+
+	/// <summary>
+	/// Get the number of lookups which had to create a new filter.
+	/// </summary>
+	/// <returns>The number of misses</returns>
+	static size_t Misses() { return m_Misses; }
+
+	typedef std::tuple<T, T, T, size_t> DensityKey;
+	typedef std::tuple<eSpatialFilterType, T, size_t, T> SpatialKey;
+	typedef std::tuple<eTemporalFilterType, size_t, T, T> TemporalKey;
+
+private:
+	/// <summary>
+	/// Find the filter with the specified key in a list, moving it to the front, or create it
+	/// and insert it at the front if it's not there.
+	/// Filters are created outside of the lock so lookups of other filters are not held up.
+	/// If another thread created the same filter in the meantime, its instance is used instead
+	/// so that there is only ever one per key.
+	/// </summary>
+	/// <param name="cache">The list to search</param>
+	/// <param name="key">The parameters of the filter</param>
+	/// <param name="create">Function which creates the filter, returning nullptr on failure</param>
+	/// <returns>The filter if found or successfully created, else nullptr.</returns>
+	template <typename filterT, typename keyT, typename createT>
+	static shared_ptr<filterT> Find(list<pair<keyT, shared_ptr<filterT>>>& cache, const keyT& key, createT create)
+	{
+		shared_ptr<filterT> filter;
+
+		m_Cs.Enter();
+
+		if (MoveToFront(cache, key))
+		{
+			filter = cache.front().second;
+			m_Hits++;
+		}
+
+		m_Cs.Leave();
+
+		if (!filter)
+		{
+			filter = shared_ptr<filterT>(create());
+
+			if (filter)
+			{
+				m_Cs.Enter();
+
+				if (MoveToFront(cache, key))
+					filter = cache.front().second;
+				else
+					cache.push_front(make_pair(key, filter));
+
+				m_Misses++;
+				Trim(cache);
+				m_Cs.Leave();
+			}
+		}
+
+		return filter;
+	}
+
+	/// <summary>
+	/// Move the entry with the specified key to the front of a list.
+	/// The caller must hold the lock.
+	/// </summary>
+	/// <param name="cache">The list to search</param>
+	/// <param name="key">The key to search for</param>
+	/// <returns>True if found, else false.</returns>
+	template <typename filterT, typename keyT>
+	static bool MoveToFront(list<pair<keyT, shared_ptr<filterT>>>& cache, const keyT& key)
+	{
+		for (auto it = cache.begin(); it != cache.end(); ++it)
+		{
+			if (it->first == key)
+			{
+				cache.splice(cache.begin(), cache, it);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Drop the least recently used entries of a list until it's within the capacity.
+	/// The caller must hold the lock.
+	/// </summary>
+	/// <param name="cache">The list to trim</param>
+	template <typename entryT>
+	static void Trim(list<entryT>& cache)
+	{
+		while (cache.size() > m_Capacity)
+			cache.pop_back();
+	}
+
+	static list<pair<DensityKey, shared_ptr<DensityFilter<T>>>> m_DensityFilters;//Most recently used first.
+	static list<pair<SpatialKey, shared_ptr<SpatialFilter<T>>>> m_SpatialFilters;
+	static list<pair<TemporalKey, shared_ptr<TemporalFilter<T>>>> m_TemporalFilters;
+	static size_t m_Capacity;//The maximum number of entries in each list.
+	static size_t m_Hits;//Guarded by m_Cs.
+	static size_t m_Misses;
+	static CriticalSection m_Cs;//Protects the lists and counters, but not the filters, which are immutable.
+};
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "EmberDefines.h"
+
+/// <summary>
+/// HugePages and HugePageAllocator classes.
+/// </summary>
+
+namespace EmberNs
+{
+#define HUGE_PAGE_SIZE (size_t(2) * 1024 * 1024)
+#define GIANT_PAGE_SIZE (size_t(1024) * 1024 * 1024)
+#define HUGE_PAGE_HEADER 64//Bytes in front of each block which record how it was allocated. Keeps the block cache line aligned.
+
+/// <summary>
+/// Allocates large buffers with huge pages according to a process wide policy.
+/// Buffers such as the histogram are written to at random locations, so when they are
+/// backed by regular 4KB pages, nearly every write misses the TLB. Backing them with
+/// 2MB or 1GB pages removes most of those misses.
+/// Allocations smaller than a huge page are never affected. Larger ones are handled according to the policy:
+///		HUGE_PAGES_NONE: Regular allocation with operator new.
+///		HUGE_PAGES_TRANSPARENT: Anonymous memory map advised to use transparent huge pages with madvise(MADV_HUGEPAGE). Linux only.
+///		HUGE_PAGES_EXPLICIT: Reserved huge pages with mmap(MAP_HUGETLB), trying 1GB then 2MB pages, on Windows large pages with VirtualAlloc(MEM_LARGE_PAGES).
+/// Each method falls back to the one below it when it fails, which is common for explicit huge pages since
+/// they must be reserved by the administrator beforehand, and ends with regular allocation. So the only
+/// thing a caller can ever observe is the speed.
+/// The policy and byte counts are static. The policy is chosen once by the program, from the command
+/// line or its settings, and applies to the buffers of every renderer, and the counts total the huge
+/// page memory of the whole process.
+/// </summary>
+class EMBER_API HugePages
+{
+public:
+	/// <summary>
+	/// Get the huge page policy used for subsequent allocations.
+	/// </summary>
+	/// <returns>The policy</returns>
+	static eHugePagePolicy Policy() { return m_Policy; }
+
+	/// <summary>
+	/// Set the huge page policy used for subsequent allocations.
+	/// Existing allocations are not affected.
+	/// </summary>
+	/// <param name="policy">The policy</param>
+	static void Policy(eHugePagePolicy policy) { m_Policy = policy; }
+
+	/// <summary>
+	/// Get the number of bytes currently allocated with explicit huge or large pages.
+	/// </summary>
+	/// <returns>The number of bytes</returns>
+	static size_t ExplicitBytes() { return m_ExplicitBytes; }
+
+	/// <summary>
+	/// Get the number of bytes currently allocated with memory maps advised to use transparent huge pages.
+	/// Whether the kernel actually backed them with huge pages can't be known here.
+	/// </summary>
+	/// <returns>The number of bytes</returns>
+	static size_t TransparentBytes() { return m_TransparentBytes; }
+
+	/// <summary>
+	/// Allocate a block of memory according to the current policy.
+	/// </summary>
+	/// <param name="bytes">The number of bytes to allocate</param>
+	/// <returns>The block, which is aligned to at least 16 bytes. Throws bad_alloc if all methods failed.</returns>
+	static void* Allocate(size_t bytes)
+	{
+		size_t total = bytes + HUGE_PAGE_HEADER;
+		size_t length = total;
+		size_t kind = ALLOC_NEW;
+		byte* block = nullptr;
+
+		if (m_Policy != HUGE_PAGES_NONE && bytes >= HUGE_PAGE_SIZE)
+		{
+#if defined(_WIN32)
+			size_t largePage = GetLargePageMinimum();
+
+			if (m_Policy == HUGE_PAGES_EXPLICIT && largePage)
+			{
+				length = RoundUp(total, largePage);
+
+				if ((block = static_cast<byte*>(VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))))
+					kind = ALLOC_LARGE;
+			}
+#elif !defined(__APPLE__)
+#ifdef MAP_HUGETLB
+			if (m_Policy == HUGE_PAGES_EXPLICIT)
+			{
+#ifdef MAP_HUGE_1GB
+				if (bytes >= GIANT_PAGE_SIZE)
+					block = Map(length = RoundUp(total, GIANT_PAGE_SIZE), MAP_HUGETLB | MAP_HUGE_1GB);
+#endif
+				if (!block)
+					block = Map(length = RoundUp(total, HUGE_PAGE_SIZE), MAP_HUGETLB);
+
+				if (block)
+					kind = ALLOC_EXPLICIT_MAP;
+			}
+#endif
+			if (!block && (block = MapAligned(length = RoundUp(total, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE)))
+			{
+#ifdef MADV_HUGEPAGE
+				madvise(block, length, MADV_HUGEPAGE);//Only advice, failure just means regular pages.
+#endif
+				kind = ALLOC_TRANSPARENT_MAP;
+			}
+#endif
+		}
+
+		if (!block)
+		{
+			block = static_cast<byte*>(::operator new(total));
+			length = total;
+			kind = ALLOC_NEW;
+		}
+
+		if (kind == ALLOC_LARGE || kind == ALLOC_EXPLICIT_MAP)
+			m_ExplicitBytes += length;
+		else if (kind == ALLOC_TRANSPARENT_MAP)
+			m_TransparentBytes += length;
+
+		reinterpret_cast<size_t*>(block)[0] = length;
+		reinterpret_cast<size_t*>(block)[1] = kind;
+		return block + HUGE_PAGE_HEADER;
+	}
+
+	/// <summary>
+	/// Free a block which was returned by Allocate().
+	/// </summary>
+	/// <param name="p">The block to free, ignored if nullptr.</param>
+	static void Free(void* p)
+	{
+		if (!p)
+			return;
+
+		byte* block = static_cast<byte*>(p) - HUGE_PAGE_HEADER;
+		size_t length = reinterpret_cast<size_t*>(block)[0];
+		size_t kind = reinterpret_cast<size_t*>(block)[1];
+
+		switch (kind)
+		{
+#if defined(_WIN32)
+			case ALLOC_LARGE:
+				m_ExplicitBytes -= length;
+				VirtualFree(block, 0, MEM_RELEASE);
+				break;
+#elif !defined(__APPLE__)
+			case ALLOC_EXPLICIT_MAP:
+				m_ExplicitBytes -= length;
+				munmap(block, length);
+				break;
+			case ALLOC_TRANSPARENT_MAP:
+				m_TransparentBytes -= length;
+				munmap(block, length);
+				break;
+#endif
+			default:
+				::operator delete(block);
+				break;
+		}
+	}
+
+	/// <summary>
+	/// Clear part of a block which was returned by Allocate() to all zeroes by giving its pages back
+	/// to the OS, which replaces them with fresh zero pages when they are next touched.
+	/// This is nearly free for the caller, and the cost of zeroing is moved to the page faults of
+	/// whichever threads touch the pages next, which will place them on their own NUMA node.
+	/// Only blocks mapped with transparent huge pages can be cleared this way, since explicit huge
+	/// pages would be returned to the reserved pool and regular allocations can't be given back.
+	/// The huge pages at the unaligned ends of the range are cleared with memset() so that the
+	/// rest of the range remains made of whole huge pages.
+	/// </summary>
+	/// <param name="p">A block which was returned by Allocate()</param>
+	/// <param name="bytes">The number of bytes from the start of the block to clear</param>
+	/// <returns>True if the range was cleared, else false if it could not be and the caller must clear it some other way.</returns>
+	static bool Discard(void* p, size_t bytes)
+	{
+#if !defined(_WIN32) && !defined(__APPLE__) && defined(MADV_DONTNEED)
+		if (!p)
+			return false;
+
+		byte* block = static_cast<byte*>(p) - HUGE_PAGE_HEADER;
+		byte* start = static_cast<byte*>(p);
+		byte* end = start + bytes;
+		byte* alignedStart = reinterpret_cast<byte*>(RoundUp(reinterpret_cast<size_t>(start), HUGE_PAGE_SIZE));
+		byte* alignedEnd = reinterpret_cast<byte*>(reinterpret_cast<size_t>(end) & ~(HUGE_PAGE_SIZE - 1));
+
+		if (reinterpret_cast<size_t*>(block)[1] != ALLOC_TRANSPARENT_MAP || alignedEnd <= alignedStart)
+			return false;
+
+		if (madvise(alignedStart, alignedEnd - alignedStart, MADV_DONTNEED))
+			return false;
+
+		memset(start, 0, alignedStart - start);
+		memset(alignedEnd, 0, end - alignedEnd);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+private:
+	enum eAllocKind : size_t { ALLOC_NEW = 0, ALLOC_TRANSPARENT_MAP = 1, ALLOC_EXPLICIT_MAP = 2, ALLOC_LARGE = 3 };
+
+	/// <summary>
+	/// Round a size up to a multiple of a page size.
+	/// </summary>
+	/// <param name="size">The size to round</param>
+	/// <param name="page">The page size, which must be a power of two.</param>
+	/// <returns>The rounded size</returns>
+	static size_t RoundUp(size_t size, size_t page) { return (size + page - 1) & ~(page - 1); }
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+	/// <summary>
+	/// Create a private anonymous memory map.
+	/// </summary>
+	/// <param name="length">The length of the map in bytes</param>
+	/// <param name="flags">Flags in addition to MAP_PRIVATE | MAP_ANONYMOUS</param>
+	/// <returns>The map if successful, else nullptr.</returns>
+	static byte* Map(size_t length, int flags)
+	{
+		void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+		return p == MAP_FAILED ? nullptr : static_cast<byte*>(p);
+	}
+
+	/// <summary>
+	/// Create a private anonymous memory map whose start is aligned to the specified boundary.
+	/// mmap() only guarantees regular page alignment, and transparent huge pages can only back the
+	/// parts of a map which cover whole aligned huge pages, so an unaligned map would lose one at each end.
+	/// The map is made larger by the alignment, then the unaligned head and the leftover tail are unmapped,
+	/// so the result can be freed with munmap() like any other map of the same length.
+	/// </summary>
+	/// <param name="length">The length of the map in bytes</param>
+	/// <param name="alignment">The alignment of the start of the map, which must be a power of two.</param>
+	/// <returns>The aligned map if successful, else nullptr.</returns>
+	static byte* MapAligned(size_t length, size_t alignment)
+	{
+		byte* p = Map(length + alignment, 0);
+
+		if (!p)
+			return nullptr;
+
+		byte* aligned = reinterpret_cast<byte*>(RoundUp(reinterpret_cast<size_t>(p), alignment));
+		size_t head = aligned - p;
+		size_t tail = alignment - head;
+
+		if (head)
+			munmap(p, head);
+
+		if (tail)
+			munmap(aligned + length, tail);
+
+		return aligned;
+	}
+#endif
+
+	static eHugePagePolicy m_Policy;//The policy used for allocations.
+	static std::atomic<size_t> m_ExplicitBytes;//Bytes currently allocated with explicit huge pages. Atomic because buffers are allocated in parallel.
+	static std::atomic<size_t> m_TransparentBytes;//Bytes currently allocated with maps advised to use transparent huge pages.
+};
+
+/// <summary>
+/// Standard allocator which gets its memory from HugePages.
+/// Meant for the large buffers of the renderer, such as the histogram, accumulator and samples.
+/// All instances are interchangeable because the policy is process wide.
+/// </summary>
+template <typename T>
+class HugePageAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef HugePageAllocator<U> other;
+	};
+
+	HugePageAllocator() { }
+	template <typename U> HugePageAllocator(const HugePageAllocator<U>&) { }
+
+	/// <summary>
+	/// Allocate storage for n elements.
+	/// </summary>
+	/// <param name="n">The number of elements</param>
+	/// <returns>Pointer to the uninitialized storage</returns>
+	T* allocate(size_t n, const void* = nullptr) { return static_cast<T*>(HugePages::Allocate(n * sizeof(T))); }
+
+	/// <summary>
+	/// Free storage returned by allocate().
+	/// </summary>
+	/// <param name="p">The storage to free</param>
+	void deallocate(T* p, size_t) { HugePages::Free(p); }
+
+	size_t max_size() const { return size_t(-1) / sizeof(T); }
+	template <typename U, typename... Args> void construct(U* p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+	template <typename U> void destroy(U* p) { p->~U(); }
+	bool operator == (const HugePageAllocator&) const { return true; }
+	bool operator != (const HugePageAllocator&) const { return false; }
+};
+}
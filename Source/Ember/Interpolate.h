@@ -13,6 +13,19 @@ namespace EmberNs
 /// </summary>
 template <typename T> class Ember;
 
+/// <summary>
+/// A keyframe segment whose embers have already been aligned for interpolation.
+/// Linear segments hold 2 embers, smooth segments hold the 4 needed for Catmull-Rom.
+/// </summary>
+template <typename T>
+struct InterpSegment
+{
+	size_t m_Index;//The index of the first source ember of the segment, or -1 if this entry is unused.
+	size_t m_Count;//The number of aligned embers, 2 or 4.
+	size_t m_LastUse;//Used to determine which entry to evict.
+	Ember<T> m_Embers[4];
+};
+
 /// <summary>
 /// Contains many static functions for handling interpolation and other miscellaneous operations on
 /// embers and vectors of embers. This class is similar to, and used in conjunction with SheepTools.
@@ -22,6 +35,16 @@ template <typename T>
 class EMBER_API Interpolater
 {
 public:
+	/// <summary>
+	/// Default constructor which starts with an empty segment cache.
+	/// An instance is only needed to use InterpolateCached(), all other functions are static.
+	/// </summary>
+	Interpolater()
+	{
+		m_Coefs.resize(2);
+		ClearCache();
+	}
+
 	/// <summary>
 	/// Aligns the specified array of embers and stores in the output array.
 	/// This is used to prepare embers before interpolating them.
@@ -394,70 +417,146 @@ public:
 		size_t i1, i2;
 		vector<T> c(2);
 		Ember<T> localEmbers[4];
-		bool smoothFlag = false;
+		bool smoothFlag = FindSegment(embers, size, time, i1, i2);
 
-		if (embers[0].m_Time >= time)
-		{
-			i1 = 0;
-			i2 = 1;
-		}
-		else if (embers[size - 1].m_Time <= time)
-		{
-			i1 = size - 2;
-			i2 = size - 1;
-		}
+		//To interpolate the xforms, make copies of the source embers
+		//and ensure that they both have the same number of xforms before progressing.
+		if (smoothFlag)
+			Align(&embers[i1 - 1], &localEmbers[0], 4);
 		else
-		{
-			i1 = 0;
+			Align(&embers[i1], &localEmbers[0], 2);
 
-			while (embers[i1].m_Time < time)
-				i1++;
+		InterpolateSegment(embers, i1, i2, time, stagger, smoothFlag, &localEmbers[0], c, result);
+	}
 
-			i1--;
-			i2 = i1 + 1;
+	/// <summary>
+	/// Thin wrapper around InterpolateCached().
+	/// </summary>
+	/// <param name="embers">The vector of embers to interpolate</param>
+	/// <param name="time">The time position in the vector specifying the point of interpolation</param>
+	/// <param name="stagger">Stagger if > 0</param>
+	/// <param name="result">The interpolated result</param>
+	void InterpolateCached(vector<Ember<T>>& embers, T time, T stagger, Ember<T>& result)
+	{
+		InterpolateCached(embers.data(), embers.size(), time, stagger, result);
+	}
+
+	/// <summary>
+	/// Same as Interpolate(), but keep the aligned embers of the most recently used keyframe segments
+	/// around so they don't have to be deep copied and aligned again on every call.
+	/// This is intended for rendering animations, where many consecutive frames and temporal samples
+	/// fall within the same segment.
+	/// The cache is automatically cleared if a different array of embers is passed in. If the contents of
+	/// the same array are modified, the caller must call ClearCache() before calling this again.
+	/// </summary>
+	/// <param name="embers">The embers array</param>
+	/// <param name="size">The size of the embers array</param>
+	/// <param name="time">The time position in the vector specifying the point of interpolation</param>
+	/// <param name="stagger">Stagger if > 0</param>
+	/// <param name="result">The interpolated result</param>
+	void InterpolateCached(Ember<T>* embers, size_t size, T time, T stagger, Ember<T>& result)
+	{
+		if (size == 1)
+		{
+			result = embers[0];//Deep copy.
+			return;
 		}
 
-		c[0] = (embers[i2].m_Time - time) / (embers[i2].m_Time - embers[i1].m_Time);
-		c[1] = 1 - c[0];
+		size_t i1, i2;
+		bool smoothFlag = FindSegment(embers, size, time, i1, i2);
+		size_t start = smoothFlag ? i1 - 1 : i1;
+		size_t count = smoothFlag ? 4 : 2;
+		InterpSegment<T>* segment = nullptr;
 
-		//To interpolate the xforms, make copies of the source embers
-		//and ensure that they both have the same number of xforms before progressing.
-		if (embers[i1].m_Interp == EMBER_INTERP_LINEAR)
+		if (embers != m_CacheSource || size != m_CacheSize)
 		{
-			Align(&embers[i1], &localEmbers[0], 2);
-			smoothFlag = false;
+			ClearCache();
+			m_CacheSource = embers;
+			m_CacheSize = size;
 		}
-		else
+
+		m_CacheCounter++;
+
+		for (auto& seg : m_Segments)
 		{
-			if (i1 == 0)
+			if (seg.m_Index == start && seg.m_Count == count)
 			{
-				//fprintf(stderr, "error: cannot use smooth interpolation on first segment.\n");
-				//fprintf(stderr, "reverting to linear interpolation.\n");
-				Align(&embers[i1], &localEmbers[0], 2);
-				smoothFlag = false;
+				segment = &seg;
+				break;
 			}
+		}
 
-			if (i2 == size - 1)
-			{
-				//fprintf(stderr, "error: cannot use smooth interpolation on last segment.\n");
-				//fprintf(stderr, "reverting to linear interpolation.\n");
-				Align(&embers[i1], &localEmbers[0], 2);
-				smoothFlag = false;
-			}
+		if (!segment)
+		{
+			//Not found, so overwrite whichever entry was used least recently.
+			segment = &m_Segments[0];
+
+			for (auto& seg : m_Segments)
+				if (seg.m_LastUse < segment->m_LastUse)
+					segment = &seg;
 
-			Align(&embers[i1 - 1], &localEmbers[0], 4);//Should really be doing some sort of checking here to ensure the ember vectors have 4 elements.
-			smoothFlag = true;
+			Align(&embers[start], &segment->m_Embers[0], count);
+			segment->m_Index = start;
+			segment->m_Count = count;
 		}
 
-		result.m_Time = time;
-		result.m_Interp = EMBER_INTERP_LINEAR;
-		result.m_AffineInterp = embers[0].m_AffineInterp;
-		result.m_PaletteInterp = INTERP_HSV;
+		segment->m_LastUse = m_CacheCounter;
+		InterpolateSegment(embers, i1, i2, time, stagger, smoothFlag, &segment->m_Embers[0], m_Coefs, result);
+	}
 
-		if (!smoothFlag)
-			result.Interpolate(&localEmbers[0], 2, c, stagger);
+	/// <summary>
+	/// Clear the aligned segments stored by InterpolateCached().
+	/// This must be called if the contents of the embers array passed to it have changed.
+	/// </summary>
+	void ClearCache()
+	{
+		m_CacheSource = nullptr;
+		m_CacheSize = 0;
+		m_CacheCounter = 0;
+
+		for (auto& seg : m_Segments)
+		{
+			seg.m_Index = size_t(-1);
+			seg.m_Count = 0;
+			seg.m_LastUse = 0;
+
+			for (auto& ember : seg.m_Embers)
+				ember.Clear();
+		}
+	}
+
+	/// <summary>
+	/// Find the pair of keyframes which surround the specified time using a binary search.
+	/// The embers array is expected to be sorted by time and contain at least 2 elements.
+	/// Times before the first or after the last ember use the first or last segment respectively.
+	/// </summary>
+	/// <param name="embers">The embers array</param>
+	/// <param name="size">The size of the embers array</param>
+	/// <param name="time">The time position in the array specifying the point of interpolation</param>
+	/// <param name="i1">Storage for the index of the ember at the start of the segment</param>
+	/// <param name="i2">Storage for the index of the ember at the end of the segment</param>
+	/// <returns>True if smooth interpolation can be used for this segment, else false for linear.</returns>
+	static bool FindSegment(Ember<T>* embers, size_t size, T time, size_t& i1, size_t& i2)
+	{
+		if (embers[0].m_Time >= time)
+		{
+			i1 = 0;
+			i2 = 1;
+		}
+		else if (embers[size - 1].m_Time <= time)
+		{
+			i1 = size - 2;
+			i2 = size - 1;
+		}
 		else
-			result.InterpolateCatmullRom(&localEmbers[0], 4, c[1]);
+		{
+			i2 = std::lower_bound(embers, embers + size, time, [&](const Ember<T>& ember, T t) -> bool { return ember.m_Time < t; }) - embers;
+			i1 = i2 - 1;
+		}
+
+		//Smooth interpolation cannot be used on the first or last segment because
+		//it requires a neighbor on each side, so revert to linear interpolation for those.
+		return embers[i1].m_Interp != EMBER_INTERP_LINEAR && i1 > 0 && i2 < size - 1;
 	}
 
 	/// <summary>
@@ -1018,5 +1117,40 @@ public:
 
 		return ad > bd;
 	}
+
+private:
+	/// <summary>
+	/// Interpolate a segment whose embers have already been aligned and store the result.
+	/// </summary>
+	/// <param name="embers">The source embers array, used for retrieving the times of the segment</param>
+	/// <param name="i1">The index of the ember at the start of the segment</param>
+	/// <param name="i2">The index of the ember at the end of the segment</param>
+	/// <param name="time">The time position in the array specifying the point of interpolation</param>
+	/// <param name="stagger">Stagger if > 0</param>
+	/// <param name="smoothFlag">True to use Catmull-Rom interpolation on 4 aligned embers, else linear on 2.</param>
+	/// <param name="alignedEmbers">The aligned embers, 4 if smoothFlag is true, else 2</param>
+	/// <param name="c">The 2 element coefficient vector to use</param>
+	/// <param name="result">The interpolated result</param>
+	static void InterpolateSegment(Ember<T>* embers, size_t i1, size_t i2, T time, T stagger, bool smoothFlag, Ember<T>* alignedEmbers, vector<T>& c, Ember<T>& result)
+	{
+		c[0] = (embers[i2].m_Time - time) / (embers[i2].m_Time - embers[i1].m_Time);
+		c[1] = 1 - c[0];
+
+		result.m_Time = time;
+		result.m_Interp = EMBER_INTERP_LINEAR;
+		result.m_AffineInterp = embers[0].m_AffineInterp;
+		result.m_PaletteInterp = INTERP_HSV;
+
+		if (!smoothFlag)
+			result.Interpolate(alignedEmbers, 2, c, stagger);
+		else
+			result.InterpolateCatmullRom(alignedEmbers, 4, c[1]);
+	}
+
+	vector<T> m_Coefs;
+	Ember<T>* m_CacheSource;
+	size_t m_CacheSize;
+	size_t m_CacheCounter;
+	InterpSegment<T> m_Segments[2];//Two is enough to cover temporal samples which straddle a keyframe.
 };
 }
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Ember.h"
+
+/// <summary>
+/// XformProfile struct and IterProfile class.
+/// </summary>
+
+namespace EmberNs
+{
+#define ITER_PROFILE_SAMPLE_MASK 4095//The cost of the variations of an xform is sampled once every 4096 times it's applied.
+
+/// <summary>
+/// The counters kept for a single xform while profiling iteration.
+/// </summary>
+struct EMBER_API XformProfile
+{
+	/// <summary>
+	/// Constructor which zeroes all counters.
+	/// </summary>
+	XformProfile()
+		: m_Selections(0), m_BadVals(0), m_Samples(0)
+	{
+	}
+
+	size_t m_Selections;//The number of times the xform was applied, including retries after bad values.
+	size_t m_BadVals;//The number of times applying the xform produced a bad value.
+	size_t m_Samples;//The number of applications whose variation costs were sampled.
+	vector<uint64_t> m_VarCycles;//The cycles spent in Func() of each variation summed over all samples, in the order of Xform::GetVariation().
+};
+
+/// <summary>
+/// Profiling counters for iterating an ember, which are only gathered when ITER_PROFILE is defined.
+/// Each rendering thread keeps its own instance, which is passed to the iterator in IterParams,
+/// and the renderer sums them once the threads are done.
+/// Xforms are counted every time they're applied, whether by the main iteration loop, by DoBadVals()
+/// when retrying after a bad value, or as the final xform, which is stored last.
+/// Timing every variation of every application would distort the very numbers being measured, so
+/// only one in every ITER_PROFILE_SAMPLE_MASK + 1 applications of an xform is timed. The cost reported
+/// includes reading the cycle counter, which is roughly 20-40 cycles on modern processors, so it's most
+/// useful for comparing variations against each other rather than as an absolute value.
+/// </summary>
+class EMBER_API IterProfile
+{
+public:
+	/// <summary>
+	/// Default constructor which zeroes all counters.
+	/// </summary>
+	IterProfile()
+	{
+		Clear();
+	}
+
+	/// <summary>
+	/// Return whether profiling was compiled in.
+	/// </summary>
+	/// <returns>True if ITER_PROFILE is defined, else false.</returns>
+	static bool Enabled()
+	{
+#ifdef ITER_PROFILE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/// <summary>
+	/// Clear all counters and size them to match the xforms and variations of an ember.
+	/// The ember must be the same one, unchanged, which is then iterated.
+	/// </summary>
+	/// <param name="ember">The ember to size the counters for</param>
+	template <typename T>
+	void Init(const Ember<T>& ember)
+	{
+		Clear();
+		m_Xforms.resize(ember.XformCount() + 1);
+
+		for (size_t i = 0; i < ember.XformCount(); i++)
+			m_Xforms[i].m_VarCycles.resize(ember.GetXform(i)->TotalVariationCount());
+
+		if (ember.UseFinalXform())
+			m_Xforms.back().m_VarCycles.resize(ember.FinalXform()->TotalVariationCount());
+	}
+
+	/// <summary>
+	/// Remove all counters.
+	/// </summary>
+	void Clear()
+	{
+		m_Xforms.clear();
+		m_Accumulated = 0;
+		m_OutOfBounds = 0;
+	}
+
+	/// <summary>
+	/// Return whether anything has been counted.
+	/// </summary>
+	/// <returns>True if nothing was counted, else false.</returns>
+	bool Empty() const { return m_Accumulated == 0 && m_Xforms.empty(); }
+
+	/// <summary>
+	/// Apply an xform, counting the selection and any bad value, and sampling the cost of its variations.
+	/// </summary>
+	/// <param name="xform">The xform to apply</param>
+	/// <param name="xformIndex">The index of the xform in the ember, or the xform count for the final xform</param>
+	/// <param name="inPoint">The input point</param>
+	/// <param name="outPoint">The output point</param>
+	/// <param name="rand">The random context to use</param>
+	/// <returns>True if a bad value was computed, else false.</returns>
+	template <typename T>
+	bool Apply(Xform<T>& xform, size_t xformIndex, Point<T>* inPoint, Point<T>* outPoint, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand)
+	{
+		bool bad;
+		XformProfile& prof = m_Xforms[xformIndex];
+
+		if ((prof.m_Selections++ & ITER_PROFILE_SAMPLE_MASK) == 0 && prof.m_VarCycles.size() == xform.TotalVariationCount())
+		{
+			bad = xform.ApplyProfiled(inPoint, outPoint, rand, prof.m_VarCycles.data());
+			prof.m_Samples++;
+		}
+		else
+			bad = xform.Apply(inPoint, outPoint, rand);
+
+		if (bad)
+			prof.m_BadVals++;
+
+		return bad;
+	}
+
+	/// <summary>
+	/// Add the counters of another profile to this one, which is used to combine the
+	/// profiles of all threads. Counters missing from this one are added.
+	/// </summary>
+	/// <param name="profile">The profile to add</param>
+	/// <returns>Reference to this</returns>
+	IterProfile& operator += (const IterProfile& profile)
+	{
+		if (m_Xforms.size() < profile.m_Xforms.size())
+			m_Xforms.resize(profile.m_Xforms.size());
+
+		for (size_t i = 0; i < profile.m_Xforms.size(); i++)
+		{
+			XformProfile& to = m_Xforms[i];
+			const XformProfile& from = profile.m_Xforms[i];
+
+			to.m_Selections += from.m_Selections;
+			to.m_BadVals += from.m_BadVals;
+			to.m_Samples += from.m_Samples;
+
+			if (to.m_VarCycles.size() < from.m_VarCycles.size())
+				to.m_VarCycles.resize(from.m_VarCycles.size());
+
+			for (size_t j = 0; j < from.m_VarCycles.size(); j++)
+				to.m_VarCycles[j] += from.m_VarCycles[j];
+		}
+
+		m_Accumulated += profile.m_Accumulated;
+		m_OutOfBounds += profile.m_OutOfBounds;
+		return *this;
+	}
+
+	/// <summary>
+	/// Return a human readable report of the counters, using the names from the ember which was iterated.
+	/// </summary>
+	/// <param name="ember">The ember the counters were gathered for</param>
+	/// <returns>The report, or an empty string if nothing was counted.</returns>
+	template <typename T>
+	string Report(const Ember<T>& ember) const
+	{
+		size_t total = 0;
+		ostringstream ss;
+
+		if (Empty())
+			return "";
+
+		for (auto& prof : m_Xforms)
+			total += prof.m_Selections;
+
+		ss << std::fixed << std::setprecision(2);
+		ss << "Iteration profile" << endl;
+		ss << "Points accumulated: " << m_Accumulated << ", out of bounds: " << m_OutOfBounds
+		   << " (" << (m_Accumulated ? 100.0 * m_OutOfBounds / m_Accumulated : 0.0) << "%)" << endl;
+
+		for (size_t i = 0; i < m_Xforms.size(); i++)
+		{
+			const XformProfile& prof = m_Xforms[i];
+			bool isFinal = i == m_Xforms.size() - 1;
+			const Xform<T>* xform = isFinal ? ember.FinalXform() : ember.GetXform(i);
+
+			if (!xform || prof.m_Selections == 0)
+				continue;
+
+			ss << (isFinal ? string("Final xform") : "Xform " + std::to_string(i + 1));
+
+			if (!xform->m_Name.empty())
+				ss << " (" << xform->m_Name << ")";
+
+			ss << ": selected " << prof.m_Selections << " (" << (total ? 100.0 * prof.m_Selections / total : 0.0) << "%), bad values "
+			   << prof.m_BadVals << " (" << 100.0 * prof.m_BadVals / prof.m_Selections << "%)" << endl;
+
+			if (prof.m_Samples)
+			{
+				for (size_t j = 0; j < prof.m_VarCycles.size() && j < xform->TotalVariationCount(); j++)
+					ss << "\t" << xform->GetVariation(j)->Name() << ": " << double(prof.m_VarCycles[j]) / prof.m_Samples << " cycles/call" << endl;
+			}
+		}
+
+		return ss.str();
+	}
+
+	vector<XformProfile> m_Xforms;//One per xform in the ember, plus one for the final xform which is always last.
+	size_t m_Accumulated;//The number of points passed to the histogram.
+	size_t m_OutOfBounds;//The number of points which fell outside of it.
+};
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Ember.h"
+#include "IterProfile.h"
 
 /// <summary>
 /// Iterator and derived classes.
@@ -13,6 +13,7 @@ namespace EmberNs
 {
 #define ITERATORUSINGS \
 	using Iterator<T>::NextXformFromIndex; \
+	using Iterator<T>::ApplyXform; \
 	using Iterator<T>::DoFinalXform; \
 	using Iterator<T>::DoBadVals;
 
@@ -23,6 +24,7 @@ struct IterParams
 {
 	size_t m_Count;
 	size_t m_Skip;
+	IterProfile* m_Profile;//The profile of the calling thread, only used if ITER_PROFILE is defined. nullptr to not profile.
 	//T m_OneColDiv2;
 	//T m_OneRowDiv2;
 };
@@ -191,8 +193,9 @@ protected:
 	/// <param name="badVals">The counter for the total number of bad values this sub batch</param>
 	/// <param name="point">The point which initially had the bad values and which will store the newly computed values</param>
 	/// <param name="rand">The random context this iterator is using</param>
+	/// <param name="profile">The profile to count the retries in, nullptr to not profile.</param>
 	/// <returns>True if a good value was computed within 5 tries, else false</returns>
-	inline bool DoBadVals(Xform<T>* xforms, size_t& badVals, Point<T>* point, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand)
+	inline bool DoBadVals(Xform<T>* xforms, size_t& badVals, Point<T>* point, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, IterProfile* profile)
 	{
 		size_t xformIndex, consec = 0;
 		Point<T> firstBadPoint;
@@ -209,7 +212,7 @@ protected:
 
 			xformIndex = NextXformFromIndex(rand.Rand());
 
-			if (!xforms[xformIndex].Apply(&firstBadPoint, point, rand))
+			if (!ApplyXform(xforms, xformIndex, &firstBadPoint, point, rand, profile))
 				return true;
 		}
 
@@ -224,6 +227,27 @@ protected:
 		return false;
 	}
 
+	/// <summary>
+	/// Apply an xform from the xforms array.
+	/// When ITER_PROFILE is defined and a profile is passed, the application is counted in it,
+	/// otherwise this is just a call to Xform::Apply().
+	/// </summary>
+	/// <param name="xforms">The xforms array</param>
+	/// <param name="xformIndex">The index of the xform to apply</param>
+	/// <param name="inPoint">The input point</param>
+	/// <param name="outPoint">The output point</param>
+	/// <param name="rand">The random context to use</param>
+	/// <param name="profile">The profile to count the application in, nullptr to not profile.</param>
+	/// <returns>True if a bad value was calculated, else false.</returns>
+	inline bool ApplyXform(Xform<T>* xforms, size_t xformIndex, Point<T>* inPoint, Point<T>* outPoint, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, IterProfile* profile)
+	{
+#ifdef ITER_PROFILE
+		if (profile)
+			return profile->Apply(xforms[xformIndex], xformIndex, inPoint, outPoint, rand);
+#endif
+		return xforms[xformIndex].Apply(inPoint, outPoint, rand);
+	}
+
 	/// <summary>
 	/// Apply the final xform.
 	/// Note that as stated in the paper, the output of the final xform is not fed back into the next iteration.
@@ -234,13 +258,20 @@ protected:
 	/// <param name="tempPoint">The input point</param>
 	/// <param name="sample">The output point</param>
 	/// <param name="rand">The random context to use.</param>
-	inline void DoFinalXform(Ember<T>& ember, Point<T>& tempPoint, Point<T>* sample, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand)
+	/// <param name="profile">The profile to count the final xform in, nullptr to not profile.</param>
+	inline void DoFinalXform(Ember<T>& ember, Point<T>& tempPoint, Point<T>* sample, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, IterProfile* profile)
 	{
 		if (IsClose<T>(ember.FinalXform()->m_Opacity, 1) || rand.Frand01<T>() < ember.FinalXform()->m_Opacity)
 		{
 			T tempVizAdjusted = tempPoint.m_VizAdjusted;
 
-			ember.NonConstFinalXform()->Apply(&tempPoint, sample, rand);
+#ifdef ITER_PROFILE
+			if (profile)
+				profile->Apply(*ember.NonConstFinalXform(), ember.XformCount(), &tempPoint, sample, rand);
+			else
+#endif
+				ember.NonConstFinalXform()->Apply(&tempPoint, sample, rand);
+
 			sample->m_VizAdjusted = tempVizAdjusted;
 		}
 		else
@@ -303,19 +334,19 @@ public:
 
 				for (i = 0; i < params.m_Skip; i++)//Fuse.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 				}
 
-				DoFinalXform(ember, p1, samples, rand);//Apply to last fuse point and store as the first element in samples.
+				DoFinalXform(ember, p1, samples, rand, params.m_Profile);//Apply to last fuse point and store as the first element in samples.
 				ember.Proj(samples[0], rand);
 
 				for (i = 1; i < params.m_Count; i++)//Real loop.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 
-					DoFinalXform(ember, p1, samples + i, rand);
+					DoFinalXform(ember, p1, samples + i, rand, params.m_Profile);
 					ember.Proj(samples[i], rand);
 				}
 			}
@@ -325,8 +356,8 @@ public:
 
 				for (i = 0; i < params.m_Skip; i++)//Fuse.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 				}
 
 				samples[0] = p1;
@@ -334,8 +365,8 @@ public:
 
 				for (i = 1; i < params.m_Count; i++)//Real loop.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &samples[i], rand))
-						DoBadVals(xforms, badVals, samples + i, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &samples[i], rand, params.m_Profile))
+						DoBadVals(xforms, badVals, samples + i, rand, params.m_Profile);
 
 					p1 = samples[i];
 					ember.Proj(samples[i], rand);
@@ -350,18 +381,18 @@ public:
 
 				for (i = 0; i < params.m_Skip; i++)//Fuse.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 				}
 
-				DoFinalXform(ember, p1, samples, rand);//Apply to last fuse point and store as the first element in samples.
+				DoFinalXform(ember, p1, samples, rand, params.m_Profile);//Apply to last fuse point and store as the first element in samples.
 
 				for (i = 1; i < params.m_Count; i++)//Real loop.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 
-					DoFinalXform(ember, p1, samples + i, rand);
+					DoFinalXform(ember, p1, samples + i, rand, params.m_Profile);
 				}
 			}
 			else
@@ -370,16 +401,16 @@ public:
 
 				for (i = 0; i < params.m_Skip; i++)//Fuse.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, badVals, &p1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, &p1, rand, params.m_Profile);
 				}
 
 				samples[0] = p1;
 
 				for (i = 0; i < params.m_Count - 1; i++)//Real loop.
 				{
-					if (xforms[NextXformFromIndex(rand.Rand())].Apply(samples + i, samples + i + 1, rand))
-						DoBadVals(xforms, badVals, samples + i + 1, rand);
+					if (ApplyXform(xforms, NextXformFromIndex(rand.Rand()), samples + i, samples + i + 1, rand, params.m_Profile))
+						DoBadVals(xforms, badVals, samples + i + 1, rand, params.m_Profile);
 				}
 			}
 		}
@@ -413,8 +444,9 @@ public:
 	/// <param name="badVals">The counter for the total number of bad values this sub batch</param>
 	/// <param name="point">The point which initially had the bad values and which will store the newly computed values</param>
 	/// <param name="rand">The random context this iterator is using</param>
+	/// <param name="profile">The profile to count the retries in, nullptr to not profile.</param>
 	/// <returns>True if a good value was computed within 5 tries, else false</returns>
-	inline bool DoBadVals(Xform<T>* xforms, size_t& xformIndex, size_t lastXformUsed, size_t& badVals, Point<T>* point, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand)
+	inline bool DoBadVals(Xform<T>* xforms, size_t& xformIndex, size_t lastXformUsed, size_t& badVals, Point<T>* point, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, IterProfile* profile)
 	{
 		size_t consec = 0;
 		Point<T> firstBadPoint;
@@ -431,7 +463,7 @@ public:
 
 			xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-			if (!xforms[xformIndex].Apply(&firstBadPoint, point, rand))
+			if (!ApplyXform(xforms, xformIndex, &firstBadPoint, point, rand, profile))
 				return true;
 		}
 
@@ -473,23 +505,23 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
 
-				DoFinalXform(ember, p1, samples, rand);//Apply to last fuse point and store as the first element in samples.
+				DoFinalXform(ember, p1, samples, rand, params.m_Profile);//Apply to last fuse point and store as the first element in samples.
 				ember.Proj(samples[0], rand);
 
 				for (i = 1; i < params.m_Count; i++)//Real loop.
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
-					DoFinalXform(ember, p1, samples + i, rand);
+					DoFinalXform(ember, p1, samples + i, rand, params.m_Profile);
 					ember.Proj(samples[i], rand);
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
@@ -502,8 +534,8 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
@@ -515,8 +547,8 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
 					samples[i] = p1;
 					ember.Proj(samples[i], rand);
@@ -534,22 +566,22 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
 
-				DoFinalXform(ember, p1, samples, rand);//Apply to last fuse point and store as the first element in samples.
+				DoFinalXform(ember, p1, samples, rand, params.m_Profile);//Apply to last fuse point and store as the first element in samples.
 
 				for (i = 1; i < params.m_Count; i++)//Real loop.
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))//Feed the resulting value of applying the randomly selected xform back into the next iter, and not the result of applying the final xform.
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
-					DoFinalXform(ember, p1, samples + i, rand);
+					DoFinalXform(ember, p1, samples + i, rand, params.m_Profile);
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
 			}
@@ -561,8 +593,8 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(&p1, &p1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand);
+					if (ApplyXform(xforms, xformIndex, &p1, &p1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, &p1, rand, params.m_Profile);
 
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
@@ -573,8 +605,8 @@ public:
 				{
 					xformIndex = NextXformFromIndex(rand.Rand(), lastXformUsed);
 
-					if (xforms[xformIndex].Apply(samples + i, samples + i + 1, rand))
-						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, samples + i + 1, rand);
+					if (ApplyXform(xforms, xformIndex, samples + i, samples + i + 1, rand, params.m_Profile))
+						DoBadVals(xforms, xformIndex, lastXformUsed, badVals, samples + i + 1, rand, params.m_Profile);
 
 					lastXformUsed = xformIndex + 1;//Store the last used transform.
 				}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "EmberDefines.h"
+
+/// <summary>
+/// NumaTopology class.
+/// </summary>
+
+namespace EmberNs
+{
+#define MAX_NUMA_NODES 64
+#define ANY_NUMA_NODE (std::numeric_limits<size_t>::max())//Work which doesn't belong to a node, so its threads aren't pinned.
+
+/// <summary>
+/// Queries the NUMA topology of the system and pins threads to nodes.
+/// On Linux, the nodes and their processors are read from sysfs. On Windows, they are
+/// queried from the OS. Everywhere else, and whenever the query fails, the system is
+/// treated as a single node containing all processors, which makes pinning a no-op.
+/// The node layout and the processors the process was allowed to run on, such as a cgroup
+/// or taskset restriction, are read once on first use. Pinning only ever narrows that original
+/// set, and Unpin() restores it rather than opening the thread up to every processor.
+/// Pinning applies to the calling thread only, and is meant to be undone with Unpin()
+/// before the thread is returned to the thread pool.
+/// </summary>
+class EMBER_API NumaTopology
+{
+public:
+	/// <summary>
+	/// Return the number of NUMA nodes in the system.
+	/// </summary>
+	/// <returns>The number of nodes, which is at least 1</returns>
+	static size_t NodeCount()
+	{
+		Init();
+		return m_NodeProcessors.size();
+	}
+
+	/// <summary>
+	/// Return the processors which belong to a node.
+	/// </summary>
+	/// <param name="node">The index of the node</param>
+	/// <returns>The processor indices of the node</returns>
+	static const vector<uint>& NodeProcessors(size_t node)
+	{
+		Init();
+		return m_NodeProcessors[std::min(node, m_NodeProcessors.size() - 1)];
+	}
+
+	/// <summary>
+	/// Return the node a thread should run on, given its index among a group of threads.
+	/// Threads are split into contiguous blocks, one per node, so that thread indices which
+	/// process neighboring rows of a buffer end up on the same node.
+	/// </summary>
+	/// <param name="threadIndex">The index of the thread within its group</param>
+	/// <param name="threadCount">The number of threads in the group</param>
+	/// <returns>The node index</returns>
+	static size_t NodeForThread(size_t threadIndex, size_t threadCount)
+	{
+		return threadCount ? std::min((threadIndex * NodeCount()) / threadCount, NodeCount() - 1) : 0;
+	}
+
+	/// <summary>
+	/// Restrict the calling thread to run only on the processors of the specified node
+	/// which the process is allowed to use.
+	/// </summary>
+	/// <param name="node">The index of the node</param>
+	/// <returns>True if pinned, else false if there is only one node, the process may not use any processor of the node, or pinning failed.</returns>
+	static bool PinToNode(size_t node)
+	{
+		if (NodeCount() < 2)
+			return false;
+
+		vector<uint> procs;
+
+		for (auto proc : NodeProcessors(node))
+			if (std::binary_search(m_AllowedProcessors.begin(), m_AllowedProcessors.end(), proc))
+				procs.push_back(proc);
+
+		return !procs.empty() && SetAffinity(procs);
+	}
+
+	/// <summary>
+	/// Allow the calling thread to run on all of the processors the process was originally allowed to use.
+	/// </summary>
+	/// <returns>True if unpinned, else false if there is only one node or unpinning failed.</returns>
+	static bool Unpin()
+	{
+		if (NodeCount() < 2)
+			return false;
+
+		return SetAffinity(m_AllowedProcessors);
+	}
+
+	/// <summary>
+	/// Return a string describing the topology, and how a group of threads would be placed on it.
+	/// </summary>
+	/// <param name="threadCount">The number of threads in the group, 0 to omit placement.</param>
+	/// <returns>The description</returns>
+	static string Dump(size_t threadCount = 0)
+	{
+		ostringstream ss;
+
+		ss << "NUMA nodes: " << NodeCount() << endl;
+
+		for (size_t node = 0; node < NodeCount(); node++)
+		{
+			size_t threads = 0;
+
+			for (size_t i = 0; i < threadCount; i++)
+				if (NodeForThread(i, threadCount) == node)
+					threads++;
+
+			ss << "Node " << node << " processors: ";
+
+			for (size_t i = 0; i < NodeProcessors(node).size(); i++)
+				ss << (i ? "," : "") << NodeProcessors(node)[i];
+
+			if (threadCount)
+				ss << ", threads: " << threads;
+
+			ss << endl;
+		}
+
+		return ss.str();
+	}
+
+private:
+	/// <summary>
+	/// Query the topology of the system exactly once, even if several threads call this at the same time.
+	/// </summary>
+	static void Init()
+	{
+		std::call_once(m_NumaOnce, Query);
+	}
+
+	/// <summary>
+	/// Query and store the topology of the system, and the processors the process is allowed to run on.
+	/// Only called through Init().
+	/// </summary>
+	static void Query()
+	{
+		m_NodeProcessors.clear();
+		m_AllowedProcessors.clear();
+#if defined(_WIN32)
+		ULONG highest = 0;
+
+		if (GetNumaHighestNodeNumber(&highest))
+		{
+			for (ULONG node = 0; node <= highest && node < MAX_NUMA_NODES; node++)
+			{
+				ULONGLONG mask = 0;
+				vector<uint> procs;
+
+				if (GetNumaNodeProcessorMask(UCHAR(node), &mask))
+					for (uint i = 0; i < 64; i++)
+						if (mask & (1ULL << i))
+							procs.push_back(i);
+
+				if (!procs.empty())
+					m_NodeProcessors.push_back(procs);
+			}
+		}
+#elif !defined(__APPLE__)
+		for (uint node = 0; node < MAX_NUMA_NODES; node++)
+		{
+			ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+			string list;
+			vector<uint> procs;
+
+			if (file && std::getline(file, list))
+			{
+				istringstream ranges(list);
+				string range;
+
+				//Format is a comma separated list of single processors or ranges, such as 0-7,16-23.
+				while (std::getline(ranges, range, ','))
+				{
+					size_t dash = range.find('-');
+					uint first = uint(strtoul(range.c_str(), nullptr, 10));
+					uint last = dash == string::npos ? first : uint(strtoul(range.c_str() + dash + 1, nullptr, 10));
+
+					for (uint i = first; i <= last; i++)
+						procs.push_back(i);
+				}
+			}
+
+			if (!procs.empty())
+				m_NodeProcessors.push_back(procs);
+		}
+#endif
+		if (m_NodeProcessors.empty())//Unknown, so treat as a single node with all processors.
+		{
+			vector<uint> procs;
+
+			for (uint i = 0; i < thread::hardware_concurrency(); i++)
+				procs.push_back(i);
+
+			m_NodeProcessors.push_back(procs);
+		}
+
+		//Threads are only unpinned back to the mask the process started with, which may be restricted by a cgroup or taskset.
+#if defined(_WIN32)
+		DWORD_PTR processMask = 0, systemMask = 0;
+
+		if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+			for (uint i = 0; i < sizeof(DWORD_PTR) * 8; i++)
+				if (processMask & (DWORD_PTR(1) << i))
+					m_AllowedProcessors.push_back(i);
+#elif !defined(__APPLE__)
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+
+		if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+			for (uint i = 0; i < CPU_SETSIZE; i++)
+				if (CPU_ISSET(i, &set))
+					m_AllowedProcessors.push_back(i);
+#endif
+		if (m_AllowedProcessors.empty())//Unknown, so assume all processors of all nodes are allowed.
+		{
+			for (auto& procs : m_NodeProcessors)
+				m_AllowedProcessors.insert(m_AllowedProcessors.end(), procs.begin(), procs.end());
+
+			std::sort(m_AllowedProcessors.begin(), m_AllowedProcessors.end());
+		}
+	}
+
+	/// <summary>
+	/// Restrict the calling thread to run only on the specified processors.
+	/// </summary>
+	/// <param name="procs">The processor indices</param>
+	/// <returns>True if success, else false.</returns>
+	static bool SetAffinity(const vector<uint>& procs)
+	{
+#if defined(_WIN32)
+		DWORD_PTR mask = 0;
+
+		for (auto proc : procs)
+			if (proc < sizeof(DWORD_PTR) * 8)
+				mask |= DWORD_PTR(1) << proc;
+
+		return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif !defined(__APPLE__)
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+
+		for (auto proc : procs)
+			if (proc < CPU_SETSIZE)
+				CPU_SET(proc, &set);
+
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		return false;//OSX has no way to pin threads to processors.
+#endif
+	}
+
+	static std::once_flag m_NumaOnce;//Guards the single call to Query().
+	static vector<vector<uint>> m_NodeProcessors;//The processors of each node, set in Query().
+	static vector<uint> m_AllowedProcessors;//The sorted processors the process was allowed to run on when first queried, set in Query().
+};
+}
@@ -1,17 +1,336 @@
 #pragma once
 
 #include "Palette.h"
+#include "Timing.h"
 
 /// <summary>
-/// PaletteList class.
+/// PaletteCacheHeader struct, PaletteCache and PaletteList classes.
 /// </summary>
 
 namespace EmberNs
 {
+#define PALETTE_CACHE_MAGIC "EMBERPAL"//Exactly 8 characters, the null terminator is not stored.
+#define PALETTE_CACHE_VERSION 1//Increment whenever the layout of a record changes.
+#define PALETTE_CACHE_ENDIAN 0x01020304u//Files are written in native byte order, so a reader with the other order sees this reversed.
+#define PALETTE_CACHE_EXT ".cache"//Appended to the name of the Xml file to get the name of its cache.
+
+/// <summary>
+/// The header at the start of a palette cache file.
+/// It's followed by one record per palette, each of which is the 32-bit palette index,
+/// the 32-bit length of the name, the name itself without a terminator and
+/// COLORMAP_LENGTH RGB triplets with one byte per channel.
+/// Bytes are all the Xml can express, so nothing is lost by not storing floating point values.
+/// </summary>
+struct PaletteCacheHeader
+{
+	char m_Magic[8];//PALETTE_CACHE_MAGIC.
+	uint32_t m_Version;//PALETTE_CACHE_VERSION of the writer.
+	uint32_t m_Endian;//PALETTE_CACHE_ENDIAN as written by the writer.
+	uint64_t m_SourceSize;//The size of the Xml file the cache was made from.
+	int64_t m_SourceTime;//The modification time of the Xml file.
+	uint64_t m_SourceHash;//64-bit FNV-1a hash of the contents of the Xml file.
+	uint64_t m_Count;//The number of palette records which follow.
+};
+
+/// <summary>
+/// A binary copy of the palettes in an Xml palette file, which is written next to it the first time it's parsed.
+/// Parsing the hundreds of hex strings in flam3-palettes.xml was a noticeable part of the startup of every
+/// process, whereas opening the cache only maps it and walks the records to find the names and offsets.
+/// A cache is used only if the size of the Xml file matches what it was made from, and either its modification
+/// time or, when that differs such as after copying, the hash of its contents matches as well.
+/// Failing to write the cache, such as when the folder is read only, is not an error and just means
+/// the Xml will be parsed again the next time.
+/// </summary>
+class EMBER_API PaletteCache
+{
+public:
+	/// <summary>
+	/// Constructor which does not open anything.
+	/// </summary>
+	PaletteCache()
+	{
+	}
+
+	/// <summary>
+	/// Open and validate the cache of the specified Xml palette file.
+	/// </summary>
+	/// <param name="sourceFilename">The full path to the Xml palette file, not the cache</param>
+	/// <returns>True if the cache exists, is intact and matches the Xml file, else false.</returns>
+	bool Open(const string& sourceFilename)
+	{
+		bool b = false;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		PaletteCacheHeader header;
+
+		Close();
+
+		if (SourceInfo(sourceFilename, sourceSize, sourceTime) &&
+			m_File.Open(Filename(sourceFilename).c_str()) &&
+			m_File.Size() >= sizeof(header))
+		{
+			memcpy(&header, m_File.Data(), sizeof(header));
+
+			if (!memcmp(header.m_Magic, PALETTE_CACHE_MAGIC, sizeof(header.m_Magic)) &&
+				header.m_Version == PALETTE_CACHE_VERSION &&
+				header.m_Endian == PALETTE_CACHE_ENDIAN &&
+				header.m_SourceSize == sourceSize)
+			{
+				b = true;
+
+				if (header.m_SourceTime != sourceTime)//The contents may still be the same, so only then pay for hashing them.
+				{
+					MappedFile source;
+
+					b = source.Open(sourceFilename.c_str()) && Hash(source.Data(), source.Size()) == header.m_SourceHash;
+				}
+
+				if (b)
+				{
+					size_t offset = sizeof(header);
+					uint32_t nameLength;
+
+					m_Offsets.reserve(size_t(std::min<uint64_t>(header.m_Count, m_File.Size() / RecordSize(0))));//Don't trust the count for the reservation.
+
+					for (uint64_t i = 0; i < header.m_Count && b; i++)
+					{
+						if ((b = m_File.Size() - offset >= RecordSize(0)))
+						{
+							memcpy(&nameLength, m_File.Data() + offset + sizeof(int32_t), sizeof(nameLength));
+
+							if ((b = m_File.Size() - offset >= RecordSize(nameLength)))
+							{
+								m_Offsets.push_back(offset);
+								offset += RecordSize(nameLength);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		if (!b)
+			Close();
+
+		return b;
+	}
+
+	/// <summary>
+	/// Unmap the cache and clear the record offsets.
+	/// </summary>
+	void Close()
+	{
+		m_File.Close();
+		m_Offsets.clear();
+	}
+
+	/// <summary>
+	/// Get the number of palettes in the cache.
+	/// </summary>
+	/// <returns>The number of palettes</returns>
+	size_t Count() const { return m_Offsets.size(); }
+
+	/// <summary>
+	/// Get the index in the Xml file of the palette at the specified position in the cache.
+	/// </summary>
+	/// <param name="i">The position of the palette in the cache, which must be less than Count()</param>
+	/// <returns>The palette index</returns>
+	int Index(size_t i) const
+	{
+		int32_t index;
+
+		memcpy(&index, m_File.Data() + m_Offsets[i], sizeof(index));
+		return int(index);
+	}
+
+	/// <summary>
+	/// Get the name of the palette at the specified position in the cache.
+	/// </summary>
+	/// <param name="i">The position of the palette in the cache, which must be less than Count()</param>
+	/// <returns>The palette name</returns>
+	string Name(size_t i) const
+	{
+		uint32_t nameLength;
+		const byte* p = m_File.Data() + m_Offsets[i] + sizeof(int32_t);
+
+		memcpy(&nameLength, p, sizeof(nameLength));
+		return string(reinterpret_cast<const char*>(p + sizeof(nameLength)), nameLength);
+	}
+
+	/// <summary>
+	/// Get the colors of the palette at the specified position in the cache.
+	/// </summary>
+	/// <param name="i">The position of the palette in the cache, which must be less than Count()</param>
+	/// <returns>A pointer to COLORMAP_LENGTH RGB triplets, which is valid until the cache is closed.</returns>
+	const byte* Colors(size_t i) const
+	{
+		uint32_t nameLength;
+		const byte* p = m_File.Data() + m_Offsets[i] + sizeof(int32_t);
+
+		memcpy(&nameLength, p, sizeof(nameLength));
+		return p + sizeof(nameLength) + nameLength;
+	}
+
+	/// <summary>
+	/// Append the record of a single palette to a buffer which will be passed to Save().
+	/// </summary>
+	/// <param name="index">The index of the palette in the Xml file</param>
+	/// <param name="name">The name of the palette</param>
+	/// <param name="rgb">COLORMAP_LENGTH RGB triplets</param>
+	/// <param name="records">The buffer to append to</param>
+	static void AddRecord(int index, const string& name, const byte* rgb, string& records)
+	{
+		int32_t i = int32_t(index);
+		uint32_t nameLength = uint32_t(name.size());
+
+		records.append(reinterpret_cast<const char*>(&i), sizeof(i));
+		records.append(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+		records.append(name);
+		records.append(reinterpret_cast<const char*>(rgb), COLORMAP_LENGTH * 3);
+	}
+
+	/// <summary>
+	/// Write the cache of an Xml palette file.
+	/// It's written to a temporary file first and then renamed, so that another process
+	/// opening the cache at the same time never sees a partially written one.
+	/// The temporary file name includes the process ID, so processes which write the cache
+	/// at the same time each write their own file, and whichever is renamed last wins.
+	/// </summary>
+	/// <param name="sourceFilename">The full path to the Xml palette file, not the cache</param>
+	/// <param name="sourceData">The contents of the Xml file, which are hashed</param>
+	/// <param name="sourceSize">The size of the contents of the Xml file</param>
+	/// <param name="count">The number of records</param>
+	/// <param name="records">The records, each appended with AddRecord()</param>
+	/// <returns>True if success, else false.</returns>
+	static bool Save(const string& sourceFilename, const byte* sourceData, size_t sourceSize, size_t count, const string& records)
+	{
+		bool b = false;
+		int64_t sourceTime;
+		uint64_t statSize;
+		PaletteCacheHeader header;
+#ifdef _WIN32
+		string filename = Filename(sourceFilename), tempFilename = filename + "." + std::to_string(GetCurrentProcessId()) + ".tmp";
+#else
+		string filename = Filename(sourceFilename), tempFilename = filename + "." + std::to_string(getpid()) + ".tmp";
+#endif
+
+		if (SourceInfo(sourceFilename, statSize, sourceTime) && statSize == sourceSize)
+		{
+			ofstream f;
+
+			memcpy(header.m_Magic, PALETTE_CACHE_MAGIC, sizeof(header.m_Magic));
+			header.m_Version = PALETTE_CACHE_VERSION;
+			header.m_Endian = PALETTE_CACHE_ENDIAN;
+			header.m_SourceSize = sourceSize;
+			header.m_SourceTime = sourceTime;
+			header.m_SourceHash = Hash(sourceData, sourceSize);
+			header.m_Count = count;
+
+			try
+			{
+				f.open(tempFilename, std::ofstream::out | std::ofstream::binary);
+
+				if (f.is_open())
+				{
+					f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+					f.write(records.data(), records.size());
+					b = f.good();
+					f.close();
+				}
+			}
+			catch (...)
+			{
+				b = false;
+			}
+
+			if (b)
+			{
+#ifdef _WIN32
+				b = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;//Rename won't replace an existing file on Windows.
+#else
+				b = !rename(tempFilename.c_str(), filename.c_str());//Replaces an existing file in one step, so readers see either the old or the new cache.
+#endif
+			}
+
+			if (!b)
+				remove(tempFilename.c_str());
+		}
+
+		return b;
+	}
+
+	/// <summary>
+	/// Get the name of the cache of an Xml palette file.
+	/// </summary>
+	/// <param name="sourceFilename">The full path to the Xml palette file</param>
+	/// <returns>The full path to the cache</returns>
+	static string Filename(const string& sourceFilename) { return sourceFilename + PALETTE_CACHE_EXT; }
+
+	/// <summary>
+	/// Compute the 64-bit FNV-1a hash of a block of memory.
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The size of the data</param>
+	/// <returns>The hash</returns>
+	static uint64_t Hash(const byte* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+private:
+	/// <summary>
+	/// Copy constructor and assignment operator which are not implemented since the map can't be shared.
+	/// </summary>
+	PaletteCache(const PaletteCache& cache);
+	PaletteCache& operator = (const PaletteCache& cache);
+
+	/// <summary>
+	/// Get the size and modification time of a file.
+	/// </summary>
+	/// <param name="filename">The full path to the file</param>
+	/// <param name="size">Stores the size</param>
+	/// <param name="time">Stores the modification time</param>
+	/// <returns>True if success, else false.</returns>
+	static bool SourceInfo(const string& filename, uint64_t& size, int64_t& time)
+	{
+		struct _stat statBuf;
+
+		if (_stat(filename.c_str(), &statBuf) == 0)
+		{
+			size = uint64_t(statBuf.st_size);
+			time = int64_t(statBuf.st_mtime);
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Get the size of a record in the cache.
+	/// </summary>
+	/// <param name="nameLength">The length of the palette name</param>
+	/// <returns>The size of the record</returns>
+	static size_t RecordSize(size_t nameLength) { return sizeof(int32_t) + sizeof(uint32_t) + nameLength + COLORMAP_LENGTH * 3; }
+
+	MappedFile m_File;
+	vector<size_t> m_Offsets;//The offset of each record in the map.
+};
+
 /// <summary>
 /// Holds a list of palettes read from an Xml file. Since the default list from flam3-palettes.xml is fairly large at 700 palettes,
 /// the list member is kept as a static. This class derives from EmberReport in order to report any errors that occurred while reading the Xml.
 /// Note that although the Xml color values are expected to be 0-255, they are converted and stored as normalized colors, with values from 0-1.
+/// When a file is read from its PaletteCache, only the names and indices are filled in at first and the colors of each palette
+/// are copied out of the cache the first time it's retrieved. Palettes must therefore only be accessed through the Get*() functions,
+/// which are safe to call from multiple threads at once.
 /// Template argument expected to be float or double.
 /// </summary>
 template <typename T>
@@ -29,11 +348,12 @@ public:
 	}
 
 	/// <summary>
-	/// Read an Xml palette file into memory.
+	/// Read an Xml palette file into memory, using its cache if it has a valid one,
+	/// else parsing the Xml and writing the cache for next time.
 	/// This must be called before any palette file usage.
 	/// </summary>
 	/// <param name="filename">The full path to the file to read</param>
-	/// <param name="force">If true, override the initialization state and force a read, else observe the initialization state.</param>
+	/// <param name="force">If true, override the initialization state and force the Xml to be parsed, else observe the initialization state.</param>
 	/// <returns>Whether anything was read</returns>
 	bool Add(const string& filename, bool force = false)
 	{
@@ -42,21 +362,35 @@ public:
 
 		if (palettes.empty() || force)
 		{
-			string buf;
+			MappedFile file;
 			const char* loc = __FUNCTION__;
+			shared_ptr<PaletteCache> cache(new PaletteCache());
 
-			if (ReadFile(filename.c_str(), buf))
+			if (!force && cache->Open(filename) && cache->Count())
 			{
-				xmlDocPtr doc = xmlReadMemory(static_cast<const char*>(buf.data()), int(buf.size()), filename.c_str(), nullptr, XML_PARSE_NONET);
+				palettes.clear();
+				palettes.reserve(cache->Count());
+
+				for (size_t i = 0; i < cache->Count(); i++)
+					palettes.push_back(Palette<T>(cache->Name(i), cache->Index(i), 0, nullptr));//Empty until first retrieved.
+
+				m_Caches[filename] = cache;
+				added = true;
+			}
+			else if (file.Open(filename.c_str()) && file.Data())//Parse directly from the map rather than copying the file.
+			{
+				xmlDocPtr doc = xmlReadMemory(CCX(file.Data()), int(file.Size()), filename.c_str(), nullptr, XML_PARSE_NONET);
 
 				if (doc != nullptr)
 				{
 					xmlNode* rootNode = xmlDocGetRootElement(doc);
 
+					m_Caches.erase(filename);
 					palettes.clear();
-					palettes.reserve(buf.size() / 2048);//Roughly what it takes per palette.
+					palettes.reserve(file.Size() / 2048);//Roughly what it takes per palette.
 					ParsePalettes(rootNode, palettes);
 					xmlFreeDoc(doc);
+					SaveCache(filename, file, palettes);
 					added = true;
 				}
 				else
@@ -92,7 +426,7 @@ public:
 			int paletteIndex = QTIsaac<ISAAC_SIZE, ISAAC_INT>::GlobalRand->Rand() % p->second.size();
 
 			if (paletteIndex < p->second.size())
-				return &p->second[paletteIndex];
+				return Load(p->first, p->second, paletteIndex);
 		}
 
 		return nullptr;
@@ -106,10 +440,10 @@ public:
 	/// <returns>A pointer to the requested palette if the index was in range, else nullptr.</returns>
 	Palette<T>* GetPalette(const string& filename, int i)
 	{
-		auto& palettes = m_Palettes[filename];
+		auto it = m_Palettes.find(filename);//Don't use operator[], which would insert and is unsafe when parsing on multiple threads.
 
-		if (!palettes.empty() && i < int(palettes.size()))
-			return &palettes[i];
+		if (it != m_Palettes.end() && i >= 0 && i < int(it->second.size()))
+			return Load(filename, it->second, i);
 
 		return nullptr;
 	}
@@ -124,9 +458,9 @@ public:
 	{
 		for (auto& palettes : m_Palettes)
 			if (palettes.first == filename)
-				for (auto& palette : palettes.second)
-					if (palette.m_Name == name)
-						return &palette;
+				for (size_t i = 0; i < palettes.second.size(); i++)
+					if (palettes.second[i].m_Name == name)
+						return Load(filename, palettes.second, i);
 
 		return nullptr;
 	}
@@ -159,6 +493,7 @@ public:
 	void Clear()
 	{
 		m_Palettes.clear();
+		m_Caches.clear();
 	}
 
 	/// <summary>
@@ -217,6 +552,76 @@ public:
 	}
 
 private:
+	/// <summary>
+	/// Fill in the colors of a palette from the cache of its file if it was read from one
+	/// and this is the first time it's being retrieved.
+	/// </summary>
+	/// <param name="filename">The filename the palette was read from</param>
+	/// <param name="palettes">The palettes read from the file</param>
+	/// <param name="i">The index of the palette to load, which must be in range</param>
+	/// <returns>A pointer to the palette</returns>
+	Palette<T>* Load(const string& filename, vector<Palette<T>>& palettes, size_t i)
+	{
+		Palette<T>& palette = palettes[i];
+		auto it = m_Caches.find(filename);
+
+		if (it != m_Caches.end())
+		{
+			m_Cs.Enter();//Another thread might be loading the same palette.
+
+			if (palette.m_Entries.empty())
+			{
+				const byte* rgb = it->second->Colors(i);
+
+				palette.m_Entries.resize(COLORMAP_LENGTH);
+
+				for (size_t j = 0; j < COLORMAP_LENGTH; j++)
+				{
+					palette[j].r = T(rgb[j * 3]) / T(255);//Same as ParsePalettes().
+					palette[j].g = T(rgb[j * 3 + 1]) / T(255);
+					palette[j].b = T(rgb[j * 3 + 2]) / T(255);
+					palette[j].a = 0;
+				}
+			}
+
+			m_Cs.Leave();
+		}
+
+		return &palette;
+	}
+
+	/// <summary>
+	/// Write the cache of a file whose palettes were just parsed from its Xml.
+	/// Failure is ignored since the Xml can always be parsed again.
+	/// </summary>
+	/// <param name="filename">The full path to the Xml file</param>
+	/// <param name="file">The map of the Xml file</param>
+	/// <param name="palettes">The palettes parsed from it</param>
+	void SaveCache(const string& filename, const MappedFile& file, vector<Palette<T>>& palettes)
+	{
+		string records;
+		byte rgb[COLORMAP_LENGTH * 3];
+
+		if (palettes.empty())
+			return;
+
+		records.reserve(palettes.size() * (sizeof(rgb) + 32));
+
+		for (auto& palette : palettes)
+		{
+			for (size_t j = 0; j < COLORMAP_LENGTH; j++)
+			{
+				rgb[j * 3]     = byte(palette[j].r * T(255) + T(0.5));
+				rgb[j * 3 + 1] = byte(palette[j].g * T(255) + T(0.5));
+				rgb[j * 3 + 2] = byte(palette[j].b * T(255) + T(0.5));
+			}
+
+			PaletteCache::AddRecord(palette.m_Index, palette.m_Name, rgb, records);
+		}
+
+		PaletteCache::Save(filename, file.Data(), file.Size(), palettes.size(), records);
+	}
+
 	/// <summary>
 	/// Parses an Xml node for all palettes present and store in the passed in palette vector.
 	/// Note that although the Xml color values are expected to be 0-255, they are converted and
@@ -300,5 +705,7 @@ private:
 	}
 
 	static map<string, vector<Palette<T>>> m_Palettes;//The map of filenames to vectors that store the palettes.
+	static map<string, shared_ptr<PaletteCache>> m_Caches;//The caches of the files in m_Palettes which were read from one, kept open until all palettes are loaded.
+	static CriticalSection m_Cs;//Protects loading palettes from the caches.
 };
 }
@@ -11,6 +11,8 @@ template <typename T, typename bucketT>
 Renderer<T, bucketT>::Renderer()
 {
 	m_PixelAspectRatio = 1;
+	m_NodeHistDirty = false;
+	m_ResetStrategy = RESET_UNKNOWN;
 	m_StandardIterator = unique_ptr<StandardIterator<T>>(new StandardIterator<T>());
 	m_XaosIterator = unique_ptr<XaosIterator<T>>(new XaosIterator<T>());
 	m_Iterator = m_StandardIterator.get();
@@ -39,6 +41,7 @@ void Renderer<T, bucketT>::AddEmber(Ember<T>& ember)
 	ChangeVal([&]
 	{
 		m_Embers.push_back(ember);
+		m_Interpolater.ClearCache();
 
 		if (m_Embers.size() == 1)
 			m_Ember = m_Embers[0];
@@ -169,6 +172,7 @@ void Renderer<T, bucketT>::SetEmber(Ember<T>& ember, eProcessAction action)
 		m_Embers.push_back(ember);
 		m_Embers[0].m_TemporalSamples = 1;//Set temporal samples here to 1 because using the real value only makes sense when using a vector of Embers for animation.
 		m_Ember = m_Embers[0];
+		m_Interpolater.ClearCache();
 	}, action);
 }
 
@@ -183,6 +187,7 @@ void Renderer<T, bucketT>::SetEmber(vector<Ember<T>>& embers)
 	ChangeVal([&]
 	{
 		m_Embers = embers;
+		m_Interpolater.ClearCache();
 
 		if (!m_Embers.empty())
 			m_Ember = m_Embers[0];
@@ -190,12 +195,13 @@ void Renderer<T, bucketT>::SetEmber(vector<Ember<T>>& embers)
 }
 
 /// <summary>
-/// Create the density filter if the current filter parameters differ
-/// from the last density filter created.
+/// Get the density filter from FilterCache if the current filter parameters differ
+/// from the last density filter used. A filter with the same parameters created earlier by
+/// this or any other renderer is reused rather than created again.
 /// The filter will be deleted if the max DE radius is 0, in which case regular
 /// log scale filtering will be used.
 /// </summary>
-/// <param name="newAlloc">True if a new filter instance was created, else false.</param>
+/// <param name="newAlloc">True if a different filter instance is now used, else false.</param>
 /// <returns>True if the filter is not nullptr (whether a new one was created or not) or if max rad is 0, else false.</returns>
 template <typename T, typename bucketT>
 bool Renderer<T, bucketT>::CreateDEFilter(bool& newAlloc)
@@ -205,21 +211,20 @@ bool Renderer<T, bucketT>::CreateDEFilter(bool& newAlloc)
 
 	if (m_Ember.m_MaxRadDE > 0)
 	{
-		//Use intelligent testing so it isn't created every time a new ember is passed in.
+		//Use intelligent testing so it isn't looked up every time a new ember is passed in.
 		if ((!m_DensityFilter.get()) ||
 			(m_Ember.m_MinRadDE != m_DensityFilter->MinRad()) ||
 			(m_Ember.m_MaxRadDE != m_DensityFilter->MaxRad()) ||
 			(m_Ember.m_CurveDE != m_DensityFilter->Curve()) ||
 			(m_Ember.m_Supersample != m_DensityFilter->Supersample()))
 		{
-			m_DensityFilter = unique_ptr<DensityFilter<T>>(new DensityFilter<T>(m_Ember.m_MinRadDE, m_Ember.m_MaxRadDE, m_Ember.m_CurveDE, m_Ember.m_Supersample));
-			newAlloc = true;
-		}
+			//The cache returns a filter which was already created, or nullptr if creation failed.
+			auto filter = FilterCache<T>::GetDensityFilter(m_Ember.m_MinRadDE, m_Ember.m_MaxRadDE, m_Ember.m_CurveDE, m_Ember.m_Supersample);
 
-		if (newAlloc)
-		{
-			if (!m_DensityFilter.get()) { return false; }//Did object creation succeed?
-			if (!m_DensityFilter->Create()) { return false; }//Object creation succeeded, did filter creation succeed?
+			if (!filter.get()) { m_DensityFilter.reset(); return false; }
+
+			newAlloc = filter != m_DensityFilter;//The filter may have adjusted its values, in which case the same one is returned again.
+			m_DensityFilter = filter;
 			//cout << m_DensityFilter->ToString() << endl;
 		}
 		else
@@ -234,10 +239,11 @@ bool Renderer<T, bucketT>::CreateDEFilter(bool& newAlloc)
 }
 
 /// <summary>
-/// Create the spatial filter if the current filter parameters differ
-/// from the last spatial filter created.
+/// Get the spatial filter from FilterCache if the current filter parameters differ
+/// from the last spatial filter used. A filter with the same parameters created earlier by
+/// this or any other renderer is reused rather than created again.
 /// </summary>
-/// <param name="newAlloc">True if a new filter instance was created, else false.</param>
+/// <param name="newAlloc">True if a different filter instance is now used, else false.</param>
 /// <returns>True if the filter is not nullptr (whether a new one was created or not), else false.</returns>
 template <typename T, typename bucketT>
 bool Renderer<T, bucketT>::CreateSpatialFilter(bool& newAlloc)
@@ -251,21 +257,22 @@ bool Renderer<T, bucketT>::CreateSpatialFilter(bool& newAlloc)
 		(m_Ember.m_Supersample != m_SpatialFilter->Supersample()) ||
 		(m_PixelAspectRatio != m_SpatialFilter->PixelAspectRatio()))
 	{
-		m_SpatialFilter = unique_ptr<SpatialFilter<T>>(
-			SpatialFilterCreator<T>::Create(m_Ember.m_SpatialFilterType, m_Ember.m_SpatialFilterRadius, m_Ember.m_Supersample, m_PixelAspectRatio));
+		auto filter = FilterCache<T>::GetSpatialFilter(m_Ember.m_SpatialFilterType, m_Ember.m_SpatialFilterRadius, m_Ember.m_Supersample, m_PixelAspectRatio);
 
+		newAlloc = filter != m_SpatialFilter;
+		m_SpatialFilter = filter;
 		m_Ember.m_SpatialFilterRadius = m_SpatialFilter->FilterRadius();//It may have been changed internally if it was too small, so ensure they're synced.
-		newAlloc = true;
 	}
 
 	return m_SpatialFilter.get() != nullptr;
 }
 
 /// <summary>
-/// Create the temporal filter if the current filter parameters differ
-/// from the last temporal filter created.
+/// Get the temporal filter from FilterCache if the current filter parameters differ
+/// from the last temporal filter used. A filter with the same parameters created earlier by
+/// this or any other renderer is reused rather than created again.
 /// </summary>
-/// <param name="newAlloc">True if a new filter instance was created, else false.</param>
+/// <param name="newAlloc">True if a different filter instance is now used, else false.</param>
 /// <returns>True if the filter is not nullptr (whether a new one was created or not), else false.</returns>
 template <typename T, typename bucketT>
 bool Renderer<T, bucketT>::CreateTemporalFilter(bool& newAlloc)
@@ -279,9 +286,10 @@ bool Renderer<T, bucketT>::CreateTemporalFilter(bool& newAlloc)
 		(m_Ember.m_TemporalFilterWidth != m_TemporalFilter->FilterWidth()) ||
 		(m_Ember.m_TemporalFilterExp != m_TemporalFilter->FilterExp()))
 	{
-		m_TemporalFilter = unique_ptr<TemporalFilter<T>>(
-							TemporalFilterCreator<T>::Create(m_Ember.m_TemporalFilterType, m_Ember.m_TemporalSamples, m_Ember.m_TemporalFilterWidth, m_Ember.m_TemporalFilterExp));
-		newAlloc = true;
+		auto filter = FilterCache<T>::GetTemporalFilter(m_Ember.m_TemporalFilterType, m_Ember.m_TemporalSamples, m_Ember.m_TemporalFilterWidth, m_Ember.m_TemporalFilterExp);
+
+		newAlloc = filter != m_TemporalFilter;
+		m_TemporalFilter = filter;
 	}
 
 	return m_TemporalFilter.get() != nullptr;
@@ -334,17 +342,15 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 	m_Abort = false;
 	bool filterAndAccumOnly = m_ProcessAction == FILTER_AND_ACCUM;
 	bool accumOnly = m_ProcessAction == ACCUM_ONLY;
+	bool paletteAndAccumOnly = m_ProcessAction == PALETTE_AND_ACCUM && m_ProcessState == ITER_DONE;
 	bool resume = m_ProcessState != NONE;
 	bool newFilterAlloc;
 	size_t i, temporalSample = 0;
 	T deTime;
 	eRenderStatus success = RENDER_OK;
-	//double iterationTime = 0;
-	//double accumulationTime = 0;
-	//Timing it;
 
 	//Reset timers and progress percent if: Beginning anew or only filtering and/or accumulating.
-	if (!resume || accumOnly || filterAndAccumOnly)
+	if (!resume || accumOnly || filterAndAccumOnly || paletteAndAccumOnly)
 	{
 		if (!resume)//Only set this if it's the first run through.
 			m_ProcessState = ITER_STARTED;
@@ -357,8 +363,10 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 	{
 		m_LastTemporalSample = 0;
 		m_LastIter = 0;
+		m_AdaptiveIters = 0;
 		m_LastIterPercent = 0;
 		m_Stats.Clear();
+		m_IterProfile.Clear();
 		m_Gamma = 0;
 		m_Vibrancy = 0;//Accumulate these after each temporal sample.
 		m_VibGamCount = 0;
@@ -377,19 +385,34 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 		m_Background.Clear();
 		ComputeQuality();//Must recompute quality when doing a quality increase.
 	}
+	//User changed the palette in the middle of iterating with deferred palette lookup.
+	//Nothing iterated so far depends on the palette, so just pick up the new one and keep going.
+	else if (m_ProcessState == ITER_STARTED && m_ProcessAction == PALETTE_AND_ACCUM && TemporalSamples() == 1)
+	{
+		m_Ember.m_Palette = m_Embers[0].m_Palette;
+		m_Ember.m_PaletteMode = m_Embers[0].m_PaletteMode;
+		MakeDmap(1);//Temporal samples is 1, so the color scalar is 1.
+		m_ProcessAction = FULL_RENDER;
+	}
 
 	//Make sure values are within valid range.
 	ClampGteRef(m_Ember.m_Supersample, size_t(1));
 
 	//Make sure to get most recent update since loop won't be entered to call Interp().
 	//Vib, gam and background are normally summed for each temporal sample. However if iteration is skipped, make sure to get the latest.
-	if ((filterAndAccumOnly || accumOnly) && TemporalSamples() == 1)//Disallow jumping when temporal samples > 1.
+	if ((filterAndAccumOnly || accumOnly || paletteAndAccumOnly) && TemporalSamples() == 1)//Disallow jumping when temporal samples > 1.
 	{
 		m_Ember = m_Embers[0];
 		m_Vibrancy = m_Ember.m_Vibrancy;
 		m_Gamma = m_Ember.m_Gamma;
 		m_Background = m_Ember.m_Background;
 
+		if (paletteAndAccumOnly)
+		{
+			MakeDmap(1);//Temporal samples is 1, so the color scalar is 1.
+			goto FilterAndAccum;
+		}
+
 		if (filterAndAccumOnly)
 			goto FilterAndAccum;
 
@@ -397,11 +420,13 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 			goto AccumOnly;
 	}
 
-	//it.Tic();
+	m_StageTimer.Tic();
+
 	//Interpolate.
 	if (m_Embers.size() > 1)
-		Interpolater<T>::Interpolate(m_Embers, T(time), 0, m_Ember);
-	//it.Toc("Interp 1");
+		m_Interpolater.InterpolateCached(m_Embers, T(time), 0, m_Ember);
+
+	m_StageTimer.Toc(m_Stats.m_InterpMs, m_Stats.m_InterpCpuMs);
 
 	//Save only for palette insertion.
 	if (m_InsertPalette && BytesPerChannel() == 1)
@@ -419,6 +444,8 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 		goto Finish;
 	}
 
+	m_StageTimer.Tic();
+
 	if (!resume && !Alloc())
 	{
 		m_ErrorReport.push_back("Histogram, accumulator and samples buffer allocations failed, aborting.\n");
@@ -429,14 +456,17 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 	if (!resume)
 		ResetBuckets(true, false);//Only reset hist here and do accum when needed later on.
 
+	m_StageTimer.Toc(m_Stats.m_AllocMs, m_Stats.m_AllocCpuMs);
 	deTime = T(time) + m_TemporalFilter->Deltas()[0];
 
 	//Interpolate and get an ember for DE purposes.
 	//Additional interpolation will be done in the temporal samples loop.
-	//it.Tic();
+	m_StageTimer.Tic();
+
 	if (m_Embers.size() > 1)
-		Interpolater<T>::Interpolate(m_Embers, deTime, 0, m_Ember);
-	//it.Toc("Interp 2");
+		m_Interpolater.InterpolateCached(m_Embers, deTime, 0, m_Ember);
+
+	m_StageTimer.Toc(m_Stats.m_InterpMs, m_Stats.m_InterpCpuMs);
 
 	ClampGteRef<T>(m_Ember.m_MinRadDE, 0);
 	ClampGteRef<T>(m_Ember.m_MaxRadDE, 0);
@@ -457,11 +487,12 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 		T temporalTime = T(time) + m_TemporalFilter->Deltas()[temporalSample];
 
 		//Interpolate again.
-		//it.Tic();
+		m_StageTimer.Tic();
+
 		if (TemporalSamples() > 1 && m_Embers.size() > 1)
-			Interpolater<T>::Interpolate(m_Embers, temporalTime, 0, m_Ember);//This will perform all necessary precalcs via the ember/xform/variation assignment operators.
+			m_Interpolater.InterpolateCached(m_Embers, temporalTime, 0, m_Ember);//This will perform all necessary precalcs via the ember/xform/variation assignment operators.
 
-		//it.Toc("Interp 3");
+		m_StageTimer.Toc(m_Stats.m_InterpMs, m_Stats.m_InterpCpuMs);
 
 		if (!resume && !AssignIterator())
 		{
@@ -483,13 +514,31 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 		//Note that the iter count is based on the final image dimensions, and not the super sampled dimensions.
 		size_t itersPerTemporalSample = ItersPerTemporalSample();//The total number of iterations for this temporal sample without overrides.
 		size_t sampleItersToDo;//The number of iterations to actually do in this sample, considering overrides.
+		size_t nextNoiseCheck = 0;//The iter count within this sample at which to next estimate the noise when iterating adaptively.
+		bool searching = false;//Whether adaptive iteration is still determining how many iters each temporal sample needs.
+
+		//With adaptive iteration, the first temporal sample runs until the target noise is reached, or until the cap is hit.
+		//All subsequent temporal samples then run the same number of iterations.
+		if (m_TargetNoise > 0)
+		{
+			if (m_AdaptiveIters == 0)
+			{
+				size_t checkIters = std::max<size_t>(itersPerTemporalSample / 16, SubBatchSize() * ThreadCount());
+
+				searching = true;
+				itersPerTemporalSample = std::max<size_t>(size_t(itersPerTemporalSample * m_MaxIterScale), 1);
+				nextNoiseCheck = std::min<size_t>(((m_LastIter / checkIters) + 1) * checkIters, itersPerTemporalSample);
+			}
+			else
+				itersPerTemporalSample = m_AdaptiveIters;
+		}
 
 		if (subBatchCountOverride > 0)
 			sampleItersToDo = subBatchCountOverride * SubBatchSize() * ThreadCount();//Run a specific number of sub batches.
 		else
 			sampleItersToDo = itersPerTemporalSample;//Run as many iters as specified to complete this temporal sample.
 
-		sampleItersToDo = std::min<size_t>(sampleItersToDo, itersPerTemporalSample - m_LastIter);
+		sampleItersToDo = std::min<size_t>(sampleItersToDo, (searching ? nextNoiseCheck : itersPerTemporalSample) - m_LastIter);
 		EmberStats stats = Iterate(sampleItersToDo, temporalSample);//The heavy work is done here.
 
 		//If no iters were executed, something went catastrophically wrong.
@@ -512,6 +561,18 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 		m_Stats.m_Iters += stats.m_Iters;//Sum of iter count of all threads, cumulative from beginning to end.
 		m_Stats.m_Badvals += stats.m_Badvals;
 		m_Stats.m_IterMs += stats.m_IterMs;
+		m_Stats.m_IterCpuMs += stats.m_IterCpuMs;
+		m_Stats.m_HistMs += stats.m_HistMs;
+
+		//Estimate the noise at each check point while searching. Since the remaining temporal samples will each add the same number of iters
+		//to the histogram, the final noise is expected to be lower than the current noise by a factor of sqrt(TemporalSamples()).
+		if (searching && m_LastIter >= nextNoiseCheck)
+		{
+			m_Stats.m_Noise = EstimateNoise() / std::sqrt(double(TemporalSamples()));
+
+			if (m_Stats.m_Noise <= m_TargetNoise || m_LastIter >= itersPerTemporalSample)
+				itersPerTemporalSample = m_AdaptiveIters = m_LastIter;
+		}
 
 		//After each temporal sample, accumulate these.
 		//Allow for incremental rendering by only taking action if the iter loop for this temporal sample is completely done.
@@ -538,6 +599,13 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 	{
 		m_ProcessState = ITER_DONE;
 
+		//Record the final noise and how many iters were saved compared to the quality based count.
+		if (m_TargetNoise > 0)
+		{
+			m_Stats.m_Noise = EstimateNoise();
+			m_Stats.m_ItersSaved = intmax_t(ItersPerTemporalSample() * TemporalSamples()) - intmax_t(m_Stats.m_Iters);
+		}
+
 		if (m_Callback && !m_Callback->ProgressFunc(m_Ember, m_ProgressParameter, 100.0, 0, 0))
 		{
 			Abort();
@@ -547,12 +615,19 @@ eRenderStatus Renderer<T, bucketT>::Run(vector<byte>& finalImage, double time, s
 	}
 
 FilterAndAccum:
-	if (filterAndAccumOnly || temporalSample >= TemporalSamples() || forceOutput)
+	if (filterAndAccumOnly || paletteAndAccumOnly || temporalSample >= TemporalSamples() || forceOutput)
 	{
-		//t.Toc("Iterating and accumulating");
 		//Compute k1 and k2.
 		eRenderStatus fullRun = RENDER_OK;//Whether density filtering was run to completion without aborting prematurely or triggering an error.
 
+		//With NUMA awareness, the node replicas must be summed into the histogram before it's read.
+		ReduceNodeHistograms();
+
+		//With deferred palette lookup, the histogram is built from the color index bins using the current palette.
+		//When only filtering, the histogram already holds the most recent projection so it can be reused.
+		if (PaletteDeferred() && !filterAndAccumOnly)
+			PaletteBinsToHistogram();
+
 		T area = FinalRasW() * FinalRasH() / (m_PixelsPerUnitX * m_PixelsPerUnitY);//Need to use temps from field if ever implemented.
 		m_K1 = (Brightness() * T(268.0)) / 256;
 
@@ -564,14 +639,23 @@ FilterAndAccum:
 			T quality = (T(m_Stats.m_Iters) / T(FinalDimensions())) * (m_Scale * m_Scale);
 			m_K2 = (Supersample() * Supersample()) / (area * quality * m_TemporalFilter->SumFilt());
 		}
+		//Adaptive iteration runs a different number of iters than the quality specifies, so scale by the number actually run.
+		//When the quality based count is run, this is the same as using the scaled quality.
+		else if (m_TargetNoise > 0)
+		{
+			T quality = T(m_Stats.m_Iters) / T(FinalDimensions());
+			m_K2 = (Supersample() * Supersample()) / (area * quality * m_TemporalFilter->SumFilt());
+		}
 		else
 			m_K2 = (Supersample() * Supersample()) / (area * m_ScaledQuality * m_TemporalFilter->SumFilt());
 
+		m_StageTimer.Tic();
 		ResetBuckets(false, true);//Only the histogram was reset above, now reset the density filtering buffer.
-		//t.Tic();
+		m_StageTimer.Toc(m_Stats.m_AllocMs, m_Stats.m_AllocCpuMs);
+		m_StageTimer.Tic();
 
 		//Apply appropriate filter if iterating is complete.
-		if (filterAndAccumOnly || temporalSample >= TemporalSamples())
+		if (filterAndAccumOnly || paletteAndAccumOnly || temporalSample >= TemporalSamples())
 		{
 			fullRun = m_DensityFilter.get() ? GaussianDensityFilter() : LogScaleDensityFilter();
 		}
@@ -584,6 +668,8 @@ FilterAndAccum:
 				fullRun = LogScaleDensityFilter();
 		}
 
+		m_StageTimer.Toc(m_Stats.m_FilterMs, m_Stats.m_FilterCpuMs);
+
 		//Only update state if iterating and filtering finished completely (didn't arrive here via forceOutput).
 		if (fullRun == RENDER_OK && m_ProcessState == ITER_DONE)
 			m_ProcessState = FILTER_DONE;
@@ -601,7 +687,6 @@ FilterAndAccum:
 			success = RENDER_ABORT;
 			goto Finish;
 		}
-		//t.Toc("Density estimation filtering time: ", true);
 	}
 
 AccumOnly:
@@ -624,9 +709,13 @@ AccumOnly:
 			for (i = 0; i < COLORMAP_LENGTH; i++)
 				m_Csa[i] = m_Ember.m_Curves.BezierFunc(i / T(COLORMAP_LENGTH_MINUS_1)) * T(COLORMAP_LENGTH_MINUS_1);
 
+		m_StageTimer.Tic();
+
 		if (AccumulatorToFinalImage(finalImage, finalOffset) == RENDER_OK)
 		{
+			m_StageTimer.Toc(m_Stats.m_AccumMs, m_Stats.m_AccumCpuMs);
 			m_Stats.m_RenderMs = m_RenderTimer.Toc();//Record total time from the very beginning to the very end, including all intermediate calls.
+			m_Stats.m_RenderCpuMs = m_RenderTimer.ElapsedCpuTime();
 
 			//Even though the ember changes throughought the inner loops because of interpolation, it's probably ok to assign here.
 			//This will hold the last interpolated value (even though spatial and temporal filters were created based off of one of the first interpolated values).
@@ -681,7 +770,16 @@ EmberImageComments Renderer<T, bucketT>::ImageComments(EmberStats& stats, size_t
 	ss << stats.m_Iters;
 	comments.m_NumIters = ss.str(); ss.str("");//Total iters.
 	ss << (stats.m_RenderMs / 1000.0);
-	comments.m_Runtime = ss.str();//Number of seconds for iterating, accumulating and filtering.
+	comments.m_Runtime = ss.str(); ss.str("");//Number of seconds for iterating, accumulating and filtering.
+
+	//Only present when adaptive iteration was used.
+	if (stats.m_Noise > 0)
+	{
+		ss << stats.m_Noise;
+		comments.m_Noise = ss.str(); ss.str("");//Estimated relative noise achieved.
+		ss << stats.m_ItersSaved;
+		comments.m_ItersSaved = ss.str();//Iters saved compared to the quality, negative if more were needed.
+	}
 
 	return comments;
 }
@@ -690,6 +788,59 @@ EmberImageComments Renderer<T, bucketT>::ImageComments(EmberStats& stats, size_t
 /// New virtual functions to be overridden in derived renderers that use the GPU, but not accessed outside.
 /// </summary>
 
+/// <summary>
+/// Estimate the relative noise of the histogram.
+/// The hit count of each pixel is treated as a Poisson process, whose relative
+/// standard deviation is 1 / sqrt(hits). This is averaged over all pixels that have been hit,
+/// weighted by log(1 + hits) to approximate how much each pixel contributes to the log scaled
+/// final image. This keeps the large number of sparsely hit pixels at the edges of a flame
+/// from dominating the estimate, while still accounting for them.
+/// </summary>
+/// <returns>The estimated relative noise, between 0 and 1.</returns>
+template <typename T, typename bucketT>
+double Renderer<T, bucketT>::EstimateNoise()
+{
+	bool deferred = PaletteDeferred();
+	size_t bins = m_PaletteBins;
+	vector<double> rowNoise(m_SuperRasH), rowWeight(m_SuperRasH);
+
+	ReduceNodeHistograms();
+
+	parallel_for(size_t(0), m_SuperRasH, [&] (size_t j)
+	{
+		size_t row = j * m_SuperRasW;
+		double noise = 0, weight = 0;
+
+		for (size_t i = 0; i < m_SuperRasW; i++)
+		{
+			double hits = 0;
+
+			//When palette lookup is deferred, the hit counts are in the color index bins rather than the histogram.
+			if (deferred)
+			{
+				for (size_t b = 0; b < bins; b++)
+					hits += double(m_PaletteBinBuckets[((row + i) * bins) + b].x);
+			}
+			else
+				hits = double(m_HistBuckets[row + i].a);
+
+			if (hits > 0)
+			{
+				double w = log(1 + hits);
+
+				noise += w * std::min(1.0, 1.0 / std::sqrt(hits));
+				weight += w;
+			}
+		}
+
+		rowNoise[j] = noise;
+		rowWeight[j] = weight;
+	});
+
+	double totalWeight = std::accumulate(rowWeight.begin(), rowWeight.end(), 0.0);
+	return totalWeight > 0 ? std::accumulate(rowNoise.begin(), rowNoise.end(), 0.0) / totalWeight : 1.0;
+}
+
 /// <summary>
 /// Make the final palette used for iteration.
 /// </summary>
@@ -703,21 +854,56 @@ void Renderer<T, bucketT>::MakeDmap(T colorScalar)
 /// <summary>
 /// Allocate various buffers if the image dimensions, thread count, or sub batch size
 /// has changed.
+/// The growth in the size of the buffers is added to the allocated bytes in the stats.
 /// </summary>
 /// <returns>True if success, else false</returns>
 template <typename T, typename bucketT>
 bool Renderer<T, bucketT>::Alloc()
 {
 	bool b = true;
+	size_t oldBytes = HostBufferBytes();
+	size_t binCount = PaletteDeferred() ? m_SuperSize * m_PaletteBins : 0;
+	size_t replicas = NumaReplicas();
+	bool replicasChanged = (replicas != m_NodeHistBuckets.size()) || (replicas && m_NodeHistBuckets[0].size() != m_SuperSize);
 	bool lock =
+		replicasChanged                                      ||
 		(m_SuperSize         != m_HistBuckets.size())        ||
 		(m_SuperSize         != m_AccumulatorBuckets.size()) ||
+		(binCount            != m_PaletteBinBuckets.size())  ||
 		(m_ThreadsToUse      != m_Samples.size())            ||
 		(m_Samples[0].size() != SubBatchSize());
 
 	if (lock)
 		EnterResize();
 
+	//For NUMA awareness, the main histogram and each replica are allocated from a thread pinned
+	//to the node which will accumulate into it, so that the first touch places its pages on that node.
+	if (replicasChanged)
+	{
+		m_NodeHistBuckets.clear();
+
+		if (replicas)
+		{
+			m_NodeHistBuckets.resize(replicas);
+			m_HistBuckets.clear();
+			m_HistBuckets.shrink_to_fit();//Force reallocation on the first node.
+
+			parallel_for(size_t(0), replicas + 1, [&] (size_t node)
+			{
+				auto& hist = node ? m_NodeHistBuckets[node - 1] : m_HistBuckets;
+
+				NumaTopology::PinToNode(node);
+				hist.resize(m_SuperSize);
+				NumaTopology::Unpin();
+			});
+
+			for (auto& hist : m_NodeHistBuckets)
+				b &= (hist.size() == m_SuperSize);
+		}
+
+		m_NodeHistDirty = false;
+	}
+
 	if (m_SuperSize != m_HistBuckets.size())
 	{
 		m_HistBuckets.resize(m_SuperSize);
@@ -738,6 +924,16 @@ bool Renderer<T, bucketT>::Alloc()
 		b &= (m_AccumulatorBuckets.size() == m_SuperSize);
 	}
 
+	if (binCount != m_PaletteBinBuckets.size())
+	{
+		m_PaletteBinBuckets.resize(binCount);
+
+		if (m_ReclaimOnResize || binCount == 0)//Always release the bins when palette lookup is no longer deferred.
+			m_PaletteBinBuckets.shrink_to_fit();
+
+		b &= (m_PaletteBinBuckets.size() == binCount);
+	}
+
 	if (m_ThreadsToUse != m_Samples.size())
 	{
 		m_Samples.resize(m_ThreadsToUse);
@@ -764,11 +960,34 @@ bool Renderer<T, bucketT>::Alloc()
 	if (lock)
 		LeaveResize();
 
+	m_Stats.m_BufferBytes = HostBufferBytes();
+	m_Stats.m_AllocBytes += m_Stats.m_BufferBytes > oldBytes ? m_Stats.m_BufferBytes - oldBytes : 0;
 	return b;
 }
 
+/// <summary>
+/// Get the total size of the histogram, accumulator, color index bins, NUMA replicas and sample buffers.
+/// </summary>
+/// <returns>The number of bytes</returns>
+template <typename T, typename bucketT>
+size_t Renderer<T, bucketT>::HostBufferBytes()
+{
+	size_t bytes = SizeOf(m_HistBuckets) + SizeOf(m_AccumulatorBuckets) + SizeOf(m_PaletteBinBuckets);
+
+	for (auto& hist : m_NodeHistBuckets)
+		bytes += SizeOf(hist);
+
+	for (auto& sample : m_Samples)
+		bytes += SizeOf(sample);
+
+	return bytes;
+}
+
 /// <summary>
 /// Clear histogram and/or density filtering buffers to all zeroes.
+/// The color index bins are cleared along with the histogram.
+/// Each buffer is cleared with ZeroBuffer(). When NUMA aware, the main histogram is cleared on the first node
+/// and each replica on its own node, so pages which are freshly faulted in stay where they were first placed.
 /// </summary>
 /// <param name="resetHist">Clear histogram if true, else don't.</param>
 /// <param name="resetAccum">Clear density filtering buffer if true, else don't.</param>
@@ -776,17 +995,22 @@ bool Renderer<T, bucketT>::Alloc()
 template <typename T, typename bucketT>
 bool Renderer<T, bucketT>::ResetBuckets(bool resetHist, bool resetAccum)
 {
-	//parallel_invoke(
-	//[&]
-	//{
 	if (resetHist && !m_HistBuckets.empty())
-		Memset(m_HistBuckets);
-	//},
-	//[&]
-	//{
+		ZeroBuffer(m_HistBuckets.data(), SizeOf(m_HistBuckets), m_NodeHistBuckets.empty() ? ANY_NUMA_NODE : 0);
+
+	if (resetHist && !m_PaletteBinBuckets.empty())
+		ZeroBuffer(m_PaletteBinBuckets.data(), SizeOf(m_PaletteBinBuckets));
+
+	if (resetHist && m_NodeHistDirty)
+	{
+		for (size_t i = 0; i < m_NodeHistBuckets.size(); i++)
+			ZeroBuffer(m_NodeHistBuckets[i].data(), SizeOf(m_NodeHistBuckets[i]), i + 1);
+
+		m_NodeHistDirty = false;
+	}
+
 	if (resetAccum && !m_AccumulatorBuckets.empty())
-		Memset(m_AccumulatorBuckets);
-	//});
+		ZeroBuffer(m_AccumulatorBuckets.data(), SizeOf(m_AccumulatorBuckets));
 
 	return resetHist || resetAccum;
 }
@@ -1198,12 +1422,15 @@ eRenderStatus Renderer<T, bucketT>::AccumulatorToFinalImage(byte* pixels, size_t
 template <typename T, typename bucketT>
 EmberStats Renderer<T, bucketT>::Iterate(size_t iterCount, size_t temporalSample)
 {
-	//Timing t2(4);
 	m_IterTimer.Tic();
 	size_t totalItersPerThread = size_t(ceil(double(iterCount) / double(m_ThreadsToUse)));
+	bool numa = !m_NodeHistBuckets.empty();
 	double percent, etaMs;
 	EmberStats stats;
 
+	if (numa)
+		m_NodeHistDirty = true;
+
 #ifdef TG
 	size_t threadIndex;
 
@@ -1218,12 +1445,23 @@ EmberStats Renderer<T, bucketT>::Iterate(size_t iterCount, size_t temporalSample
 #ifdef WIN32
 		//SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
 #endif
-		//Timing t;
 		IterParams<T> params;
+		size_t node = numa ? NumaTopology::NodeForThread(threadIndex, m_ThreadsToUse) : 0;
+		tvec4<bucketT, glm::defaultp>* hist = node ? m_NodeHistBuckets[node - 1].data() : m_HistBuckets.data();//Each NUMA node accumulates into its own replica.
+
+		if (numa)
+			NumaTopology::PinToNode(node);
 
 		m_BadVals[threadIndex] = 0;
+		m_HistMs[threadIndex] = 0;
 		params.m_Count = std::min(totalItersPerThread, SubBatchSize());
 		params.m_Skip = FuseCount();
+#ifdef ITER_PROFILE
+		m_IterProfiles[threadIndex].Init(m_Ember);
+		params.m_Profile = &m_IterProfiles[threadIndex];
+#else
+		params.m_Profile = nullptr;
+#endif
 		//params.m_OneColDiv2 = m_CarToRas.OneCol() / 2;
 		//params.m_OneRowDiv2 = m_CarToRas.OneRow() / 2;
 
@@ -1243,20 +1481,23 @@ EmberStats Renderer<T, bucketT>::Iterate(size_t iterCount, size_t temporalSample
 			m_Samples[threadIndex][0].m_ColorX = m_Rand[threadIndex].template Frand01<T>();
 
 			//Finally, iterate.
-			//t.Tic();
 			//Iterating, loop 3.
 			m_BadVals[threadIndex] += m_Iterator->Iterate(m_Ember, params, m_Samples[threadIndex].data(), m_Rand[threadIndex]);
-			//iterationTime += t.Toc();
+
+			//Read the clock directly rather than using Timing, which also queries the process CPU time and is too costly to call per sub batch.
+			auto accumBegin = Clock::now();
 
 			if (m_LockAccum)
 				m_AccumCs.Enter();
-			//t.Tic();
+
 			//Map temp buffer samples into the histogram using the palette for color.
-			Accumulate(m_Rand[threadIndex], m_Samples[threadIndex].data(), params.m_Count, &m_Dmap);
-			//accumulationTime += t.Toc();
+			Accumulate(m_Rand[threadIndex], m_Samples[threadIndex].data(), params.m_Count, &m_Dmap, hist, params.m_Profile);
+
 			if (m_LockAccum)
 				m_AccumCs.Leave();
 
+			m_HistMs[threadIndex] += duration<double, std::milli>(Clock::now() - accumBegin).count();
+
 			if (m_Callback && threadIndex == 0)
 			{
 				percent = 100.0 *
@@ -1289,6 +1530,9 @@ EmberStats Renderer<T, bucketT>::Iterate(size_t iterCount, size_t temporalSample
 				}
 			}
 		}
+
+		if (numa)
+			NumaTopology::Unpin();
 	});
 #ifdef TG
 	}
@@ -1298,8 +1542,15 @@ EmberStats Renderer<T, bucketT>::Iterate(size_t iterCount, size_t temporalSample
 
 	stats.m_Iters = std::accumulate(m_SubBatch.begin(), m_SubBatch.end(), 0ULL);//Sum of iter count of all threads.
 	stats.m_Badvals = std::accumulate(m_BadVals.begin(), m_BadVals.end(), 0ULL);
+	stats.m_HistMs = std::accumulate(m_HistMs.begin(), m_HistMs.end(), 0.0);
+#ifdef ITER_PROFILE
+
+	for (auto& profile : m_IterProfiles)
+		m_IterProfile += profile;
+
+#endif
 	stats.m_IterMs = m_IterTimer.Toc();
-	//t2.Toc(__FUNCTION__);
+	stats.m_IterCpuMs = m_IterTimer.ElapsedCpuTime();
 	return stats;
 }
 
@@ -1350,6 +1601,7 @@ template <typename T, typename bucketT> double			   Renderer<T, bucketT>::LowerL
 template <typename T, typename bucketT> double			   Renderer<T, bucketT>::UpperRightX(bool gutter) const { return double(gutter ? m_CarToRas.CarUrX() : m_UpperRightX); }
 template <typename T, typename bucketT> double			   Renderer<T, bucketT>::UpperRightY(bool gutter) const { return double(gutter ? m_CarToRas.CarUrY() : m_UpperRightY); }
 template <typename T, typename bucketT> DensityFilterBase* Renderer<T, bucketT>::GetDensityFilter()			    { return m_DensityFilter.get(); }
+template <typename T, typename bucketT> string			   Renderer<T, bucketT>::IterationProfileReport()  const { return m_IterProfile.Report(m_Ember); }
 
 /// <summary>
 /// Non-virtual ember wrappers, getters only.
@@ -1439,10 +1691,14 @@ void Renderer<T, bucketT>::PrepFinalAccumVals(Color<T>& background, T& g, T& lin
 /// <param name="samples">The samples to accumulate</param>
 /// <param name="sampleCount">The number of samples</param>
 /// <param name="palette">The palette to use</param>
+/// <param name="hist">The histogram to accumulate to, which is a NUMA node replica when NUMA aware</param>
+/// <param name="profile">The profile to count out of bounds points in, only used if ITER_PROFILE is defined. Default: nullptr.</param>
 template <typename T, typename bucketT>
-void Renderer<T, bucketT>::Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Point<T>* samples, size_t sampleCount, const Palette<bucketT>* palette)
+void Renderer<T, bucketT>::Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Point<T>* samples, size_t sampleCount, const Palette<bucketT>* palette, tvec4<bucketT, glm::defaultp>* hist, IterProfile* profile)
 {
 	size_t histIndex, intColorIndex, histSize = m_HistBuckets.size();
+	size_t bins = m_PaletteBins;
+	bool deferred = PaletteDeferred();
 	bucketT colorIndex, colorIndexFrac;
 	auto dmap = palette->m_Entries.data();
 	//T oneColDiv2 = m_CarToRas.OneCol() / 2;
@@ -1457,6 +1713,11 @@ void Renderer<T, bucketT>::Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Poin
 	//Original used a function called bump_no_overflow(). Just do a straight add because the type will always be float or double.
 	//Doing so gives a 25% speed increase.
 	//Splitting these conditionals into separate loops makes no speed difference.
+#ifdef ITER_PROFILE
+	if (profile)
+		profile->m_Accumulated += sampleCount;
+
+#endif
 	for (size_t i = 0; i < sampleCount && !m_Abort; i++)
 	{
 		Point<T> p(samples[i]);//Slightly faster to cache this.
@@ -1502,7 +1763,16 @@ void Renderer<T, bucketT>::Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Poin
 					//Fraction = 0.7
 					//Color = (dmap[25] * 0.3) + (dmap[26] * 0.7)
 					//Use overloaded addition and multiplication operators in vec4 to perform the accumulation.
-					if (PaletteMode() == PALETTE_LINEAR)
+					//If palette lookup is deferred, only record the weight and weighted color index in the bin the color index falls in.
+					//The palette is applied later in PaletteBinsToHistogram().
+					if (deferred)
+					{
+						auto& bin = m_PaletteBinBuckets[(histIndex * bins) + size_t(Clamp<T>(p.m_ColorX * bins, 0, T(bins - 1)))];//Clamp before casting so negative indices go to the first bin.
+
+						bin.x += bucketT(p.m_VizAdjusted);
+						bin.y += bucketT(p.m_ColorX * p.m_VizAdjusted);
+					}
+					else if (PaletteMode() == PALETTE_LINEAR)
 					{
 						colorIndex = bucketT(p.m_ColorX) * COLORMAP_LENGTH;
 						intColorIndex = size_t(colorIndex);
@@ -1523,25 +1793,221 @@ void Renderer<T, bucketT>::Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Poin
 						}
 
 						if (p.m_VizAdjusted == 1)
-							m_HistBuckets[histIndex] += ((dmap[intColorIndex] * (1 - colorIndexFrac)) + (dmap[intColorIndex + 1] * colorIndexFrac));
+							hist[histIndex] += ((dmap[intColorIndex] * (1 - colorIndexFrac)) + (dmap[intColorIndex + 1] * colorIndexFrac));
 						else
-							m_HistBuckets[histIndex] += (((dmap[intColorIndex] * (1 - colorIndexFrac)) + (dmap[intColorIndex + 1] * colorIndexFrac)) * bucketT(p.m_VizAdjusted));
+							hist[histIndex] += (((dmap[intColorIndex] * (1 - colorIndexFrac)) + (dmap[intColorIndex + 1] * colorIndexFrac)) * bucketT(p.m_VizAdjusted));
 					}
 					else if (PaletteMode() == PALETTE_STEP)
 					{
 						intColorIndex = Clamp<size_t>(size_t(p.m_ColorX * COLORMAP_LENGTH), 0, COLORMAP_LENGTH_MINUS_1);
 
 						if (p.m_VizAdjusted == 1)
-							m_HistBuckets[histIndex] += dmap[intColorIndex];
+							hist[histIndex] += dmap[intColorIndex];
 						else
-							m_HistBuckets[histIndex] += (dmap[intColorIndex] * bucketT(p.m_VizAdjusted));
+							hist[histIndex] += (dmap[intColorIndex] * bucketT(p.m_VizAdjusted));
 					}
 				}
 			}
 		}
+#ifdef ITER_PROFILE
+		else if (profile)
+		{
+			profile->m_OutOfBounds++;
+		}
+#endif
 	}
 }
 
+/// <summary>
+/// Whether palette lookup is deferred by accumulating into color index bins rather than directly into the histogram.
+/// This is only done with a single temporal sample because each temporal sample uses a different palette.
+/// </summary>
+/// <returns>True if palette bins are enabled and there is one temporal sample, else false.</returns>
+template <typename T, typename bucketT>
+bool Renderer<T, bucketT>::PaletteDeferred() const
+{
+	return m_PaletteBins > 0 && TemporalSamples() == 1;
+}
+
+/// <summary>
+/// Sum the NUMA node histogram replicas into the main histogram and clear them.
+/// Only does anything if iteration has accumulated into the replicas since the last call.
+/// This must be called before anything reads the histogram.
+/// </summary>
+template <typename T, typename bucketT>
+void Renderer<T, bucketT>::ReduceNodeHistograms()
+{
+	if (!m_NodeHistDirty)
+		return;
+
+	parallel_for(size_t(0), m_SuperRasH, [&] (size_t j)
+	{
+		size_t rowStart = j * m_SuperRasW;
+		size_t rowEnd = rowStart + m_SuperRasW;
+
+		for (auto& replica : m_NodeHistBuckets)
+		{
+			for (size_t i = rowStart; i < rowEnd; i++)
+			{
+				m_HistBuckets[i] += replica[i];
+				replica[i] = tvec4<bucketT, glm::defaultp>(0);
+			}
+		}
+	});
+
+	m_NodeHistDirty = false;
+}
+
+/// <summary>
+/// Clear a buffer to all zeroes with whichever strategy is cheapest for its size.
+/// Small buffers are cleared with a single memset(), since threading them costs more than it saves.
+/// Large buffers are cleared in parallel, unless they are large enough to be given back to the OS in
+/// exchange for fresh zero pages with HugePages::Discard(). Which of those two is cheaper depends on
+/// the memory bandwidth and the page fault cost of the system, so both are measured on the first large
+/// clear and the winner is used from then on.
+/// Fresh zero pages are cheap to clear, but every page faults when it's next touched, so the measurement
+/// of that strategy includes touching every page from all threads, the way iterating or filtering will.
+/// </summary>
+/// <param name="buffer">The buffer to clear, which must have been allocated with HugePageAllocator.</param>
+/// <param name="bytes">The size of the buffer in bytes</param>
+/// <param name="node">The NUMA node the buffer belongs to, or ANY_NUMA_NODE if it doesn't belong to one. Default: ANY_NUMA_NODE.</param>
+template <typename T, typename bucketT>
+void Renderer<T, bucketT>::ZeroBuffer(void* buffer, size_t bytes, size_t node)
+{
+	if (bytes < PARALLEL_CLEAR_BYTES)
+	{
+		memset(buffer, 0, bytes);
+		return;
+	}
+
+	if (bytes >= ZERO_PAGE_BYTES)
+	{
+		if (m_ResetStrategy == RESET_UNKNOWN)
+		{
+			Timing t;
+			bool discarded = HugePages::Discard(buffer, bytes);
+
+			if (discarded)
+				ParallelClear(buffer, bytes, node, true);
+
+			double discardMs = t.Toc();
+
+			t.Tic();
+			ParallelClear(buffer, bytes, node);
+			m_ResetStrategy = discarded && discardMs < t.Toc() ? RESET_DISCARD : RESET_CLEAR;
+			return;
+		}
+		else if (m_ResetStrategy == RESET_DISCARD && HugePages::Discard(buffer, bytes))
+		{
+			return;
+		}
+	}
+
+	ParallelClear(buffer, bytes, node);
+}
+
+/// <summary>
+/// Clear a buffer to all zeroes using all threads, each clearing a contiguous chunk.
+/// When NUMA awareness is in use and the buffer belongs to a node, every thread is pinned to that node.
+/// </summary>
+/// <param name="buffer">The buffer to clear</param>
+/// <param name="bytes">The size of the buffer in bytes</param>
+/// <param name="node">The NUMA node the buffer belongs to, or ANY_NUMA_NODE to not pin the threads.</param>
+/// <param name="touchOnly">If true, only write one byte per page rather than the whole buffer. Used for measuring the cost of faulting in fresh pages. Default: false.</param>
+template <typename T, typename bucketT>
+void Renderer<T, bucketT>::ParallelClear(void* buffer, size_t bytes, size_t node, bool touchOnly)
+{
+	bool numa = !m_NodeHistBuckets.empty() && node != ANY_NUMA_NODE;
+	size_t threads = std::max<size_t>(m_ThreadsToUse, 1);
+	size_t chunkSize = (((bytes / threads) + 4095) / 4096) * 4096;//Keep chunks page aligned so no page is shared by two threads.
+	byte* p = static_cast<byte*>(buffer);
+
+	parallel_for(size_t(0), threads, [&] (size_t threadIndex)
+	{
+		size_t start = std::min(threadIndex * chunkSize, bytes);
+		size_t end = std::min(start + chunkSize, bytes);
+
+		if (numa)
+			NumaTopology::PinToNode(node);
+
+		if (touchOnly)
+		{
+			for (size_t i = start; i < end; i += 4096)
+				p[i] = 0;
+		}
+		else
+			memset(p + start, 0, end - start);
+
+		if (numa)
+			NumaTopology::Unpin();
+	});
+}
+
+/// <summary>
+/// Build the histogram from the color index bins using the current palette.
+/// The mean color index of each bin is looked up in the palette the same way Accumulate() does,
+/// and the color is weighted by the number of hits in the bin.
+/// This is not abortable so the histogram is never left partially built, which would
+/// leave it invalid for a subsequent FILTER_AND_ACCUM.
+/// </summary>
+template <typename T, typename bucketT>
+void Renderer<T, bucketT>::PaletteBinsToHistogram()
+{
+	size_t bins = m_PaletteBins;
+	bool linear = PaletteMode() == PALETTE_LINEAR;
+	auto dmap = m_Dmap.m_Entries.data();
+
+	parallel_for(size_t(0), m_SuperRasH, [&] (size_t j)
+	{
+		size_t intColorIndex, row = j * m_SuperRasW;
+		bucketT colorIndex, colorIndexFrac;
+
+		for (size_t i = 0; i < m_SuperRasW; i++)
+		{
+			size_t index = row + i;
+			auto bin = &m_PaletteBinBuckets[index * bins];
+			tvec4<bucketT, glm::defaultp> bucket(0);
+
+			for (size_t b = 0; b < bins; b++)
+			{
+				if (bin[b].x != 0)
+				{
+					colorIndex = (bin[b].y / bin[b].x) * COLORMAP_LENGTH;//Mean color index of all hits in this bin.
+
+					if (linear)
+					{
+						intColorIndex = size_t(colorIndex);
+
+						if (colorIndex < 0)
+						{
+							intColorIndex = 0;
+							colorIndexFrac = 0;
+						}
+						else if (intColorIndex >= COLORMAP_LENGTH_MINUS_1)
+						{
+							intColorIndex = COLORMAP_LENGTH_MINUS_1 - 1;
+							colorIndexFrac = 1;
+						}
+						else
+						{
+							colorIndexFrac = colorIndex - bucketT(intColorIndex);
+						}
+
+						bucket += (((dmap[intColorIndex] * (1 - colorIndexFrac)) + (dmap[intColorIndex + 1] * colorIndexFrac)) * bin[b].x);
+					}
+					else
+					{
+						intColorIndex = colorIndex < 0 ? 0 : Clamp<size_t>(size_t(colorIndex), 0, COLORMAP_LENGTH_MINUS_1);
+						bucket += (dmap[intColorIndex] * bin[b].x);
+					}
+				}
+			}
+
+			m_HistBuckets[index] = bucket;
+		}
+	});
+}
+
 /// <summary>
 /// Add a value to the density filtering buffer with a bounds check.
 /// </summary>
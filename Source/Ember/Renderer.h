@@ -4,6 +4,7 @@
 #include "Iterator.h"
 #include "SpatialFilter.h"
 #include "TemporalFilter.h"
+#include "FilterCache.h"
 #include "Interpolate.h"
 #include "CarToRas.h"
 #include "EmberToXml.h"
@@ -77,6 +78,7 @@ protected:
 	virtual eRenderStatus AccumulatorToFinalImage(vector<byte>& pixels, size_t finalOffset);
 	virtual eRenderStatus AccumulatorToFinalImage(byte* pixels, size_t finalOffset);
 	virtual EmberStats Iterate(size_t iterCount, size_t temporalSample);
+	virtual double EstimateNoise();
 
 public:
 	//Non-virtual render properties, getters and setters.
@@ -102,6 +104,7 @@ public:
 	virtual double UpperRightX(bool gutter = true) const override;
 	virtual double UpperRightY(bool gutter = true) const override;
 	virtual DensityFilterBase* GetDensityFilter()        override;
+	virtual string IterationProfileReport()        const override;
 
 	//Non-virtual ember wrappers, getters only.
 	inline bool              XaosPresent()		   const;
@@ -150,7 +153,13 @@ protected:
 
 	private:
 	//Miscellaneous non-virtual functions used only in this class.
-	void Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Point<T>* samples, size_t sampleCount, const Palette<bucketT>* palette);
+	void Accumulate(QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, Point<T>* samples, size_t sampleCount, const Palette<bucketT>* palette, tvec4<bucketT, glm::defaultp>* hist, IterProfile* profile = nullptr);
+	bool PaletteDeferred() const;
+	void PaletteBinsToHistogram();
+	void ReduceNodeHistograms();
+	void ZeroBuffer(void* buffer, size_t bytes, size_t node = ANY_NUMA_NODE);
+	void ParallelClear(void* buffer, size_t bytes, size_t node, bool touchOnly = false);
+	size_t HostBufferBytes();
 	/*inline*/ void AddToAccum(const tvec4<bucketT, glm::defaultp>& bucket, intmax_t i, intmax_t ii, intmax_t j, intmax_t jj);
 	template <typename accumT> void GammaCorrection(tvec4<bucketT, glm::defaultp>& bucket, Color<T>& background, T g, T linRange, T vibrancy, bool doAlpha, bool scale, accumT* correctedChannels);
 	void CurveAdjust(T& a, const glm::length_t& index);
@@ -175,17 +184,22 @@ protected:
 	Ember<T> m_TempEmber;
 	Ember<T> m_LastEmber;
 	vector<Ember<T>> m_Embers;
+	Interpolater<T> m_Interpolater;
 	CarToRas<T> m_CarToRas;
 	Iterator<T>* m_Iterator;
 	unique_ptr<StandardIterator<T>> m_StandardIterator;
 	unique_ptr<XaosIterator<T>> m_XaosIterator;
 	Palette<bucketT> m_Dmap, m_Csa;
-	vector<tvec4<bucketT, glm::defaultp>> m_HistBuckets;
-	vector<tvec4<bucketT, glm::defaultp>> m_AccumulatorBuckets;
-	unique_ptr<SpatialFilter<T>> m_SpatialFilter;
-	unique_ptr<TemporalFilter<T>> m_TemporalFilter;
-	unique_ptr<DensityFilter<T>> m_DensityFilter;
-	vector<vector<Point<T>>> m_Samples;
+	vector<tvec4<bucketT, glm::defaultp>, HugePageAllocator<tvec4<bucketT, glm::defaultp>>> m_HistBuckets;//Large, randomly accessed buffers use huge pages to reduce TLB misses.
+	vector<tvec4<bucketT, glm::defaultp>, HugePageAllocator<tvec4<bucketT, glm::defaultp>>> m_AccumulatorBuckets;
+	vector<tvec2<bucketT, glm::defaultp>, HugePageAllocator<tvec2<bucketT, glm::defaultp>>> m_PaletteBinBuckets;
+	vector<vector<tvec4<bucketT, glm::defaultp>, HugePageAllocator<tvec4<bucketT, glm::defaultp>>>> m_NodeHistBuckets;//One replica per NUMA node after the first.
+	bool m_NodeHistDirty;
+	eResetStrategy m_ResetStrategy;//How large buffers are cleared, measured on the first large clear.
+	shared_ptr<SpatialFilter<T>> m_SpatialFilter;//Filters come from FilterCache and may be shared with other renderers, so they must never be modified.
+	shared_ptr<TemporalFilter<T>> m_TemporalFilter;
+	shared_ptr<DensityFilter<T>> m_DensityFilter;
+	vector<vector<Point<T>, HugePageAllocator<Point<T>>>> m_Samples;
 	EmberToXml<T> m_EmberToXml;
 };
 
@@ -19,6 +19,8 @@ RendererBase::RendererBase()
 	m_CurvesSet = false;
 	m_NumChannels = 3;
 	m_BytesPerChannel = 1;
+	m_PaletteBins = 0;
+	m_NumaAware = false;
 	m_SuperSize = 0;
 	m_Transparency = false;
 	ThreadCount(Timing::ProcessorCount());
@@ -26,7 +28,10 @@ RendererBase::RendererBase()
 	m_ProgressParameter = nullptr;
 	m_LastTemporalSample = 0;
 	m_LastIter = 0;
+	m_AdaptiveIters = 0;
 	m_LastIterPercent = 0;
+	m_TargetNoise = 0;
+	m_MaxIterScale = 4;
 	m_InteractiveFilter = FILTER_LOG;
 	m_ProcessState = NONE;
 	m_ProcessAction = FULL_RENDER;
@@ -91,6 +96,27 @@ void RendererBase::ChangeVal(std::function<void(void)> func, eProcessAction acti
 			m_ProcessAction = FILTER_AND_ACCUM;
 		}
 	}
+	//Only the palette changed, so re-project the color index binned histogram through the new palette, then filter and accum.
+	else if (action == PALETTE_AND_ACCUM)
+	{
+		//Binned counts are not kept without palette bins or with multiple temporal samples, so just start over.
+		if (m_PaletteBins == 0 || TemporalSamples() > 1 || m_ProcessState == NONE)
+		{
+			m_ProcessState = NONE;
+			m_ProcessAction = FULL_RENDER;
+		}
+		//In the middle of iterating, the new palette only needs to be picked up and iterating can continue.
+		else if (m_ProcessState == ITER_STARTED)
+		{
+			m_ProcessAction = PALETTE_AND_ACCUM;
+		}
+		//Set the state to ITER_DONE and the next process action to PALETTE_AND_ACCUM.
+		else
+		{
+			m_ProcessState = ITER_DONE;
+			m_ProcessAction = PALETTE_AND_ACCUM;
+		}
+	}
 	//Run accum only.
 	else if (action == ACCUM_ONLY)
 	{
@@ -130,7 +156,9 @@ size_t RendererBase::HistMemoryRequired(size_t strips)
 	ComputeBounds();
 
 	//Because ComputeBounds() was called, this includes gutter.
-	return (SuperSize() * HistBucketSize()) / strips;
+	//Each palette bin holds a weight and a color index sum, which is half the size of a histogram bucket.
+	//Each NUMA node other than the first keeps a full histogram replica.
+	return (SuperSize() * (HistBucketSize() + (m_PaletteBins * HistBucketSize() / 2) + (NumaReplicas() * HistBucketSize()))) / strips;
 }
 
 /// <summary>
@@ -151,7 +179,7 @@ pair<size_t, size_t> RendererBase::MemoryRequired(size_t strips, bool includeFin
 
 	outSize *= (threadedWrite ? 2 : 1);
 	p.first = HistMemoryRequired(strips);
-	p.second = (p.first * 2) + outSize;//Multiply hist by 2 to account for the density filtering buffer which is the same size as the histogram.
+	p.second = p.first + ((SuperSize() * HistBucketSize()) / strips) + outSize;//Add the density filtering buffer which is the same size as the histogram, excluding palette bins.
 
 	return p;
 }
@@ -307,6 +335,13 @@ eProcessState  RendererBase::ProcessState()				   const { return m_ProcessState;
 eProcessAction RendererBase::ProcessAction()			   const { return m_ProcessAction; }
 EmberStats     RendererBase::Stats()					   const { return m_Stats; }
 
+/// <summary>
+/// Get the iteration profile of the current render.
+/// This is only populated if ITER_PROFILE is defined.
+/// </summary>
+/// <returns>The profile summed over all threads</returns>
+const IterProfile& RendererBase::IterationProfile() const { return m_IterProfile; }
+
 /// <summary>
 /// Non-virtual render properties, getters and setters.
 /// </summary>
@@ -446,13 +481,13 @@ void RendererBase::Callback(RenderCallback* callback)
 /// This will also reset the vector of random contexts to be the same size
 /// as the number of specified threads.
 /// Since this is where they get set up, the caller can optionally pass in
-/// a seed string, however it's only used if threads is 1.
-/// This is useful for debugging since it will run the same point trajectory
-/// every time.
+/// a seed string. Each thread's random context is then derived only from the seed
+/// and the thread's index, so every thread runs the same point trajectory every time.
+/// This is useful for debugging and benchmarking.
 /// Reset the rendering process.
 /// </summary>
 /// <param name="threads">The number of threads to use</param>
-/// <param name="seedString">The seed string to use if threads is 1. Default: nullptr.</param>
+/// <param name="seedString">The seed string to use, nullptr to seed from the time. Default: nullptr.</param>
 void RendererBase::ThreadCount(size_t threads, const char* seedString)
 {
 	ChangeVal([&]
@@ -466,6 +501,8 @@ void RendererBase::ThreadCount(size_t threads, const char* seedString)
 		m_SubBatch.clear();
 		m_SubBatch.resize(m_ThreadsToUse);
 		m_BadVals.resize(m_ThreadsToUse);
+		m_HistMs.resize(m_ThreadsToUse);
+		m_IterProfiles.resize(m_ThreadsToUse);
 
 		if (seedString)
 		{
@@ -481,7 +518,7 @@ void RendererBase::ThreadCount(size_t threads, const char* seedString)
 
 			if (seedString)
 			{
-				ISAAC_INT newSize = ISAAC_INT(size + 5 + (t.Toc() + t.EndTime()));
+				ISAAC_INT newSize = ISAAC_INT(size + 5);//Must not depend on the time, else the sequence would differ between runs.
 
 #ifdef ISAAC_FLAM3_DEBUG
 				QTIsaac<ISAAC_SIZE, ISAAC_INT> isaac(0, 0, 0, seeds);
@@ -546,6 +583,35 @@ void RendererBase::BytesPerChannel(size_t bytesPerChannel)
 /// <returns>The number of channels per pixel in the output image</returns>
 size_t RendererBase::NumChannels() const { return m_NumChannels; }
 
+/// <summary>
+/// Get the number of color index bins kept per pixel when deferring palette lookup.
+/// When non-zero, iteration accumulates hit counts binned by color index rather than
+/// palette colors, so a palette change only requires re-projecting the bins through the new
+/// palette, followed by filtering and final accumulation. See PALETTE_AND_ACCUM.
+/// Default: 0, meaning colors are looked up from the palette while iterating.
+/// </summary>
+/// <returns>The number of color index bins per pixel</returns>
+size_t RendererBase::PaletteBins() const { return m_PaletteBins; }
+
+/// <summary>
+/// Get whether histogram placement and threads are NUMA aware.
+/// When true on a system with more than one NUMA node, the threads of each node
+/// accumulate into their own histogram replica, allocated on that node, which are summed
+/// into the main histogram before it's read. Iteration, density filtering and final
+/// accumulation threads are pinned to the nodes which own the rows they process.
+/// This is not used when palette lookup is deferred.
+/// Default: false.
+/// </summary>
+/// <returns>True if NUMA aware, else false.</returns>
+bool RendererBase::NumaAware() const { return m_NumaAware; }
+
+/// <summary>
+/// Get the number of histogram replicas in use for NUMA aware rendering.
+/// The first node uses the main histogram, so this is one less than the number of nodes.
+/// </summary>
+/// <returns>The number of replicas, 0 if NUMA awareness is disabled or not applicable.</returns>
+size_t RendererBase::NumaReplicas() const { return (m_NumaAware && m_PaletteBins == 0) ? NumaTopology::NodeCount() - 1 : 0; }
+
 /// <summary>
 /// Get the type of filter to use for preview renders during interactive rendering.
 /// Using basic log scaling is quicker, but doesn't provide any bluring.
@@ -569,6 +635,47 @@ void RendererBase::InteractiveFilter(eInteractiveFilter filter)
 	ChangeVal([&] { m_InteractiveFilter = filter; }, FULL_RENDER);
 }
 
+/// <summary>
+/// Get the target relative noise used for adaptive iteration.
+/// When non-zero, rather than running the number of iterations specified by the quality,
+/// the noise of the histogram is periodically estimated while iterating. Iteration stops
+/// as soon as the estimated noise is at or below this value, or when the number of iterations
+/// reaches the quality based count multiplied by MaxIterScale().
+/// The brightness of the output is normalized to the number of iterations actually run.
+/// Default: 0, meaning the quality is used.
+/// </summary>
+/// <returns>The target relative noise</returns>
+double RendererBase::TargetNoise() const { return m_TargetNoise; }
+
+/// <summary>
+/// Set the target relative noise used for adaptive iteration.
+/// Reasonable values are between 0.01 and 0.05.
+/// Reset the rendering process.
+/// </summary>
+/// <param name="targetNoise">The target relative noise, 0 to disable adaptive iteration.</param>
+void RendererBase::TargetNoise(double targetNoise)
+{
+	ChangeVal([&] { m_TargetNoise = std::max(0.0, targetNoise); }, FULL_RENDER);
+}
+
+/// <summary>
+/// Get the maximum multiple of the quality based iteration count that adaptive iteration may run.
+/// Default: 4.
+/// </summary>
+/// <returns>The maximum iteration scale</returns>
+double RendererBase::MaxIterScale() const { return m_MaxIterScale; }
+
+/// <summary>
+/// Set the maximum multiple of the quality based iteration count that adaptive iteration may run.
+/// Values less than 1 will prevent adaptive iteration from ever exceeding the quality.
+/// Reset the rendering process.
+/// </summary>
+/// <param name="maxIterScale">The maximum iteration scale, must be greater than 0.</param>
+void RendererBase::MaxIterScale(double maxIterScale)
+{
+	ChangeVal([&] { m_MaxIterScale = maxIterScale > 0 ? maxIterScale : 1; }, FULL_RENDER);
+}
+
 /// <summary>
 /// Virtual render properties, getters and setters.
 /// </summary>
@@ -585,6 +692,28 @@ void RendererBase::NumChannels(size_t numChannels)
 	ChangeVal([&] { m_NumChannels = numChannels; }, ACCUM_ONLY);
 }
 
+/// <summary>
+/// Set the number of color index bins kept per pixel when deferring palette lookup.
+/// Values between 16 and 64 give a good tradeoff between accuracy and memory.
+/// Values greater than COLORMAP_LENGTH are clamped to it.
+/// Reset the rendering process.
+/// </summary>
+/// <param name="paletteBins">The number of color index bins per pixel, 0 to disable.</param>
+void RendererBase::PaletteBins(size_t paletteBins)
+{
+	ChangeVal([&] { m_PaletteBins = std::min<size_t>(paletteBins, COLORMAP_LENGTH); }, FULL_RENDER);
+}
+
+/// <summary>
+/// Set whether histogram placement and threads are NUMA aware.
+/// Reset the rendering process.
+/// </summary>
+/// <param name="numaAware">True to enable NUMA awareness, else false.</param>
+void RendererBase::NumaAware(bool numaAware)
+{
+	ChangeVal([&] { m_NumaAware = numaAware; }, FULL_RENDER);
+}
+
 /// <summary>
 /// Get the number of threads used when rendering.
 /// Default: use all avaliable cores.
@@ -599,6 +728,13 @@ size_t RendererBase::ThreadCount() const { return m_ThreadsToUse; }
 /// <returns>CPU_RENDERER</returns>
 eRendererType RendererBase::RendererType() const { return CPU_RENDERER; }
 
+/// <summary>
+/// Get a human readable report of the iteration profile of the current render.
+/// Derived classes which know the ember being rendered override this.
+/// </summary>
+/// <returns>An empty string</returns>
+string RendererBase::IterationProfileReport() const { return ""; }
+
 /// <summary>
 /// //Non-virtual threading control.
 /// </summary>
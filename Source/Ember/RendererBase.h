@@ -3,6 +3,9 @@
 #include "Utils.h"
 #include "Ember.h"
 #include "DensityFilter.h"
+#include "Numa.h"
+#include "HugePages.h"
+#include "IterProfile.h"
 
 /// <summary>
 /// RendererBase, RenderCallback and EmberStats classes.
@@ -44,6 +47,24 @@ public:
 /// number of bad values calculated during iteration, and
 /// the total time for the entire render from the start of
 /// iteration to the end of final accumulation.
+/// The time spent in each stage is also recorded separately, summed over all calls to Run().
+/// Each stage records both its elapsed time and the CPU time the process used during it.
+/// Since the CPU time covers all threads of the process, a stage which overlaps with another,
+/// such as writing a file on a separate thread while the next image renders, includes the CPU
+/// time of both.
+/// The stages are:
+///		Interp: Interpolating the ember for each temporal sample.
+///		Alloc: Allocating and clearing the histogram, accumulator and sample buffers.
+///		Iter: Iterating and accumulating into the histogram.
+///		Hist: The part of Iter spent accumulating into the histogram, summed over all threads. There is no CPU time for this stage.
+///		Filter: Density filtering.
+///		Accum: Final accumulation.
+///		Encode, Write: Converting the final image for output and writing it to a file. Filled in by the programs which write the files.
+/// The number of bytes newly allocated by Alloc, and the number of bytes the host buffers hold at the end are recorded as well.
+/// When adaptive iteration is used, the estimated relative noise
+/// achieved and the number of iterations saved compared to the
+/// quality based count are also recorded. The latter is negative
+/// if more iterations than the quality specified were needed.
 /// </summary>
 class EMBER_API EmberStats
 {
@@ -60,21 +81,63 @@ public:
 	{
 		m_Iters = 0;
 		m_Badvals = 0;
+		m_AllocBytes = 0;
+		m_BufferBytes = 0;
 		m_IterMs = 0;
 		m_RenderMs = 0;
+		m_FilterMs = 0;
+		m_AccumMs = 0;
+		m_Noise = 0;
+		m_ItersSaved = 0;
+		m_InterpMs = 0;
+		m_AllocMs = 0;
+		m_HistMs = 0;
+		m_EncodeMs = 0;
+		m_WriteMs = 0;
+		m_InterpCpuMs = 0;
+		m_AllocCpuMs = 0;
+		m_IterCpuMs = 0;
+		m_FilterCpuMs = 0;
+		m_AccumCpuMs = 0;
+		m_EncodeCpuMs = 0;
+		m_WriteCpuMs = 0;
+		m_RenderCpuMs = 0;
 	}
 
 	EmberStats& operator += (const EmberStats& stats)
 	{
 		m_Iters += stats.m_Iters;
 		m_Badvals += stats.m_Badvals;
+		m_AllocBytes += stats.m_AllocBytes;
+		m_BufferBytes = std::max(m_BufferBytes, stats.m_BufferBytes);
 		m_IterMs += stats.m_IterMs;
 		m_RenderMs += stats.m_RenderMs;
+		m_FilterMs += stats.m_FilterMs;
+		m_AccumMs += stats.m_AccumMs;
+		m_Noise = std::max(m_Noise, stats.m_Noise);//Report the noisiest part, such as a strip, rather than the sum.
+		m_ItersSaved += stats.m_ItersSaved;
+		m_InterpMs += stats.m_InterpMs;
+		m_AllocMs += stats.m_AllocMs;
+		m_HistMs += stats.m_HistMs;
+		m_EncodeMs += stats.m_EncodeMs;
+		m_WriteMs += stats.m_WriteMs;
+		m_InterpCpuMs += stats.m_InterpCpuMs;
+		m_AllocCpuMs += stats.m_AllocCpuMs;
+		m_IterCpuMs += stats.m_IterCpuMs;
+		m_FilterCpuMs += stats.m_FilterCpuMs;
+		m_AccumCpuMs += stats.m_AccumCpuMs;
+		m_EncodeCpuMs += stats.m_EncodeCpuMs;
+		m_WriteCpuMs += stats.m_WriteCpuMs;
+		m_RenderCpuMs += stats.m_RenderCpuMs;
 		return *this;
 	}
 
 	size_t m_Iters, m_Badvals;
-	double m_IterMs, m_RenderMs;
+	size_t m_AllocBytes, m_BufferBytes;
+	intmax_t m_ItersSaved;
+	double m_IterMs, m_RenderMs, m_FilterMs, m_AccumMs, m_Noise;
+	double m_InterpMs, m_AllocMs, m_HistMs, m_EncodeMs, m_WriteMs;
+	double m_InterpCpuMs, m_AllocCpuMs, m_IterCpuMs, m_FilterCpuMs, m_AccumCpuMs, m_EncodeCpuMs, m_WriteCpuMs, m_RenderCpuMs;
 };
 
 /// <summary>
@@ -138,6 +201,7 @@ public:
 	eProcessState  ProcessState()				 const;
 	eProcessAction ProcessAction()				 const;
 	EmberStats     Stats() 						 const;
+	const IterProfile& IterationProfile()		 const;
 
 	//Non-virtual render getters and setters.
 	bool LockAccum() const;
@@ -157,13 +221,23 @@ public:
 	size_t BytesPerChannel() const;
 	void BytesPerChannel(size_t bytesPerChannel);
 	size_t NumChannels() const;
+	size_t PaletteBins() const;
+	bool NumaAware() const;
+	size_t NumaReplicas() const;
 	eInteractiveFilter InteractiveFilter() const;
 	void InteractiveFilter(eInteractiveFilter filter);
+	double TargetNoise() const;
+	void TargetNoise(double targetNoise);
+	double MaxIterScale() const;
+	void MaxIterScale(double maxIterScale);
 
 	//Virtual render properties, getters and setters.
 	virtual void NumChannels(size_t numChannels);
+	virtual void PaletteBins(size_t paletteBins);
+	virtual void NumaAware(bool numaAware);
 	virtual size_t ThreadCount()   const;
 	virtual eRendererType RendererType() const;
+	virtual string IterationProfileReport() const;
 
 	//Abstract render properties, getters only.
 	virtual size_t TemporalSamples()			   const = 0;
@@ -203,6 +277,7 @@ protected:
 	bool m_InsertPalette;
 	bool m_ReclaimOnResize;
 	bool m_CurvesSet;
+	bool m_NumaAware;
 	volatile bool m_Abort;
 	size_t m_SuperRasW;
 	size_t m_SuperRasH;
@@ -211,11 +286,15 @@ protected:
 	size_t m_DensityFilterOffset;
 	size_t m_NumChannels;
 	size_t m_BytesPerChannel;
+	size_t m_PaletteBins;
 	size_t m_ThreadsToUse;
 	size_t m_VibGamCount;
 	size_t m_LastTemporalSample;
 	size_t m_LastIter;
+	size_t m_AdaptiveIters;
 	double m_LastIterPercent;
+	double m_TargetNoise;
+	double m_MaxIterScale;
 	eProcessAction m_ProcessAction;
 	eProcessState m_ProcessState;
 	eInteractiveFilter m_InteractiveFilter;
@@ -223,9 +302,12 @@ protected:
 	RenderCallback* m_Callback;
 	vector<size_t> m_SubBatch;
 	vector<size_t> m_BadVals;
+	vector<double> m_HistMs;//Time each thread spent accumulating into the histogram during the last call to Iterate().
+	vector<IterProfile> m_IterProfiles;//The iteration profile of each thread during the last call to Iterate(), only used if ITER_PROFILE is defined.
+	IterProfile m_IterProfile;//The sum of m_IterProfiles over the whole render.
 	vector<QTIsaac<ISAAC_SIZE, ISAAC_INT>> m_Rand;
 	auto_ptr<tbb::task_group> m_TaskGroup;
 	CriticalSection m_RenderingCs, m_AccumCs, m_FinalAccumCs, m_ResizeCs;
-	Timing m_RenderTimer, m_IterTimer, m_ProgressTimer;
+	Timing m_RenderTimer, m_IterTimer, m_ProgressTimer, m_StageTimer;
 };
 }
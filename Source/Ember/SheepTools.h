@@ -1103,8 +1103,7 @@ public:
 
 		//Create the edit doc xml.
 		sprintf_s(temp, 50, "rotate %g", blend * 360.0);
-		result.ClearEdit();
-		result.m_Edits = m_EmberToXml.CreateNewEditdoc(&parent, nullptr, temp, m_Nick, m_Url, m_Id, m_Comment, m_SheepGen, m_SheepId);
+		result.SetEdit(m_EmberToXml.CreateNewEditdoc(&parent, nullptr, temp, m_Nick, m_Url, m_Id, m_Comment, m_SheepGen, m_SheepId));
 
 		//Subpixel jitter.
 		Offset(result, m_OffsetX, m_OffsetY);
@@ -1144,8 +1143,7 @@ public:
 
 		//Create the edit doc xml.
 		sprintf_s(temp, 50, "interpolate %g", blend * 360.0);
-		result.ClearEdit();
-		result.m_Edits = m_EmberToXml.CreateNewEditdoc(&parents[0], &parents[1], temp, m_Nick, m_Url, m_Id, m_Comment, m_SheepGen, m_SheepId);
+		result.SetEdit(m_EmberToXml.CreateNewEditdoc(&parents[0], &parents[1], temp, m_Nick, m_Url, m_Id, m_Comment, m_SheepGen, m_SheepId));
 
 		//Subpixel jitter.
 		Offset(result, m_OffsetX, m_OffsetY);
@@ -1300,6 +1298,7 @@ public:
 		m_Samples.resize(samples);
 		params.m_Count = samples;
 		params.m_Skip = 20;
+		params.m_Profile = nullptr;
 		//params.m_OneColDiv2 = m_Renderer->CoordMap()->OneCol() / 2;
 		//params.m_OneRowDiv2 = m_Renderer->CoordMap()->OneRow() / 2;
 
@@ -13,6 +13,8 @@ namespace EmberNs
 /// of both the development process and the execution results. This class provides an easy way to time
 /// things by simply calling its Tic() and Toc() member functions. It also assists with formatting the
 /// elapsed time as a string.
+/// The CPU time used by the whole process between Tic() and Toc() is recorded as well, so comparing it to the
+/// elapsed time shows how well a stage made use of the available cores.
 /// </summary>
 class EMBER_API Timing
 {
@@ -25,6 +27,7 @@ public:
 	Timing(int precision = 2)
 	{
 		m_Precision = precision;
+		m_EndCpuTime = 0;
 		Init();
 		Tic();
 	}
@@ -36,6 +39,7 @@ public:
 	double Tic()
 	{
 		m_BeginTime = Clock::now();
+		m_BeginCpuTime = CpuTime();
 		return BeginTime();
 	}
 
@@ -48,6 +52,7 @@ public:
 	double Toc(const char* str = nullptr, bool fullString = false)
 	{
 		m_EndTime = Clock::now();
+		m_EndCpuTime = CpuTime();
 		double ms = ElapsedTime();
 
 		if (str != nullptr)
@@ -58,6 +63,22 @@ public:
 		return ms;
 	}
 
+	/// <summary>
+	/// Set the end time and add the elapsed time and CPU time to running totals,
+	/// such as the fields of a stage in EmberStats.
+	/// </summary>
+	/// <param name="ms">The elapsed time total to add to</param>
+	/// <param name="cpuMs">The CPU time total to add to</param>
+	/// <returns>The elapsed time in milliseconds as a double</returns>
+	double Toc(double& ms, double& cpuMs)
+	{
+		double elapsed = Toc();
+
+		ms += elapsed;
+		cpuMs += ElapsedCpuTime();
+		return elapsed;
+	}
+
 	/// <summary>
 	/// Return the begin time as a double.
 	/// </summary>
@@ -81,6 +102,37 @@ public:
 		return elapsed.count() * 1000.0;
 	}
 
+	/// <summary>
+	/// Return the CPU time used by all threads of the process between the last calls to Tic() and Toc().
+	/// </summary>
+	/// <returns>The CPU time in milliseconds as a double</returns>
+	double ElapsedCpuTime() { return m_EndCpuTime - m_BeginCpuTime; }
+
+	/// <summary>
+	/// Return the CPU time used by all threads of the process since it started.
+	/// </summary>
+	/// <returns>The CPU time in milliseconds as a double</returns>
+	static double CpuTime()
+	{
+#if defined(_WIN32)
+		FILETIME create, exit, kernel, user;
+
+		if (GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+			return ((double(kernel.dwHighDateTime) + double(user.dwHighDateTime)) * 4294967296.0 + double(kernel.dwLowDateTime) + double(user.dwLowDateTime)) / 10000.0;//100ns units.
+
+		return 0;
+#elif defined(CLOCK_PROCESS_CPUTIME_ID)
+		timespec ts;
+
+		if (!clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts))
+			return (double(ts.tv_sec) * 1000.0) + (double(ts.tv_nsec) / 1000000.0);
+
+		return 0;
+#else
+		return (double(clock()) * 1000.0) / CLOCKS_PER_SEC;
+#endif
+	}
+
 	/// <summary>
 	/// Formats a specified milliseconds value as a string.
 	/// This uses some intelligence to determine what to return depending on how much time has elapsed.
@@ -143,6 +195,8 @@ private:
 	int m_Precision;//How many digits after the decimal place to print for seconds.
 	time_point<Clock> m_BeginTime;//The start of the timing, set with Tic().
 	time_point<Clock> m_EndTime;//The end of the timing, set with Toc().
+	double m_BeginCpuTime;//The CPU time of the process in ms, set with Tic().
+	double m_EndCpuTime;//The CPU time of the process in ms, set with Toc().
 	static bool m_TimingInit;//Whether the performance info has bee queried.
 	static uint m_ProcessorCount;//The number of cores on the system, set in Init().
 };
@@ -26,8 +26,8 @@ static inline bool FindIf(c& container, pr pred)
 /// </summary>
 /// <param name="vec">The vector to compute the size of</param>
 /// <returns>The size of one element times the length.</returns>
-template<typename T>
-static inline size_t SizeOf(vector<T>& vec)
+template<typename T, typename Alloc>
+static inline size_t SizeOf(vector<T, Alloc>& vec)
 {
 	return sizeof(vec[0]) * vec.size();
 }
@@ -56,12 +56,16 @@ public:
 		m_Badvals = "";
 		m_NumIters = "";
 		m_Runtime = "";
+		m_Noise = "";
+		m_ItersSaved = "";
 	}
 
 	string m_Genome;
 	string m_Badvals;
 	string m_NumIters;
 	string m_Runtime;
+	string m_Noise;
+	string m_ItersSaved;
 };
 
 /// <summary>
@@ -146,6 +150,184 @@ protected:
 	vector<string> m_ErrorReport;
 };
 
+/// <summary>
+/// Hash functor for unordered containers keyed on names which are compared with _stricmp().
+/// The hash ignores case so it agrees with the comparison on all platforms.
+/// </summary>
+struct EMBER_API NameHash
+{
+	size_t operator() (const string& s) const
+	{
+		size_t h = 2166136261u;//FNV-1a.
+
+		for (auto c : s)
+			h = (h ^ size_t(tolower(static_cast<unsigned char>(c)))) * 16777619u;
+
+		return h;
+	}
+};
+
+/// <summary>
+/// Equality functor for unordered containers keyed on names, which uses _stricmp().
+/// </summary>
+struct EMBER_API NameEqual
+{
+	bool operator() (const string& s1, const string& s2) const { return !_stricmp(s1.c_str(), s2.c_str()); }
+};
+
+/// <summary>
+/// A read only memory map of an entire file.
+/// Reading a file this way lets the OS page it in on demand and share the pages with its own cache,
+/// rather than copying the whole file into a buffer up front.
+/// The map is released in the destructor, so pointers into it must not be kept past the life of the object.
+/// </summary>
+class EMBER_API MappedFile
+{
+public:
+	/// <summary>
+	/// Constructor which does not map anything.
+	/// </summary>
+	MappedFile()
+		: m_Data(nullptr), m_Size(0)
+	{
+#ifdef _WIN32
+		m_File = INVALID_HANDLE_VALUE;
+		m_Mapping = nullptr;
+#endif
+	}
+
+	/// <summary>
+	/// Destructor which unmaps the file.
+	/// </summary>
+	~MappedFile()
+	{
+		Close();
+	}
+
+	/// <summary>
+	/// Map the entire contents of a file, unmapping any previous one first.
+	/// An empty file is opened successfully, but has no data.
+	/// </summary>
+	/// <param name="filename">The full path to the file to map</param>
+	/// <returns>True if success, else false.</returns>
+	bool Open(const char* filename)
+	{
+		Close();
+#ifdef _WIN32
+		LARGE_INTEGER size;
+
+		if ((m_File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)) == INVALID_HANDLE_VALUE)
+			return false;
+
+		if (!GetFileSizeEx(m_File, &size))
+		{
+			Close();
+			return false;
+		}
+
+		if ((m_Size = size_t(size.QuadPart)) == 0)
+			return true;
+
+		if (!(m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr)) ||
+			!(m_Data = static_cast<const byte*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0))))
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+#else
+		bool b = false;
+		struct stat statBuf;
+		int fd = open(filename, O_RDONLY);
+
+		if (fd != -1)
+		{
+			if (fstat(fd, &statBuf) == 0)
+			{
+				if (statBuf.st_size == 0)
+				{
+					b = true;
+				}
+				else
+				{
+					void* p = mmap(nullptr, size_t(statBuf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+					if (p != MAP_FAILED)
+					{
+						m_Data = static_cast<const byte*>(p);
+						m_Size = size_t(statBuf.st_size);
+						madvise(p, m_Size, MADV_SEQUENTIAL);//Only a hint, so ignore failure.
+						b = true;
+					}
+				}
+			}
+
+			close(fd);//The map keeps its own reference to the file.
+		}
+
+		return b;
+#endif
+	}
+
+	/// <summary>
+	/// Unmap the file if one is mapped.
+	/// </summary>
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+
+		if (m_File != INVALID_HANDLE_VALUE)
+			CloseHandle(m_File);
+
+		m_File = INVALID_HANDLE_VALUE;
+		m_Mapping = nullptr;
+#else
+		if (m_Data)
+			munmap(const_cast<byte*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+	/// <summary>
+	/// Accessors.
+	/// </summary>
+	const byte* Data() const { return m_Data; }
+	size_t Size() const { return m_Size; }
+
+private:
+	/// <summary>
+	/// Copy constructor and assignment operator which are not implemented since the map can't be shared.
+	/// </summary>
+	MappedFile(const MappedFile& file);
+	MappedFile& operator = (const MappedFile& file);
+
+	const byte* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	HANDLE m_File;
+	HANDLE m_Mapping;
+#endif
+};
+
+/// <summary>
+/// Get the size of a file without opening it.
+/// </summary>
+/// <param name="filename">The full path to the file</param>
+/// <returns>The size of the file in bytes, 0 if it doesn't exist or couldn't be queried.</returns>
+static size_t FileSize(const string& filename)
+{
+	struct _stat statBuf;
+
+	return _stat(filename.c_str(), &statBuf) == 0 ? size_t(statBuf.st_size) : 0;
+}
+
 /// <summary>
 /// Open a file in binary mode and read its entire contents into a vector of bytes. Optionally null terminate.
 /// </summary>
@@ -272,8 +454,8 @@ static void ClearVec(vector<T*>& vec, bool arrayDelete = false)
 /// </summary>
 /// <param name="vec">The vector to memset</param>
 /// <param name="val">The value to set each element to, default 0.</param>
-template<typename T>
-static inline void Memset(vector<T>& vec, int val = 0)
+template<typename T, typename Alloc>
+static inline void Memset(vector<T, Alloc>& vec, int val = 0)
 {
 	memset(static_cast<void*>(vec.data()), val, SizeOf(vec));
 }
@@ -692,6 +874,417 @@ static inline bool Compare(const xmlChar* name, const char* val)
 	return xmlStrcmp(name, XC(val)) != 0;
 }
 
+/// <summary>
+/// Convert the start of a string to a double, in the manner of std::from_chars().
+/// Unlike strtod(), this doesn't use errno, so it's safe to call from multiple threads, and doesn't depend on the locale.
+/// Nearly all numbers in flame files have few enough significant digits and a small enough exponent that their
+/// value can be computed exactly from an integer mantissa and a power of ten, which is much faster than strtod().
+/// Anything else, such as very long or very large numbers, hex, inf or nan, is passed to strtod() so the result is
+/// always correctly rounded. Leading whitespace is skipped, the same as strtod().
+/// </summary>
+/// <param name="str">The string to convert</param>
+/// <param name="val">The converted value</param>
+/// <returns>Pointer to the first character after the number, str itself if no number was found, or nullptr if it was out of range.</returns>
+static const char* FromChars(const char* str, double& val)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	bool neg = false, fallback = false;
+	int sigDigits = 0, digits = 0, exponent = 0;
+	uint64_t mantissa = 0;
+	const char* p = str;
+
+	while (isspace(static_cast<unsigned char>(*p)))
+		p++;
+
+	if (*p == '-' || *p == '+')
+		neg = *p++ == '-';
+
+	for (; *p >= '0' && *p <= '9'; p++, digits++)
+	{
+		if (mantissa || *p != '0')
+			fallback |= ++sigDigits > 15;
+
+		mantissa = (mantissa * 10) + (*p - '0');
+	}
+
+	if (*p == '.')
+	{
+		for (p++; *p >= '0' && *p <= '9'; p++, digits++, exponent--)
+		{
+			if (mantissa || *p != '0')
+				fallback |= ++sigDigits > 15;
+
+			mantissa = (mantissa * 10) + (*p - '0');
+		}
+	}
+
+	if (digits && (*p == 'e' || *p == 'E'))
+	{
+		int expVal = 0;
+		bool expNeg = false;
+		const char* e = p + 1;
+
+		if (*e == '-' || *e == '+')
+			expNeg = *e++ == '-';
+
+		if (*e >= '0' && *e <= '9')//Otherwise the e is not part of the number, the same as strtod().
+		{
+			for (; *e >= '0' && *e <= '9'; e++)
+				if (expVal < 10000)
+					expVal = (expVal * 10) + (*e - '0');
+
+			exponent += expNeg ? -expVal : expVal;
+			p = e;
+		}
+	}
+
+	if (digits && !fallback && *p != 'x' && *p != 'X')
+	{
+		if (mantissa == 0)
+		{
+			val = neg ? -0.0 : 0.0;
+			return p;
+		}
+		else if (exponent >= -22 && exponent <= 22)
+		{
+			val = exponent < 0 ? double(mantissa) / powers[-exponent] : double(mantissa) * powers[exponent];
+			val = neg ? -val : val;
+			return p;
+		}
+	}
+
+	//Not a simple number, so let strtod() handle it. Check for overflow by looking at the result rather than errno.
+	char* endp;
+
+	val = strtod(str, &endp);
+
+	if (digits && std::isinf(val))
+		return nullptr;
+
+	return endp;
+}
+
+/// <summary>
+/// Convert the start of a string to an integer within a range, in the manner of std::from_chars().
+/// Unlike strtol(), this doesn't use errno, so it's safe to call from multiple threads.
+/// Leading whitespace is skipped, the same as strtol().
+/// Used by the int and uint overloads of FromChars(), which differ only in their range.
+/// </summary>
+/// <param name="str">The string to convert</param>
+/// <param name="minVal">The smallest value accepted</param>
+/// <param name="maxVal">The largest value accepted</param>
+/// <param name="val">The converted value, only assigned if a number in range was found</param>
+/// <returns>Pointer to the first character after the number, str itself if no number was found, or nullptr if it was out of range.</returns>
+static const char* FromCharsInRange(const char* str, int64_t minVal, int64_t maxVal, int64_t& val)
+{
+	bool neg = false;
+	int64_t result = 0;
+	int64_t limit;
+	const char* p = str;
+
+	while (isspace(static_cast<unsigned char>(*p)))
+		p++;
+
+	if (*p == '-' || *p == '+')
+		neg = *p++ == '-';
+
+	if (*p < '0' || *p > '9')
+		return str;
+
+	limit = neg ? -minVal : maxVal;
+
+	for (; *p >= '0' && *p <= '9'; p++)
+	{
+		result = (result * 10) + (*p - '0');
+
+		if (result > limit)
+			return nullptr;
+	}
+
+	val = neg ? -result : result;
+	return p;
+}
+
+/// <summary>
+/// Convert the start of a string to an int, in the manner of std::from_chars().
+/// </summary>
+/// <param name="str">The string to convert</param>
+/// <param name="val">The converted value</param>
+/// <returns>Pointer to the first character after the number, str itself if no number was found, or nullptr if it was out of range.</returns>
+static const char* FromChars(const char* str, int& val)
+{
+	int64_t result = 0;
+	const char* p = FromCharsInRange(str, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), result);
+
+	val = int(result);
+	return p;
+}
+
+/// <summary>
+/// Convert the start of a string to a uint, in the manner of std::from_chars().
+/// Negative values are accepted down to the smallest int and wrap around, the same as
+/// converting the string with strtol() and casting the result to uint.
+/// </summary>
+/// <param name="str">The string to convert</param>
+/// <param name="val">The converted value</param>
+/// <returns>Pointer to the first character after the number, str itself if no number was found, or nullptr if it was out of range.</returns>
+static const char* FromChars(const char* str, uint& val)
+{
+	int64_t result = 0;
+	const char* p = FromCharsInRange(str, std::numeric_limits<int>::min(), std::numeric_limits<uint>::max(), result);
+
+	val = uint(result);
+	return p;
+}
+
+/// <summary>
+/// Write the digits of a mantissa and a decimal exponent in the same format as printf("%g").
+/// Trailing zeros of the mantissa are dropped, and scientific notation is used when the exponent
+/// is less than -4 or not less than the number of digits.
+/// </summary>
+/// <param name="mantissa">The mantissa, which must have exactly the specified number of digits</param>
+/// <param name="digits">The number of digits in the mantissa</param>
+/// <param name="exponent">The decimal exponent of the first digit</param>
+/// <param name="neg">Whether the value is negative</param>
+/// <param name="buf">The buffer to write to, which must hold at least 32 characters</param>
+/// <returns>The number of characters written, not including the null terminator.</returns>
+static size_t WriteGeneral(uint64_t mantissa, int digits, int exponent, bool neg, char* buf)
+{
+	char d[20];
+	int i, k = digits;
+	size_t len = 0;
+
+	for (i = digits - 1; i >= 0; i--, mantissa /= 10)
+		d[i] = char('0' + (mantissa % 10));
+
+	while (k > 1 && d[k - 1] == '0')
+		k--;
+
+	if (neg)
+		buf[len++] = '-';
+
+	if (exponent < -4 || exponent >= digits)
+	{
+		int absExp = exponent < 0 ? -exponent : exponent;
+
+		buf[len++] = d[0];
+
+		if (k > 1)
+		{
+			buf[len++] = '.';
+
+			for (i = 1; i < k; i++)
+				buf[len++] = d[i];
+		}
+
+		buf[len++] = 'e';
+		buf[len++] = exponent < 0 ? '-' : '+';
+
+		if (absExp >= 100)
+			buf[len++] = char('0' + absExp / 100);
+
+		buf[len++] = char('0' + (absExp / 10) % 10);
+		buf[len++] = char('0' + absExp % 10);
+	}
+	else if (exponent >= 0)
+	{
+		for (i = 0; i <= exponent; i++)
+			buf[len++] = i < k ? d[i] : '0';
+
+		if (k > exponent + 1)
+		{
+			buf[len++] = '.';
+
+			for (i = exponent + 1; i < k; i++)
+				buf[len++] = d[i];
+		}
+	}
+	else
+	{
+		buf[len++] = '0';
+		buf[len++] = '.';
+
+		for (i = -1; i > exponent; i--)
+			buf[len++] = '0';
+
+		for (i = 0; i < k; i++)
+			buf[len++] = d[i];
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+/// <summary>
+/// Write a floating point value as text which FromChars() converts back to exactly the same value of type T.
+/// The value is first written with the number of significant digits the type can always represent, 6 for float
+/// and 15 for double, in the same format as printf("%g"), which is also what streams use by default.
+/// That's enough for nearly every value which was read from a file or typed in, and those come out just as
+/// streams wrote them. Only values which don't survive the round trip, usually the results of arithmetic,
+/// are written with all 9 or 17 digits.
+/// The first attempt is computed from an integer mantissa when the value is in a range where that's exact,
+/// which avoids snprintf() and its dependence on the locale for nearly all values.
+/// </summary>
+/// <param name="val">The value to write</param>
+/// <param name="buf">The buffer to write to, which must hold at least 32 characters. It's null terminated.</param>
+/// <returns>The number of characters written, not including the null terminator.</returns>
+template <typename T>
+static size_t ToChars(T val, char* buf)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	int precision = std::numeric_limits<T>::digits10;
+	double d = double(val), a = fabs(d), back;
+	size_t len = 0;
+
+	if (d == 0)
+	{
+		if (std::signbit(d))
+			buf[len++] = '-';
+
+		buf[len++] = '0';
+		buf[len] = '\0';
+		return len;
+	}
+
+	if (a >= 1e-5 && a < 1e15)//Both the scale and the mantissa are exact in this range, or nearly so, and the result is checked anyway.
+	{
+		int exponent = int(floor(log10(a)));
+
+		for (int tries = 0; tries < 3; tries++)
+		{
+			int shift = precision - 1 - exponent;
+			uint64_t mantissa = uint64_t((shift >= 0 ? a * powers[shift] : a / powers[-shift]) + 0.5);
+
+			if (mantissa >= uint64_t(powers[precision]))//Rounded up to the next power of ten, or log10() was off by one.
+			{
+				exponent++;
+			}
+			else if (mantissa < uint64_t(powers[precision - 1]))
+			{
+				exponent--;
+			}
+			else
+			{
+				len = WriteGeneral(mantissa, precision, exponent, d < 0, buf);
+				break;
+			}
+		}
+
+		if (len)
+		{
+			if (FromChars(buf, back) && T(back) == val)
+				return len;
+
+			precision = std::numeric_limits<T>::max_digits10;//The same digits would come out of sprintf_s(), so don't try them again.
+		}
+	}
+
+	for (; ; precision = std::numeric_limits<T>::max_digits10)
+	{
+		int n = sprintf_s(buf, 32, "%.*g", precision, d);
+
+		len = n > 0 ? std::min<size_t>(size_t(n), 31) : 0;
+		std::replace(buf, buf + len, ',', '.');//Some locales use a comma as the decimal separator.
+
+		if (precision == std::numeric_limits<T>::max_digits10 || (FromChars(buf, back) && T(back) == val))
+			break;
+	}
+
+	return len;
+}
+
+/// <summary>
+/// Minimal replacement for ostringstream which appends to a string owned by the caller.
+/// Streams were a large part of the cost of converting embers to Xml, because of their locale
+/// handling and the temporary strings they create. Here, numbers are written with ToChars(),
+/// so floating point values are only as long as they need to be to round trip exactly, and the
+/// caller can reserve the string once and reuse it.
+/// </summary>
+class EMBER_API StringWriter
+{
+public:
+	/// <summary>
+	/// Constructor which takes the string to append to.
+	/// </summary>
+	/// <param name="buf">The string to append to, which must outlive this object</param>
+	StringWriter(string& buf)
+		: m_Buf(&buf)
+	{
+	}
+
+	/// <summary>
+	/// Append operators for strings and characters.
+	/// </summary>
+	StringWriter& operator << (const char* s) { m_Buf->append(s); return *this; }
+	StringWriter& operator << (const xmlChar* s) { m_Buf->append(reinterpret_cast<const char*>(s)); return *this; }
+	StringWriter& operator << (const string& s) { m_Buf->append(s); return *this; }
+	StringWriter& operator << (char c) { m_Buf->push_back(c); return *this; }
+
+	/// <summary>
+	/// Append operators for floating point values, which are written with ToChars().
+	/// </summary>
+	StringWriter& operator << (float val) { char buf[32]; m_Buf->append(buf, ToChars(val, buf)); return *this; }
+	StringWriter& operator << (double val) { char buf[32]; m_Buf->append(buf, ToChars(val, buf)); return *this; }
+
+	/// <summary>
+	/// Append operator for integral values of any size and sign.
+	/// </summary>
+	/// <param name="val">The value to append</param>
+	/// <returns>Reference to this</returns>
+	template <typename U>
+	typename std::enable_if<std::is_integral<U>::value, StringWriter&>::type operator << (U val)
+	{
+		char buf[24];
+		char* p = buf + sizeof(buf);
+		bool neg = val < 0;
+		uint64_t u = neg ? uint64_t(0) - uint64_t(val) : uint64_t(val);
+
+		do
+		{
+			*--p = char('0' + (u % 10));
+			u /= 10;
+		} while (u);
+
+		if (neg)
+			*--p = '-';
+
+		m_Buf->append(p, buf + sizeof(buf) - p);
+		return *this;
+	}
+
+	/// <summary>
+	/// Append the two digit lower case hexadecimal representation of a byte.
+	/// </summary>
+	/// <param name="val">The value to append</param>
+	void Hex(uint val)
+	{
+		static const char* digits = "0123456789abcdef";
+
+		m_Buf->push_back(digits[(val >> 4) & 0xF]);
+		m_Buf->push_back(digits[val & 0xF]);
+	}
+
+	/// <summary>
+	/// Append a floating point value with a fixed number of decimal places, the same as printf("%.*f").
+	/// </summary>
+	/// <param name="val">The value to append</param>
+	/// <param name="decimals">The number of decimal places</param>
+	void Fixed(double val, int decimals)
+	{
+		char buf[64];
+		int n = sprintf_s(buf, sizeof(buf), "%.*f", decimals, val);
+
+		if (n > 0)
+		{
+			std::replace(buf, buf + std::min<size_t>(size_t(n), sizeof(buf) - 1), ',', '.');//Some locales use a comma as the decimal separator.
+			m_Buf->append(buf, std::min<size_t>(size_t(n), sizeof(buf) - 1));
+		}
+	}
+
+private:
+	string* m_Buf;
+};
+
 /// <summary>
 /// Determine whether the specified value is very close to zero.
 /// This is useful for determining equality of float/double types.
@@ -2,6 +2,7 @@
 
 #include "Point.h"
 #include "Isaac.h"
+#include "VariationPool.h"
 
 /// <summary>
 /// Base variation classes. Individual variations will be grouped into files of roughly 50
@@ -1060,6 +1061,22 @@ public:
 	{
 	}
 
+	/// <summary>
+	/// Class specific allocation, which gets the memory for all variations from VariationPool
+	/// rather than making a separate heap allocation for each.
+	/// </summary>
+	/// <param name="size">The size of the derived variation object</param>
+	/// <returns>The memory for the object</returns>
+	static void* operator new(size_t size) { return VariationPool::Allocate(size); }
+
+	/// <summary>
+	/// Class specific deallocation, which returns the memory of a variation to VariationPool.
+	/// Since the destructor is virtual, the size passed is that of the derived object.
+	/// </summary>
+	/// <param name="p">The memory of the object</param>
+	/// <param name="size">The size of the derived variation object</param>
+	static void operator delete(void* p, size_t size) { VariationPool::Free(p, size); }
+
 	/// <summary>
 	/// Default assignment operator.
 	/// </summary>
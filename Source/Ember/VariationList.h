@@ -360,6 +360,27 @@ public:
 			if (ParametricVariation<T>* parVar = dynamic_cast<ParametricVariation<T>*>(m_Variations[i]))
 				m_ParametricVariations.push_back(parVar);
 		}
+
+		//Index the variations by name, and the parametric variations by the names of their params, so
+		//parsing doesn't have to compare the name of every attribute against every variation.
+		//Insertion keeps the first entry for a name, which is what the linear searches used to return.
+		m_VariationIndices.reserve(m_Variations.size());
+
+		for (size_t i = 0; i < m_Variations.size(); i++)
+			m_VariationIndices.insert(make_pair(m_Variations[i]->Name(), i));
+
+		for (auto parVar : m_ParametricVariations)
+		{
+			ParamWithName<T>* params = parVar->Params();
+
+			for (size_t i = 0; i < parVar->ParamCount(); i++)
+			{
+				auto& ids = m_ParamVariations[params[i].Name()];
+
+				if (std::find(ids.begin(), ids.end(), parVar->VariationId()) == ids.end())
+					ids.push_back(parVar->VariationId());
+			}
+		}
 	}
 
 	/// <summary>
@@ -412,11 +433,10 @@ public:
 	/// <returns>A pointer to the variation if found, else nullptr.</returns>
 	Variation<T>* GetVariation(eVariationId id)
 	{
-		for (uint i = 0; i < m_Variations.size() && m_Variations[i] != nullptr; i++)
-			if (id == m_Variations[i]->VariationId())
-				return m_Variations[i];
+		//The list is sorted by ID in the constructor.
+		auto it = std::lower_bound(m_Variations.begin(), m_Variations.end(), id, [&](const Variation<T>* var, eVariationId varId) { return var->VariationId() < varId; });
 
-		return nullptr;
+		return it != m_Variations.end() && (*it)->VariationId() == id ? *it : nullptr;
 	}
 
 	/// <summary>
@@ -435,11 +455,9 @@ public:
 	/// <returns>A pointer to the variation if found, else nullptr.</returns>
 	Variation<T>* GetVariation(const string& name)
 	{
-		for (uint i = 0; i < m_Variations.size() && m_Variations[i] != nullptr; i++)
-			if (!_stricmp(name.c_str(), m_Variations[i]->Name().c_str()))
-				return m_Variations[i];
+		int index = GetVariationIndex(name);
 
-		return nullptr;
+		return index != -1 ? m_Variations[index] : nullptr;
 	}
 
 	/// <summary>
@@ -466,11 +484,20 @@ public:
 	/// <returns>The parametric variation with a matching name, else nullptr.</returns>
 	ParametricVariation<T>* GetParametricVariation(const string& name)
 	{
-		for (uint i = 0; i < m_ParametricVariations.size() && m_ParametricVariations[i] != nullptr; i++)
-			if (!_stricmp(name.c_str(), m_ParametricVariations[i]->Name().c_str()))
-				return m_ParametricVariations[i];
+		return dynamic_cast<ParametricVariation<T>*>(GetVariation(name));
+	}
 
-		return nullptr;
+	/// <summary>
+	/// Get the IDs of the parametric variations which have a param with the specified name.
+	/// Param names are almost always unique to a single variation, but this is not enforced.
+	/// </summary>
+	/// <param name="name">The name of the param to search for</param>
+	/// <returns>A pointer to the IDs of the variations with a matching param, else nullptr.</returns>
+	const vector<eVariationId>* GetParamVariationIds(const string& name) const
+	{
+		auto it = m_ParamVariations.find(name);
+
+		return it != m_ParamVariations.end() ? &it->second : nullptr;
 	}
 
 	/// <summary>
@@ -480,11 +507,9 @@ public:
 	/// <returns>The index of the variation with the matching name, else -1</returns>
 	int GetVariationIndex(const string& name)
 	{
-		for (uint i = 0; i < m_Variations.size() && m_Variations[i] != nullptr; i++)
-			if (!_stricmp(name.c_str(), m_Variations[i]->Name().c_str()))
-				return i;
+		auto it = m_VariationIndices.find(name);
 
-		return -1;
+		return it != m_VariationIndices.end() ? int(it->second) : -1;
 	}
 
 	/// <summary>
@@ -533,5 +558,7 @@ private:
 	vector<Variation<T>*> m_PreVariations;
 	vector<Variation<T>*> m_PostVariations;
 	vector<ParametricVariation<T>*> m_ParametricVariations;//A list of pointers to elements in m_Variations which are derived from ParametricVariation.
+	unordered_map<string, size_t, NameHash, NameEqual> m_VariationIndices;//The index in m_Variations of each variation name.
+	unordered_map<string, vector<eVariationId>, NameHash, NameEqual> m_ParamVariations;//The IDs of the parametric variations which have each param name.
 };
 }
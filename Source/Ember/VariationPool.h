@@ -0,0 +1,159 @@
+#pragma once
+
+#include "EmberDefines.h"
+
+/// <summary>
+/// VariationPool class.
+/// </summary>
+
+namespace EmberNs
+{
+#define VAR_POOL_GRANULE 64//Size classes are multiples of a cache line.
+#define VAR_POOL_CLASSES 32//Objects larger than VAR_POOL_GRANULE * VAR_POOL_CLASSES bytes are allocated with operator new.
+#define VAR_POOL_CHUNK (64 * 1024)//Bytes allocated at once when the free list of a size class is empty.
+
+/// <summary>
+/// Pool allocator for Variation objects, used by the class specific operator new and delete of Variation.
+/// Xforms create and delete variations constantly when embers are copied, interpolated and mutated,
+/// and each one used to be a separate small heap allocation scattered around the heap.
+/// Here, objects are grouped into size classes which are multiples of a cache line. Each class keeps a
+/// free list of blocks carved out of large chunks, so variations which are created together, such as
+/// those of an ember being copied, sit next to each other in memory. Allocating or freeing one is just
+/// a pointer swap under a spin lock.
+/// Freed blocks go back on their free list for reuse rather than back to the heap, and chunks are never
+/// freed, so the memory held is bounded by the largest number of variations which were alive at once.
+/// The free lists are static because the class specific operator delete of Variation has no way to find a
+/// pool other than a global one, and a variation may be freed by a different ember, or thread, than the one
+/// which created it. They are plain old data, so they are usable during static initialization and destruction.
+/// </summary>
+class EMBER_API VariationPool
+{
+public:
+	/// <summary>
+	/// Allocate a block from the free list of the size class of the object.
+	/// </summary>
+	/// <param name="size">The size of the object in bytes</param>
+	/// <returns>The block. Throws bad_alloc on failure, like operator new.</returns>
+	static void* Allocate(size_t size)
+	{
+		size_t sizeClass = SizeClass(size);
+
+		if (sizeClass >= VAR_POOL_CLASSES)
+			return ::operator new(size);
+
+		Lock();
+		FreeBlock* block = m_FreeLists[sizeClass];
+
+		if (block)
+		{
+			m_FreeLists[sizeClass] = block->m_Next;
+			m_BlocksInUse++;
+		}
+
+		Unlock();
+		return block ? block : Refill(sizeClass);
+	}
+
+	/// <summary>
+	/// Return a block which was returned by Allocate() to the free list of its size class.
+	/// </summary>
+	/// <param name="p">The block to free, ignored if nullptr.</param>
+	/// <param name="size">The size of the object in bytes, which must be the same as was passed to Allocate().</param>
+	static void Free(void* p, size_t size)
+	{
+		if (!p)
+			return;
+
+		size_t sizeClass = SizeClass(size);
+
+		if (sizeClass >= VAR_POOL_CLASSES)
+		{
+			::operator delete(p);
+			return;
+		}
+
+		FreeBlock* block = static_cast<FreeBlock*>(p);
+
+		Lock();
+		block->m_Next = m_FreeLists[sizeClass];
+		m_FreeLists[sizeClass] = block;
+		m_BlocksInUse--;
+		Unlock();
+	}
+
+	/// <summary>
+	/// Get the number of blocks currently allocated from the pool.
+	/// </summary>
+	/// <returns>The number of blocks</returns>
+	static size_t BlocksInUse() { return m_BlocksInUse; }
+
+	/// <summary>
+	/// Get the total size of all chunks the pool has allocated.
+	/// </summary>
+	/// <returns>The number of bytes</returns>
+	static size_t ChunkBytes() { return m_ChunkBytes; }
+
+private:
+	/// <summary>
+	/// A free block, which holds the pointer to the next free block of the same size class.
+	/// </summary>
+	struct FreeBlock
+	{
+		FreeBlock* m_Next;
+	};
+
+	/// <summary>
+	/// Get the index of the size class an object belongs to.
+	/// </summary>
+	/// <param name="size">The size of the object in bytes</param>
+	/// <returns>The size class index, which is VAR_POOL_CLASSES or greater if the object is too large for the pool.</returns>
+	static size_t SizeClass(size_t size) { return size ? (size - 1) / VAR_POOL_GRANULE : 0; }
+
+	/// <summary>
+	/// Allocate a new chunk for a size class whose free list is empty.
+	/// The first block of the chunk is returned, and the rest are added to the free list.
+	/// The chunk is allocated outside of the lock so other size classes are not held up.
+	/// </summary>
+	/// <param name="sizeClass">The size class index</param>
+	/// <returns>The first block of the new chunk</returns>
+	static FreeBlock* Refill(size_t sizeClass)
+	{
+		size_t blockSize = (sizeClass + 1) * VAR_POOL_GRANULE;
+		size_t count = std::max<size_t>(VAR_POOL_CHUNK / blockSize, 2);
+		byte* chunk = static_cast<byte*>(::operator new(count * blockSize));
+		FreeBlock* first = reinterpret_cast<FreeBlock*>(chunk + blockSize);
+		FreeBlock* last = reinterpret_cast<FreeBlock*>(chunk + ((count - 1) * blockSize));
+
+		for (size_t i = 1; i < count - 1; i++)
+			reinterpret_cast<FreeBlock*>(chunk + (i * blockSize))->m_Next = reinterpret_cast<FreeBlock*>(chunk + ((i + 1) * blockSize));
+
+		Lock();
+		last->m_Next = m_FreeLists[sizeClass];
+		m_FreeLists[sizeClass] = first;
+		m_ChunkBytes += count * blockSize;
+		m_BlocksInUse++;
+		Unlock();
+		return reinterpret_cast<FreeBlock*>(chunk);
+	}
+
+	/// <summary>
+	/// Acquire the spin lock which protects the free lists.
+	/// It's only ever held for a few instructions.
+	/// </summary>
+	static void Lock()
+	{
+		while (m_Lock.test_and_set(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+	/// <summary>
+	/// Release the spin lock which protects the free lists.
+	/// </summary>
+	static void Unlock() { m_Lock.clear(std::memory_order_release); }
+
+	static FreeBlock* m_FreeLists[VAR_POOL_CLASSES];//The head of the free list of each size class.
+	static std::atomic_flag m_Lock;//Protects the free lists and counters.
+	static size_t m_BlocksInUse;//The number of blocks currently allocated.
+	static size_t m_ChunkBytes;//The total size of all chunks allocated.
+};
+}
@@ -118,6 +118,16 @@ public:
 		Xform<T>::operator=<U>(xform);
 	}
 
+	/// <summary>
+	/// Move constructor which takes the variations of an Xform object rather than cloning them.
+	/// </summary>
+	/// <param name="xform">The Xform object to move, which is left with no variations.</param>
+	Xform(Xform<T>&& xform) NOEXCEPT
+		: m_ParentEmber(nullptr)//Hack.
+	{
+		Xform<T>::operator=(std::move(xform));
+	}
+
 	/// <summary>
 	/// Deletes each element of the variation vector and clears it.
 	/// </summary>
@@ -138,6 +148,37 @@ public:
 		return *this;
 	}
 
+	/// <summary>
+	/// Move assignment operator.
+	/// This will delete all of the variations in the vector and take
+	/// ownership of the ones in xform's vectors without cloning them.
+	/// This is what keeps growing a vector of xforms from cloning every variation.
+	/// </summary>
+	/// <param name="xform">The Xform object to move, which is left with no variations.</param>
+	/// <returns>Reference to updated self</returns>
+	Xform<T>& operator = (Xform<T>&& xform) NOEXCEPT
+	{
+		if (this != &xform)
+		{
+			CopyVals(xform);
+			ClearAndDeleteVariations();
+			m_PreVariations.swap(xform.m_PreVariations);
+			m_Variations.swap(xform.m_Variations);
+			m_PostVariations.swap(xform.m_PostVariations);
+			SetPrecalcFlags();//Will also set the parent xform of each variation to this.
+
+			//If this xform was already part of a different ember, then do not assign, else do.
+			if (!m_ParentEmber)
+				m_ParentEmber = xform.m_ParentEmber;
+
+			m_Xaos = std::move(xform.m_Xaos);
+			m_Motion = std::move(xform.m_Motion);
+			m_Name = std::move(xform.m_Name);
+		}
+
+		return *this;
+	}
+
 	/// <summary>
 	/// Assignment operator to assign a Xform object of type U.
 	/// This will delete all of the variations in the vector
@@ -149,23 +190,7 @@ public:
 	template <typename U>
 	Xform<T>& operator = (const Xform<U>& xform)
 	{
-		m_Affine = xform.m_Affine;
-		m_Post = xform.m_Post;
-		m_Weight = T(xform.m_Weight);
-		m_ColorX = T(xform.m_ColorX);
-		m_ColorY = T(xform.m_ColorY);
-		m_DirectColor = T(xform.m_DirectColor);
-		m_ColorSpeed = T(xform.m_ColorSpeed);
-		m_Animate = T(xform.m_Animate);
-		m_Opacity = T(xform.m_Opacity);
-		CacheColorVals();
-		m_HasPost = xform.HasPost();
-		m_HasPreOrRegularVars = xform.PreVariationCount() > 0 || xform.VariationCount() > 0;
-		m_Wind[0] = T(xform.m_Wind[0]);
-		m_Wind[1] = T(xform.m_Wind[1]);
-		m_MotionFreq = xform.m_MotionFreq;
-		m_MotionFunc = xform.m_MotionFunc;
-
+		CopyVals(xform);
 		ClearAndDeleteVariations();
 
 		//Must manually add them via the AddVariation() function so that
@@ -195,6 +220,34 @@ public:
 		return *this;
 	}
 
+private:
+	/// <summary>
+	/// Copy all values of an Xform object of type U other than its variations, xaos, motion and name.
+	/// Shared by the copy and move assignment operators.
+	/// </summary>
+	/// <param name="xform">The Xform object to copy the values of</param>
+	template <typename U>
+	void CopyVals(const Xform<U>& xform)
+	{
+		m_Affine = xform.m_Affine;
+		m_Post = xform.m_Post;
+		m_Weight = T(xform.m_Weight);
+		m_ColorX = T(xform.m_ColorX);
+		m_ColorY = T(xform.m_ColorY);
+		m_DirectColor = T(xform.m_DirectColor);
+		m_ColorSpeed = T(xform.m_ColorSpeed);
+		m_Animate = T(xform.m_Animate);
+		m_Opacity = T(xform.m_Opacity);
+		CacheColorVals();
+		m_HasPost = xform.HasPost();
+		m_HasPreOrRegularVars = xform.PreVariationCount() > 0 || xform.VariationCount() > 0;
+		m_Wind[0] = T(xform.m_Wind[0]);
+		m_Wind[1] = T(xform.m_Wind[1]);
+		m_MotionFreq = xform.m_MotionFreq;
+		m_MotionFunc = xform.m_MotionFunc;
+	}
+
+public:
 	/// <summary>
 	/// Init default values.
 	/// Non default values are used to signify an uninitialized state. This is useful for 
@@ -608,8 +661,38 @@ public:
 	/// <param name="rand">The random context to use</param>
 	/// <returns>True if a bad value was calculated, else false.</returns>
 	bool Apply(Point<T>* inPoint, Point<T>* outPoint, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand)
+	{
+		return DoApply<false>(inPoint, outPoint, rand, nullptr);
+	}
+
+	/// <summary>
+	/// Same as Apply(), but also adds the cycles spent in Func() of each variation to a counter.
+	/// This is only used when profiling iteration, see IterProfile.
+	/// </summary>
+	/// <param name="inPoint">The initial point from the previous iteration</param>
+	/// <param name="outPoint">The output point</param>
+	/// <param name="rand">The random context to use</param>
+	/// <param name="cycles">The counters to add to, one per variation in the order of GetVariation()</param>
+	/// <returns>True if a bad value was calculated, else false.</returns>
+	bool ApplyProfiled(Point<T>* inPoint, Point<T>* outPoint, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, uint64_t* cycles)
+	{
+		return DoApply<true>(inPoint, outPoint, rand, cycles);
+	}
+
+	/// <summary>
+	/// The implementation of Apply() and ApplyProfiled().
+	/// When profile is false, the timing code is removed at compile time so Apply() pays nothing for it.
+	/// </summary>
+	/// <param name="inPoint">The initial point from the previous iteration</param>
+	/// <param name="outPoint">The output point</param>
+	/// <param name="rand">The random context to use</param>
+	/// <param name="cycles">The counters to add the cycles of each variation to if profile is true, else ignored.</param>
+	/// <returns>True if a bad value was calculated, else false.</returns>
+	template <bool profile>
+	bool DoApply(Point<T>* inPoint, Point<T>* outPoint, QTIsaac<ISAAC_SIZE, ISAAC_INT>& rand, uint64_t* cycles)
 	{
 		size_t i;
+		uint64_t start = 0;
 
 		//This must be local, rather than a member, because this function can be called
 		//from multiple threads. If it were a member, they'd be clobbering each others' values.
@@ -638,7 +721,15 @@ public:
 				iterHelper.In.y = iterHelper.m_TransY;
 				iterHelper.In.z = iterHelper.m_TransZ;
 				m_PreVariations[i]->PrecalcHelper(iterHelper, inPoint);//Apply per-variation precalc, the second parameter is unused for pre variations.
+
+				if (profile)
+					start = CycleCount();
+
 				m_PreVariations[i]->Func(iterHelper, *outPoint, rand);
+
+				if (profile)
+					cycles[i] += CycleCount() - start;
+
 				WritePre(iterHelper, m_PreVariations[i]->AssignType());
 			}
 
@@ -660,7 +751,14 @@ public:
 				//with the exact same speed as both regular and static member functions.
 				for (i = 0; i < VariationCount(); i++)
 				{
+					if (profile)
+						start = CycleCount();
+
 					m_Variations[i]->Func(iterHelper, *outPoint, rand);
+
+					if (profile)
+						cycles[PreVariationCount() + i] += CycleCount() - start;
+
 					outPoint->m_X += iterHelper.Out.x;
 					outPoint->m_Y += iterHelper.Out.y;
 					outPoint->m_Z += iterHelper.Out.z;
@@ -692,7 +790,15 @@ public:
 			iterHelper.In.y = outPoint->m_Y;
 			iterHelper.In.z = outPoint->m_Z;
 			m_PostVariations[i]->PrecalcHelper(iterHelper, outPoint);//Apply per-variation precalc.
+
+			if (profile)
+				start = CycleCount();
+
 			m_PostVariations[i]->Func(iterHelper, *outPoint, rand);
+
+			if (profile)
+				cycles[PreVariationCount() + VariationCount() + i] += CycleCount() - start;
+
 			WritePost(iterHelper, *outPoint, m_PostVariations[i]->AssignType());
 		}
 
@@ -80,81 +80,81 @@ public:
 		if (!m_Init)
 		{
 			m_BadParamNames.reserve(100);
-			m_BadParamNames.push_back(pair<string, string>("swtin_distort",   "stwin_distort"));//stwin.
-			m_BadParamNames.push_back(pair<string, string>("pow_numerator",   "pow_block_numerator"));//pow_block.
-			m_BadParamNames.push_back(pair<string, string>("pow_denominator", "pow_block_denominator"));
-			m_BadParamNames.push_back(pair<string, string>("pow_root",        "pow_block_root"));
-			m_BadParamNames.push_back(pair<string, string>("pow_correctn",    "pow_block_correctn"));
-			m_BadParamNames.push_back(pair<string, string>("pow_correctd",    "pow_block_correctd"));
-			m_BadParamNames.push_back(pair<string, string>("pow_power",       "pow_block_power"));
-			m_BadParamNames.push_back(pair<string, string>("lT", "linearT_powX"));//linearT.
-			m_BadParamNames.push_back(pair<string, string>("lT", "linearT_powY"));
-			m_BadParamNames.push_back(pair<string, string>("Re_A", "Mobius_Re_A"));//Mobius.
-			m_BadParamNames.push_back(pair<string, string>("Im_A", "Mobius_Im_A"));
-			m_BadParamNames.push_back(pair<string, string>("Re_B", "Mobius_Re_B"));
-			m_BadParamNames.push_back(pair<string, string>("Im_B", "Mobius_Im_B"));
-			m_BadParamNames.push_back(pair<string, string>("Re_C", "Mobius_Re_C"));
-			m_BadParamNames.push_back(pair<string, string>("Im_C", "Mobius_Im_C"));
-			m_BadParamNames.push_back(pair<string, string>("Re_D", "Mobius_Re_D"));
-			m_BadParamNames.push_back(pair<string, string>("Im_D", "Mobius_Im_D"));
-			m_BadParamNames.push_back(pair<string, string>("rx_sin", "rotate_x_sin"));//rotate_x.
-			m_BadParamNames.push_back(pair<string, string>("rx_cos", "rotate_x_cos"));
-			m_BadParamNames.push_back(pair<string, string>("ry_sin", "rotate_y_sin"));//rotate_y.
-			m_BadParamNames.push_back(pair<string, string>("ry_cos", "rotate_y_cos"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_a1", "interference2_a1"));//interference2.
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_b1", "interference2_b1"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_c1", "interference2_c1"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_p1", "interference2_p1"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_t1", "interference2_t1"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_a2", "interference2_a2"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_b2", "interference2_b2"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_c2", "interference2_c2"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_p2", "interference2_p2"));
-			m_BadParamNames.push_back(pair<string, string>("intrfr2_t2", "interference2_t2"));
-			m_BadParamNames.push_back(pair<string, string>("octa_x", "octagon_x"));//octagon.
-			m_BadParamNames.push_back(pair<string, string>("octa_y", "octagon_y"));
-			m_BadParamNames.push_back(pair<string, string>("octa_z", "octagon_z"));
-			m_BadParamNames.push_back(pair<string, string>("bubble_x", "bubble2_x"));//bubble2.
-			m_BadParamNames.push_back(pair<string, string>("bubble_y", "bubble2_y"));
-			m_BadParamNames.push_back(pair<string, string>("bubble_z", "bubble2_z"));
-			m_BadParamNames.push_back(pair<string, string>("cubic3D_xpand", "cubicLattice_3D_xpand"));//cubicLattice_3D.
-			m_BadParamNames.push_back(pair<string, string>("cubic3D_style", "cubicLattice_3D_style"));
-			m_BadParamNames.push_back(pair<string, string>("splitb_x",  "SplitBrdr_x"));//SplitBrdr.
-			m_BadParamNames.push_back(pair<string, string>("splitb_y",  "SplitBrdr_y"));
-			m_BadParamNames.push_back(pair<string, string>("splitb_px", "SplitBrdr_px"));
-			m_BadParamNames.push_back(pair<string, string>("splitb_py", "SplitBrdr_py"));
-			m_BadParamNames.push_back(pair<string, string>("dc_cyl_offset", "dc_cylinder_offset"));//dc_cylinder.
-			m_BadParamNames.push_back(pair<string, string>("dc_cyl_angle",  "dc_cylinder_angle"));
-			m_BadParamNames.push_back(pair<string, string>("dc_cyl_scale",  "dc_cylinder_scale"));
-			m_BadParamNames.push_back(pair<string, string>("cyl_x",         "dc_cylinder_x"));
-			m_BadParamNames.push_back(pair<string, string>("cyl_y",         "dc_cylinder_y"));
-			m_BadParamNames.push_back(pair<string, string>("cyl_blur",      "dc_cylinder_blur"));
-			m_BadParamNames.push_back(pair<string, string>("mobius_radius",   "mobius_strip_radius"));//mobius_strip.
-			m_BadParamNames.push_back(pair<string, string>("mobius_width",    "mobius_strip_width"));
-			m_BadParamNames.push_back(pair<string, string>("mobius_rect_x",   "mobius_strip_rect_x"));
-			m_BadParamNames.push_back(pair<string, string>("mobius_rect_y",   "mobius_strip_rect_y"));
-			m_BadParamNames.push_back(pair<string, string>("mobius_rotate_x", "mobius_strip_rotate_x"));
-			m_BadParamNames.push_back(pair<string, string>("mobius_rotate_y", "mobius_strip_rotate_y"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps2_cellsize",    "bwraps_cellsize"));//bwraps2.
-			m_BadParamNames.push_back(pair<string, string>("bwraps2_space",       "bwraps_space"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps2_gain",        "bwraps_gain"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps2_inner_twist", "bwraps_inner_twist"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps2_outer_twist", "bwraps_outer_twist"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps7_cellsize",    "bwraps_cellsize"));//bwraps7.
-			m_BadParamNames.push_back(pair<string, string>("bwraps7_space",       "bwraps_space"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps7_gain",        "bwraps_gain"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps7_inner_twist", "bwraps_inner_twist"));
-			m_BadParamNames.push_back(pair<string, string>("bwraps7_outer_twist", "bwraps_outer_twist"));
-			m_BadParamNames.push_back(pair<string, string>("pre_bwraps2_cellsize",    "pre_bwraps_cellsize"));
-			m_BadParamNames.push_back(pair<string, string>("pre_bwraps2_space",       "pre_bwraps_space"));
-			m_BadParamNames.push_back(pair<string, string>("pre_bwraps2_gain",        "pre_bwraps_gain"));
-			m_BadParamNames.push_back(pair<string, string>("pre_bwraps2_inner_twist", "pre_bwraps_inner_twist"));
-			m_BadParamNames.push_back(pair<string, string>("pre_bwraps2_outer_twist", "pre_bwraps_outer_twist"));
-			m_BadParamNames.push_back(pair<string, string>("post_bwraps2_cellsize",    "post_bwraps_cellsize"));
-			m_BadParamNames.push_back(pair<string, string>("post_bwraps2_space",       "post_bwraps_space"));
-			m_BadParamNames.push_back(pair<string, string>("post_bwraps2_gain",        "post_bwraps_gain"));
-			m_BadParamNames.push_back(pair<string, string>("post_bwraps2_inner_twist", "post_bwraps_inner_twist"));
-			m_BadParamNames.push_back(pair<string, string>("post_bwraps2_outer_twist", "post_bwraps_outer_twist"));
+			m_BadParamNames.insert(pair<string, string>("swtin_distort",   "stwin_distort"));//stwin.
+			m_BadParamNames.insert(pair<string, string>("pow_numerator",   "pow_block_numerator"));//pow_block.
+			m_BadParamNames.insert(pair<string, string>("pow_denominator", "pow_block_denominator"));
+			m_BadParamNames.insert(pair<string, string>("pow_root",        "pow_block_root"));
+			m_BadParamNames.insert(pair<string, string>("pow_correctn",    "pow_block_correctn"));
+			m_BadParamNames.insert(pair<string, string>("pow_correctd",    "pow_block_correctd"));
+			m_BadParamNames.insert(pair<string, string>("pow_power",       "pow_block_power"));
+			m_BadParamNames.insert(pair<string, string>("lT", "linearT_powX"));//linearT.
+			m_BadParamNames.insert(pair<string, string>("lT", "linearT_powY"));
+			m_BadParamNames.insert(pair<string, string>("Re_A", "Mobius_Re_A"));//Mobius.
+			m_BadParamNames.insert(pair<string, string>("Im_A", "Mobius_Im_A"));
+			m_BadParamNames.insert(pair<string, string>("Re_B", "Mobius_Re_B"));
+			m_BadParamNames.insert(pair<string, string>("Im_B", "Mobius_Im_B"));
+			m_BadParamNames.insert(pair<string, string>("Re_C", "Mobius_Re_C"));
+			m_BadParamNames.insert(pair<string, string>("Im_C", "Mobius_Im_C"));
+			m_BadParamNames.insert(pair<string, string>("Re_D", "Mobius_Re_D"));
+			m_BadParamNames.insert(pair<string, string>("Im_D", "Mobius_Im_D"));
+			m_BadParamNames.insert(pair<string, string>("rx_sin", "rotate_x_sin"));//rotate_x.
+			m_BadParamNames.insert(pair<string, string>("rx_cos", "rotate_x_cos"));
+			m_BadParamNames.insert(pair<string, string>("ry_sin", "rotate_y_sin"));//rotate_y.
+			m_BadParamNames.insert(pair<string, string>("ry_cos", "rotate_y_cos"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_a1", "interference2_a1"));//interference2.
+			m_BadParamNames.insert(pair<string, string>("intrfr2_b1", "interference2_b1"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_c1", "interference2_c1"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_p1", "interference2_p1"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_t1", "interference2_t1"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_a2", "interference2_a2"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_b2", "interference2_b2"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_c2", "interference2_c2"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_p2", "interference2_p2"));
+			m_BadParamNames.insert(pair<string, string>("intrfr2_t2", "interference2_t2"));
+			m_BadParamNames.insert(pair<string, string>("octa_x", "octagon_x"));//octagon.
+			m_BadParamNames.insert(pair<string, string>("octa_y", "octagon_y"));
+			m_BadParamNames.insert(pair<string, string>("octa_z", "octagon_z"));
+			m_BadParamNames.insert(pair<string, string>("bubble_x", "bubble2_x"));//bubble2.
+			m_BadParamNames.insert(pair<string, string>("bubble_y", "bubble2_y"));
+			m_BadParamNames.insert(pair<string, string>("bubble_z", "bubble2_z"));
+			m_BadParamNames.insert(pair<string, string>("cubic3D_xpand", "cubicLattice_3D_xpand"));//cubicLattice_3D.
+			m_BadParamNames.insert(pair<string, string>("cubic3D_style", "cubicLattice_3D_style"));
+			m_BadParamNames.insert(pair<string, string>("splitb_x",  "SplitBrdr_x"));//SplitBrdr.
+			m_BadParamNames.insert(pair<string, string>("splitb_y",  "SplitBrdr_y"));
+			m_BadParamNames.insert(pair<string, string>("splitb_px", "SplitBrdr_px"));
+			m_BadParamNames.insert(pair<string, string>("splitb_py", "SplitBrdr_py"));
+			m_BadParamNames.insert(pair<string, string>("dc_cyl_offset", "dc_cylinder_offset"));//dc_cylinder.
+			m_BadParamNames.insert(pair<string, string>("dc_cyl_angle",  "dc_cylinder_angle"));
+			m_BadParamNames.insert(pair<string, string>("dc_cyl_scale",  "dc_cylinder_scale"));
+			m_BadParamNames.insert(pair<string, string>("cyl_x",         "dc_cylinder_x"));
+			m_BadParamNames.insert(pair<string, string>("cyl_y",         "dc_cylinder_y"));
+			m_BadParamNames.insert(pair<string, string>("cyl_blur",      "dc_cylinder_blur"));
+			m_BadParamNames.insert(pair<string, string>("mobius_radius",   "mobius_strip_radius"));//mobius_strip.
+			m_BadParamNames.insert(pair<string, string>("mobius_width",    "mobius_strip_width"));
+			m_BadParamNames.insert(pair<string, string>("mobius_rect_x",   "mobius_strip_rect_x"));
+			m_BadParamNames.insert(pair<string, string>("mobius_rect_y",   "mobius_strip_rect_y"));
+			m_BadParamNames.insert(pair<string, string>("mobius_rotate_x", "mobius_strip_rotate_x"));
+			m_BadParamNames.insert(pair<string, string>("mobius_rotate_y", "mobius_strip_rotate_y"));
+			m_BadParamNames.insert(pair<string, string>("bwraps2_cellsize",    "bwraps_cellsize"));//bwraps2.
+			m_BadParamNames.insert(pair<string, string>("bwraps2_space",       "bwraps_space"));
+			m_BadParamNames.insert(pair<string, string>("bwraps2_gain",        "bwraps_gain"));
+			m_BadParamNames.insert(pair<string, string>("bwraps2_inner_twist", "bwraps_inner_twist"));
+			m_BadParamNames.insert(pair<string, string>("bwraps2_outer_twist", "bwraps_outer_twist"));
+			m_BadParamNames.insert(pair<string, string>("bwraps7_cellsize",    "bwraps_cellsize"));//bwraps7.
+			m_BadParamNames.insert(pair<string, string>("bwraps7_space",       "bwraps_space"));
+			m_BadParamNames.insert(pair<string, string>("bwraps7_gain",        "bwraps_gain"));
+			m_BadParamNames.insert(pair<string, string>("bwraps7_inner_twist", "bwraps_inner_twist"));
+			m_BadParamNames.insert(pair<string, string>("bwraps7_outer_twist", "bwraps_outer_twist"));
+			m_BadParamNames.insert(pair<string, string>("pre_bwraps2_cellsize",    "pre_bwraps_cellsize"));
+			m_BadParamNames.insert(pair<string, string>("pre_bwraps2_space",       "pre_bwraps_space"));
+			m_BadParamNames.insert(pair<string, string>("pre_bwraps2_gain",        "pre_bwraps_gain"));
+			m_BadParamNames.insert(pair<string, string>("pre_bwraps2_inner_twist", "pre_bwraps_inner_twist"));
+			m_BadParamNames.insert(pair<string, string>("pre_bwraps2_outer_twist", "pre_bwraps_outer_twist"));
+			m_BadParamNames.insert(pair<string, string>("post_bwraps2_cellsize",    "post_bwraps_cellsize"));
+			m_BadParamNames.insert(pair<string, string>("post_bwraps2_space",       "post_bwraps_space"));
+			m_BadParamNames.insert(pair<string, string>("post_bwraps2_gain",        "post_bwraps_gain"));
+			m_BadParamNames.insert(pair<string, string>("post_bwraps2_inner_twist", "post_bwraps_inner_twist"));
+			m_BadParamNames.insert(pair<string, string>("post_bwraps2_outer_twist", "post_bwraps_outer_twist"));
 
 			m_FlattenNames.reserve(24);
 			m_FlattenNames.push_back("pre_crop");
@@ -195,7 +195,7 @@ public:
 			badParams.push_back("bwraps7_gain");
 			badParams.push_back("bwraps7_inner_twist");
 			badParams.push_back("bwraps7_outer_twist");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("bwraps7"), string("bwraps")), badParams));//bwraps7 is the same as bwraps.
+			m_BadVariationNames.insert(make_pair(string("bwraps7"), make_pair(string("bwraps"), badParams)));//bwraps7 is the same as bwraps.
 			badParams.clear();
 
 			badParams.push_back("bwraps2_cellsize");
@@ -203,7 +203,7 @@ public:
 			badParams.push_back("bwraps2_gain");
 			badParams.push_back("bwraps2_inner_twist");
 			badParams.push_back("bwraps2_outer_twist");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("bwraps2"), string("bwraps")), badParams));//bwraps2 is the same as bwraps.
+			m_BadVariationNames.insert(make_pair(string("bwraps2"), make_pair(string("bwraps"), badParams)));//bwraps2 is the same as bwraps.
 			badParams.clear();
 
 			badParams.push_back("pre_bwraps2_cellsize");
@@ -211,7 +211,7 @@ public:
 			badParams.push_back("pre_bwraps2_gain");
 			badParams.push_back("pre_bwraps2_inner_twist");
 			badParams.push_back("pre_bwraps2_outer_twist");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("pre_bwraps2"), string("pre_bwraps")), badParams));
+			m_BadVariationNames.insert(make_pair(string("pre_bwraps2"), make_pair(string("pre_bwraps"), badParams)));
 			badParams.clear();
 
 			badParams.push_back("post_bwraps2_cellsize");
@@ -219,7 +219,7 @@ public:
 			badParams.push_back("post_bwraps2_gain");
 			badParams.push_back("post_bwraps2_inner_twist");
 			badParams.push_back("post_bwraps2_outer_twist");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("post_bwraps2"), string("post_bwraps")), badParams));
+			m_BadVariationNames.insert(make_pair(string("post_bwraps2"), make_pair(string("post_bwraps"), badParams)));
 			badParams.clear();
 
 			badParams.push_back("mobius_radius");
@@ -228,7 +228,7 @@ public:
 			badParams.push_back("mobius_rect_y");
 			badParams.push_back("mobius_rotate_x");
 			badParams.push_back("mobius_rotate_y");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("mobius"),	string("mobius_strip")), badParams));//mobius_strip clashes with Mobius.
+			m_BadVariationNames.insert(make_pair(string("mobius"),	make_pair(string("mobius_strip"), badParams)));//mobius_strip clashes with Mobius.
 			badParams.clear();
 
 			badParams.push_back("post_dcztransl_x0");
@@ -236,31 +236,43 @@ public:
 			badParams.push_back("post_dcztransl_factor");
 			badParams.push_back("post_dcztransl_overwrite");
 			badParams.push_back("post_dcztransl_clamp");
-			m_BadVariationNames.push_back(make_pair(make_pair(string("post_dcztransl"), string("post_dc_ztransl")), badParams));
+			m_BadVariationNames.insert(make_pair(string("post_dcztransl"), make_pair(string("post_dc_ztransl"), badParams)));
 			badParams.clear();
 
-			m_BadVariationNames.push_back(make_pair(make_pair(string("pre_blur"),    string("pre_gaussian_blur")), badParams));
-			m_BadVariationNames.push_back(make_pair(make_pair(string("pre_spin_z"),  string("pre_rotate_z")),      badParams));
-			m_BadVariationNames.push_back(make_pair(make_pair(string("post_spin_z"), string("post_rotate_z")),     badParams));
+			m_BadVariationNames.insert(make_pair(string("pre_blur"),    make_pair(string("pre_gaussian_blur"), badParams)));
+			m_BadVariationNames.insert(make_pair(string("pre_spin_z"),  make_pair(string("pre_rotate_z"),      badParams)));
+			m_BadVariationNames.insert(make_pair(string("post_spin_z"), make_pair(string("post_rotate_z"),     badParams)));
 
 			m_Init = true;
 		}
 	}
 
 	/// <summary>
-	/// Parse the specified buffer and place the results in the vector of embers passed in.
+	/// Parse the specified null terminated buffer and place the results in the vector of embers passed in.
 	/// </summary>
 	/// <param name="buf">The buffer to parse</param>
 	/// <param name="filename">Full path and filename, optionally empty</param>
 	/// <param name="embers">The newly constructed embers based on what was parsed</param>
 	/// <returns>True if there were no errors, else false.</returns>
 	bool Parse(byte* buf, const char* filename, vector<Ember<T>>& embers)
+	{
+		const char* xmlPtr = CX(&buf[0]);
+
+		return Parse(xmlPtr, strlen(xmlPtr), filename, embers);
+	}
+
+	/// <summary>
+	/// Parse the specified buffer, which need not be null terminated, and place the results in the vector of embers passed in.
+	/// </summary>
+	/// <param name="xmlPtr">The buffer to parse</param>
+	/// <param name="bufSize">The size of the buffer in bytes</param>
+	/// <param name="filename">Full path and filename, optionally empty</param>
+	/// <param name="embers">The newly constructed embers based on what was parsed</param>
+	/// <returns>True if there were no errors, else false.</returns>
+	bool Parse(const char* xmlPtr, size_t bufSize, const char* filename, vector<Ember<T>>& embers)
 	{
 		char* bn;
-		const char* xmlPtr;
 		const char* loc = __FUNCTION__;
-		size_t emberSize;
-		size_t bufSize;
 		xmlDocPtr doc;//Parsed XML document tree.
 		xmlNodePtr rootnode;
 		Locale locale;//Sets and restores on exit.
@@ -268,8 +280,6 @@ public:
 		m_ErrorReport.clear();
 
 		//Parse XML string into internal document.
-		xmlPtr = CX(&buf[0]);
-		bufSize = strlen(xmlPtr);
 		embers.reserve(bufSize / 2500);//The Xml text for an ember is around 2500 bytes, but can be much more. Pre-allocate to aovid unnecessary resizing.
 		doc = xmlReadMemory(xmlPtr, int(bufSize), filename, "ISO-8859-1", XML_PARSE_NONET);//Forbid network access during read.
 		//t.Toc("xmlReadMemory");
@@ -288,60 +298,201 @@ public:
 		bn = basename(const_cast<char*>(filename));
 		ScanForEmberNodes(rootnode, bn, embers);
 		xmlFreeDoc(doc);
-		emberSize = embers.size();
 		//t.Toc("ScanForEmberNodes");
 
-		//Check to see if the first control point or the second-to-last
-		//control point has interpolation="smooth".  This is invalid
-		//and should be reset to linear (with a warning).
-		if (emberSize > 0)
+		FixupEmbers(embers);
+		return true;
+	}
+
+	/// <summary>
+	/// Parse the specified file and place the results in the vector of embers passed in.
+	/// This will strip out ampersands because the Xml parser can't handle them.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="embers">The newly constructed embers based on what was parsed</param>
+	/// <returns>True if there were no errors, else false.</returns>
+	bool Parse(const char* filename, vector<Ember<T>>& embers)
+	{
+		const char* loc = __FUNCTION__;
+		const char* data;
+		size_t size;
+		string buf;
+		MappedFile file;
+
+		//Ensure palette list is setup first.
+		if (!m_PaletteList.Size())
 		{
-			if (embers[0].m_Interp == EMBER_INTERP_SMOOTH)
-			{
-				cout << "Warning: smooth interpolation cannot be used for first segment.\n         switching to linear.\n" << endl;
-				embers[0].m_Interp = EMBER_INTERP_LINEAR;
-			}
+			m_ErrorReport.push_back(string(loc) + " : Palette list must be initialized before parsing embers.");
+			return false;
+		}
 
-			if (emberSize >= 2 && embers[emberSize - 2].m_Interp == EMBER_INTERP_SMOOTH)
-			{
-				cout << "Warning: smooth interpolation cannot be used for last segment.\n         switching to linear.\n" << endl;
-				embers[emberSize - 2].m_Interp = EMBER_INTERP_LINEAR;
-			}
+		if ((data = MapFile(filename, file, buf, size)))
+			return Parse(data, size, filename, embers);
+		else
+			return false;
+	}
+
+	/// <summary>
+	/// Parse the specified file one ember at a time, passing each to a function as soon as it's complete.
+	/// Parse() builds a tree of the entire file before the first ember can be used, which for large files
+	/// with thousands of embers takes a long time and a lot of memory. This instead reads the file in small
+	/// chunks with an xmlTextReader and only expands the elements of one <flame> at a time, which are then
+	/// parsed the same way as in Parse() and freed by the reader once it moves past them. So memory use is
+	/// bounded by the largest ember rather than the size of the file, and the caller can start using the
+	/// first ember while the rest of the file is still being read.
+	/// The same fixups as Parse() are applied. The interpolation of the second to last ember can only be
+	/// corrected once the end of the file is reached, so each ember is held back until two more have been read.
+	/// Ampersands are stripped out while reading, the same as Parse().
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="func">Function called with each ember in the order they appear in the file. Return false to stop parsing.</param>
+	/// <returns>True if there were no errors, else false.</returns>
+	bool ParseStream(const char* filename, std::function<bool (Ember<T>& ember)> func)
+	{
+		bool b = true, keepGoing = true;
+		int ret;
+		size_t index = 0;
+		const char* loc = __FUNCTION__;
+		FILE* f = nullptr;
+		xmlTextReaderPtr reader;
+		deque<Ember<T>> pending;//Embers which have been parsed, but not yet passed to func.
+		Locale locale;//Sets and restores on exit.
+		string parentFileString;
+
+		m_ErrorReport.clear();
+
+		//Ensure palette list is setup first.
+		if (!m_PaletteList.Size())
+		{
+			m_ErrorReport.push_back(string(loc) + " : Palette list must be initialized before parsing embers.");
+			return false;
 		}
 
-		//Finally, ensure that consecutive 'rotate' parameters never exceed
-		//a difference of more than 180 degrees (+/-) for interpolation.
-		//An adjustment of +/- 360 degrees is made until this is true.
-		if (emberSize > 1)
+		fopen_s(&f, filename, "rb");
+
+		if (f == nullptr)
 		{
-			for (uint i = 1; i < emberSize; i++)
+			m_ErrorReport.push_back(string(loc) + " : Error opening xml file " + string(filename));
+			return false;
+		}
+
+		reader = xmlReaderForIO(ReadWithoutAmpersands, nullptr, f, filename, "ISO-8859-1", XML_PARSE_NONET);//Forbid network access during read.
+
+		if (reader == nullptr)
+		{
+			m_ErrorReport.push_back(string(loc) + " : Error creating xml reader for file " + string(filename));
+			fclose(f);
+			return false;
+		}
+
+		parentFileString = string(basename(const_cast<char*>(filename)));
+		ret = xmlTextReaderRead(reader);
+
+		while (ret == 1 && keepGoing)
+		{
+			if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT && !Compare(xmlTextReaderConstName(reader), "flame"))
 			{
-				//Only do this adjustment if not in compat mode..
-				if (embers[i - 1].m_AffineInterp != INTERP_COMPAT && embers[i - 1].m_AffineInterp != INTERP_OLDER)
+				Ember<T> currentEmber;//Place this inside here so its constructor is called each time.
+				xmlNodePtr emberNode = xmlTextReaderExpand(reader);//Only valid until the reader moves past the element.
+
+				if (emberNode == nullptr || !ParseEmberElement(emberNode, currentEmber))
 				{
-					while (embers[i].m_Rotate < embers[i - 1].m_Rotate - 180)
-						embers[i].m_Rotate += 360;
+					m_ErrorReport.push_back(string(loc) + " : Error parsing ember element");
+					b = false;
+					break;
+				}
 
-					while (embers[i].m_Rotate > embers[i - 1].m_Rotate + 180)
-						embers[i].m_Rotate -= 360;
+				FinishEmber(currentEmber, index++, parentFileString);
+
+				if (pending.empty())
+				{
+					if (currentEmber.m_Interp == EMBER_INTERP_SMOOTH)
+					{
+						cout << "Warning: smooth interpolation cannot be used for first segment.\n         switching to linear.\n" << endl;
+						currentEmber.m_Interp = EMBER_INTERP_LINEAR;
+					}
 				}
+				else
+				{
+					Ember<T>& prev = pending.back();
+
+					//Only do this adjustment if not in compat mode.
+					if (prev.m_AffineInterp != INTERP_COMPAT && prev.m_AffineInterp != INTERP_OLDER)
+					{
+						while (currentEmber.m_Rotate < prev.m_Rotate - 180)
+							currentEmber.m_Rotate += 360;
+
+						while (currentEmber.m_Rotate > prev.m_Rotate + 180)
+							currentEmber.m_Rotate -= 360;
+					}
+				}
+
+				pending.push_back(std::move(currentEmber));
+
+				if (pending.size() > 2)
+				{
+					keepGoing = func(pending.front());
+					pending.pop_front();
+				}
+
+				ret = xmlTextReaderNext(reader);//Skip over the children of the ember, which were already parsed.
+			}
+			else
+			{
+				ret = xmlTextReaderRead(reader);
 			}
 		}
 
-		return true;
+		if (ret < 0)
+		{
+			m_ErrorReport.push_back(string(loc) + " : Error parsing xml file " + string(filename));
+			b = false;
+		}
+
+		xmlFreeTextReader(reader);
+		fclose(f);
+
+		//The end of the file has been reached, so the second to last ember is now known.
+		if (keepGoing && pending.size() == 2 && pending.front().m_Interp == EMBER_INTERP_SMOOTH)
+		{
+			cout << "Warning: smooth interpolation cannot be used for last segment.\n         switching to linear.\n" << endl;
+			pending.front().m_Interp = EMBER_INTERP_LINEAR;
+		}
+
+		while (keepGoing && !pending.empty())
+		{
+			keepGoing = func(pending.front());
+			pending.pop_front();
+		}
+
+		return b;
 	}
 
 	/// <summary>
-	/// Parse the specified file and place the results in the vector of embers passed in.
+	/// Parse the specified file using multiple threads and place the results in the vector of embers passed in.
+	/// Each <flame> element can be parsed independently of the others once it's known where it begins and ends.
+	/// So rather than building a tree of the whole file, the text is split at the boundaries of the flame elements,
+	/// and contiguous groups of them are parsed on the thread pool, each with its own XmlToEmber. Each parser has
+	/// its own VariationList and error report, so the only state shared between them is the read only palette list.
+	/// The results are stored in file order, and the same fixups as Parse() are applied once all are done.
+	/// Since no single parser sees the whole document, the text outside of the flame elements is checked
+	/// separately, so a file which Parse() would reject as not well formed is rejected here too.
+	/// If the file can't be split, such as when it has fewer than two flame elements, or the text outside
+	/// of them isn't well formed, this falls back to Parse() so the errors are the same as it reports.
 	/// This will strip out ampersands because the Xml parser can't handle them.
 	/// </summary>
 	/// <param name="filename">Full path and filename</param>
 	/// <param name="embers">The newly constructed embers based on what was parsed</param>
+	/// <param name="threads">The number of threads to use, 0 to use all processors. Default: 0.</param>
 	/// <returns>True if there were no errors, else false.</returns>
-	bool Parse(const char* filename, vector<Ember<T>>& embers)
+	bool ParseParallel(const char* filename, vector<Ember<T>>& embers, size_t threads = 0)
 	{
 		const char* loc = __FUNCTION__;
-		string buf;
+		const char* data;
+		size_t size;
+		string buf, parentFileString;
+		MappedFile file;
+		vector<pair<size_t, size_t>> ranges;
 
 		//Ensure palette list is setup first.
 		if (!m_PaletteList.Size())
@@ -350,13 +501,88 @@ public:
 			return false;
 		}
 
-		if (ReadFile(filename, buf))
+		if (!(data = MapFile(filename, file, buf, size)))
+			return false;
+
+		if (!SplitEmbers(data, size, ranges) || ranges.size() < 2 || !OutsideEmbersWellFormed(data, size, ranges, filename))
+			return Parse(data, size, filename, embers);
+
+		Locale locale;//Sets and restores on exit. The locale is process wide, so this covers all threads.
+		size_t workers = std::min(ranges.size(), threads ? threads : size_t(Timing::ProcessorCount()));
+		vector<unique_ptr<XmlToEmber<T>>> parsers;
+		vector<size_t> failed(workers, ranges.size());//The index of the first ember each worker failed to parse, if any.
+
+		m_ErrorReport.clear();
+		parentFileString = string(basename(const_cast<char*>(filename)));
+		embers.clear();
+		embers.resize(ranges.size());
+		xmlInitParser();//Must be called once before using libxml2 from multiple threads.
+
+		for (size_t i = 0; i < workers; i++)//Create serially because the constructor initializes static members.
+			parsers.push_back(unique_ptr<XmlToEmber<T>>(new XmlToEmber<T>()));
+
+		parallel_for(size_t(0), workers, [&] (size_t worker)
 		{
-			std::replace(buf.begin(), buf.end(), '&', '+');
-			return Parse(reinterpret_cast<byte*>(const_cast<char*>(buf.data())), filename, embers);
+			XmlToEmber<T>& parser = *parsers[worker];
+			size_t start = (worker * ranges.size()) / workers;
+			size_t end = ((worker + 1) * ranges.size()) / workers;
+
+			for (size_t i = start; i < end; i++)
+			{
+				xmlDocPtr doc = xmlReadMemory(data + ranges[i].first, int(ranges[i].second - ranges[i].first), filename, "ISO-8859-1", XML_PARSE_NONET);//Forbid network access during read.
+
+				if (doc == nullptr || !parser.ParseEmberElement(xmlDocGetRootElement(doc), embers[i]))
+				{
+					if (doc)
+						xmlFreeDoc(doc);
+
+					failed[worker] = i;
+					break;
+				}
+
+				xmlFreeDoc(doc);
+				parser.FinishEmber(embers[i], i, parentFileString);
+			}
+		});
+
+		//Parse() stops at the first ember that fails, so do the same here by discarding it and all after it.
+		for (size_t i = 0; i < workers; i++)
+		{
+			auto& errors = parsers[i]->m_ErrorReport;
+
+			m_ErrorReport.insert(m_ErrorReport.end(), errors.begin(), errors.end());
+
+			if (failed[i] < embers.size())
+			{
+				m_ErrorReport.push_back(string(loc) + " : Error parsing ember element " + std::to_string(failed[i]) + " in xml file " + string(filename));
+				embers.resize(failed[i]);
+				FixupEmbers(embers);
+				return false;
+			}
 		}
-		else
-			return false;
+
+		FixupEmbers(embers);
+		return true;
+	}
+
+	/// <summary>
+	/// Count the <flame> elements in a file without parsing it, so that users of ParseStream()
+	/// can know how many embers to expect before the first one arrives.
+	/// The file is mapped and searched with SplitEmbers(), which is much faster than parsing and
+	/// skips over comments and CDATA sections, so commented out flames are not counted.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <returns>The number of <flame> elements found, 0 if the file couldn't be read.</returns>
+	static size_t CountEmbers(const char* filename)
+	{
+		MappedFile file;
+		vector<pair<size_t, size_t>> ranges;
+
+		if (!file.Open(filename) || !file.Data())
+			return 0;
+
+		SplitEmbers(CCX(file.Data()), file.Size(), ranges);//If the end of the file is malformed, count the complete elements before it.
+		return ranges.size();
 	}
 
 	/// <summary>
@@ -369,25 +595,20 @@ public:
 	bool Atof(const char* str, T& val)
 	{
 		bool b = true;
-		char* endp;
+		double d = 0;
 		const char* loc = __FUNCTION__;
+		const char* endp = FromChars(str, d);//Doesn't use errno, so this is safe to call from multiple threads.
 
-		//Reset errno.
-		errno = 0;//Note that this is not thread-safe.
+		val = T(d);
 
-		//Convert the string using strtod().
-		val = T(strtod(str, &endp));
-
-		//Check errno & return string.
-		if (endp != str + strlen(str))
+		if (endp == nullptr)
 		{
-			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str) + ", extra chars");
+			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str));
 			b = false;
 		}
-
-		if (errno)
+		else if (*endp)
 		{
-			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str));
+			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str) + ", extra chars");
 			b = false;
 		}
 
@@ -395,46 +616,27 @@ public:
 	}
 
 	/// <summary>
-	/// Thin wrapper around Atoi().
-	/// See error report for errors.
-	/// </summary>
-	/// <param name="str">The string to convert</param>
-	/// <param name="val">The converted uinteger value</param>
-	/// <returns>True if success, else false.</returns>
-	bool Atoi(const char* str, uint& val)
-	{
-		return Atoi(str, reinterpret_cast<int&>(val));
-	}
-
-	/// <summary>
-	/// Convert the string to an uinteger value and return a bool indicating success.
+	/// Convert the string to an int or uint value and return a bool indicating success.
 	/// See error report for errors.
 	/// </summary>
 	/// <param name="str">The string to convert</param>
-	/// <param name="val">The converted uinteger value</param>
+	/// <param name="val">The converted value</param>
 	/// <returns>True if success, else false.</returns>
-	bool Atoi(const char* str, int& val)
+	template <typename intT>
+	bool Atoi(const char* str, intT& val)
 	{
 		bool b = true;
-		char* endp;
 		const char* loc = __FUNCTION__;
+		const char* endp = FromChars(str, val);//Doesn't use errno, so this is safe to call from multiple threads.
 
-		//Reset errno.
-		errno = 0;//Note that this is not thread-safe.
-
-		//Convert the string using strtod().
-		val = strtol(str, &endp, 10);
-
-		//Check errno & return string.
-		if (endp != str + strlen(str))
+		if (endp == nullptr)
 		{
-			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str) + ", extra chars");
+			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str));
 			b = false;
 		}
-
-		if (errno)
+		else if (*endp)
 		{
-			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str));
+			m_ErrorReport.push_back(string(loc) + " : Error converting " + string(str) + ", extra chars");
 			b = false;
 		}
 
@@ -513,20 +715,7 @@ private:
 					return;
 				}
 
-				if (currentEmber.PaletteIndex() != -1)
-				{
-					if (!m_PaletteList.GetHueAdjustedPalette(PaletteList<T>::m_DefaultFilename, currentEmber.PaletteIndex(), currentEmber.m_Hue, currentEmber.m_Palette))
-					{
-						m_ErrorReport.push_back(string(loc) + " : Error assigning palette with index " + Itos(currentEmber.PaletteIndex()));
-					}
-				}
-
-				//if (!Interpolater<T>::InterpMissingColors(currentEmber.m_Palette.m_Entries))
-				//	m_ErrorReport.push_back(string(loc) + " : Error interpolating missing palette colors");
-
-				currentEmber.CacheXforms();
-				currentEmber.m_Index = embers.size();
-				currentEmber.m_ParentFilename = parentFileString;
+				FinishEmber(currentEmber, embers.size(), parentFileString);
 				embers.push_back(currentEmber);
 			}
 			else
@@ -537,6 +726,266 @@ private:
 		}
 	}
 
+	/// <summary>
+	/// Complete an ember which was just parsed by assigning its palette, caching its xforms
+	/// and recording where it came from.
+	/// </summary>
+	/// <param name="currentEmber">The ember to complete</param>
+	/// <param name="index">The index of the ember within its file</param>
+	/// <param name="parentFile">The filename of the file the ember was read from</param>
+	void FinishEmber(Ember<T>& currentEmber, size_t index, const string& parentFile)
+	{
+		const char* loc = __FUNCTION__;
+
+		if (currentEmber.PaletteIndex() != -1)
+		{
+			if (!m_PaletteList.GetHueAdjustedPalette(PaletteList<T>::m_DefaultFilename, currentEmber.PaletteIndex(), currentEmber.m_Hue, currentEmber.m_Palette))
+			{
+				m_ErrorReport.push_back(string(loc) + " : Error assigning palette with index " + Itos(currentEmber.PaletteIndex()));
+			}
+		}
+
+		//if (!Interpolater<T>::InterpMissingColors(currentEmber.m_Palette.m_Entries))
+		//	m_ErrorReport.push_back(string(loc) + " : Error interpolating missing palette colors");
+
+		currentEmber.CacheXforms();
+		currentEmber.m_Index = index;
+		currentEmber.m_ParentFilename = parentFile;
+	}
+
+	/// <summary>
+	/// Apply the fixups which depend on the neighbors of each ember once all embers in a file have been parsed.
+	/// </summary>
+	/// <param name="embers">The embers to fix up, in the order they appeared in the file</param>
+	void FixupEmbers(vector<Ember<T>>& embers)
+	{
+		size_t emberSize = embers.size();
+
+		//Check to see if the first control point or the second-to-last
+		//control point has interpolation="smooth".  This is invalid
+		//and should be reset to linear (with a warning).
+		if (emberSize > 0)
+		{
+			if (embers[0].m_Interp == EMBER_INTERP_SMOOTH)
+			{
+				cout << "Warning: smooth interpolation cannot be used for first segment.\n         switching to linear.\n" << endl;
+				embers[0].m_Interp = EMBER_INTERP_LINEAR;
+			}
+
+			if (emberSize >= 2 && embers[emberSize - 2].m_Interp == EMBER_INTERP_SMOOTH)
+			{
+				cout << "Warning: smooth interpolation cannot be used for last segment.\n         switching to linear.\n" << endl;
+				embers[emberSize - 2].m_Interp = EMBER_INTERP_LINEAR;
+			}
+		}
+
+		//Finally, ensure that consecutive 'rotate' parameters never exceed
+		//a difference of more than 180 degrees (+/-) for interpolation.
+		//An adjustment of +/- 360 degrees is made until this is true.
+		if (emberSize > 1)
+		{
+			for (uint i = 1; i < emberSize; i++)
+			{
+				//Only do this adjustment if not in compat mode..
+				if (embers[i - 1].m_AffineInterp != INTERP_COMPAT && embers[i - 1].m_AffineInterp != INTERP_OLDER)
+				{
+					while (embers[i].m_Rotate < embers[i - 1].m_Rotate - 180)
+						embers[i].m_Rotate += 360;
+
+					while (embers[i].m_Rotate > embers[i - 1].m_Rotate + 180)
+						embers[i].m_Rotate -= 360;
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Map a file for parsing, or copy it if it contains ampersands, which are replaced because the Xml parser can't handle them.
+	/// Almost no files have any, so most are parsed directly from the map without ever being copied, which also lets
+	/// any number of processes parsing the same file share its pages in the OS file cache.
+	/// </summary>
+	/// <param name="filename">Full path and filename</param>
+	/// <param name="file">The map, which must outlive any use of the returned pointer</param>
+	/// <param name="buf">Storage for the copy if one was needed</param>
+	/// <param name="size">The size of the text in bytes</param>
+	/// <returns>The text of the file if successful, else nullptr.</returns>
+	const char* MapFile(const char* filename, MappedFile& file, string& buf, size_t& size)
+	{
+		const char* data;
+
+		if (!file.Open(filename) || !file.Data())
+		{
+			m_ErrorReport.push_back(string(__FUNCTION__) + " : Couldn't read file " + string(filename));
+			return nullptr;
+		}
+
+		data = CCX(file.Data());
+		size = file.Size();
+
+		if (memchr(data, '&', size))
+		{
+			buf.assign(data, size);
+			std::replace(buf.begin(), buf.end(), '&', '+');
+			file.Close();
+			data = buf.data();
+		}
+
+		return data;
+	}
+
+	/// <summary>
+	/// Find a string in a buffer.
+	/// </summary>
+	/// <param name="data">The buffer to search</param>
+	/// <param name="size">The size of the buffer</param>
+	/// <param name="s">The string to search for</param>
+	/// <param name="from">The offset to start searching at</param>
+	/// <returns>The offset of the string if found, else string::npos.</returns>
+	static size_t Find(const char* data, size_t size, const char* s, size_t from)
+	{
+		const char* end = data + size;
+		const char* p = std::search(data + std::min(from, size), end, s, s + strlen(s));
+
+		return p != end ? size_t(p - data) : string::npos;
+	}
+
+	/// <summary>
+	/// Determine whether a buffer contains a string at an offset.
+	/// </summary>
+	/// <param name="data">The buffer to check</param>
+	/// <param name="size">The size of the buffer</param>
+	/// <param name="i">The offset to check at</param>
+	/// <param name="s">The string to compare with</param>
+	/// <returns>True if the string is at the offset, else false.</returns>
+	static bool Matches(const char* data, size_t size, size_t i, const char* s)
+	{
+		size_t len = strlen(s);
+
+		return i + len <= size && !memcmp(data + i, s, len);
+	}
+
+	/// <summary>
+	/// Check that the text of a file is well formed once its flame elements have been cut out.
+	/// Each flame element is a complete element which is checked when it's parsed on its own, so if
+	/// this passes too, the file as a whole is well formed, the same as what Parse() requires.
+	/// The flame elements are the bulk of any file, so what's left is small and quick to parse.
+	/// </summary>
+	/// <param name="data">The text of the file</param>
+	/// <param name="size">The size of the text in bytes</param>
+	/// <param name="ranges">The start and one past the end of each flame element, as found by SplitEmbers()</param>
+	/// <param name="filename">Full path and filename, used in libxml2's own messages</param>
+	/// <returns>True if the remaining text is a well formed document, else false.</returns>
+	static bool OutsideEmbersWellFormed(const char* data, size_t size, const vector<pair<size_t, size_t>>& ranges, const char* filename)
+	{
+		size_t last = 0;
+		string outside;
+		xmlDocPtr doc;
+
+		for (auto& range : ranges)
+		{
+			outside.append(data + last, range.first - last);
+			last = range.second;
+		}
+
+		outside.append(data + last, size - last);
+		doc = xmlReadMemory(outside.data(), int(outside.size()), filename, "ISO-8859-1", XML_PARSE_NONET | XML_PARSE_NOERROR | XML_PARSE_NOWARNING);//Quiet, because Parse() reports the errors if this fails.
+
+		if (doc == nullptr)
+			return false;
+
+		xmlFreeDoc(doc);
+		return true;
+	}
+
+	/// <summary>
+	/// Find where each <flame> element in the text of a file begins and ends.
+	/// Flame elements can't be nested, so this only needs to skip over comments and CDATA
+	/// sections, and quoted attribute values in the start tag which may contain a '>'.
+	/// </summary>
+	/// <param name="data">The text of the file</param>
+	/// <param name="size">The size of the text in bytes</param>
+	/// <param name="ranges">The start and one past the end of each flame element</param>
+	/// <returns>True if all flame elements were found to be complete, else false.</returns>
+	static bool SplitEmbers(const char* data, size_t size, vector<pair<size_t, size_t>>& ranges)
+	{
+		size_t i = 0;
+		const char* p;
+
+		ranges.clear();
+
+		while (i < size && (p = static_cast<const char*>(memchr(data + i, '<', size - i))))
+		{
+			i = size_t(p - data);
+
+			if (Matches(data, size, i, "<!--"))
+			{
+				if ((i = Find(data, size, "-->", i + 4)) == string::npos)
+					return false;
+			}
+			else if (Matches(data, size, i, "<![CDATA["))
+			{
+				if ((i = Find(data, size, "]]>", i + 9)) == string::npos)
+					return false;
+			}
+			else if (Matches(data, size, i, "<flame") && i + 6 < size && (data[i + 6] == '>' || data[i + 6] == '/' || isspace(static_cast<unsigned char>(data[i + 6]))))
+			{
+				char quote = 0;
+				size_t j, end;
+
+				for (j = i + 6; j < size; j++)//Find the end of the start tag.
+				{
+					if (quote)
+					{
+						if (data[j] == quote)
+							quote = 0;
+					}
+					else if (data[j] == '"' || data[j] == '\'')
+						quote = data[j];
+					else if (data[j] == '>')
+						break;
+				}
+
+				if (j == size)
+					return false;
+
+				if (data[j - 1] == '/')//Empty element.
+					end = j + 1;
+				else if ((end = Find(data, size, "</flame", j)) != string::npos && (end = Find(data, size, ">", end)) != string::npos)
+					end++;
+				else
+					return false;
+
+				ranges.push_back(make_pair(i, end));
+				i = end;
+				continue;
+			}
+
+			i++;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Read callback for the xmlTextReader used by ParseStream(), which reads the next
+	/// chunk of the file and strips out ampersands because the Xml parser can't handle them.
+	/// </summary>
+	/// <param name="context">The FILE* being read</param>
+	/// <param name="buffer">The buffer to read into</param>
+	/// <param name="len">The size of the buffer</param>
+	/// <returns>The number of bytes read, 0 at the end of the file, or -1 on error.</returns>
+	static int ReadWithoutAmpersands(void* context, char* buffer, int len)
+	{
+		FILE* f = static_cast<FILE*>(context);
+		size_t bytesRead = fread(buffer, 1, size_t(len), f);
+
+		if (ferror(f))
+			return -1;
+
+		std::replace(buffer, buffer + bytesRead, '&', '+');
+		return int(bytesRead);
+	}
+
 	/// <summary>
 	/// Parse an ember element.
 	/// </summary>
@@ -988,9 +1437,11 @@ private:
 			else if (!Compare(childNode->name, "edit"))
 			{
 				//Create a new XML document with this edit node as the root node.
-				currentEmber.m_Edits = xmlNewDoc(XC("1.0"));
+				xmlDocPtr edits = xmlNewDoc(XC("1.0"));
+
 				editNode = xmlCopyNode(childNode, 1);
-				xmlDocSetRootElement(currentEmber.m_Edits, editNode);
+				xmlDocSetRootElement(edits, editNode);
+				currentEmber.SetEdit(edits);
 			}
 		}
 
@@ -1220,16 +1671,17 @@ private:
 		}
 
 		//Now that all xforms have been parsed, go through and try to find params for the parametric variations.
-		for (uint i = 0; i < xform.TotalVariationCount(); i++)
+		//The variation list knows which variations have a param with a given name, so each attribute is only looked up once.
+		for (curAtt = attPtr; curAtt; curAtt = curAtt->next)
 		{
-			if (ParametricVariation<T>* parVar = dynamic_cast<ParametricVariation<T>*>(xform.GetVariation(i)))
+			string s = GetCorrectedParamName(m_BadParamNames, CCX(curAtt->name));
+			const char* name = s.c_str();
+
+			if (auto ids = m_VariationList.GetParamVariationIds(s))
 			{
-				for (curAtt = attPtr; curAtt; curAtt = curAtt->next)
+				for (auto id : *ids)
 				{
-					string s = GetCorrectedParamName(m_BadParamNames, CCX(curAtt->name));
-					const char* name = s.c_str();
-
-					if (parVar->ContainsParam(name))
+					if (ParametricVariation<T>* parVar = dynamic_cast<ParametricVariation<T>*>(xform.GetVariationById(id)))
 					{
 						T val = 0;
 						attStr = CX(xmlGetProp(childNode, curAtt->name));
@@ -1256,16 +1708,14 @@ private:
 	/// Some Apophysis plugins use an inconsistent naming scheme for the parametric variation variables.
 	/// This function identifies and converts them to Ember's consistent naming convention.
 	/// </summary>
-	/// <param name="vec">The vector of corrected names to search</param>
+	/// <param name="names">The map of corrected names to search</param>
 	/// <param name="att">The current Xml node to check</param>
 	/// <returns>The corrected name if one was found, else the passed in name.</returns>
-	static string GetCorrectedParamName(vector<pair<string, string>>& vec, const char* name)
+	static string GetCorrectedParamName(unordered_map<string, string, NameHash, NameEqual>& names, const char* name)
 	{
-		for (auto& v : vec)
-			if (!_stricmp(v.first.c_str(), name))
-				return v.second;
+		auto it = names.find(name);
 
-		return name;
+		return it != names.end() ? it->second : name;
 	}
 
 	/// <summary>
@@ -1274,28 +1724,29 @@ private:
 	/// It uses some additional intelligence to ensure the variation is the expected one,
 	/// by examining the rest of the xform for the existence of parameter names.
 	/// </summary>
-	/// <param name="vec">The vector of corrected names to search</param>
+	/// <param name="names">The map of corrected names to search</param>
 	/// <param name="att">The current Xml node to check</param>
 	/// <returns>The corrected name if one was found, else the passed in name.</returns>
-	static string GetCorrectedVariationName(vector<pair<pair<string, string>, vector<string>>>& vec, xmlAttrPtr att)
+	static string GetCorrectedVariationName(unordered_map<string, pair<string, vector<string>>, NameHash, NameEqual>& names, xmlAttrPtr att)
 	{
-		for (auto& v : vec)
+		auto it = names.find(CCX(att->name));
+
+		if (it != names.end())
 		{
-			if (!_stricmp(v.first.first.c_str(), CCX(att->name)))//Do case insensitive here.
+			auto& v = it->second;
+
+			if (!v.second.empty())
 			{
-				if (!v.second.empty())
-				{
-					for (size_t j = 0; j < v.second.size(); j++)
-					{
-						if (XmlContainsTag(att, v.second[j].c_str()))
-							return v.first.second;
-					}
-				}
-				else
+				for (size_t j = 0; j < v.second.size(); j++)
 				{
-					return v.first.second;
+					if (XmlContainsTag(att, v.second[j].c_str()))
+						return v.first;
 				}
 			}
+			else
+			{
+				return v.first;
+			}
 		}
 
 		return string(CCX(att->name));
@@ -1439,8 +1890,8 @@ private:
 	}
 
 	static bool m_Init;
-	static vector<pair<string, string>> m_BadParamNames;
-	static vector<pair<pair<string, string>, vector<string>>> m_BadVariationNames;
+	static unordered_map<string, string, NameHash, NameEqual> m_BadParamNames;//The first entry for a name is used.
+	static unordered_map<string, pair<string, vector<string>>, NameHash, NameEqual> m_BadVariationNames;
 	VariationList<T> m_VariationList;//The variation list used to make copies of variations to populate the embers with.
 	PaletteList<T> m_PaletteList;
 };
@@ -37,9 +37,13 @@ bool EmberAnimate(EmberOptions& opt)
 	ostringstream os;
 	vector<Ember<T>> embers;
 	EmberStats stats;
+	EmberStats frameStats[2];//Stats of the frame held in each final image buffer, completed by the write thread.
+	uint frameTimes[2] = { 0, 0 };
+	StatsJson statsJson;
 	EmberReport emberReport;
 	EmberImageComments comments;
 	Ember<T> centerEmber;
+	Interpolater<T> interpolater;
 	XmlToEmber<T> parser;
 	EmberToXml<T> emberToXml;
 	vector<byte> finalImages[2];
@@ -124,6 +128,12 @@ bool EmberAnimate(EmberOptions& opt)
 		opt.BitsPerChannel(8);
 	}
 
+	if (opt.PngCompression() > 9)
+	{
+		cout << "Png compression must be 0-9 not " << opt.PngCompression() << ". Setting to 9." << endl;
+		opt.PngCompression(9);
+	}
+
 	if (opt.InsertPalette() && opt.BitsPerChannel() != 8)
 	{
 		cout << "Inserting palette only supported with 8 bits per channel, insertion will not take place." << endl;
@@ -258,18 +268,33 @@ bool EmberAnimate(EmberOptions& opt)
 	renderer->Transparency(opt.Transparency());
 	renderer->NumChannels(channels);
 	renderer->BytesPerChannel(opt.BitsPerChannel() / 8);
+	renderer->TargetNoise(opt.Noise());
+	renderer->MaxIterScale(opt.MaxIterScale());
+	renderer->NumaAware(opt.Numa());
+	HugePages::Policy(eHugePagePolicy(std::min(opt.HugePages(), uint(HUGE_PAGES_EXPLICIT))));
 	renderer->Callback(opt.DoProgress() ? progress.get() : nullptr);
 
+	if (opt.Verbose() && opt.Numa() && !opt.EmberCL())
+	{
+		cout << NumaTopology::Dump(renderer->ThreadCount());
+		cout << "Histogram replicas: " << renderer->NumaReplicas() << endl;
+	}
+
 	std::function<void(uint)> saveFunc = [&](uint threadVecIndex)
 	{
 		bool writeSuccess = false;
 		byte* finalImagep = finalImages[threadVecIndex].data();
+		EmberStats& frameStat = frameStats[threadVecIndex];
+		Timing stageTimer;
 
 		if ((opt.Format() == "jpg" || opt.Format() == "bmp") && renderer->NumChannels() == 4)
 			RgbaToRgb(finalImages[threadVecIndex], finalImages[threadVecIndex], renderer->FinalRasW(), renderer->FinalRasH());
 
+		stageTimer.Toc(frameStat.m_EncodeMs, frameStat.m_EncodeCpuMs);
+		stageTimer.Tic();
+
 		if (opt.Format() == "png")
-			writeSuccess = WritePng(filename.c_str(), finalImagep, renderer->FinalRasW(), renderer->FinalRasH(), opt.BitsPerChannel() / 8, opt.PngComments(), comments, opt.Id(), opt.Url(), opt.Nick());
+			writeSuccess = WritePng(filename.c_str(), finalImagep, renderer->FinalRasW(), renderer->FinalRasH(), opt.BitsPerChannel() / 8, opt.PngComments(), comments, opt.Id(), opt.Url(), opt.Nick(), int(opt.PngCompression()));
 		else if (opt.Format() == "jpg")
 			writeSuccess = WriteJpeg(filename.c_str(), finalImagep, renderer->FinalRasW(), renderer->FinalRasH(), opt.JpegQuality(), opt.JpegComments(), comments, opt.Id(), opt.Url(), opt.Nick());
 		else if (opt.Format() == "ppm")
@@ -277,8 +302,12 @@ bool EmberAnimate(EmberOptions& opt)
 		else if (opt.Format() == "bmp")
 			writeSuccess = WriteBmp(filename.c_str(), finalImagep, renderer->FinalRasW(), renderer->FinalRasH());
 
+		stageTimer.Toc(frameStat.m_WriteMs, frameStat.m_WriteCpuMs);
+
 		if (!writeSuccess)
 			cout << "Error writing " << filename << endl;/**/
+
+		statsJson.Add(filename, frameTimes[threadVecIndex], frameStat);
 	};
 
 	//Begin run.
@@ -310,7 +339,7 @@ bool EmberAnimate(EmberOptions& opt)
 		{
 			flameName = filename.substr(0, filename.find_last_of('.')) + ".flam3";
 			VerbosePrint("Writing " + flameName);
-			Interpolater<T>::Interpolate(embers, localTime, 0, centerEmber);//Get center flame.
+			interpolater.InterpolateCached(embers, localTime, 0, centerEmber);//Get center flame.
 
 			if (appendXml)
 			{
@@ -329,8 +358,16 @@ bool EmberAnimate(EmberOptions& opt)
 
 		VerbosePrint("\nIters ran/requested: " + os.str());
 		VerbosePrint("Bad values: " << stats.m_Badvals);
+
+		if (comments.m_Noise != "")
+		{
+			VerbosePrint("Noise: " + comments.m_Noise);
+			VerbosePrint("Iters saved: " + comments.m_ItersSaved);
+		}
+
 		VerbosePrint("Render time: " + t.Format(stats.m_RenderMs));
 		VerbosePrint("Pure iter time: " + t.Format(stats.m_IterMs));
+		VerbosePrint("Huge page memory: explicit " << (HugePages::ExplicitBytes() / (1024 * 1024)) << "MB, transparent " << (HugePages::TransparentBytes() / (1024 * 1024)) << "MB");
 		VerbosePrint("Iters/sec: " << size_t(stats.m_Iters / (stats.m_IterMs / 1000.0)) << endl);
 		VerbosePrint("Writing " + filename);
 
@@ -341,6 +378,9 @@ bool EmberAnimate(EmberOptions& opt)
 
 		uint threadVecIndex = finalImageIndex;//Cache before launching thread.
 
+		frameStats[threadVecIndex] = stats;
+		frameTimes[threadVecIndex] = ftime;
+
 		if (opt.ThreadedWrite())
 			writeThread = std::thread(saveFunc, threadVecIndex);
 		else
@@ -353,6 +393,9 @@ bool EmberAnimate(EmberOptions& opt)
 	if (writeThread.joinable())
 		writeThread.join();
 
+	if (!opt.StatsJson().empty() && !statsJson.Save(opt.StatsJson()))
+		cout << "Error writing stats to " << opt.StatsJson() << endl;
+
 	VerbosePrint("Done.\n");
 
 	if (opt.Verbose())
@@ -0,0 +1,398 @@
+#include "EmberCommonPch.h"
+#include "EmberBench.h"
+
+#define BENCH_SEED "EmberBench"//Seed used when --isaac_seed is not specified, so that every run iterates the same sequence.
+#define BENCH_MIN_MS 1.0//Stage times which differ from their baseline by less than this are never regressions, since the difference is timer noise.
+#define BENCH_MIN_MB 1.0//Likewise for peak memory.
+
+/// <summary>
+/// Return the peak resident memory of the process so far.
+/// This only ever grows, so when several flames are rendered, the value after each
+/// one is the peak of it and all of the flames before it.
+/// </summary>
+/// <returns>The peak in bytes, 0 if it could not be queried.</returns>
+static size_t PeakMemoryUsage()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+
+	return 0;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage))
+		return 0;
+
+#ifdef __APPLE__
+	return size_t(usage.ru_maxrss);//Bytes on OSX.
+#else
+	return size_t(usage.ru_maxrss) * 1024;//Kilobytes on Linux.
+#endif
+#endif
+}
+
+/// <summary>
+/// Read the results stored in a baseline file.
+/// Each line holds one flame as tab separated fields: name bits threads iters/sec de_ms accum_ms process_peak_rss_mb
+/// Tabs are used because flame names often contain spaces. Blank lines and lines starting with # are ignored.
+/// </summary>
+/// <param name="filename">The full path and name of the file</param>
+/// <param name="results">The vector to append the results to</param>
+/// <returns>True if the file could be opened, else false.</returns>
+static bool ReadBaseline(const string& filename, vector<BenchResult>& results)
+{
+	string line;
+	ifstream file(filename);
+
+	if (!file)
+		return false;
+
+	while (std::getline(file, line))
+	{
+		BenchResult result;
+		istringstream ss(line);
+
+		ss.imbue(std::locale::classic());
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		if (std::getline(ss, result.m_Name, '\t') && ss >> result.m_Bits >> result.m_Threads >> result.m_ItersPerSec >> result.m_DeMs >> result.m_AccumMs >> result.m_PeakRssMb)
+			results.push_back(result);
+		else
+			cout << "Skipping malformed baseline line: " << line << endl;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Write results to a baseline file.
+/// Entries already in the file for the same flame, bits and thread count are replaced, and all others are kept.
+/// This allows the baselines for different precisions and thread counts to be kept in a single file.
+/// </summary>
+/// <param name="filename">The full path and name of the file</param>
+/// <param name="results">The results to write</param>
+/// <returns>True if success, else false.</returns>
+static bool WriteBaseline(const string& filename, const vector<BenchResult>& results)
+{
+	vector<BenchResult> merged;
+
+	ReadBaseline(filename, merged);//Ok if it doesn't exist yet.
+
+	for (auto& result : results)
+	{
+		auto it = std::find_if(merged.begin(), merged.end(), [&](const BenchResult& base)
+		{
+			return base.m_Name == result.m_Name && base.m_Bits == result.m_Bits && base.m_Threads == result.m_Threads;
+		});
+
+		if (it != merged.end())
+			*it = result;
+		else
+			merged.push_back(result);
+	}
+
+	ofstream file(filename);
+
+	if (!file)
+		return false;
+
+	file.imbue(std::locale::classic());
+	file << "#EmberBench " << EmberVersion() << " baseline." << endl;
+	file << "#name\tbits\tthreads\titers/sec\tde_ms\taccum_ms\tprocess_peak_rss_mb" << endl;
+	file << std::fixed;
+
+	for (auto& result : merged)
+	{
+		string name = result.m_Name;
+
+		std::replace(name.begin(), name.end(), '\t', ' ');//Tabs separate the fields, so they can't appear in the name.
+		file << name << "\t" << result.m_Bits << "\t" << result.m_Threads << "\t"
+			 << std::setprecision(0) << result.m_ItersPerSec << "\t"
+			 << std::setprecision(3) << result.m_DeMs << "\t" << result.m_AccumMs << "\t" << result.m_PeakRssMb << endl;
+	}
+
+	return bool(file);
+}
+
+/// <summary>
+/// Compare a result against its baseline and print every value which is worse by more than the threshold.
+/// Higher is better for iters/sec, and lower is better for everything else.
+/// </summary>
+/// <param name="result">The result of the flame just rendered</param>
+/// <param name="baseline">The baseline of the same flame, bits and thread count</param>
+/// <param name="threshold">The percentage a value can be worse than its baseline before it's a regression</param>
+/// <returns>True if nothing regressed, else false.</returns>
+static bool CompareToBaseline(const BenchResult& result, const BenchResult& baseline, double threshold)
+{
+	bool b = true;
+	auto check = [&](const char* what, double val, double base, bool higherIsBetter, double minDiff)
+	{
+		double diff = higherIsBetter ? base - val : val - base;
+		double percent = base > 0 ? (diff / base) * 100 : 0;
+
+		if (diff > minDiff && percent > threshold)
+		{
+			cout << "Regression: " << result.m_Name << " " << what << " " << std::fixed << std::setprecision(2) << val << " vs. baseline " << base << " (" << percent << "% worse)." << endl;
+			b = false;
+		}
+	};
+
+	check("iters/sec",      result.m_ItersPerSec, baseline.m_ItersPerSec, true,  0);
+	check("DE ms",          result.m_DeMs,        baseline.m_DeMs,        false, BENCH_MIN_MS);
+	check("final accum ms", result.m_AccumMs,     baseline.m_AccumMs,     false, BENCH_MIN_MS);
+	check("process peak RSS MB", result.m_PeakRssMb, baseline.m_PeakRssMb, false, BENCH_MIN_MB);
+	return b;
+}
+
+/// <summary>
+/// The core of the EmberBench.exe program.
+/// Renders each flame of the corpus the specified number of times with a fixed seed and thread count,
+/// then either stores the results as the baseline, or compares them against it.
+/// Nothing is written to disk other than the baseline and the optional stats file.
+/// Template argument expected to be float or double.
+/// </summary>
+/// <param name="opt">A populated EmberOptions object which specifies all program options to be used</param>
+/// <returns>True if success and no regressions were found, else false.</returns>
+template <typename T, typename bucketT>
+bool EmberBench(EmberOptions& opt)
+{
+	OpenCLWrapper wrapper;
+
+	std::cout.imbue(std::locale(""));
+
+	if (opt.DumpArgs())
+		cout << opt.GetValues(OPT_USE_BENCH) << endl;
+
+	if (opt.OpenCLInfo())
+	{
+		cout << "\nOpenCL Info: " << endl;
+		cout << wrapper.DumpInfo();
+		return true;
+	}
+
+	bool b = true;
+	size_t i, run, runs = std::max<size_t>(opt.Runs(), 1);
+	string seed = opt.IsaacSeed() != "" ? opt.IsaacSeed() : BENCH_SEED;
+	vector<Ember<T>> embers;
+	vector<byte> finalImage;
+	vector<BenchResult> results, baselines;
+	EmberStats stats;
+	StatsJson statsJson;
+	EmberReport emberReport;
+	XmlToEmber<T> parser;
+	unique_ptr<Renderer<T, bucketT>> renderer(CreateRenderer<T, bucketT>(opt.EmberCL() ? OPENCL_RENDERER : CPU_RENDERER, opt.Platform(), opt.Device(), false, 0, emberReport));
+	vector<string> errorReport = emberReport.ErrorReport();
+
+	if (!errorReport.empty())
+		emberReport.DumpErrorReport();
+
+	if (!renderer.get())
+	{
+		cout << "Renderer creation failed, exiting." << endl;
+		return false;
+	}
+
+	if (opt.EmberCL() && renderer->RendererType() != OPENCL_RENDERER)//OpenCL init failed, so fall back to CPU.
+		opt.EmberCL(false);
+
+	if (opt.Input().empty())
+	{
+		cout << "No corpus specified with --in, exiting." << endl;
+		return false;
+	}
+
+	if (opt.SaveBaseline() && opt.Baseline().empty())
+	{
+		cout << "--save_baseline requires --baseline to specify the file to save to, exiting." << endl;
+		return false;
+	}
+
+	if (!opt.Baseline().empty() && !opt.SaveBaseline() && !ReadBaseline(opt.Baseline(), baselines))
+	{
+		cout << "Could not read baseline file " << opt.Baseline() << ", exiting." << endl;
+		return false;
+	}
+
+	if (!InitPaletteList<T>(opt.PalettePath()))
+		return false;
+
+	if (!ParseEmberFile(parser, opt.Input(), embers))
+		return false;
+
+	//Unlike EmberRender, the thread count is always made explicit so it can be recorded with the results.
+	if (!opt.EmberCL())
+	{
+		if (opt.ThreadCount() == 0)
+			opt.ThreadCount(Timing::ProcessorCount());
+
+		cout << "Using " << opt.ThreadCount() << " threads." << endl;
+	}
+	else
+	{
+		cout << "Using OpenCL to render." << endl;
+
+		if (opt.Verbose())
+		{
+			cout << "Platform: " << wrapper.PlatformName(opt.Platform()) << endl;
+			cout << "Device: " << wrapper.DeviceName(opt.Platform(), opt.Device()) << endl;
+		}
+
+		opt.ThreadCount(1);
+	}
+
+	renderer->EarlyClip(opt.EarlyClip());
+	renderer->LockAccum(opt.LockAccum());
+	renderer->PixelAspectRatio(T(opt.AspectRatio()));
+	renderer->NumChannels(4);
+	renderer->BytesPerChannel(1);
+	renderer->NumaAware(opt.Numa());
+	renderer->Callback(nullptr);
+	HugePages::Policy(eHugePagePolicy(std::min(opt.HugePages(), uint(HUGE_PAGES_EXPLICIT))));
+	cout << "Seed: " << seed << ", runs per flame: " << runs << endl << endl;
+	cout << std::left << setw(20) << "Flame" << std::right << setw(16) << "Iters/sec" << setw(12) << "DE ms" << setw(12) << "Accum ms" << setw(22) << "Process peak RSS MB" << endl;
+
+	for (i = 0; i < embers.size(); i++)
+	{
+		BenchResult result;
+		Ember<T>& ember = embers[i];
+
+		if (opt.SubBatchSize() != DEFAULT_SBS)
+			ember.m_SubBatchSize = opt.SubBatchSize();
+
+		ember.m_TemporalSamples = 1;
+		ember.m_Quality *= T(opt.QualityScale());
+		ember.m_FinalRasW = uint(T(ember.m_FinalRasW) * opt.SizeScale());
+		ember.m_FinalRasH = uint(T(ember.m_FinalRasH) * opt.SizeScale());
+		ember.m_PixelsPerUnit *= T(opt.SizeScale());
+		result.m_Name = !ember.m_Name.empty() ? ember.m_Name : "flame" + std::to_string(i);
+		result.m_Bits = opt.Bits();
+		result.m_Threads = opt.ThreadCount();
+		result.m_ItersPerSec = 0;
+		result.m_DeMs = result.m_AccumMs = std::numeric_limits<double>::max();
+
+		for (run = 0; run < runs; run++)
+		{
+			//Reseed every run so they all iterate the same way.
+			renderer->ThreadCount(opt.ThreadCount(), seed.c_str());
+			renderer->SetEmber(ember);
+			renderer->PrepFinalAccumVector(finalImage);
+
+			if (renderer->Run(finalImage) != RENDER_OK)
+			{
+				cout << "Error: rendering " << result.m_Name << " failed." << endl;
+				renderer->DumpErrorReport();
+				return false;
+			}
+
+			stats = renderer->Stats();
+			statsJson.Add(result.m_Name, run, stats);
+			result.m_ItersPerSec = std::max(result.m_ItersPerSec, stats.m_IterMs > 0 ? double(stats.m_Iters) / (stats.m_IterMs / 1000.0) : 0.0);
+			result.m_DeMs = std::min(result.m_DeMs, stats.m_FilterMs);
+			result.m_AccumMs = std::min(result.m_AccumMs, stats.m_AccumMs);
+		}
+
+		result.m_PeakRssMb = double(PeakMemoryUsage()) / (1024.0 * 1024.0);
+		results.push_back(result);
+		cout << std::left << setw(20) << result.m_Name << std::right << std::fixed
+			 << setw(16) << std::setprecision(0) << result.m_ItersPerSec
+			 << setw(12) << std::setprecision(2) << result.m_DeMs
+			 << setw(12) << result.m_AccumMs
+			 << setw(22) << result.m_PeakRssMb << endl;
+	}
+
+	cout << endl;
+
+	if (opt.SaveBaseline())
+	{
+		if (WriteBaseline(opt.Baseline(), results))
+		{
+			cout << "Saved baseline to " << opt.Baseline() << endl;
+		}
+		else
+		{
+			cout << "Error writing baseline to " << opt.Baseline() << endl;
+			b = false;
+		}
+	}
+	else if (!opt.Baseline().empty())
+	{
+		size_t regressions = 0;
+
+		for (auto& result : results)
+		{
+			auto it = std::find_if(baselines.begin(), baselines.end(), [&](const BenchResult& base)
+			{
+				return base.m_Name == result.m_Name && base.m_Bits == result.m_Bits && base.m_Threads == result.m_Threads;
+			});
+
+			if (it == baselines.end())
+				cout << "No baseline for " << result.m_Name << " with bits " << result.m_Bits << " and " << result.m_Threads << " threads, skipping." << endl;
+			else if (!CompareToBaseline(result, *it, opt.Threshold()))
+				regressions++;
+		}
+
+		if (regressions)
+		{
+			cout << regressions << " of " << results.size() << " flames regressed by more than " << opt.Threshold() << "%." << endl;
+			b = false;
+		}
+		else
+		{
+			cout << "No regressions beyond " << opt.Threshold() << "% against " << opt.Baseline() << endl;
+		}
+	}
+
+	if (!opt.StatsJson().empty() && !statsJson.Save(opt.StatsJson()))
+		cout << "Error writing stats to " << opt.StatsJson() << endl;
+
+	return b;
+}
+
+/// <summary>
+/// Main program entry point for EmberBench.exe.
+/// </summary>
+/// <param name="argc">The number of command line arguments passed</param>
+/// <param name="argv">The command line arguments passed</param>
+/// <returns>0 if successful and no regressions were found, else 1.</returns>
+int _tmain(int argc, _TCHAR* argv[])
+{
+	bool b = false;
+	EmberOptions opt;
+
+	//Required for large allocs, else GPU memory usage will be severely limited to small sizes.
+	//This must be done in the application and not in the EmberCL DLL.
+#ifdef WIN32
+	_putenv_s("GPU_MAX_ALLOC_PERCENT", "100");
+#else
+	putenv(const_cast<char*>("GPU_MAX_ALLOC_PERCENT=100"));
+#endif
+
+	if (!opt.Populate(argc, argv, OPT_USE_BENCH))
+	{
+
+#ifdef DO_DOUBLE
+		if (opt.Bits() == 64)
+		{
+			b = EmberBench<double, double>(opt);
+		}
+		else
+#endif
+		if (opt.Bits() == 33)
+		{
+			b = EmberBench<float, float>(opt);
+		}
+		else if (opt.Bits() == 32)
+		{
+			cout << "Bits 32/int histogram no longer supported. Using bits == 33 (float)." << endl;
+			opt.Bits(33);
+			b = EmberBench<float, float>(opt);
+		}
+	}
+
+	return b ? 0 : 1;
+}
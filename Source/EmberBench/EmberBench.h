@@ -0,0 +1,31 @@
+#pragma once
+
+#include "EmberOptions.h"
+
+/// <summary>
+/// BenchResult struct and declaration for the EmberBench() function.
+/// </summary>
+
+/// <summary>
+/// The results of benchmarking a single flame, which is also what is stored per flame in a baseline file.
+/// When a flame is rendered more than once, each value is the best one seen across all runs.
+/// </summary>
+struct BenchResult
+{
+	string m_Name;//The name of the flame in the corpus.
+	size_t m_Bits;//The value of --bits the flame was rendered with.
+	size_t m_Threads;//The number of threads the flame was rendered with.
+	double m_ItersPerSec;//Iterations per second of pure iteration time.
+	double m_DeMs;//Milliseconds spent density filtering.
+	double m_AccumMs;//Milliseconds spent in final accumulation.
+	double m_PeakRssMb;//Peak resident memory of the whole process so far, in megabytes. This is the maximum over this flame and every flame rendered before it, not a value for this flame alone.
+};
+
+/// <summary>
+/// The core of the EmberBench.exe program.
+/// Template argument expected to be float or double.
+/// </summary>
+/// <param name="opt">A populated EmberOptions object which specifies all program options to be used</param>
+/// <returns>True if success and no regressions were found, else false.</returns>
+template <typename T, typename bucketT>
+static bool EmberBench(EmberOptions& opt);
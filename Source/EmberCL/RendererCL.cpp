@@ -376,6 +376,27 @@ void RendererCL<T>::NumChannels(size_t numChannels)
 	m_NumChannels = 4;
 }
 
+/// <summary>
+/// Override to force palette bins to be 0 because the OpenCL iteration kernel
+/// always looks up colors in the palette while iterating.
+/// </summary>
+/// <param name="paletteBins">The number of palette bins, ignored.</param>
+template <typename T>
+void RendererCL<T>::PaletteBins(size_t paletteBins)
+{
+	m_PaletteBins = 0;
+}
+
+/// <summary>
+/// Override to force NUMA awareness off because the histogram lives on the device.
+/// </summary>
+/// <param name="numaAware">Whether to be NUMA aware, ignored.</param>
+template <typename T>
+void RendererCL<T>::NumaAware(bool numaAware)
+{
+	m_NumaAware = false;
+}
+
 /// <summary>
 /// Dump the error report for this class as well as the OpenCLWrapper member.
 /// </summary>
@@ -721,6 +742,7 @@ EmberStats RendererCL<T>::Iterate(size_t iterCount, size_t temporalSample)
 			m_Abort = true;
 
 		stats.m_IterMs = m_IterTimer.Toc();
+		stats.m_IterCpuMs = m_IterTimer.ElapsedCpuTime();
 	}
 	else
 	{
@@ -731,6 +753,21 @@ EmberStats RendererCL<T>::Iterate(size_t iterCount, size_t temporalSample)
 	return stats;
 }
 
+/// <summary>
+/// Read the histogram from the device, then estimate its noise on the host.
+/// Only called periodically during adaptive iteration, so the cost of the read is acceptable.
+/// </summary>
+/// <returns>The estimated relative noise, between 0 and 1. 1 if the histogram could not be read.</returns>
+template <typename T>
+double RendererCL<T>::EstimateNoise()
+{
+	if (ReadHist())
+		return Renderer<T, T>::EstimateNoise();
+
+	m_ErrorReport.push_back(__FUNCTION__);
+	return 1;
+}
+
 /// <summary>
 /// Private functions for making and running OpenCL programs.
 /// </summary>
@@ -56,6 +56,8 @@ using EmberNs::Renderer<T, T>::RendererBase::m_YAxisUp;
 using EmberNs::Renderer<T, T>::RendererBase::m_LockAccum;
 using EmberNs::Renderer<T, T>::RendererBase::m_Abort;
 using EmberNs::Renderer<T, T>::RendererBase::m_NumChannels;
+using EmberNs::Renderer<T, T>::RendererBase::m_PaletteBins;
+using EmberNs::Renderer<T, T>::RendererBase::m_NumaAware;
 using EmberNs::Renderer<T, T>::RendererBase::m_LastIter;
 using EmberNs::Renderer<T, T>::RendererBase::m_LastIterPercent;
 using EmberNs::Renderer<T, T>::RendererBase::m_Stats;
@@ -134,6 +136,8 @@ public:
 	virtual size_t MemoryAvailable() override;
 	virtual bool Ok() const override;
 	virtual void NumChannels(size_t numChannels) override;
+	virtual void PaletteBins(size_t paletteBins) override;
+	virtual void NumaAware(bool numaAware) override;
 	virtual void DumpErrorReport() override;
 	virtual void ClearErrorReport() override;
 	virtual size_t SubBatchSize() const override;
@@ -156,6 +160,7 @@ protected:
 	virtual eRenderStatus GaussianDensityFilter() override;
 	virtual eRenderStatus AccumulatorToFinalImage(byte* pixels, size_t finalOffset) override;
 	virtual EmberStats Iterate(size_t iterCount, size_t temporalSample) override;
+	virtual double EstimateNoise() override;
 
 #ifndef TEST_CL
 private:
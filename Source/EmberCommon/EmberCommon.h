@@ -74,8 +74,8 @@ private:
 };
 
 /// <summary>
-/// Wrapper for parsing an ember Xml file, storing the embers in a vector and printing
-/// any errors that occurred.
+/// Wrapper for parsing an ember Xml file, or a binary one written by EmberToBinary,
+/// storing the embers in a vector and printing any errors that occurred.
 /// Template argument expected to be float or double.
 /// </summary>
 /// <param name="parser">The parser to use</param>
@@ -85,7 +85,18 @@ private:
 template <typename T>
 static bool ParseEmberFile(XmlToEmber<T>& parser, string filename, vector<Ember<T>>& embers)
 {
-	if (!parser.Parse(filename.c_str(), embers))
+	if (BinaryToEmber<T>::IsBinaryFile(filename))
+	{
+		BinaryToEmber<T> reader;
+
+		if (!reader.Load(filename, embers))
+		{
+			cout << "Error reading binary flame file " << filename << ", returning without executing." << endl;
+			reader.DumpErrorReport();
+			return false;
+		}
+	}
+	else if (!parser.ParseParallel(filename.c_str(), embers))
 	{
 		cout << "Error parsing flame file " << filename << ", returning without executing." << endl;
 		return false;
@@ -100,6 +111,140 @@ static bool ParseEmberFile(XmlToEmber<T>& parser, string filename, vector<Ember<
 	return true;
 }
 
+#define EMBER_STREAM_MIN_BYTES (size_t(32) * 1024 * 1024)//Files smaller than this are parsed faster all at once with ParseEmberFile() than streamed.
+
+/// <summary>
+/// Parses an ember Xml file on a background thread with XmlToEmber::ParseStream(), handing out
+/// the embers in order as soon as each one is available. This lets a program start rendering
+/// the first ember while the rest of a large file is still being parsed.
+/// Only a limited number of parsed embers are queued, and parsing pauses whenever the queue is
+/// full, so memory use stays bounded no matter how large the file is.
+/// The parser must not be used by anything else until Finish() has been called, and must outlive
+/// the stream, since the destructor calls Finish() to wait for the parsing thread.
+/// Embers which were already parsed some other way can be handed out through the same interface,
+/// so a program can choose per file whether streaming is worth it.
+/// Template argument expected to be float or double.
+/// </summary>
+template <typename T>
+class EmberStream
+{
+public:
+	/// <summary>
+	/// Constructor which sets the size of the queue.
+	/// </summary>
+	/// <param name="maxQueued">The maximum number of parsed embers to hold before parsing pauses. Default: 8.</param>
+	EmberStream(size_t maxQueued = 8)
+		: m_MaxQueued(std::max<size_t>(maxQueued, 1)), m_Done(false), m_Stop(false), m_Success(false)
+	{
+	}
+
+	/// <summary>
+	/// Destructor which stops parsing if it's still running.
+	/// </summary>
+	~EmberStream()
+	{
+		Finish();
+	}
+
+	/// <summary>
+	/// Begin parsing a file on a background thread.
+	/// </summary>
+	/// <param name="parser">The parser to use</param>
+	/// <param name="filename">The full path and name of the file</param>
+	void Start(XmlToEmber<T>& parser, const string& filename)
+	{
+		Finish();
+		m_Queue.clear();
+		m_Done = m_Stop = m_Success = false;
+		m_Thread = std::thread([&parser, filename, this]()
+		{
+			bool success = parser.ParseStream(filename.c_str(), [&](Ember<T>& ember) -> bool
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_CanPush.wait(lock, [&] { return m_Stop || m_Queue.size() < m_MaxQueued; });
+
+				if (m_Stop)
+					return false;
+
+				m_Queue.push_back(std::move(ember));
+				m_CanPop.notify_one();
+				return true;
+			});
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Success = success;
+			m_Done = true;
+			m_CanPop.notify_all();
+		});
+	}
+
+	/// <summary>
+	/// Hand out embers which have already been parsed, rather than parsing a file.
+	/// </summary>
+	/// <param name="embers">The embers, which are moved from</param>
+	void Start(vector<Ember<T>>& embers)
+	{
+		Finish();
+		m_Queue.assign(std::make_move_iterator(embers.begin()), std::make_move_iterator(embers.end()));
+		embers.clear();
+		m_Stop = false;
+		m_Done = m_Success = true;
+	}
+
+	/// <summary>
+	/// Get the next ember in the file, waiting for it to be parsed if needed.
+	/// </summary>
+	/// <param name="ember">Storage for the ember</param>
+	/// <returns>True if an ember was returned, else false if there are no more.</returns>
+	bool Next(Ember<T>& ember)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_CanPop.wait(lock, [&] { return m_Done || !m_Queue.empty(); });
+
+		if (m_Queue.empty())
+			return false;
+
+		ember = std::move(m_Queue.front());
+		m_Queue.pop_front();
+		m_CanPush.notify_one();
+		return true;
+	}
+
+	/// <summary>
+	/// Stop parsing if it's still running, discard any embers not yet taken
+	/// and wait for the background thread to exit.
+	/// </summary>
+	/// <returns>True if the file was parsed without errors, else false.</returns>
+	bool Finish()
+	{
+		if (m_Thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Stop = true;
+				m_CanPush.notify_all();
+			}
+
+			m_Thread.join();
+		}
+
+		return m_Success;
+	}
+
+private:
+	size_t m_MaxQueued;
+	bool m_Done;//Parsing has finished, either because the end of the file was reached, an error occurred or it was stopped.
+	bool m_Stop;
+	bool m_Success;
+	deque<Ember<T>> m_Queue;//Guarded by m_Mutex.
+	std::mutex m_Mutex;
+	std::condition_variable m_CanPush;//Signaled when an ember is taken from the queue or parsing is stopped.
+	std::condition_variable m_CanPop;//Signaled when an ember is added to the queue or parsing has finished.
+	std::thread m_Thread;
+};
+
 /// <summary>
 /// Wrapper for parsing palette Xml file and initializing it's private static members,
 /// and printing any errors that occurred.
@@ -124,6 +269,24 @@ static bool InitPaletteList(const string& filename)
 	return true;
 }
 
+/// <summary>
+/// Convert an RGBA buffer to an RGB buffer which has already been allocated.
+/// The two buffers can point to the same memory location if needed.
+/// </summary>
+/// <param name="rgba">The RGBA buffer</param>
+/// <param name="rgb">The RGB buffer, which must hold at least width * height * 3 bytes.</param>
+/// <param name="width">The width of the image in pixels</param>
+/// <param name="height">The height of the image in pixels</param>
+static void RgbaToRgb(const byte* rgba, byte* rgb, size_t width, size_t height)
+{
+	for (size_t i = 0, j = 0; i < (width * height * 4); i += 4, j += 3)
+	{
+		rgb[j]	   = rgba[i];
+		rgb[j + 1] = rgba[i + 1];
+		rgb[j + 2] = rgba[i + 2];
+	}
+}
+
 /// <summary>
 /// Convert an RGBA buffer to an RGB buffer.
 /// The two buffers can point to the same memory location if needed.
@@ -137,12 +300,7 @@ static void RgbaToRgb(vector<byte>& rgba, vector<byte>& rgb, size_t width, size_
 	if (rgba.data() != rgb.data())//Only resize the destination buffer if they are different.
 		rgb.resize(width * height * 3);
 
-	for (uint i = 0, j = 0; i < (width * height * 4); i += 4, j += 3)
-	{
-		rgb[j]	   = rgba[i];
-		rgb[j + 1] = rgba[i + 1];
-		rgb[j + 2] = rgba[i + 2];
-	}
+	RgbaToRgb(rgba.data(), rgb.data(), width, height);
 }
 
 /// <summary>
@@ -278,15 +436,317 @@ static Renderer<T, bucketT>* CreateRenderer(eRendererType renderType, uint platf
 	return renderer.release();
 }
 
+/// <summary>
+/// Pool of renderers which are leased out to render jobs and returned when they finish, rather than
+/// being created and destroyed for each job.
+/// Creating a renderer, and allocating and first touching its histogram, accumulator and sample buffers,
+/// can cost more than rendering a small job. Renderers in the pool keep their buffers between leases,
+/// since a renderer only gives memory back on resize when reclaim on resize is on, which Return() turns
+/// back off. So a renderer which has already rendered an image at least as large as the one requested,
+/// gutter included, reuses its buffers without reallocating. When leasing, the idle renderer with the
+/// smallest buffers which are still large enough is chosen, else the largest one, which will grow.
+/// Every option a job can set on a leased renderer is put back to its default when it's returned, so
+/// no job inherits the settings of the one before it.
+/// Warm() can be used to create renderers and allocate their buffers up front.
+/// All renderers in a pool share the same type, precision and thread count. The pool owns every renderer
+/// it creates, so it must outlive all leases. Leasing and returning are thread safe.
+/// Template arguments expected to be the same as those passed to CreateRenderer().
+/// </summary>
+template <typename T, typename bucketT>
+class RendererPool
+{
+public:
+	/// <summary>
+	/// Constructor which sets the type of renderers the pool creates.
+	/// </summary>
+	/// <param name="renderType">Type of renderer to create</param>
+	/// <param name="platform">The index platform of the platform to use</param>
+	/// <param name="device">The index device of the device to use</param>
+	/// <param name="threads">The number of threads each renderer uses, 0 for all cores. Default: 0.</param>
+	RendererPool(eRendererType renderType, uint platform, uint device, size_t threads = 0)
+	{
+		m_RenderType = renderType;
+		m_Platform = platform;
+		m_Device = device;
+		m_Threads = threads ? threads : Timing::ProcessorCount();
+	}
+
+	/// <summary>
+	/// Create renderers and allocate their buffers for a raster size by rendering a blank ember
+	/// of that size at minimal quality, then add them to the pool.
+	/// </summary>
+	/// <param name="count">The number of renderers to create</param>
+	/// <param name="width">The width of the final image</param>
+	/// <param name="height">The height of the final image</param>
+	/// <param name="supersample">The supersample value. Default: 1.</param>
+	void Warm(size_t count, size_t width, size_t height, size_t supersample = 1)
+	{
+		Ember<T> ember;
+		Xform<T> xform;
+		vector<byte> finalImage;
+
+		xform.AddVariation(new LinearVariation<T>());
+		ember.AddXform(xform);
+		ember.m_FinalRasW = width;
+		ember.m_FinalRasH = height;
+		ember.m_Supersample = supersample;
+		ember.m_TemporalSamples = 1;
+		ember.m_Quality = 1;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (Renderer<T, bucketT>* renderer = Create())
+			{
+				renderer->SetEmber(ember);
+				renderer->Run(finalImage);
+				m_Cs.Enter();
+				m_Entries.push_back(PoolEntry(renderer, renderer->SuperSize(), false));
+				m_Cs.Leave();
+			}
+		}
+	}
+
+	/// <summary>
+	/// Lease a renderer for rendering an ember.
+	/// An idle renderer is reused if there is one, else a new one is created.
+	/// The caller may change any of its properties, but must not delete it.
+	/// </summary>
+	/// <param name="ember">The ember which will be rendered, used to find a renderer whose buffers are large enough.</param>
+	/// <returns>The renderer, which must be given back with Return(). nullptr if creating a new one failed.</returns>
+	Renderer<T, bucketT>* Lease(const Ember<T>& ember)
+	{
+		Renderer<T, bucketT>* renderer = nullptr;
+		size_t needed = SuperSize(ember);
+		PoolEntry* best = nullptr;
+
+		m_Cs.Enter();
+
+		for (auto& entry : m_Entries)
+		{
+			if (entry.m_Leased)
+				continue;
+
+			if (!best)
+				best = &entry;
+			else if (entry.m_SuperSize >= needed)
+			{
+				if (best->m_SuperSize < needed || entry.m_SuperSize < best->m_SuperSize)
+					best = &entry;
+			}
+			else if (best->m_SuperSize < needed && entry.m_SuperSize > best->m_SuperSize)
+				best = &entry;
+		}
+
+		if (best)
+		{
+			best->m_Leased = true;
+			renderer = best->m_Renderer.get();
+		}
+
+		m_Cs.Leave();
+
+		if (!renderer && (renderer = Create()))
+		{
+			m_Cs.Enter();
+			m_Entries.push_back(PoolEntry(renderer, 0, true));
+			m_Cs.Leave();
+		}
+
+		return renderer;
+	}
+
+	/// <summary>
+	/// Give a leased renderer back to the pool so it can be leased again.
+	/// Every option the job may have set is reset to its default, and the callback is cleared
+	/// since it likely refers to an object owned by the job which leased it.
+	/// </summary>
+	/// <param name="renderer">The renderer to return, which must not be rendering. Ignored if nullptr or not from this pool.</param>
+	void Return(Renderer<T, bucketT>* renderer)
+	{
+		if (!renderer)
+			return;
+
+		ResetOptions(renderer);
+		m_Cs.Enter();
+
+		for (auto& entry : m_Entries)
+		{
+			if (entry.m_Renderer.get() == renderer)
+			{
+				entry.m_SuperSize = std::max(entry.m_SuperSize, renderer->SuperSize());//Buffers only grow, so keep the largest size allocated.
+				entry.m_Leased = false;
+				break;
+			}
+		}
+
+		m_Cs.Leave();
+	}
+
+	/// <summary>
+	/// Delete all idle renderers, freeing their buffers.
+	/// Leased renderers are not affected.
+	/// </summary>
+	void Clear()
+	{
+		m_Cs.Enter();
+		m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), [&](const PoolEntry& entry) { return !entry.m_Leased; }), m_Entries.end());
+		m_Cs.Leave();
+	}
+
+	/// <summary>
+	/// Get the number of renderers currently leased.
+	/// </summary>
+	/// <returns>The number of leased renderers</returns>
+	size_t LeasedCount()
+	{
+		m_Cs.Enter();
+		size_t count = std::count_if(m_Entries.begin(), m_Entries.end(), [&](const PoolEntry& entry) { return entry.m_Leased; });
+		m_Cs.Leave();
+		return count;
+	}
+
+	/// <summary>
+	/// Get the total number of renderers in the pool, both idle and leased.
+	/// </summary>
+	/// <returns>The number of renderers</returns>
+	size_t Size()
+	{
+		m_Cs.Enter();
+		size_t size = m_Entries.size();
+		m_Cs.Leave();
+		return size;
+	}
+
+	EmberReport& ErrorReport() { return m_ErrorReport; }
+
+private:
+	/// <summary>
+	/// A renderer owned by the pool, along with the largest super raster size it has allocated
+	/// buffers for and whether it's currently leased.
+	/// </summary>
+	struct PoolEntry
+	{
+		PoolEntry(Renderer<T, bucketT>* renderer, size_t superSize, bool leased)
+			: m_Renderer(renderer), m_SuperSize(superSize), m_Leased(leased)
+		{
+		}
+
+		PoolEntry(PoolEntry&& entry)
+			: m_Renderer(std::move(entry.m_Renderer)), m_SuperSize(entry.m_SuperSize), m_Leased(entry.m_Leased)
+		{
+		}
+
+		PoolEntry& operator = (PoolEntry&& entry)
+		{
+			m_Renderer = std::move(entry.m_Renderer);
+			m_SuperSize = entry.m_SuperSize;
+			m_Leased = entry.m_Leased;
+			return *this;
+		}
+
+		unique_ptr<Renderer<T, bucketT>> m_Renderer;
+		size_t m_SuperSize;
+		bool m_Leased;
+	};
+
+	/// <summary>
+	/// Create a new renderer with the settings of the pool.
+	/// </summary>
+	/// <returns>The new renderer if successful, else nullptr.</returns>
+	Renderer<T, bucketT>* Create()
+	{
+		Renderer<T, bucketT>* renderer = CreateRenderer<T, bucketT>(m_RenderType, m_Platform, m_Device, false, 0, m_ErrorReport);
+
+		if (renderer)
+			renderer->ThreadCount(m_Threads);
+
+		return renderer;
+	}
+
+	/// <summary>
+	/// Put every option a job can set on a renderer back to the value it has in a newly created one.
+	/// The number of channels is set to 3, which OpenCL renderers force back to 4.
+	/// </summary>
+	/// <param name="renderer">The renderer to reset</param>
+	void ResetOptions(Renderer<T, bucketT>* renderer)
+	{
+		renderer->Callback(nullptr);
+		renderer->EarlyClip(false);
+		renderer->YAxisUp(false);
+		renderer->Transparency(false);
+		renderer->NumChannels(3);
+		renderer->BytesPerChannel(1);
+		renderer->LockAccum(false);
+		renderer->InsertPalette(false);
+		renderer->ReclaimOnResize(false);
+		renderer->PixelAspectRatio(T(1));
+		renderer->PaletteBins(0);
+		renderer->NumaAware(false);
+		renderer->InteractiveFilter(FILTER_LOG);
+		renderer->TargetNoise(0);
+		renderer->MaxIterScale(4);
+
+		if (renderer->ThreadCount() != m_Threads)
+			renderer->ThreadCount(m_Threads);
+	}
+
+	/// <summary>
+	/// Get the size of the super raster a renderer will need to render an ember,
+	/// including the gutter added around it for the spatial filter, the same way Renderer computes it.
+	/// </summary>
+	/// <param name="ember">The ember which will be rendered</param>
+	/// <returns>The number of super raster cells</returns>
+	static size_t SuperSize(const Ember<T>& ember)
+	{
+		size_t gutter = 0;
+		auto filter = FilterCache<T>::GetSpatialFilter(ember.m_SpatialFilterType, ember.m_SpatialFilterRadius, ember.m_Supersample, T(1));
+
+		if (filter && size_t(filter->FinalFilterWidth()) > ember.m_Supersample)
+			gutter = (size_t(filter->FinalFilterWidth()) - ember.m_Supersample) / 2;
+
+		return ((ember.m_FinalRasW * ember.m_Supersample) + (2 * gutter)) * ((ember.m_FinalRasH * ember.m_Supersample) + (2 * gutter));
+	}
+
+	eRendererType m_RenderType;
+	uint m_Platform;
+	uint m_Device;
+	size_t m_Threads;
+	vector<PoolEntry> m_Entries;//Every renderer the pool owns, idle or leased.
+	CriticalSection m_Cs;
+	EmberReport m_ErrorReport;
+};
+
+/// <summary>
+/// Render an ember in horizontal strips to reduce the memory required.
+/// By default, each strip is stored at its location within finalImage, which must be large enough to hold the entire image.
+/// If perStripRows is specified, each strip is instead rendered to the beginning of finalImage, which only needs to hold
+/// a single strip, and its rows are passed to perStripRows once it finishes. In that case the strips are rendered
+/// from the top of the output image to the bottom, which reverses their order when yAxisUp is true, so the rows
+/// can be written to a file as they arrive.
+/// The strip index passed to the callbacks is the number of strips rendered before it.
+/// </summary>
+/// <param name="renderer">The renderer to use</param>
+/// <param name="ember">The ember to render, which is restored to its original dimensions afterward</param>
+/// <param name="finalImage">The buffer to render into</param>
+/// <param name="time">The time to render at</param>
+/// <param name="strips">The number of strips to use</param>
+/// <param name="yAxisUp">True to flip the image vertically, else false.</param>
+/// <param name="perStripStart">Called before each strip is rendered</param>
+/// <param name="perStripFinish">Called after each strip is successfully rendered</param>
+/// <param name="perStripError">Called when a strip fails to render, or perStripRows returns false, after which rendering stops</param>
+/// <param name="allStripsFinished">Called once all strips have been successfully rendered</param>
+/// <param name="perStripRows">If not nullptr, called after perStripFinish with the rows of each strip and the number of them. Default: nullptr.</param>
+/// <returns>True if all strips were successfully rendered, else false.</returns>
 template <typename T>
 static bool StripsRender(RendererBase* renderer, Ember<T>& ember, vector<byte>& finalImage, double time, size_t strips, bool yAxisUp,
 	std::function<void(size_t strip)> perStripStart,
 	std::function<void(size_t strip)> perStripFinish,
 	std::function<void(size_t strip)> perStripError,
-	std::function<void(Ember<T>& finalEmber)> allStripsFinished)
+	std::function<void(Ember<T>& finalEmber)> allStripsFinished,
+	std::function<bool(const byte* rows, size_t rowCount)> perStripRows = nullptr)
 {
 	bool success = false;
-	size_t origHeight, realHeight = ember.m_FinalRasH;
+	size_t origHeight, stripHeight, realHeight = ember.m_FinalRasH;
 	T centerY = ember.m_CenterY;
 	T floatStripH = T(ember.m_FinalRasH) / T(strips);
 	T zoomScale = pow(T(2), ember.m_Zoom);
@@ -294,16 +754,21 @@ static bool StripsRender(RendererBase* renderer, Ember<T>& ember, vector<byte>&
 	vector<QTIsaac<ISAAC_SIZE, ISAAC_INT>> randVec;
 
 	ember.m_Quality *= strips;
-	ember.m_FinalRasH = size_t(ceil(floatStripH));
+	stripHeight = size_t(ceil(floatStripH));
 
 	if (strips > 1)
 		randVec = renderer->RandVec();
 
-	for (size_t strip = 0; strip < strips; strip++)
+	for (size_t i = 0; i < strips; i++)
 	{
 		size_t stripOffset;
+		size_t strip = (perStripRows && yAxisUp) ? (strips - i) - 1 : i;
+
+		ember.m_FinalRasH = stripHeight;//The last strip may have been shortened.
 
-		if (yAxisUp)
+		if (perStripRows)
+			stripOffset = 0;
+		else if (yAxisUp)
 			stripOffset = ember.m_FinalRasH * ((strips - strip) - 1) * renderer->FinalRowSize();
 		else
 			stripOffset = ember.m_FinalRasH * strip * renderer->FinalRowSize();
@@ -317,7 +782,7 @@ static bool StripsRender(RendererBase* renderer, Ember<T>& ember, vector<byte>&
 			ember.m_CenterY -= (origHeight - ember.m_FinalRasH) * T(0.5) / (ember.m_PixelsPerUnit * zoomScale);
 		}
 
-		perStripStart(strip);
+		perStripStart(i);
 
 		if (strips > 1)
 		{
@@ -327,15 +792,21 @@ static bool StripsRender(RendererBase* renderer, Ember<T>& ember, vector<byte>&
 
 		if ((renderer->Run(finalImage, time, 0, false, stripOffset) == RENDER_OK) && !renderer->Aborted() && !finalImage.empty())
 		{
-			perStripFinish(strip);
+			perStripFinish(i);
 		}
 		else
 		{
-			perStripError(strip);
+			perStripError(i);
 			break;
 		}
 
-		if (strip == strips - 1)
+		if (perStripRows && !perStripRows(finalImage.data(), ember.m_FinalRasH))
+		{
+			perStripError(i);
+			break;
+		}
+
+		if (i == strips - 1)
 			success = true;
 	}
 
@@ -384,6 +855,120 @@ static size_t VerifyStrips(size_t height, size_t strips,
 	return strips;
 }
 
+/// <summary>
+/// Collects the stats of each image written by a command line program and saves them
+/// to a file as a JSON array with one object per image, for use by external tools.
+/// Each object holds the counters, and an object per stage with its elapsed and CPU time
+/// in milliseconds. See EmberStats for what each stage covers.
+/// </summary>
+class StatsJson
+{
+public:
+	/// <summary>
+	/// Add the stats of an image.
+	/// </summary>
+	/// <param name="name">The name of the image, usually its filename</param>
+	/// <param name="index">The index of the image, such as the ember index or frame time</param>
+	/// <param name="stats">The stats to add</param>
+	void Add(const string& name, size_t index, const EmberStats& stats)
+	{
+		ostringstream os;
+
+		os.imbue(std::locale::classic());
+		os << std::fixed << std::setprecision(3)
+		   << "\t{\n"
+		   << "\t\t\"name\": \"" << Escape(name) << "\",\n"
+		   << "\t\t\"index\": " << index << ",\n"
+		   << "\t\t\"iters\": " << stats.m_Iters << ",\n"
+		   << "\t\t\"badvals\": " << stats.m_Badvals << ",\n"
+		   << "\t\t\"iters_saved\": " << stats.m_ItersSaved << ",\n"
+		   << "\t\t\"noise\": " << std::setprecision(6) << stats.m_Noise << std::setprecision(3) << ",\n"
+		   << "\t\t\"alloc_bytes\": " << stats.m_AllocBytes << ",\n"
+		   << "\t\t\"buffer_bytes\": " << stats.m_BufferBytes << ",\n"
+		   << "\t\t\"stages\":\n"
+		   << "\t\t{\n"
+		   << Stage("interp", stats.m_InterpMs, stats.m_InterpCpuMs) << ",\n"
+		   << Stage("alloc", stats.m_AllocMs, stats.m_AllocCpuMs) << ",\n"
+		   << Stage("iter", stats.m_IterMs, stats.m_IterCpuMs) << ",\n"
+		   << "\t\t\t\"hist\": { \"ms\": " << stats.m_HistMs << " },\n"
+		   << Stage("filter", stats.m_FilterMs, stats.m_FilterCpuMs) << ",\n"
+		   << Stage("accum", stats.m_AccumMs, stats.m_AccumCpuMs) << ",\n"
+		   << Stage("encode", stats.m_EncodeMs, stats.m_EncodeCpuMs) << ",\n"
+		   << Stage("write", stats.m_WriteMs, stats.m_WriteCpuMs) << ",\n"
+		   << Stage("render", stats.m_RenderMs, stats.m_RenderCpuMs) << "\n"
+		   << "\t\t}\n"
+		   << "\t}";
+		m_Cs.Enter();
+		m_Entries.push_back(os.str());
+		m_Cs.Leave();
+	}
+
+	/// <summary>
+	/// Write all stats added so far to a file, replacing its contents.
+	/// </summary>
+	/// <param name="filename">The full path and name of the file</param>
+	/// <returns>True if success, else false.</returns>
+	bool Save(const string& filename)
+	{
+		ofstream f(filename.c_str());
+
+		if (!f.is_open())
+			return false;
+
+		m_Cs.Enter();
+		f << "[\n";
+
+		for (size_t i = 0; i < m_Entries.size(); i++)
+			f << m_Entries[i] << (i + 1 < m_Entries.size() ? ",\n" : "\n");
+
+		f << "]\n";
+		m_Cs.Leave();
+		return f.good();
+	}
+
+private:
+	/// <summary>
+	/// Format a stage as a JSON member.
+	/// </summary>
+	/// <param name="name">The name of the stage</param>
+	/// <param name="ms">The elapsed time of the stage</param>
+	/// <param name="cpuMs">The CPU time of the stage</param>
+	/// <returns>The formatted member</returns>
+	static string Stage(const char* name, double ms, double cpuMs)
+	{
+		ostringstream os;
+
+		os.imbue(std::locale::classic());
+		os << std::fixed << std::setprecision(3) << "\t\t\t\"" << name << "\": { \"ms\": " << ms << ", \"cpu_ms\": " << cpuMs << " }";
+		return os.str();
+	}
+
+	/// <summary>
+	/// Escape quotes, backslashes and control characters so a string can be placed in a JSON string.
+	/// </summary>
+	/// <param name="str">The string to escape</param>
+	/// <returns>The escaped string</returns>
+	static string Escape(const string& str)
+	{
+		ostringstream os;
+
+		for (auto c : str)
+		{
+			if (c == '"' || c == '\\')
+				os << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				os << "\\u" << std::hex << setfill('0') << setw(4) << int(c) << std::dec;
+			else
+				os << c;
+		}
+
+		return os.str();
+	}
+
+	vector<string> m_Entries;//One formatted object per image.
+	CriticalSection m_Cs;//Images may be written on a separate thread.
+};
+
 /// <summary>
 /// Simple macro to print a string if the --verbose options has been specified.
 /// </summary>
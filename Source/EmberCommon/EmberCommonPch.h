@@ -15,9 +15,11 @@
 #include <BaseTsd.h>
 #include <crtdbg.h>
 #include <tchar.h>
+#include <psapi.h>//For GetProcessMemoryInfo().
 #define snprintf _snprintf
 #else
 #include <arpa/inet.h>
+#include <sys/resource.h>//For getrusage().
 #define _TCHAR char
 #define _tmain main
 #define _T
@@ -41,11 +43,13 @@
 
 #include "png.h"
 //#include "pnginfo.h"
+#include "zlib.h"//For compressing png image data in parallel.
 
 //Ember.
 #include "Ember.h"
 #include "Variation.h"
 #include "EmberToXml.h"
+#include "EmberBinary.h"
 #include "XmlToEmber.h"
 #include "PaletteList.h"
 #include "Iterator.h"
@@ -17,9 +17,12 @@ enum eOptionUse
 	OPT_USE_RENDER  = 1,
 	OPT_USE_ANIMATE = 1 << 1,
 	OPT_USE_GENOME  = 1 << 2,
+	OPT_USE_BENCH   = 1 << 3,
 	OPT_RENDER_ANIM = OPT_USE_RENDER  | OPT_USE_ANIMATE,
 	OPT_ANIM_GENOME = OPT_USE_ANIMATE | OPT_USE_GENOME,
-	OPT_USE_ALL     = OPT_USE_RENDER  | OPT_USE_ANIMATE | OPT_USE_GENOME
+	OPT_RENDER_ANIM_BENCH = OPT_RENDER_ANIM | OPT_USE_BENCH,
+	OPT_USE_ALL     = OPT_USE_RENDER  | OPT_USE_ANIMATE | OPT_USE_GENOME,
+	OPT_ALL_BENCH   = OPT_USE_ALL     | OPT_USE_BENCH
 };
 
 /// <summary>
@@ -54,6 +57,8 @@ enum eOptionIDs
 	OPT_UNSMOOTH_EDGE,
 	OPT_LOCK_ACCUM,
 	OPT_DUMP_KERNEL,
+	OPT_NUMA,
+	OPT_SAVE_BASELINE,
 
 	//Value args.
 	OPT_OPENCL_PLATFORM,//Int value args.
@@ -65,8 +70,10 @@ enum eOptionIDs
 	OPT_BITS,
 	OPT_BPC,
 	OPT_SBS,
+	OPT_HUGE_PAGES,
 	OPT_PRINT_EDIT_DEPTH,
 	OPT_JPEG,
+	OPT_PNG_COMPRESSION,
 	OPT_BEGIN,
 	OPT_END,
 	OPT_FRAME,
@@ -80,6 +87,7 @@ enum eOptionIDs
 	OPT_REPEAT,
 	OPT_TRIES,
 	OPT_MAX_XFORMS,
+	OPT_RUNS,
 
 	OPT_SS,//Float value args.
 	OPT_QS,
@@ -92,6 +100,9 @@ enum eOptionIDs
 	OPT_OFFSETX,
 	OPT_OFFSETY,
 	OPT_USEMEM,
+	OPT_NOISE,
+	OPT_MAX_ITER_SCALE,
+	OPT_THRESHOLD,
 
 	OPT_ISAAC_SEED,//String value args.
 	OPT_IN,
@@ -104,6 +115,8 @@ enum eOptionIDs
 	OPT_ID,
 	OPT_URL,
 	OPT_NICK,
+	OPT_STATS_JSON,
+	OPT_BASELINE,
 	OPT_COMMENT,
 	OPT_TEMPLATE,
 	OPT_CLONE,
@@ -297,17 +310,17 @@ public:
 		m_StringArgs.reserve(35);
 
 		//Diagnostic bools.
-		INITBOOLOPTION(Help,           Eob(OPT_USE_ALL,     OPT_HELP,             _T("--help"),                 false,                SO_NONE,    "\t--help                   Show this screen.\n"));
-		INITBOOLOPTION(Version,        Eob(OPT_USE_ALL,     OPT_VERSION,          _T("--version"),              false,                SO_NONE,    "\t--version                Show version.\n"));
-		INITBOOLOPTION(Verbose,        Eob(OPT_USE_ALL,     OPT_VERBOSE,          _T("--verbose"),              false,                SO_NONE,    "\t--verbose                Verbose output.\n"));
+		INITBOOLOPTION(Help,           Eob(OPT_ALL_BENCH,   OPT_HELP,             _T("--help"),                 false,                SO_NONE,    "\t--help                   Show this screen.\n"));
+		INITBOOLOPTION(Version,        Eob(OPT_ALL_BENCH,   OPT_VERSION,          _T("--version"),              false,                SO_NONE,    "\t--version                Show version.\n"));
+		INITBOOLOPTION(Verbose,        Eob(OPT_ALL_BENCH,   OPT_VERBOSE,          _T("--verbose"),              false,                SO_NONE,    "\t--verbose                Verbose output.\n"));
 		INITBOOLOPTION(Debug,          Eob(OPT_USE_ALL,     OPT_DEBUG,            _T("--debug"),                false,                SO_NONE,    "\t--debug                  Debug output.\n"));
-		INITBOOLOPTION(DumpArgs,       Eob(OPT_USE_ALL,     OPT_DUMP_ARGS,        _T("--dumpargs"),             false,                SO_NONE,    "\t--dumpargs               Print all arguments entered from either the command line or environment variables.\n"));
+		INITBOOLOPTION(DumpArgs,       Eob(OPT_ALL_BENCH,   OPT_DUMP_ARGS,        _T("--dumpargs"),             false,                SO_NONE,    "\t--dumpargs               Print all arguments entered from either the command line or environment variables.\n"));
 		INITBOOLOPTION(DoProgress,     Eob(OPT_USE_ALL,     OPT_PROGRESS,         _T("--progress"),             false,                SO_NONE,    "\t--progress               Display progress. This will slow down processing by about 10%%.\n"));
-		INITBOOLOPTION(OpenCLInfo,     Eob(OPT_USE_ALL,     OPT_DUMP_OPENCL_INFO, _T("--openclinfo"),           false,                SO_NONE,    "\t--openclinfo             Display platforms and devices for OpenCL.\n"));
+		INITBOOLOPTION(OpenCLInfo,     Eob(OPT_ALL_BENCH,   OPT_DUMP_OPENCL_INFO, _T("--openclinfo"),           false,                SO_NONE,    "\t--openclinfo             Display platforms and devices for OpenCL.\n"));
 
 		//Execution bools.
-		INITBOOLOPTION(EmberCL,        Eob(OPT_USE_ALL,     OPT_OPENCL,           _T("--opencl"),               false,                SO_NONE,    "\t--opencl                 Use OpenCL renderer (EmberCL) for rendering [default: false].\n"));
-		INITBOOLOPTION(EarlyClip,      Eob(OPT_USE_ALL,     OPT_EARLYCLIP,        _T("--earlyclip"),            false,                SO_NONE,    "\t--earlyclip              Perform clipping of RGB values before spatial filtering for better antialiasing and resizing [default: false].\n"));
+		INITBOOLOPTION(EmberCL,        Eob(OPT_ALL_BENCH,   OPT_OPENCL,           _T("--opencl"),               false,                SO_NONE,    "\t--opencl                 Use OpenCL renderer (EmberCL) for rendering [default: false].\n"));
+		INITBOOLOPTION(EarlyClip,      Eob(OPT_ALL_BENCH,   OPT_EARLYCLIP,        _T("--earlyclip"),            false,                SO_NONE,    "\t--earlyclip              Perform clipping of RGB values before spatial filtering for better antialiasing and resizing [default: false].\n"));
 		INITBOOLOPTION(YAxisUp,        Eob(OPT_USE_ALL,     OPT_POS_Y_UP,         _T("--yaxisup"),              false,                SO_NONE,    "\t--yaxisup                Orient the image with the positive y axis pointing up [default: false].\n"));
 		INITBOOLOPTION(Transparency,   Eob(OPT_USE_ALL,     OPT_TRANSPARENCY,     _T("--transparency"),         false,                SO_NONE,    "\t--transparency           Include alpha channel in final output [default: false except for PNG].\n"));
 		INITBOOLOPTION(NameEnable,     Eob(OPT_USE_RENDER,  OPT_NAME_ENABLE,      _T("--name_enable"),          false,                SO_NONE,    "\t--name_enable            Use the name attribute contained in the xml as the output filename [default: false].\n"));
@@ -321,28 +334,32 @@ public:
 		INITBOOLOPTION(Enclosed,	   Eob(OPT_USE_GENOME,  OPT_ENCLOSED,		  _T("--enclosed"),				true,				  SO_OPT,	  "\t--enclosed               Use enclosing XML tags [default: true].\n"));
 		INITBOOLOPTION(NoEdits,        Eob(OPT_USE_GENOME,  OPT_NO_EDITS,         _T("--noedits"),              false,                SO_NONE,    "\t--noedits                Exclude edit tags when writing Xml [default: false].\n"));
 		INITBOOLOPTION(UnsmoothEdge,   Eob(OPT_USE_GENOME,  OPT_UNSMOOTH_EDGE,    _T("--unsmoother"),           false,                SO_NONE,    "\t--unsmoother             Do not use smooth blending for sheep edges [default: false].\n"));
-		INITBOOLOPTION(LockAccum,	   Eob(OPT_USE_ALL,		OPT_LOCK_ACCUM,       _T("--lock_accum"),           false,                SO_NONE,    "\t--lock_accum             Lock threads when accumulating to the histogram using the CPU. This will drop performance to that of single threading [default: false].\n"));
+		INITBOOLOPTION(LockAccum,	   Eob(OPT_ALL_BENCH,	OPT_LOCK_ACCUM,       _T("--lock_accum"),           false,                SO_NONE,    "\t--lock_accum             Lock threads when accumulating to the histogram using the CPU. This will drop performance to that of single threading [default: false].\n"));
 		INITBOOLOPTION(DumpKernel,	   Eob(OPT_USE_RENDER,	OPT_DUMP_KERNEL,      _T("--dump_kernel"),          false,                SO_NONE,    "\t--dump_kernel            Print the iteration kernel string when using OpenCL (ignored for CPU) [default: false].\n"));
+		INITBOOLOPTION(Numa,		   Eob(OPT_RENDER_ANIM_BENCH, OPT_NUMA,             _T("--numa"),                 false,                SO_NONE,    "\t--numa                   Keep a histogram per NUMA node and pin threads to nodes when using the CPU (ignored for OpenCL) [default: false].\n"));
+		INITBOOLOPTION(SaveBaseline,   Eob(OPT_USE_BENCH,   OPT_SAVE_BASELINE,    _T("--save_baseline"),        false,                SO_NONE,    "\t--save_baseline          Write the results to the file specified by --baseline instead of comparing against it [default: false].\n"));
 
 		//Int.
 		INITINTOPTION(Symmetry,        Eoi(OPT_USE_GENOME,  OPT_SYMMETRY,         _T("--symmetry"),             0,                    SO_REQ_SEP, "\t--symmetry=<val>         Set symmetry of result [default: 0].\n"));
 		INITINTOPTION(SheepGen,        Eoi(OPT_USE_GENOME,  OPT_SHEEP_GEN,        _T("--sheep_gen"),            -1,                   SO_REQ_SEP, "\t--sheep_gen=<val>        Sheep generation of this flame [default: -1].\n"));
 		INITINTOPTION(SheepId,         Eoi(OPT_USE_GENOME,  OPT_SHEEP_ID,         _T("--sheep_id"),             -1,                   SO_REQ_SEP, "\t--sheep_id=<val>         Sheep ID of this flame [default: -1].\n"));
-		INITUINTOPTION(Platform,       Eou(OPT_USE_ALL,     OPT_OPENCL_PLATFORM,  _T("--platform"),             0,                    SO_REQ_SEP, "\t--platform               The OpenCL platform index to use [default: 0].\n"));
-		INITUINTOPTION(Device,         Eou(OPT_USE_ALL,     OPT_OPENCL_DEVICE,    _T("--device"),               0,                    SO_REQ_SEP, "\t--device                 The OpenCL device index within the specified platform to use [default: 0].\n"));
+		INITUINTOPTION(Platform,       Eou(OPT_ALL_BENCH,   OPT_OPENCL_PLATFORM,  _T("--platform"),             0,                    SO_REQ_SEP, "\t--platform               The OpenCL platform index to use [default: 0].\n"));
+		INITUINTOPTION(Device,         Eou(OPT_ALL_BENCH,   OPT_OPENCL_DEVICE,    _T("--device"),               0,                    SO_REQ_SEP, "\t--device                 The OpenCL device index within the specified platform to use [default: 0].\n"));
 		INITUINTOPTION(Seed,           Eou(OPT_USE_ALL,     OPT_SEED,             _T("--seed"),                 0,                    SO_REQ_SEP, "\t--seed=<val>             Integer seed to use for the random number generator [default: random].\n"));
-		INITUINTOPTION(ThreadCount,    Eou(OPT_USE_ALL,     OPT_NTHREADS,         _T("--nthreads"),             0,                    SO_REQ_SEP, "\t--nthreads=<val>         The number of threads to use [default: use all available cores].\n"));
+		INITUINTOPTION(ThreadCount,    Eou(OPT_ALL_BENCH,   OPT_NTHREADS,         _T("--nthreads"),             0,                    SO_REQ_SEP, "\t--nthreads=<val>         The number of threads to use [default: use all available cores].\n"));
 		INITUINTOPTION(Strips,		   Eou(OPT_USE_RENDER,  OPT_STRIPS,           _T("--nstrips"),              1,                    SO_REQ_SEP, "\t--nstrips=<val>          The number of fractions to split a single render frame into. Useful for print size renders or low memory systems [default: 1].\n"));
 		INITUINTOPTION(Supersample,    Eou(OPT_RENDER_ANIM, OPT_SUPERSAMPLE,      _T("--supersample"),          0,                    SO_REQ_SEP, "\t--supersample=<val>      The supersample value used to override the one specified in the file [default: 0 (use value from file)].\n"));
 		INITUINTOPTION(BitsPerChannel, Eou(OPT_RENDER_ANIM, OPT_BPC,              _T("--bpc"),                  8,                    SO_REQ_SEP, "\t--bpc=<val>              Bits per channel. 8 or 16 for PNG, 8 for all others [default: 8].\n"));
-		INITUINTOPTION(SubBatchSize,   Eou(OPT_USE_ALL,		OPT_SBS,			  _T("--sub_batch_size"),		DEFAULT_SBS,		  SO_REQ_SEP, "\t--sub_batch_size=<val>   The chunk size that iterating will be broken into [default: 10k].\n"));
-		INITUINTOPTION(Bits,           Eou(OPT_USE_ALL,     OPT_BITS,             _T("--bits"),                 33,                   SO_REQ_SEP, "\t--bits=<val>             Determines the types used for the histogram and accumulator [default: 33].\n"
+		INITUINTOPTION(SubBatchSize,   Eou(OPT_ALL_BENCH,	OPT_SBS,			  _T("--sub_batch_size"),		DEFAULT_SBS,		  SO_REQ_SEP, "\t--sub_batch_size=<val>   The chunk size that iterating will be broken into [default: 10k].\n"));
+		INITUINTOPTION(HugePages,      Eou(OPT_RENDER_ANIM_BENCH, OPT_HUGE_PAGES,       _T("--hugepages"),            1,                    SO_REQ_SEP, "\t--hugepages=<val>        Huge page policy for the histogram and accumulator when using the CPU. 0: none, 1: transparent, 2: explicit, falling back to transparent [default: 1].\n"));
+		INITUINTOPTION(Bits,           Eou(OPT_ALL_BENCH,   OPT_BITS,             _T("--bits"),                 33,                   SO_REQ_SEP, "\t--bits=<val>             Determines the types used for the histogram and accumulator [default: 33].\n"
 																																							  "\t\t\t\t\t32:  Histogram: float, Accumulator: float.\n"
 																																							  "\t\t\t\t\t33:  Histogram: float, Accumulator: float.\n"//This differs from the original which used an int hist for bits 33.
 																																							  "\t\t\t\t\t64:  Histogram: double, Accumulator: double.\n"));
 
 		INITUINTOPTION(PrintEditDepth, Eou(OPT_USE_ALL,     OPT_PRINT_EDIT_DEPTH, _T("--print_edit_depth"),     0,                    SO_REQ_SEP, "\t--print_edit_depth=<val> Depth to truncate <edit> tag structure when converting a flame to xml. 0 prints all <edit> tags [default: 0].\n"));
 		INITUINTOPTION(JpegQuality,    Eou(OPT_RENDER_ANIM, OPT_JPEG,             _T("--jpeg"),                 95,                   SO_REQ_SEP, "\t--jpeg=<val>             Jpeg quality 0-100 for compression [default: 95].\n"));
+		INITUINTOPTION(PngCompression, Eou(OPT_RENDER_ANIM, OPT_PNG_COMPRESSION,  _T("--png_compression"),      6,                    SO_REQ_SEP, "\t--png_compression=<val>  Png compression level 0-9. Lower values write faster but produce larger files [default: 6].\n"));
 		INITUINTOPTION(FirstFrame,     Eou(OPT_USE_ANIMATE, OPT_BEGIN,            _T("--begin"),                UINT_MAX,             SO_REQ_SEP, "\t--begin=<val>            Time of first frame to render [default: first time specified in file].\n"));
 		INITUINTOPTION(LastFrame,      Eou(OPT_USE_ANIMATE, OPT_END,              _T("--end"),	                UINT_MAX,             SO_REQ_SEP, "\t--end=<val>              Time of last frame to render [default: last time specified in the input file].\n"));
 		INITUINTOPTION(Time,           Eou(OPT_ANIM_GENOME, OPT_TIME,             _T("--time"),                 0,                    SO_REQ_SEP, "\t--time=<val>             Time of first and last frame (ie do one frame).\n"));
@@ -353,11 +370,12 @@ public:
 		INITUINTOPTION(Repeat,         Eou(OPT_USE_GENOME,  OPT_REPEAT,           _T("--repeat"),               1,                    SO_REQ_SEP, "\t--repeat=<val>           Number of new flames to create. Ignored if sequence, inter or rotate were specified [default: 1].\n"));
 		INITUINTOPTION(Tries,          Eou(OPT_USE_GENOME,  OPT_TRIES,            _T("--tries"),                10,                   SO_REQ_SEP, "\t--tries=<val>            Number times to try creating a flame that meets the specified constraints. Ignored if sequence, inter or rotate were specified [default: 10].\n"));
 		INITUINTOPTION(MaxXforms,      Eou(OPT_USE_GENOME,  OPT_MAX_XFORMS,       _T("--maxxforms"),            UINT_MAX,             SO_REQ_SEP, "\t--maxxforms=<val>        The maximum number of xforms allowed in the final output.\n"));
+		INITUINTOPTION(Runs,           Eou(OPT_USE_BENCH,   OPT_RUNS,             _T("--runs"),                 3,                    SO_REQ_SEP, "\t--runs=<val>             Number of times to render each flame, keeping the fastest run of each stage [default: 3].\n"));
 
 		//Double.
-		INITDOUBLEOPTION(SizeScale,    Eod(OPT_RENDER_ANIM, OPT_SS,               _T("--ss"),                   1,                    SO_REQ_SEP, "\t--ss=<val>               Size scale. All dimensions are scaled by this amount [default: 1.0].\n"));
-		INITDOUBLEOPTION(QualityScale, Eod(OPT_RENDER_ANIM, OPT_QS,               _T("--qs"),                   1,                    SO_REQ_SEP, "\t--qs=<val>               Quality scale. All quality values are scaled by this amount [default: 1.0].\n"));
-		INITDOUBLEOPTION(AspectRatio,  Eod(OPT_USE_ALL,     OPT_PIXEL_ASPECT,     _T("--pixel_aspect"),         1,                    SO_REQ_SEP, "\t--pixel_aspect=<val>     Aspect ratio of pixels (width over height), eg. 0.90909 for NTSC [default: 1.0].\n"));
+		INITDOUBLEOPTION(SizeScale,    Eod(OPT_RENDER_ANIM_BENCH, OPT_SS,               _T("--ss"),                   1,                    SO_REQ_SEP, "\t--ss=<val>               Size scale. All dimensions are scaled by this amount [default: 1.0].\n"));
+		INITDOUBLEOPTION(QualityScale, Eod(OPT_RENDER_ANIM_BENCH, OPT_QS,               _T("--qs"),                   1,                    SO_REQ_SEP, "\t--qs=<val>               Quality scale. All quality values are scaled by this amount [default: 1.0].\n"));
+		INITDOUBLEOPTION(AspectRatio,  Eod(OPT_ALL_BENCH,   OPT_PIXEL_ASPECT,     _T("--pixel_aspect"),         1,                    SO_REQ_SEP, "\t--pixel_aspect=<val>     Aspect ratio of pixels (width over height), eg. 0.90909 for NTSC [default: 1.0].\n"));
 		INITDOUBLEOPTION(Stagger,      Eod(OPT_USE_GENOME,  OPT_STAGGER,          _T("--stagger"),              0,                    SO_REQ_SEP, "\t--stagger=<val>          Affects simultaneity of xform interpolation during flame interpolation.\n"
 																												 											  "\t                         Represents how 'separate' the xforms are interpolated. Set to 1 for each\n"
 																												 											  "\t                         xform to be interpolated individually, fractions control interpolation overlap [default: 0].\n"));
@@ -368,19 +386,24 @@ public:
 		INITDOUBLEOPTION(OffsetX,      Eod(OPT_USE_GENOME,  OPT_OFFSETX,          _T("--offsetx"),              0.0,                  SO_REQ_SEP, "\t--offsetx=<val>          Amount to jitter each flame horizontally when applying genome tools [default: 0].\n"));
 		INITDOUBLEOPTION(OffsetY,      Eod(OPT_USE_GENOME,  OPT_OFFSETY,          _T("--offsety"),              0.0,                  SO_REQ_SEP, "\t--offsety=<val>          Amount to jitter each flame vertically when applying genome tools [default: 0].\n"));
 		INITDOUBLEOPTION(UseMem,       Eod(OPT_USE_RENDER,  OPT_USEMEM,           _T("--use_mem"),              0.0,                  SO_REQ_SEP, "\t--use_mem=<val>          Number of bytes of memory to use [default: max system memory].\n"));
+		INITDOUBLEOPTION(Noise,        Eod(OPT_RENDER_ANIM, OPT_NOISE,            _T("--noise"),                0.0,                  SO_REQ_SEP, "\t--noise=<val>            Target relative noise for adaptive iteration, eg. 0.02. Stops iterating once reached rather than using the quality [default: 0, use quality].\n"));
+		INITDOUBLEOPTION(MaxIterScale, Eod(OPT_RENDER_ANIM, OPT_MAX_ITER_SCALE,   _T("--max_iter_scale"),       4.0,                  SO_REQ_SEP, "\t--max_iter_scale=<val>   Maximum multiple of the quality based iteration count that adaptive iteration can run. Ignored if --noise is 0 [default: 4].\n"));
+		INITDOUBLEOPTION(Threshold,    Eod(OPT_USE_BENCH,   OPT_THRESHOLD,        _T("--threshold"),            10.0,                 SO_REQ_SEP, "\t--threshold=<val>        Percentage a result can be worse than its baseline before it's reported as a regression [default: 10].\n"));
 
 		//String.
-		INITSTRINGOPTION(IsaacSeed,    Eos(OPT_USE_ALL,     OPT_ISAAC_SEED,       _T("--isaac_seed"),           "",                   SO_REQ_SEP, "\t--isaac_seed=<val>       Character-based seed for the random number generator [default: random].\n"));
-		INITSTRINGOPTION(Input,        Eos(OPT_RENDER_ANIM, OPT_IN,               _T("--in"),                   "",                   SO_REQ_SEP, "\t--in=<val>               Name of the input file.\n"));
+		INITSTRINGOPTION(IsaacSeed,    Eos(OPT_ALL_BENCH,   OPT_ISAAC_SEED,       _T("--isaac_seed"),           "",                   SO_REQ_SEP, "\t--isaac_seed=<val>       Character-based seed for the random number generator [default: random].\n"));
+		INITSTRINGOPTION(Input,        Eos(OPT_RENDER_ANIM_BENCH, OPT_IN,               _T("--in"),                   "",                   SO_REQ_SEP, "\t--in=<val>               Name of the input file.\n"));
 		INITSTRINGOPTION(Out,          Eos(OPT_RENDER_ANIM, OPT_OUT,              _T("--out"),                  "",                   SO_REQ_SEP, "\t--out=<val>              Name of a single output file. Not recommended when rendering more than one image.\n"));
 		INITSTRINGOPTION(Prefix,       Eos(OPT_RENDER_ANIM, OPT_PREFIX,           _T("--prefix"),               "",                   SO_REQ_SEP, "\t--prefix=<val>           Prefix to prepend to all output files.\n"));
 		INITSTRINGOPTION(Suffix,       Eos(OPT_RENDER_ANIM, OPT_SUFFIX,           _T("--suffix"),               "",                   SO_REQ_SEP, "\t--suffix=<val>           Suffix to append to all output files.\n"));
 		INITSTRINGOPTION(Format,       Eos(OPT_RENDER_ANIM, OPT_FORMAT,           _T("--format"),               "png",                SO_REQ_SEP, "\t--format=<val>           Format of the output file. Valid values are: bmp, jpg, png, ppm [default: jpg].\n"));
-		INITSTRINGOPTION(PalettePath,  Eos(OPT_USE_ALL,     OPT_PALETTE_FILE,     _T("--flam3_palettes"),       "flam3-palettes.xml", SO_REQ_SEP, "\t--flam3_palettes=<val>   Path and name of the palette file [default: flam3-palettes.xml].\n"));
+		INITSTRINGOPTION(PalettePath,  Eos(OPT_ALL_BENCH,   OPT_PALETTE_FILE,     _T("--flam3_palettes"),       "flam3-palettes.xml", SO_REQ_SEP, "\t--flam3_palettes=<val>   Path and name of the palette file [default: flam3-palettes.xml].\n"));
 		//INITSTRINGOPTION(PaletteImage, Eos(OPT_USE_ALL,     OPT_PALETTE_IMAGE,    _T("--image"),                "",                   SO_REQ_SEP, "\t--image=<val>            Replace palette with png, jpg, or ppm image.\n"));
 		INITSTRINGOPTION(Id,           Eos(OPT_USE_ALL,     OPT_ID,               _T("--id"),                   "",                   SO_REQ_SEP, "\t--id=<val>               ID to use in <edit> tags / image comments.\n"));
 		INITSTRINGOPTION(Url,          Eos(OPT_USE_ALL,     OPT_URL,              _T("--url"),                  "",                   SO_REQ_SEP, "\t--url=<val>              URL to use in <edit> tags / image comments.\n"));
 		INITSTRINGOPTION(Nick,         Eos(OPT_USE_ALL,     OPT_NICK,             _T("--nick"),                 "",                   SO_REQ_SEP, "\t--nick=<val>             Nickname to use in <edit> tags / image comments.\n"));
+		INITSTRINGOPTION(StatsJson,    Eos(OPT_ALL_BENCH,   OPT_STATS_JSON,       _T("--stats_json"),           "",                   SO_REQ_SEP, "\t--stats_json=<val>       Write per stage timings and counters of each output image or flame to this file as a JSON array [default: none].\n"));
+		INITSTRINGOPTION(Baseline,     Eos(OPT_USE_BENCH,   OPT_BASELINE,         _T("--baseline"),             "",                   SO_REQ_SEP, "\t--baseline=<val>         Baseline file to compare the results against, or to write them to with --save_baseline [default: none].\n"));
 		INITSTRINGOPTION(Comment,      Eos(OPT_USE_GENOME,  OPT_COMMENT,          _T("--comment"),              "",                   SO_REQ_SEP, "\t--comment=<val>          Comment to use in <edit> tags.\n"));
 
 		INITSTRINGOPTION(TemplateFile, Eos(OPT_USE_GENOME,  OPT_TEMPLATE,         _T("--template"),             "",                   SO_REQ_SEP, "\t--template=<val>         Apply defaults based on this flame.\n"));
@@ -413,7 +436,7 @@ public:
 	bool Populate(int argc, _TCHAR* argv[], eOptionUse optUsage)
 	{
 		EmberOptions options;
-		vector<CSimpleOpt::SOption> sOptions = options.GetSimpleOptions();
+		vector<CSimpleOpt::SOption> sOptions = options.GetSimpleOptions(OPT_ALL_BENCH);//Recognize the options of every program, regardless of which one this is.
 		CSimpleOpt args(argc, argv, sOptions.data());
 
 		//Process args.
@@ -457,6 +480,8 @@ public:
 					PARSEBOOLOPTION(OPT_UNSMOOTH_EDGE, UnsmoothEdge);
 					PARSEBOOLOPTION(OPT_LOCK_ACCUM, LockAccum);
 					PARSEBOOLOPTION(OPT_DUMP_KERNEL, DumpKernel);
+					PARSEBOOLOPTION(OPT_NUMA, Numa);
+					PARSEBOOLOPTION(OPT_SAVE_BASELINE, SaveBaseline);
 
 					PARSEINTOPTION(OPT_SYMMETRY, Symmetry);//Int args
 					PARSEINTOPTION(OPT_SHEEP_GEN, SheepGen);
@@ -470,8 +495,10 @@ public:
 					PARSEUINTOPTION(OPT_BITS, Bits);
 					PARSEUINTOPTION(OPT_BPC, BitsPerChannel);
 					PARSEUINTOPTION(OPT_SBS, SubBatchSize);
+					PARSEUINTOPTION(OPT_HUGE_PAGES, HugePages);
 					PARSEUINTOPTION(OPT_PRINT_EDIT_DEPTH, PrintEditDepth);
 					PARSEUINTOPTION(OPT_JPEG, JpegQuality);
+					PARSEUINTOPTION(OPT_PNG_COMPRESSION, PngCompression);
 					PARSEUINTOPTION(OPT_BEGIN, FirstFrame);
 					PARSEUINTOPTION(OPT_END, LastFrame);
 					PARSEUINTOPTION(OPT_FRAME, Frame);
@@ -482,6 +509,7 @@ public:
 					PARSEUINTOPTION(OPT_REPEAT, Repeat);
 					PARSEUINTOPTION(OPT_TRIES, Tries);
 					PARSEUINTOPTION(OPT_MAX_XFORMS, MaxXforms);
+					PARSEUINTOPTION(OPT_RUNS, Runs);
 
 					PARSEDOUBLEOPTION(OPT_SS, SizeScale);//Float args.
 					PARSEDOUBLEOPTION(OPT_QS, QualityScale);
@@ -494,6 +522,9 @@ public:
 					PARSEDOUBLEOPTION(OPT_OFFSETX, OffsetX);
 					PARSEDOUBLEOPTION(OPT_OFFSETY, OffsetY);
 					PARSEDOUBLEOPTION(OPT_USEMEM, UseMem);
+					PARSEDOUBLEOPTION(OPT_NOISE, Noise);
+					PARSEDOUBLEOPTION(OPT_MAX_ITER_SCALE, MaxIterScale);
+					PARSEDOUBLEOPTION(OPT_THRESHOLD, Threshold);
 
 					PARSESTRINGOPTION(OPT_ISAAC_SEED, IsaacSeed);//String args.
 					PARSESTRINGOPTION(OPT_IN, Input);
@@ -506,6 +537,8 @@ public:
 					PARSESTRINGOPTION(OPT_ID, Id);
 					PARSESTRINGOPTION(OPT_URL, Url);
 					PARSESTRINGOPTION(OPT_NICK, Nick);
+					PARSESTRINGOPTION(OPT_STATS_JSON, StatsJson);
+					PARSESTRINGOPTION(OPT_BASELINE, Baseline);
 					PARSESTRINGOPTION(OPT_COMMENT, Comment);
 					PARSESTRINGOPTION(OPT_TEMPLATE, TemplateFile);
 					PARSESTRINGOPTION(OPT_CLONE, Clone);
@@ -620,6 +653,11 @@ public:
 			cout << "Usage:\n"
 				"\tEmberGenome.exe --sequence=test.flam3 > sequenceout.flam3\n" << endl;
 		}
+		else if (optUsage == OPT_USE_BENCH)
+		{
+			cout << "Usage:\n"
+				"\tEmberBench.exe --in=bench.flame --baseline=baseline.txt [--save_baseline --threshold=10 --nthreads=8 --opencl]\n" << endl;
+		}
 
 		cout << GetUsage(optUsage) << endl;
 	}
@@ -672,6 +710,8 @@ public:
 	EmberOptionEntry<bool> UnsmoothEdge;
 	EmberOptionEntry<bool> LockAccum;
 	EmberOptionEntry<bool> DumpKernel;
+	EmberOptionEntry<bool> Numa;
+	EmberOptionEntry<bool> SaveBaseline;
 
 	EmberOptionEntry<int> Symmetry;//Value int.
 	EmberOptionEntry<int> SheepGen;
@@ -684,9 +724,11 @@ public:
 	EmberOptionEntry<uint> Supersample;
 	EmberOptionEntry<uint> BitsPerChannel;
 	EmberOptionEntry<uint> SubBatchSize;
+	EmberOptionEntry<uint> HugePages;
 	EmberOptionEntry<uint> Bits;
 	EmberOptionEntry<uint> PrintEditDepth;
 	EmberOptionEntry<uint> JpegQuality;
+	EmberOptionEntry<uint> PngCompression;
 	EmberOptionEntry<uint> FirstFrame;
 	EmberOptionEntry<uint> LastFrame;
 	EmberOptionEntry<uint> Frame;
@@ -697,6 +739,7 @@ public:
 	EmberOptionEntry<uint> Repeat;
 	EmberOptionEntry<uint> Tries;
 	EmberOptionEntry<uint> MaxXforms;
+	EmberOptionEntry<uint> Runs;
 
 	EmberOptionEntry<double> SizeScale;//Value double.
 	EmberOptionEntry<double> QualityScale;
@@ -709,6 +752,9 @@ public:
 	EmberOptionEntry<double> OffsetX;
 	EmberOptionEntry<double> OffsetY;
 	EmberOptionEntry<double> UseMem;
+	EmberOptionEntry<double> Noise;
+	EmberOptionEntry<double> MaxIterScale;
+	EmberOptionEntry<double> Threshold;
 
 	EmberOptionEntry<string> IsaacSeed;//Value string.
 	EmberOptionEntry<string> Input;
@@ -721,6 +767,8 @@ public:
 	EmberOptionEntry<string> Id;
 	EmberOptionEntry<string> Url;
 	EmberOptionEntry<string> Nick;
+	EmberOptionEntry<string> StatsJson;
+	EmberOptionEntry<string> Baseline;
 	EmberOptionEntry<string> Comment;
 	EmberOptionEntry<string> TemplateFile;
 	EmberOptionEntry<string> Clone;
@@ -2,7 +2,10 @@
 
 #include "EmberCommonPch.h"
 
-#define PNG_COMMENT_MAX 8
+#define PNG_COMMENT_MAX 10
+#define PNG_WINDOW_SIZE 32768//The largest dictionary deflate can use.
+#define PNG_BLOCK_SIZE (1 << 18)//The number of bytes of filtered rows each thread compresses at a time, which must be well above PNG_WINDOW_SIZE to keep the overhead of splitting small.
+#define PNG_PARALLEL_MIN_SIZE (1 << 20)//Images with fewer bytes than this are written with libpng alone.
 
 /// <summary>
 /// Write a PPM file.
@@ -30,6 +33,50 @@ static bool WritePpm(const char* filename, byte* image, size_t width, size_t hei
 	return b;
 }
 
+/// <summary>
+/// Create the comment strings embedded in a JPEG file, in the order they are written.
+/// Each is limited to the 65533 bytes a marker can hold.
+/// </summary>
+/// <param name="comments">The comment string to embed</param>
+/// <param name="id">Id of the author</param>
+/// <param name="url">Url of the author</param>
+/// <param name="nick">Nickname of the author</param>
+/// <returns>The comment strings</returns>
+static vector<string> JpegComments(EmberImageComments& comments, const string& id, const string& url, const string& nick)
+{
+	vector<string> strings;
+
+	strings.push_back(string("flam3_version: ") + EmberVersion());
+
+	if (nick != "")
+		strings.push_back("flam3_nickname: " + nick);
+
+	if (url != "")
+		strings.push_back("flam3_url: " + url);
+
+	if (id != "")
+		strings.push_back("flam3_id: " + id);
+
+	strings.push_back("flam3_error_rate: " + comments.m_Badvals);
+	strings.push_back("flam3_samples: " + comments.m_NumIters);
+	strings.push_back("flam3_time: " + comments.m_Runtime);
+
+	//Only present when adaptive iteration was used.
+	if (comments.m_Noise != "")
+	{
+		strings.push_back("ember_noise: " + comments.m_Noise);
+		strings.push_back("ember_iters_saved: " + comments.m_ItersSaved);
+	}
+
+	strings.push_back("flam3_genome: " + comments.m_Genome);
+
+	for (auto& str : strings)
+		if (str.size() > 65533)
+			str.resize(65533);
+
+	return strings;
+}
+
 /// <summary>
 /// Write a JPEG file.
 /// </summary>
@@ -54,16 +101,6 @@ static bool WriteJpeg(const char* filename, byte* image, size_t width, size_t he
 		size_t i;
 		jpeg_error_mgr jerr;
 		jpeg_compress_struct info;
-		char nickString[64], urlString[128], idString[128];
-		char bvString[64], niString[64], rtString[64];
-		char genomeString[65536], verString[64];
-
-		//Create the mandatory comment strings.
-		snprintf_s(genomeString, 65536, "flam3_genome: %s", comments.m_Genome.c_str());
-		snprintf_s(bvString, 64, "flam3_error_rate: %s", comments.m_Badvals.c_str());
-		snprintf_s(niString, 64, "flam3_samples: %s", comments.m_NumIters.c_str());
-		snprintf_s(rtString, 64, "flam3_time: %s", comments.m_Runtime.c_str());
-		snprintf_s(verString, 64, "flam3_version: %s", EmberVersion());
 
 		info.err = jpeg_std_error(&jerr);
 		jpeg_create_compress(&info);
@@ -78,51 +115,496 @@ static bool WriteJpeg(const char* filename, byte* image, size_t width, size_t he
 
 		//Write comments to jpeg.
 		if (enableComments)
+			for (auto& str : JpegComments(comments, id, url, nick))
+				jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<const byte*>(str.data()), uint(str.size()));
+
+		for (i = 0; i < height; i++)
+		{
+			JSAMPROW row_pointer[1];
+			row_pointer[0] = reinterpret_cast<byte*>(image) + (3 * width * i);
+			jpeg_write_scanlines(&info, row_pointer, 1);
+		}
+
+		jpeg_finish_compress(&info);
+		jpeg_destroy_compress(&info);
+		fclose(file);
+		b = true;
+	}
+
+	return b;
+}
+
+/// <summary>
+/// Fill in the text chunks embedded in a PNG file.
+/// The strings are not copied, so the arguments must outlive the use of the chunks.
+/// </summary>
+/// <param name="text">The PNG_COMMENT_MAX chunks to fill in</param>
+/// <param name="comments">The comment string to embed</param>
+/// <param name="id">Id of the author</param>
+/// <param name="url">Url of the author</param>
+/// <param name="nick">Nickname of the author</param>
+/// <returns>The number of chunks to write. The last two are only present when adaptive iteration was used.</returns>
+static int PngComments(png_text* text, EmberImageComments& comments, const string& id, const string& url, const string& nick)
+{
+	memset(text, 0, sizeof(png_text) * PNG_COMMENT_MAX);
+
+	text[0].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[0].key = const_cast<png_charp>("flam3_version");
+	text[0].text = const_cast<png_charp>(EmberVersion());
+
+	text[1].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[1].key = const_cast<png_charp>("flam3_nickname");
+	text[1].text = const_cast<png_charp>(nick.c_str());
+
+	text[2].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[2].key = const_cast<png_charp>("flam3_url");
+	text[2].text = const_cast<png_charp>(url.c_str());
+
+	text[3].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[3].key = const_cast<png_charp>("flam3_id");
+	text[3].text = const_cast<png_charp>(id.c_str());
+
+	text[4].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[4].key = const_cast<png_charp>("flam3_error_rate");
+	text[4].text = const_cast<png_charp>(comments.m_Badvals.c_str());
+
+	text[5].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[5].key = const_cast<png_charp>("flam3_samples");
+	text[5].text = const_cast<png_charp>(comments.m_NumIters.c_str());
+
+	text[6].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[6].key = const_cast<png_charp>("flam3_time");
+	text[6].text = const_cast<png_charp>(comments.m_Runtime.c_str());
+
+	text[7].compression = PNG_TEXT_COMPRESSION_zTXt;
+	text[7].key = const_cast<png_charp>("flam3_genome");
+	text[7].text = const_cast<png_charp>(comments.m_Genome.c_str());
+
+	text[8].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[8].key = const_cast<png_charp>("ember_noise");
+	text[8].text = const_cast<png_charp>(comments.m_Noise.c_str());
+
+	text[9].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[9].key = const_cast<png_charp>("ember_iters_saved");
+	text[9].text = const_cast<png_charp>(comments.m_ItersSaved.c_str());
+
+	return comments.m_Noise != "" ? PNG_COMMENT_MAX : PNG_COMMENT_MAX - 2;
+}
+
+/// <summary>
+/// Writes the image data of a PNG file using all cores.
+/// libpng filters and compresses rows one at a time on a single thread, which takes a large fraction of the
+/// time spent on big images. Here the rows are split into blocks which are filtered and deflated in parallel.
+/// Each block is preset with the 32KB of filtered data preceding it as its dictionary and ends on a byte
+/// boundary with a sync flush, except for the last which finishes the stream. So the blocks can be concatenated
+/// into a single zlib stream that decodes exactly as if it had been compressed in one piece, and is only slightly larger.
+/// The row filters are chosen per row with the same minimum sum of absolute differences heuristic libpng uses.
+/// The signature, header and any text chunks preceding the image data are written with libpng,
+/// the IDAT and IEND chunks are written here.
+/// </summary>
+class PngEncoder
+{
+public:
+	/// <summary>
+	/// Default constructor which sets all values to empty.
+	/// </summary>
+	PngEncoder()
+		: m_File(nullptr), m_PixelSize(0), m_RowSize(0), m_Level(Z_DEFAULT_COMPRESSION), m_Swap(false), m_Started(false), m_Adler(1)
+	{
+	}
+
+	/// <summary>
+	/// Write the signature, header and text chunks and prepare to compress rows.
+	/// </summary>
+	/// <param name="file">The file to write to, which must be open for binary writing and remains owned by the caller</param>
+	/// <param name="width">Width of the image in pixels</param>
+	/// <param name="height">Height of the image in pixels</param>
+	/// <param name="bytesPerChannel">Bytes per channel, 1 or 2.</param>
+	/// <param name="level">The zlib compression level, 0-9 or Z_DEFAULT_COMPRESSION</param>
+	/// <param name="text">The text chunks to write before the image data, or nullptr for none</param>
+	/// <param name="textCount">The number of text chunks</param>
+	/// <returns>True if success, else false.</returns>
+	bool Begin(FILE* file, size_t width, size_t height, size_t bytesPerChannel, int level, png_text* text, int textCount)
+	{
+		glm::uint16 testbe = 1;
+		png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+		png_infop info_ptr = png_create_info_struct(png_ptr);
+
+		if (setjmp(png_jmpbuf(png_ptr)))
 		{
-			jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(verString), uint(strlen(verString)));
+			png_destroy_write_struct(&png_ptr, &info_ptr);
+			perror("writing file");
+			return false;
+		}
+
+		png_init_io(png_ptr, file);
 
-			if (nick != "")
+		png_set_IHDR(png_ptr, info_ptr, png_uint_32(width), png_uint_32(height), 8 * png_uint_32(bytesPerChannel),
+			PNG_COLOR_TYPE_RGBA,
+			PNG_INTERLACE_NONE,
+			PNG_COMPRESSION_TYPE_BASE,
+			PNG_FILTER_TYPE_BASE);
+
+		if (text && textCount)
+			png_set_text(png_ptr, info_ptr, text, textCount);
+
+		png_write_info(png_ptr, info_ptr);
+		png_write_flush(png_ptr);
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+
+		m_File = file;
+		m_PixelSize = 4 * bytesPerChannel;
+		m_RowSize = width * m_PixelSize;
+		m_Level = level < 0 || level > 9 ? Z_DEFAULT_COMPRESSION : level;
+		m_Swap = bytesPerChannel == 2 && testbe != htons(testbe);//Samples must be stored big endian.
+		m_Started = false;
+		m_Adler = adler32(0, nullptr, 0);
+		m_Tail.clear();
+		m_PrevRow.clear();
+		return true;
+	}
+
+	/// <summary>
+	/// Filter, compress and write the next rows of the image as IDAT chunks.
+	/// </summary>
+	/// <param name="rows">Pointer to the rows, which are contiguous. Each pixel is 4 channels of RGBA.</param>
+	/// <param name="count">The number of rows</param>
+	/// <param name="last">True if these are the last rows of the image, which finishes the compressed stream, else false.</param>
+	/// <returns>True if success, else false.</returns>
+	bool Write(const byte* rows, size_t count, bool last)
+	{
+		bool b = m_File != nullptr;
+		size_t filteredRowSize = m_RowSize + 1;//Each row is preceded by its filter type.
+		size_t blockRows = std::max<size_t>(1, PNG_BLOCK_SIZE / filteredRowSize);
+		size_t waveRows = blockRows * 4 * std::max<size_t>(1, Timing::ProcessorCount());//Bounds the memory used for filtered and compressed data.
+
+		for (size_t wave = 0; b && (wave < count || (wave == 0 && last)); wave += waveRows)
+		{
+			size_t waveCount = std::min(waveRows, count - wave);
+			size_t blocks = std::max<size_t>(1, (waveCount + blockRows - 1) / blockRows);
+			size_t tailSize = m_Tail.size();
+			bool finish = last && wave + waveCount == count;
+
+			//The filtered rows follow the tail of the previous ones, so every block can find its dictionary in front of it.
+			m_Filtered.resize(tailSize + waveCount * filteredRowSize);
+			m_Compressed.resize(blocks);
+			m_Adlers.resize(blocks);
+			m_Results.assign(blocks, 0);
+
+			if (tailSize)
+				memcpy(m_Filtered.data(), m_Tail.data(), tailSize);
+
+			parallel_for(size_t(0), blocks, [&](size_t block)
 			{
-				snprintf_s(nickString, 64, "flam3_nickname: %s", nick.c_str());
-				jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(nickString), uint(strlen(nickString)));
+				vector<byte> cur, prev;
+				size_t start = block * blockRows, end = std::min(waveCount, start + blockRows);
+
+				for (size_t r = start; r < end; r++)
+				{
+					size_t row = wave + r;
+					const byte* rowp = rows + row * m_RowSize;
+					const byte* prevp = row ? rows + (row - 1) * m_RowSize : (m_PrevRow.empty() ? nullptr : m_PrevRow.data());
+
+					if (m_Swap)
+					{
+						if (r == start && row)
+							Swap16(prevp, prev);
+
+						Swap16(rowp, cur);
+						rowp = cur.data();
+						prevp = (r == start && !row) ? prevp : (prev.empty() ? nullptr : prev.data());
+					}
+
+					FilterRow(rowp, prevp, m_Filtered.data() + tailSize + r * filteredRowSize);
+
+					if (m_Swap)
+						cur.swap(prev);
+				}
+			});
+
+			parallel_for(size_t(0), blocks, [&](size_t block)
+			{
+				size_t start = block * blockRows, end = std::min(waveCount, start + blockRows);
+				size_t begin = tailSize + start * filteredRowSize, size = (end - start) * filteredRowSize;
+				size_t dictSize = std::min<size_t>(begin, PNG_WINDOW_SIZE);
+				const byte* data = m_Filtered.data() + begin;
+
+				m_Adlers[block] = adler32(adler32(0, nullptr, 0), data, uInt(size));
+				m_Results[block] = Deflate(data - dictSize, dictSize, data, size, finish && block == blocks - 1, m_Compressed[block]);
+			});
+
+			for (size_t block = 0; b && block < blocks; block++)
+			{
+				vector<byte>& out = m_Compressed[block];
+				size_t start = block * blockRows, end = std::min(waveCount, start + blockRows);
+
+				b = m_Results[block] != 0;
+				m_Adler = adler32_combine(m_Adler, m_Adlers[block], z_off_t((end - start) * filteredRowSize));
+
+				if (!m_Started)//Zlib header, with the level stored the same way zlib does.
+				{
+					byte cmf = 0x78, flg = byte((m_Level == Z_DEFAULT_COMPRESSION ? 2 : m_Level < 2 ? 0 : m_Level < 6 ? 1 : m_Level == 6 ? 2 : 3) << 6);
+
+					flg += byte(31 - (cmf * 256 + flg) % 31);
+					out.insert(out.begin(), flg);
+					out.insert(out.begin(), cmf);
+					m_Started = true;
+				}
+
+				if (finish && block == blocks - 1)//Zlib trailer.
+				{
+					out.push_back(byte(m_Adler >> 24));
+					out.push_back(byte(m_Adler >> 16));
+					out.push_back(byte(m_Adler >> 8));
+					out.push_back(byte(m_Adler));
+				}
+
+				b = b && WriteChunk(m_File, "IDAT", out.data(), out.size());
 			}
 
-			if (url != "")
+			//Keep what the next rows need: the dictionary for their first block, and the row above the first of them.
+			size_t keep = std::min<size_t>(m_Filtered.size(), PNG_WINDOW_SIZE);
+
+			m_Tail.assign(m_Filtered.end() - keep, m_Filtered.end());
+
+			if (waveCount)
 			{
-				snprintf_s(urlString, 128, "flam3_url: %s", url.c_str());
-				jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(urlString), uint(strlen(urlString)));
+				const byte* lastRow = rows + (wave + waveCount - 1) * m_RowSize;
+
+				if (m_Swap)
+					Swap16(lastRow, m_PrevRow);
+				else
+					m_PrevRow.assign(lastRow, lastRow + m_RowSize);
 			}
+		}
 
-			if (id != "")
+		if (last)
+		{
+			vector<byte>().swap(m_Filtered);
+			vector<vector<byte>>().swap(m_Compressed);
+		}
+
+		return b;
+	}
+
+	/// <summary>
+	/// Write text chunks, which must be called after the last rows were written.
+	/// Compressed text is compressed on the calling thread.
+	/// </summary>
+	/// <param name="text">The text chunks to write</param>
+	/// <param name="textCount">The number of text chunks</param>
+	/// <returns>True if success, else false.</returns>
+	bool WriteText(png_text* text, int textCount)
+	{
+		bool b = m_File != nullptr;
+
+		for (int i = 0; b && i < textCount; i++)
+		{
+			size_t keyLen = strlen(text[i].key), textLen = text[i].text ? strlen(text[i].text) : 0;
+			vector<byte> data(text[i].key, text[i].key + keyLen + 1);//Include the null terminator.
+
+			if (text[i].compression == PNG_TEXT_COMPRESSION_zTXt)
 			{
-				snprintf_s(idString, 128, "flam3_id: %s", id.c_str());
-				jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(idString), uint(strlen(idString)));
+				uLongf size = compressBound(uLong(textLen));
+
+				data.push_back(0);//Compression method.
+				data.resize(keyLen + 2 + size);
+				b = compress2(data.data() + keyLen + 2, &size, reinterpret_cast<const byte*>(text[i].text), uLong(textLen), m_Level) == Z_OK;
+				data.resize(keyLen + 2 + size);
+				b = b && WriteChunk(m_File, "zTXt", data.data(), data.size());
+			}
+			else
+			{
+				data.insert(data.end(), text[i].text, text[i].text + textLen);
+				b = WriteChunk(m_File, "tEXt", data.data(), data.size());
 			}
+		}
+
+		return b;
+	}
+
+	/// <summary>
+	/// Write the IEND chunk which completes the file.
+	/// </summary>
+	/// <returns>True if success, else false.</returns>
+	bool End()
+	{
+		bool b = m_File && WriteChunk(m_File, "IEND", nullptr, 0);
+
+		m_File = nullptr;
+		return b;
+	}
+
+private:
+	/// <summary>
+	/// Copy a row of 16-bit samples, swapping the bytes of each.
+	/// </summary>
+	/// <param name="row">The row to copy</param>
+	/// <param name="out">The vector to store the swapped row in</param>
+	void Swap16(const byte* row, vector<byte>& out) const
+	{
+		out.resize(m_RowSize);
 
-			jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(bvString), uint(strlen(bvString)));
-			jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(niString), uint(strlen(niString)));
-			jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(rtString), uint(strlen(rtString)));
-			jpeg_write_marker(&info, JPEG_COM, reinterpret_cast<byte*>(genomeString), uint(strlen(genomeString)));
+		for (size_t i = 0; i < m_RowSize; i += 2)
+		{
+			out[i] = row[i + 1];
+			out[i + 1] = row[i];
 		}
+	}
 
-		for (i = 0; i < height; i++)
+	/// <summary>
+	/// Filter a row with each of the five PNG filters and store the filter type followed by
+	/// the result of the one whose output has the smallest sum of absolute values, treated as signed bytes.
+	/// </summary>
+	/// <param name="row">The row to filter</param>
+	/// <param name="prev">The row above it, or nullptr for the first row</param>
+	/// <param name="out">The buffer to store the filter type and filtered row in, which must be one byte longer than a row</param>
+	void FilterRow(const byte* row, const byte* prev, byte* out) const
+	{
+		size_t i, best = 0;
+		size_t sums[5] = { 0, 0, 0, 0, 0 };
+
+		for (i = 0; i < m_RowSize; i++)
 		{
-			JSAMPROW row_pointer[1];
-			row_pointer[0] = reinterpret_cast<byte*>(image) + (3 * width * i);
-			jpeg_write_scanlines(&info, row_pointer, 1);
+			int a = i >= m_PixelSize ? row[i - m_PixelSize] : 0;
+			int b = prev ? prev[i] : 0;
+			int c = (prev && i >= m_PixelSize) ? prev[i - m_PixelSize] : 0;
+			int x = row[i];
+
+			sums[0] += SignedAbs(byte(x));
+			sums[1] += SignedAbs(byte(x - a));
+			sums[2] += SignedAbs(byte(x - b));
+			sums[3] += SignedAbs(byte(x - ((a + b) >> 1)));
+			sums[4] += SignedAbs(byte(x - Paeth(a, b, c)));
 		}
 
-		jpeg_finish_compress(&info);
-		jpeg_destroy_compress(&info);
-		fclose(file);
-		b = true;
+		for (i = 1; i < 5; i++)
+			if (sums[i] < sums[best])
+				best = i;
+
+		out[0] = byte(best);
+		out++;
+
+		for (i = 0; i < m_RowSize; i++)
+		{
+			int a = i >= m_PixelSize ? row[i - m_PixelSize] : 0;
+			int b = prev ? prev[i] : 0;
+			int c = (prev && i >= m_PixelSize) ? prev[i - m_PixelSize] : 0;
+			int x = row[i];
+
+			switch (best)
+			{
+				case 0: out[i] = byte(x); break;
+				case 1: out[i] = byte(x - a); break;
+				case 2: out[i] = byte(x - b); break;
+				case 3: out[i] = byte(x - ((a + b) >> 1)); break;
+				default: out[i] = byte(x - Paeth(a, b, c)); break;
+			}
+		}
 	}
 
-	return b;
-}
+	static size_t SignedAbs(byte v) { return v < 128 ? v : 256 - v; }
+
+	static int Paeth(int a, int b, int c)
+	{
+		int p = b - c, q = a - c;
+		int pa = abs(p), pb = abs(q), pc = abs(p + q);
+
+		return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+	}
+
+	/// <summary>
+	/// Deflate a block of filtered data into a raw deflate stream, with no zlib header or trailer.
+	/// </summary>
+	/// <param name="dict">The data preceding the block, to use as the dictionary</param>
+	/// <param name="dictSize">The size of the dictionary, at most 32KB</param>
+	/// <param name="data">The data to compress</param>
+	/// <param name="size">The size of the data</param>
+	/// <param name="finish">True to end the stream after this block, else false to end on a byte boundary with a sync flush.</param>
+	/// <param name="out">The vector to store the compressed data in</param>
+	/// <returns>True if success, else false.</returns>
+	bool Deflate(const byte* dict, size_t dictSize, const byte* data, size_t size, bool finish, vector<byte>& out) const
+	{
+		int ret;
+		z_stream strm;
+
+		memset(&strm, 0, sizeof(strm));
+
+		if (deflateInit2(&strm, m_Level, Z_DEFLATED, -15, 8, Z_FILTERED) != Z_OK)
+			return false;
+
+		if (dictSize && deflateSetDictionary(&strm, dict, uInt(dictSize)) != Z_OK)
+		{
+			deflateEnd(&strm);
+			return false;
+		}
+
+		out.resize(deflateBound(&strm, uLong(size)) + 16);
+		strm.next_in = const_cast<byte*>(data);
+		strm.avail_in = uInt(size);
+
+		do
+		{
+			if (strm.total_out == out.size())
+				out.resize(out.size() * 2);
+
+			strm.next_out = out.data() + strm.total_out;
+			strm.avail_out = uInt(out.size() - strm.total_out);
+			ret = deflate(&strm, finish ? Z_FINISH : Z_SYNC_FLUSH);
+		}
+		while (ret != Z_STREAM_ERROR && strm.avail_out == 0);
+
+		out.resize(strm.total_out);
+		deflateEnd(&strm);
+		return finish ? ret == Z_STREAM_END : (ret == Z_OK && strm.avail_in == 0);
+	}
+
+	/// <summary>
+	/// Write a chunk along with its length and CRC.
+	/// </summary>
+	/// <param name="file">The file to write to</param>
+	/// <param name="type">The four character type of the chunk</param>
+	/// <param name="data">The data of the chunk</param>
+	/// <param name="size">The size of the data</param>
+	/// <returns>True if success, else false.</returns>
+	static bool WriteChunk(FILE* file, const char* type, const byte* data, size_t size)
+	{
+		uLong crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const byte*>(type), 4);
+		byte len[4] = { byte(size >> 24), byte(size >> 16), byte(size >> 8), byte(size) };
+		byte crcb[4];
+
+		if (size)
+			crc = crc32(crc, data, uInt(size));
+
+		crcb[0] = byte(crc >> 24);
+		crcb[1] = byte(crc >> 16);
+		crcb[2] = byte(crc >> 8);
+		crcb[3] = byte(crc);
+
+		return fwrite(len, 1, 4, file) == 4 &&
+			   fwrite(type, 1, 4, file) == 4 &&
+			   (!size || fwrite(data, 1, size, file) == size) &&
+			   fwrite(crcb, 1, 4, file) == 4;
+	}
+
+	FILE* m_File;
+	size_t m_PixelSize;
+	size_t m_RowSize;
+	int m_Level;
+	bool m_Swap;//True if 16-bit samples need to be swapped to big endian.
+	bool m_Started;//True once the zlib header was written.
+	uLong m_Adler;//Adler-32 checksum of all filtered data written so far.
+	vector<byte> m_Tail;//The last 32KB of filtered data written, which is the dictionary for the next rows.
+	vector<byte> m_PrevRow;//The last row written, swapped if needed, which the first of the next rows is filtered against.
+	vector<byte> m_Filtered;
+	vector<vector<byte>> m_Compressed;
+	vector<uLong> m_Adlers;
+	vector<char> m_Results;
+};
 
 /// <summary>
 /// Write a PNG file.
+/// Images of at least PNG_PARALLEL_MIN_SIZE bytes are compressed on all cores with PngEncoder.
 /// </summary>
 /// <param name="filename">The full path and name of the file</param>
 /// <param name="image">Pointer to the image data to write</param>
@@ -134,8 +616,9 @@ static bool WriteJpeg(const char* filename, byte* image, size_t width, size_t he
 /// <param name="id">Id of the author</param>
 /// <param name="url">Url of the author</param>
 /// <param name="nick">Nickname of the author</param>
+/// <param name="compressionLevel">The zlib compression level, 0-9, where lower is faster but larger. Default: Z_DEFAULT_COMPRESSION.</param>
 /// <returns>True if success, else false</returns>
-static bool WritePng(const char* filename, byte* image, size_t width, size_t height, size_t bytesPerChannel, bool enableComments, EmberImageComments& comments, string id, string url, string nick)
+static bool WritePng(const char* filename, byte* image, size_t width, size_t height, size_t bytesPerChannel, bool enableComments, EmberImageComments& comments, string id, string url, string nick, int compressionLevel = Z_DEFAULT_COMPRESSION)
 {
 	bool b = false;
 	FILE* file;
@@ -149,37 +632,18 @@ static bool WritePng(const char* filename, byte* image, size_t width, size_t hei
 		glm::uint16 testbe = 1;
 		vector<byte*> rows(height);
 
-		text[0].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[0].key = const_cast<png_charp>("flam3_version");
-		text[0].text = const_cast<png_charp>(EmberVersion());
-
-		text[1].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[1].key = const_cast<png_charp>("flam3_nickname");
-		text[1].text = const_cast<png_charp>(nick.c_str());
-
-		text[2].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[2].key = const_cast<png_charp>("flam3_url");
-		text[2].text = const_cast<png_charp>(url.c_str());
-
-		text[3].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[3].key = const_cast<png_charp>("flam3_id");
-		text[3].text = const_cast<png_charp>(id.c_str());
+		int textCount = PngComments(text, comments, id, url, nick);
 
-		text[4].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[4].key = const_cast<png_charp>("flam3_error_rate");
-		text[4].text = const_cast<png_charp>(comments.m_Badvals.c_str());
-
-		text[5].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[5].key = const_cast<png_charp>("flam3_samples");
-		text[5].text = const_cast<png_charp>(comments.m_NumIters.c_str());
-
-		text[6].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[6].key = const_cast<png_charp>("flam3_time");
-		text[6].text = const_cast<png_charp>(comments.m_Runtime.c_str());
+		if (width * height * 4 * bytesPerChannel >= PNG_PARALLEL_MIN_SIZE)
+		{
+			PngEncoder encoder;
 
-		text[7].compression = PNG_TEXT_COMPRESSION_zTXt;
-		text[7].key = const_cast<png_charp>("flam3_genome");
-		text[7].text = const_cast<png_charp>(comments.m_Genome.c_str());
+			b = encoder.Begin(file, width, height, bytesPerChannel, compressionLevel, enableComments ? text : nullptr, textCount) &&
+				encoder.Write(image, height, true) &&
+				encoder.End();
+			fclose(file);
+			return b;
+		}
 
 		for (i = 0; i < height; i++)
 			rows[i] = image + i * width * 4 * bytesPerChannel;
@@ -204,7 +668,10 @@ static bool WritePng(const char* filename, byte* image, size_t width, size_t hei
 			PNG_FILTER_TYPE_BASE);
 
 		if (enableComments == 1)
-			png_set_text(png_ptr, info_ptr, text, PNG_COMMENT_MAX);
+			png_set_text(png_ptr, info_ptr, text, textCount);
+
+		if (compressionLevel >= 0 && compressionLevel <= 9)
+			png_set_compression_level(png_ptr, compressionLevel);
 
 		png_write_info(png_ptr, info_ptr);
 
@@ -362,3 +829,359 @@ static bool WriteBmp(const char* filename, byte* image, size_t width, size_t hei
 
 	return b;
 }
+
+/// <summary>
+/// Base class for writing an image file one block of rows at a time, from top to bottom,
+/// which allows an image rendered in strips to be written without ever holding all of it in memory.
+/// Comments are only known once the whole image is rendered, so they are passed to Finish().
+/// Destroying a writer before Finish() succeeds abandons the file, which the caller should then remove.
+/// </summary>
+class RowWriter
+{
+public:
+	/// <summary>
+	/// Default constructor which sets all values to empty.
+	/// </summary>
+	RowWriter()
+		: m_File(nullptr), m_Width(0), m_Height(0), m_RowSize(0), m_RowsWritten(0)
+	{
+	}
+
+	/// <summary>
+	/// Virtual destructor which closes the file if it's still open.
+	/// </summary>
+	virtual ~RowWriter()
+	{
+		if (m_File)
+			fclose(m_File);
+	}
+
+	/// <summary>
+	/// Write the next rows of the image.
+	/// </summary>
+	/// <param name="rows">Pointer to the rows, which are contiguous</param>
+	/// <param name="count">The number of rows</param>
+	/// <returns>True if success, else false.</returns>
+	virtual bool WriteRows(const byte* rows, size_t count) = 0;
+
+	/// <summary>
+	/// Embed the comments if supported, complete and close the file.
+	/// This fails if fewer rows than the height of the image were written.
+	/// </summary>
+	/// <param name="enableComments">True to embed comments, else false</param>
+	/// <param name="comments">The comment string to embed</param>
+	/// <param name="id">Id of the author</param>
+	/// <param name="url">Url of the author</param>
+	/// <param name="nick">Nickname of the author</param>
+	/// <returns>True if success, else false.</returns>
+	virtual bool Finish(bool enableComments, EmberImageComments& comments, const string& id, const string& url, const string& nick) = 0;
+
+protected:
+	/// <summary>
+	/// Open the file and store the dimensions.
+	/// </summary>
+	/// <param name="filename">The full path and name of the file</param>
+	/// <param name="width">Width of the image in pixels</param>
+	/// <param name="height">Height of the image in pixels</param>
+	/// <param name="pixelSize">The number of bytes per pixel</param>
+	/// <returns>True if success, else false.</returns>
+	bool OpenFile(const char* filename, size_t width, size_t height, size_t pixelSize)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_RowSize = width * pixelSize;
+		m_RowsWritten = 0;
+		return !m_File && width && height && fopen_s(&m_File, filename, "wb") == 0;
+	}
+
+	/// <summary>
+	/// Close the file.
+	/// </summary>
+	/// <returns>True if the file was open and closed without error, else false.</returns>
+	bool CloseFile()
+	{
+		bool b = m_File && fclose(m_File) == 0;
+
+		m_File = nullptr;
+		return b;
+	}
+
+	FILE* m_File;
+	size_t m_Width;
+	size_t m_Height;
+	size_t m_RowSize;//The number of bytes in a row.
+	size_t m_RowsWritten;
+
+private:
+	RowWriter(const RowWriter& writer);
+	RowWriter& operator = (const RowWriter& writer);
+};
+
+/// <summary>
+/// Writes a PPM file one block of rows at a time. PPM has no comments.
+/// </summary>
+class PpmWriter : public RowWriter
+{
+public:
+	/// <summary>
+	/// Create the file and write the header.
+	/// </summary>
+	/// <param name="filename">The full path and name of the file</param>
+	/// <param name="width">Width of the image in pixels</param>
+	/// <param name="height">Height of the image in pixels</param>
+	/// <returns>True if success, else false.</returns>
+	bool Open(const char* filename, size_t width, size_t height)
+	{
+		if (!OpenFile(filename, width, height, 3))
+			return false;
+
+		fprintf_s(m_File, "P6\n");
+		fprintf_s(m_File, "%lu %lu\n255\n", width, height);
+		return true;
+	}
+
+	/// <summary>
+	/// Write the next rows of the image. Each pixel is 3 bytes of RGB.
+	/// </summary>
+	/// <param name="rows">Pointer to the rows, which are contiguous</param>
+	/// <param name="count">The number of rows</param>
+	/// <returns>True if success, else false.</returns>
+	virtual bool WriteRows(const byte* rows, size_t count) override
+	{
+		if (!m_File || m_RowsWritten + count > m_Height)
+			return false;
+
+		m_RowsWritten += count;
+		return fwrite(rows, m_RowSize, count, m_File) == count;
+	}
+
+	/// <summary>
+	/// Close the file.
+	/// </summary>
+	/// <returns>True if success, else false.</returns>
+	virtual bool Finish(bool enableComments, EmberImageComments& comments, const string& id, const string& url, const string& nick) override
+	{
+		return (m_RowsWritten == m_Height) & CloseFile();
+	}
+};
+
+/// <summary>
+/// Writes a JPEG file one block of rows at a time.
+/// The comment markers must precede the compressed image data in the file, but the comments
+/// are not known until the image is finished. So the compressed data is kept in memory and
+/// the file is written by Finish(), with the comments inserted in the same place WriteJpeg() puts them.
+/// The compressed data is typically a small fraction of the size of the raw image.
+/// </summary>
+class JpegWriter : public RowWriter
+{
+public:
+	/// <summary>
+	/// Default constructor which sets all values to empty.
+	/// </summary>
+	JpegWriter()
+		: m_Started(false)
+	{
+		m_Dest.m_Buf = &m_Data;
+	}
+
+	/// <summary>
+	/// Destructor which releases the compressor if Finish() was not called.
+	/// </summary>
+	~JpegWriter()
+	{
+		if (m_Started)
+			jpeg_destroy_compress(&m_Info);
+	}
+
+	/// <summary>
+	/// Create the file and start the compressor.
+	/// </summary>
+	/// <param name="filename">The full path and name of the file</param>
+	/// <param name="width">Width of the image in pixels</param>
+	/// <param name="height">Height of the image in pixels</param>
+	/// <param name="quality">The quality to use</param>
+	/// <returns>True if success, else false.</returns>
+	bool Open(const char* filename, size_t width, size_t height, int quality)
+	{
+		if (m_Started || !OpenFile(filename, width, height, 3))
+			return false;
+
+		m_Info.err = jpeg_std_error(&m_Err);
+		jpeg_create_compress(&m_Info);
+		m_Started = true;
+		m_Data.clear();
+		m_Dest.m_Mgr.init_destination = InitDestination;
+		m_Dest.m_Mgr.empty_output_buffer = EmptyOutputBuffer;
+		m_Dest.m_Mgr.term_destination = TermDestination;
+		m_Info.dest = &m_Dest.m_Mgr;
+		m_Info.in_color_space = JCS_RGB;
+		m_Info.input_components = 3;
+		m_Info.image_width = JDIMENSION(width);
+		m_Info.image_height = JDIMENSION(height);
+		jpeg_set_defaults(&m_Info);
+		jpeg_set_quality(&m_Info, quality, TRUE);
+		jpeg_start_compress(&m_Info, TRUE);
+		return true;
+	}
+
+	/// <summary>
+	/// Compress the next rows of the image. Each pixel is 3 bytes of RGB.
+	/// </summary>
+	/// <param name="rows">Pointer to the rows, which are contiguous</param>
+	/// <param name="count">The number of rows</param>
+	/// <returns>True if success, else false.</returns>
+	virtual bool WriteRows(const byte* rows, size_t count) override
+	{
+		if (!m_Started || m_RowsWritten + count > m_Height)
+			return false;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			JSAMPROW row_pointer[1];
+			row_pointer[0] = const_cast<byte*>(rows + i * m_RowSize);
+			jpeg_write_scanlines(&m_Info, row_pointer, 1);
+		}
+
+		m_RowsWritten += count;
+		return true;
+	}
+
+	/// <summary>
+	/// Finish compressing and write the file, with the comments placed after the JFIF header.
+	/// </summary>
+	/// <returns>True if success, else false.</returns>
+	virtual bool Finish(bool enableComments, EmberImageComments& comments, const string& id, const string& url, const string& nick) override
+	{
+		bool b = false;
+
+		if (m_Started && m_RowsWritten == m_Height)
+		{
+			size_t pos = 2;
+
+			jpeg_finish_compress(&m_Info);
+			jpeg_destroy_compress(&m_Info);
+			m_Started = false;
+
+			//Skip SOI and the JFIF and Adobe application markers, which is where libjpeg writes comments.
+			while (pos + 4 <= m_Data.size() && m_Data[pos] == 0xFF && (m_Data[pos + 1] == 0xE0 || m_Data[pos + 1] == 0xEE))
+				pos += 2 + ((size_t(m_Data[pos + 2]) << 8) | m_Data[pos + 3]);
+
+			if (pos <= m_Data.size())
+			{
+				b = fwrite(m_Data.data(), 1, pos, m_File) == pos;
+
+				if (enableComments)
+				{
+					for (auto& str : JpegComments(comments, id, url, nick))
+					{
+						size_t len = str.size() + 2;
+						byte marker[4] = { 0xFF, byte(JPEG_COM), byte(len >> 8), byte(len & 0xFF) };
+
+						b &= fwrite(marker, 1, 4, m_File) == 4;
+						b &= fwrite(str.data(), 1, str.size(), m_File) == str.size();
+					}
+				}
+
+				b &= fwrite(m_Data.data() + pos, 1, m_Data.size() - pos, m_File) == m_Data.size() - pos;
+			}
+		}
+
+		vector<byte>().swap(m_Data);
+		return b & CloseFile();
+	}
+
+private:
+	/// <summary>
+	/// A libjpeg destination which appends the compressed data to a vector.
+	/// The manager must be first so a pointer to it is also a pointer to this.
+	/// </summary>
+	struct VectorDest
+	{
+		jpeg_destination_mgr m_Mgr;
+		vector<byte>* m_Buf;
+		byte m_Block[65536];
+	};
+
+	static void InitDestination(j_compress_ptr info)
+	{
+		VectorDest* dest = reinterpret_cast<VectorDest*>(info->dest);
+		dest->m_Mgr.next_output_byte = dest->m_Block;
+		dest->m_Mgr.free_in_buffer = sizeof(dest->m_Block);
+	}
+
+	static boolean EmptyOutputBuffer(j_compress_ptr info)
+	{
+		VectorDest* dest = reinterpret_cast<VectorDest*>(info->dest);
+		dest->m_Buf->insert(dest->m_Buf->end(), dest->m_Block, dest->m_Block + sizeof(dest->m_Block));//Must write the whole block regardless of free_in_buffer.
+		InitDestination(info);
+		return TRUE;
+	}
+
+	static void TermDestination(j_compress_ptr info)
+	{
+		VectorDest* dest = reinterpret_cast<VectorDest*>(info->dest);
+		dest->m_Buf->insert(dest->m_Buf->end(), dest->m_Block, dest->m_Block + (sizeof(dest->m_Block) - dest->m_Mgr.free_in_buffer));
+	}
+
+	bool m_Started;
+	jpeg_error_mgr m_Err;
+	jpeg_compress_struct m_Info;
+	VectorDest m_Dest;
+	vector<byte> m_Data;
+};
+
+/// <summary>
+/// Writes a PNG file one block of rows at a time, compressing each block on all cores with PngEncoder.
+/// Text chunks may follow the image data in a PNG file, so the comments are written after it by Finish().
+/// Readers which look for them before the image data, rather than anywhere in the file, will not find them.
+/// </summary>
+class PngWriter : public RowWriter
+{
+public:
+	/// <summary>
+	/// Create the file and write the header.
+	/// </summary>
+	/// <param name="filename">The full path and name of the file</param>
+	/// <param name="width">Width of the image in pixels</param>
+	/// <param name="height">Height of the image in pixels</param>
+	/// <param name="bytesPerChannel">Bytes per channel, 1 or 2.</param>
+	/// <param name="compressionLevel">The zlib compression level, 0-9, where lower is faster but larger. Default: Z_DEFAULT_COMPRESSION.</param>
+	/// <returns>True if success, else false.</returns>
+	bool Open(const char* filename, size_t width, size_t height, size_t bytesPerChannel, int compressionLevel = Z_DEFAULT_COMPRESSION)
+	{
+		return OpenFile(filename, width, height, 4 * bytesPerChannel) && m_Encoder.Begin(m_File, width, height, bytesPerChannel, compressionLevel, nullptr, 0);
+	}
+
+	/// <summary>
+	/// Compress and write the next rows of the image. Each pixel is 4 channels of RGBA.
+	/// </summary>
+	/// <param name="rows">Pointer to the rows, which are contiguous</param>
+	/// <param name="count">The number of rows</param>
+	/// <returns>True if success, else false.</returns>
+	virtual bool WriteRows(const byte* rows, size_t count) override
+	{
+		if (!m_File || m_RowsWritten + count > m_Height)
+			return false;
+
+		m_RowsWritten += count;
+		return m_Encoder.Write(rows, count, m_RowsWritten == m_Height);
+	}
+
+	/// <summary>
+	/// Write the comments and the end of the file.
+	/// </summary>
+	/// <returns>True if success, else false.</returns>
+	virtual bool Finish(bool enableComments, EmberImageComments& comments, const string& id, const string& url, const string& nick) override
+	{
+		bool b = false;
+		png_text text[PNG_COMMENT_MAX];
+
+		if (m_File && m_RowsWritten == m_Height)
+			b = (!enableComments || m_Encoder.WriteText(text, PngComments(text, comments, id, url, nick))) && m_Encoder.End();
+
+		return b & CloseFile();
+	}
+
+private:
+	PngEncoder m_Encoder;
+};
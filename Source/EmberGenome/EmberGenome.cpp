@@ -56,13 +56,13 @@ bool EmberGenome(EmberOptions& opt)
 	}
 
 	//Regular variables.
-	Timing t;
+	Timing t, stageTimer;
 	bool exactTimeMatch, randomMode, didColor, seqFlag;
 	uint i, j, i0, i1, rep, val, frame, frameCount, count = 0;
 	uint ftime, firstFrame, lastFrame;
 	size_t n, tot, totb, totw;
 	T avgPix, fractionBlack, fractionWhite, blend, spread, mix0, mix1;
-	string token, filename;
+	string token, filename, xml;
 	ostringstream os, os2;
 	vector<Ember<T>> embers, embers2, templateEmbers;
 	vector<eVariationId> vars, noVars;
@@ -72,10 +72,13 @@ bool EmberGenome(EmberOptions& opt)
 	Ember<T> orig, save, selp0, selp1, parent0, parent1;
 	Ember<T> result, result1, result2, result3, interpolated;
 	Ember<T>* aselp0, *aselp1, *pTemplate = nullptr;
+	Interpolater<T> interpolater;
 	XmlToEmber<T> parser;
 	EmberToXml<T> emberToXml;
 	VariationList<T> varList;
 	EmberReport emberReport, emberReport2;
+	EmberStats flameStats;//Sum of the test renders of each flame in repeat mode.
+	StatsJson statsJson;
 	unique_ptr<RenderProgress<T>> progress(new RenderProgress<T>());
 	unique_ptr<Renderer<T, bucketT>> renderer(CreateRenderer<T, bucketT>(opt.EmberCL() ? OPENCL_RENDERER : CPU_RENDERER, opt.Platform(), opt.Device(), false, 0, emberReport));
 	QTIsaac<ISAAC_SIZE, ISAAC_INT> rand(ISAAC_INT(t.Tic()), ISAAC_INT(t.Tic() * 2), ISAAC_INT(t.Tic() * 3));
@@ -295,9 +298,9 @@ bool EmberGenome(EmberOptions& opt)
 				tools.ApplyTemplate(embers[i], *pTemplate);
 
 			tools.Offset(embers[i], T(opt.OffsetX()), T(opt.OffsetY()));
-			cout << emberToXml.ToString(embers[i], opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 		}
 
+		emberToXml.Write(cout, embers, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());//Converted in parallel.
 		cout << "</clone_all>" << endl;
 		return true;
 	}
@@ -339,7 +342,7 @@ bool EmberGenome(EmberOptions& opt)
 
 			if (!exactTimeMatch)
 			{
-				Interpolater<T>::Interpolate(embers, T(ftime), T(opt.Stagger()), interpolated);
+				interpolater.InterpolateCached(embers, T(ftime), T(opt.Stagger()), interpolated);
 
 				for (i = 0; i < embers.size(); i++)
 				{
@@ -357,7 +360,7 @@ bool EmberGenome(EmberOptions& opt)
 			if (pTemplate)
 				tools.ApplyTemplate(interpolated, *pTemplate);
 
-			cout << emberToXml.ToString(interpolated, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(interpolated, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 		}
 
 		cout << "</animate>" << endl;
@@ -388,7 +391,7 @@ bool EmberGenome(EmberOptions& opt)
 				{
 					blend = T(frame) / T(opt.Frames());
 					tools.Spin(embers[i], pTemplate, result, frameCount++, blend);//Result is cleared and reassigned each time inside of Spin().
-					cout << emberToXml.ToString(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+					cout << emberToXml.ToBuffer(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 				}
 			}
 
@@ -400,14 +403,14 @@ bool EmberGenome(EmberOptions& opt)
 					blend = frame / T(opt.Frames());
 					result.Clear();
 					tools.SpinInter(&embers[i], pTemplate, result, frameCount++, seqFlag, blend);
-					cout << emberToXml.ToString(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+					cout << emberToXml.ToBuffer(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 				}
 			}
 		}
 
 		result = embers.back();
 		tools.Spin(embers.back(), pTemplate, result, frameCount, 0);
-		cout << emberToXml.ToString(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+		cout << emberToXml.ToBuffer(result, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 
 		if (opt.Enclosed())
 			cout << "</sequence>" << endl;
@@ -443,9 +446,9 @@ bool EmberGenome(EmberOptions& opt)
 			tools.Spin(embers[0], pTemplate, result2, frame    , blend         );
 			tools.Spin(embers[0], pTemplate, result3, frame + 1, blend + spread);
 
-			cout << emberToXml.ToString(result1, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
-			cout << emberToXml.ToString(result2, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
-			cout << emberToXml.ToString(result3, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result1, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result2, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result3, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 		}
 		else
 		{
@@ -459,9 +462,9 @@ bool EmberGenome(EmberOptions& opt)
 			tools.SpinInter(embers.data(), pTemplate, result2, frame    , 0, blend         );
 			tools.SpinInter(embers.data(), pTemplate, result3, frame + 1, 0, blend + spread);
 
-			cout << emberToXml.ToString(result1, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
-			cout << emberToXml.ToString(result2, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
-			cout << emberToXml.ToString(result3, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result1, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result2, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(result3, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 		}
 
 		if (opt.Enclosed())
@@ -495,7 +498,7 @@ bool EmberGenome(EmberOptions& opt)
 				tools.ApplyTemplate(embers[i], *pTemplate);
 
 			tools.Offset(embers[i], T(opt.OffsetX()), T(opt.OffsetY()));
-			cout << emberToXml.ToString(embers[i], opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+			cout << emberToXml.ToBuffer(embers[i], opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
 		}
 
 		if (opt.Enclosed())
@@ -525,6 +528,7 @@ bool EmberGenome(EmberOptions& opt)
 		count = 0;
 		os.str("");
 		save.Clear();
+		flameStats.Clear();
 		VerbosePrint("Flame = " << rep + 1 << "/" << opt.Repeat() << "..");
 
 		if (opt.Clone() != "")
@@ -539,7 +543,7 @@ bool EmberGenome(EmberOptions& opt)
 			aselp0 = &selp0;
 			aselp1 = nullptr;
 			os << tools.TruncateVariations(save, 5);
-			save.m_Edits = emberToXml.CreateNewEditdoc(aselp0, aselp1, os.str(), opt.Nick(), opt.Url(), opt.Id(), opt.Comment(), opt.SheepGen(), opt.SheepId());
+			save.SetEdit(emberToXml.CreateNewEditdoc(aselp0, aselp1, os.str(), opt.Nick(), opt.Url(), opt.Id(), opt.Comment(), opt.SheepGen(), opt.SheepId()));
 		}
 		else
 		{
@@ -686,7 +690,7 @@ bool EmberGenome(EmberOptions& opt)
 					os << " improved colors";
 				}
 
-				orig.m_Edits = emberToXml.CreateNewEditdoc(aselp0, aselp1, os.str(), opt.Nick(), opt.Url(), opt.Id(), opt.Comment(), opt.SheepGen(), opt.SheepId());
+				orig.SetEdit(emberToXml.CreateNewEditdoc(aselp0, aselp1, os.str(), opt.Nick(), opt.Url(), opt.Id(), opt.Comment(), opt.SheepGen(), opt.SheepId()));
 				save = orig;
 				SetDefaultTestValues(orig);
 				renderer->SetEmber(orig);
@@ -697,6 +701,8 @@ bool EmberGenome(EmberOptions& opt)
 					return false;
 				}
 
+				flameStats += renderer->Stats();
+
 				tot = totb = totw = 0;
 				n = orig.m_FinalRasW * orig.m_FinalRasH;
 
@@ -739,15 +745,24 @@ bool EmberGenome(EmberOptions& opt)
 				save.DeleteTotalXform(save.TotalXformCount() - 1);
 		}
 
-		cout << emberToXml.ToString(save, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
-		VerbosePrint("\nDone. Action = " << os.str() << "\n");
+		stageTimer.Tic();
+		xml = emberToXml.ToString(save, opt.Extras(), opt.PrintEditDepth(), !opt.NoEdits(), false, opt.HexPalette());
+		stageTimer.Toc(flameStats.m_EncodeMs, flameStats.m_EncodeCpuMs);
+		stageTimer.Tic();
+		cout << xml;
 		cout.flush();
+		stageTimer.Toc(flameStats.m_WriteMs, flameStats.m_WriteCpuMs);
+		VerbosePrint("\nDone. Action = " << os.str() << "\n");
+		statsJson.Add(save.m_Name, rep, flameStats);
 		save.Clear();
 	}
 
 	if (opt.Enclosed())
 		cout << "</pick>\n";
 
+	if (!opt.StatsJson().empty() && !statsJson.Save(opt.StatsJson()))
+		cerr << "Error writing stats to " << opt.StatsJson() << endl;
+
 	return true;
 }
 
@@ -25,23 +25,30 @@ bool EmberRender(EmberOptions& opt)
 		return true;
 	}
 
-	Timing t;
+	Timing t, stageTimer;
 	bool writeSuccess = false;
 	byte* finalImagep;
 	uint padding;
 	size_t i, channels;
 	size_t strips;
 	size_t iterCount;
+	size_t emberCount;
 	string filename;
 	string inputPath = GetPath(opt.Input());
 	ostringstream os;
 	pair<size_t, size_t> p;
-	vector<Ember<T>> embers;
+	Ember<T> ember;
+	XmlToEmber<T> parser;//Declared before emberStream so it outlives the parsing thread.
+	EmberStream<T> emberStream;
 	vector<byte> finalImage;
+	vector<byte> rgbRows;
+	unique_ptr<RowWriter> rowWriter;
+	std::function<bool(const byte* rows, size_t rowCount)> writeRows;
 	EmberStats stats;
+	IterProfile iterProfile;
+	StatsJson statsJson;
 	EmberReport emberReport;
 	EmberImageComments comments;
-	XmlToEmber<T> parser;
 	EmberToXml<T> emberToXml;
 	vector<QTIsaac<ISAAC_SIZE, ISAAC_INT>> randVec;
 	unique_ptr<RenderProgress<T>> progress(new RenderProgress<T>());
@@ -63,8 +70,25 @@ bool EmberRender(EmberOptions& opt)
 	if (!InitPaletteList<T>(opt.PalettePath()))
 		return false;
 
-	if (!ParseEmberFile(parser, opt.Input(), embers))
-		return false;
+	//For large Xml files with many embers, only count them up front, and parse them on a background thread while
+	//rendering so that rendering the first one can start without waiting for the whole file to be parsed.
+	//Everything else, including binary files which load faster than they could be streamed, is read up front.
+	if (!BinaryToEmber<T>::IsBinaryFile(opt.Input()) &&
+		FileSize(opt.Input()) >= EMBER_STREAM_MIN_BYTES &&
+		(emberCount = XmlToEmber<T>::CountEmbers(opt.Input().c_str())) > 1)
+	{
+		emberStream.Start(parser, opt.Input());
+	}
+	else
+	{
+		vector<Ember<T>> embers;
+
+		if (!ParseEmberFile(parser, opt.Input(), embers))
+			return false;
+
+		emberCount = embers.size();
+		emberStream.Start(embers);
+	}
 
 	if (!opt.EmberCL())
 	{
@@ -124,6 +148,12 @@ bool EmberRender(EmberOptions& opt)
 		opt.BitsPerChannel(8);
 	}
 
+	if (opt.PngCompression() > 9)
+	{
+		cout << "Png compression must be 0-9 not " << opt.PngCompression() << ". Setting to 9." << endl;
+		opt.PngCompression(9);
+	}
+
 	if (opt.InsertPalette() && opt.BitsPerChannel() != 8)
 	{
 		cout << "Inserting palette only supported with 8 bits per channel, insertion will not take place." << endl;
@@ -136,7 +166,7 @@ bool EmberRender(EmberOptions& opt)
 		opt.AspectRatio(1);
 	}
 
-	if (!opt.Out().empty() && (embers.size() > 1))
+	if (!opt.Out().empty() && (emberCount > 1))
 	{
 		cout << "Single output file " << opt.Out() << " specified for multiple images. Changing to use prefix of badname-changethis instead. Always specify prefixes when reading a file with multiple embers." << endl;
 		opt.Out("");
@@ -145,7 +175,7 @@ bool EmberRender(EmberOptions& opt)
 
 	//Final setup steps before running.
 	os.imbue(std::locale(""));
-	padding = uint(log10((double)embers.size())) + 1;
+	padding = uint(log10((double)emberCount)) + 1;
 	renderer->EarlyClip(opt.EarlyClip());
 	renderer->YAxisUp(opt.YAxisUp());
 	renderer->LockAccum(opt.LockAccum());
@@ -154,49 +184,59 @@ bool EmberRender(EmberOptions& opt)
 	renderer->Transparency(opt.Transparency());
 	renderer->NumChannels(channels);
 	renderer->BytesPerChannel(opt.BitsPerChannel() / 8);
+	renderer->TargetNoise(opt.Noise());
+	renderer->MaxIterScale(opt.MaxIterScale());
+	renderer->NumaAware(opt.Numa());
+	HugePages::Policy(eHugePagePolicy(std::min(opt.HugePages(), uint(HUGE_PAGES_EXPLICIT))));
 	renderer->Callback(opt.DoProgress() ? progress.get() : nullptr);
 
-	for (i = 0; i < embers.size(); i++)
+	if (opt.Verbose() && opt.Numa() && !opt.EmberCL())
 	{
-		if (opt.Verbose() && embers.size() > 1)
-			cout << "\nFlame = " << i + 1 << "/" << embers.size() << endl;
-		else if (embers.size() > 1)
+		cout << NumaTopology::Dump(renderer->ThreadCount());
+		cout << "Histogram replicas: " << renderer->NumaReplicas() << endl;
+	}
+
+	for (i = 0; emberStream.Next(ember); i++)
+	{
+		if (opt.Verbose() && emberCount > 1)
+			cout << "\nFlame = " << i + 1 << "/" << emberCount << endl;
+		else if (emberCount > 1)
 			VerbosePrint(endl);
 
 		if (opt.Supersample() > 0)
-			embers[i].m_Supersample = opt.Supersample();
+			ember.m_Supersample = opt.Supersample();
 
 		if (opt.SubBatchSize() != DEFAULT_SBS)
-			embers[i].m_SubBatchSize = opt.SubBatchSize();
+			ember.m_SubBatchSize = opt.SubBatchSize();
 
-		embers[i].m_TemporalSamples = 1;//Force temporal samples to 1 for render.
-		embers[i].m_Quality *= T(opt.QualityScale());
-		embers[i].m_FinalRasW = uint(T(embers[i].m_FinalRasW) * opt.SizeScale());
-		embers[i].m_FinalRasH = uint(T(embers[i].m_FinalRasH) * opt.SizeScale());
-		embers[i].m_PixelsPerUnit *= T(opt.SizeScale());
+		ember.m_TemporalSamples = 1;//Force temporal samples to 1 for render.
+		ember.m_Quality *= T(opt.QualityScale());
+		ember.m_FinalRasW = uint(T(ember.m_FinalRasW) * opt.SizeScale());
+		ember.m_FinalRasH = uint(T(ember.m_FinalRasH) * opt.SizeScale());
+		ember.m_PixelsPerUnit *= T(opt.SizeScale());
 
-		if (embers[i].m_FinalRasW == 0 || embers[i].m_FinalRasH == 0)
+		if (ember.m_FinalRasW == 0 || ember.m_FinalRasH == 0)
 		{
-			cout << "Output image " << i << " has dimension 0: " << embers[i].m_FinalRasW  << ", " << embers[i].m_FinalRasH << ". Setting to 1920 x 1080." << endl;
-			embers[i].m_FinalRasW = 1920;
-			embers[i].m_FinalRasH = 1080;
+			cout << "Output image " << i << " has dimension 0: " << ember.m_FinalRasW  << ", " << ember.m_FinalRasH << ". Setting to 1920 x 1080." << endl;
+			ember.m_FinalRasW = 1920;
+			ember.m_FinalRasH = 1080;
 		}
 
 		//Cast to double in case the value exceeds 2^32.
-		double imageMem = double(renderer->NumChannels()) * double(embers[i].m_FinalRasW)
-			   * double(embers[i].m_FinalRasH) * double(renderer->BytesPerChannel());
+		double imageMem = double(renderer->NumChannels()) * double(ember.m_FinalRasW)
+			   * double(ember.m_FinalRasH) * double(renderer->BytesPerChannel());
 		double maxMem = pow(2.0, double((sizeof(void*) * 8) - 1));
 
 		if (imageMem > maxMem)//Ensure the max amount of memory for a process is not exceeded.
 		{
 			cout << "Image " << i << " size > " << maxMem << ". Setting to 1920 x 1080." << endl;
-			embers[i].m_FinalRasW = 1920;
-			embers[i].m_FinalRasH = 1080;
+			ember.m_FinalRasW = 1920;
+			ember.m_FinalRasH = 1080;
 		}
 
 		stats.Clear();
-		renderer->SetEmber(embers[i]);
-		renderer->PrepFinalAccumVector(finalImage);//Must manually call this first because it could be erroneously made smaller due to strips if called inside Renderer::Run().
+		iterProfile.Clear();
+		renderer->SetEmber(ember);
 
 		if (opt.Strips() > 1)
 		{
@@ -211,11 +251,86 @@ bool EmberRender(EmberOptions& opt)
 				VerbosePrint("Setting strips to " << strips << " with specified memory usage of " << opt.UseMem());
 		}
 
-		strips = VerifyStrips(embers[i].m_FinalRasH, strips,
+		strips = VerifyStrips(ember.m_FinalRasH, strips,
 			[&](const string& s) { cout << s << endl; },//Greater than height.
 			[&](const string& s) { cout << s << endl; },//Mod height != 0.
 			[&](const string& s) { cout << s << endl; });//Final strips value to be set.
 
+		if (!opt.Out().empty())
+		{
+			filename = opt.Out();
+		}
+		else if (opt.NameEnable() && !ember.m_Name.empty())
+		{
+			filename = inputPath + opt.Prefix() + ember.m_Name + opt.Suffix() + "." + opt.Format();
+		}
+		else
+		{
+			ostringstream fnstream;
+
+			fnstream << inputPath << opt.Prefix() << setfill('0') << setw(padding) << i << opt.Suffix() << "." << opt.Format();
+			filename = fnstream.str();
+		}
+
+		//When rendering in strips, write each one to the file as soon as it finishes so that only a single strip needs to be held in memory.
+		//Bmp files are stored bottom up, so they are always written from the full image.
+		rowWriter.reset();
+		writeRows = nullptr;
+
+		if (strips > 1)
+		{
+			if (opt.Format() == "png")
+			{
+				unique_ptr<PngWriter> writer(new PngWriter());
+
+				if (writer->Open(filename.c_str(), ember.m_FinalRasW, ember.m_FinalRasH, opt.BitsPerChannel() / 8, int(opt.PngCompression())))
+					rowWriter = std::move(writer);
+			}
+			else if (opt.Format() == "jpg")
+			{
+				unique_ptr<JpegWriter> writer(new JpegWriter());
+
+				if (writer->Open(filename.c_str(), ember.m_FinalRasW, ember.m_FinalRasH, opt.JpegQuality()))
+					rowWriter = std::move(writer);
+			}
+			else if (opt.Format() == "ppm")
+			{
+				unique_ptr<PpmWriter> writer(new PpmWriter());
+
+				if (writer->Open(filename.c_str(), ember.m_FinalRasW, ember.m_FinalRasH))
+					rowWriter = std::move(writer);
+			}
+		}
+
+		if (rowWriter.get())
+		{
+			vector<byte>().swap(finalImage);//Run() will allocate the size of a single strip.
+			writeRows = [&](const byte* rows, size_t rowCount) -> bool
+			{
+				stageTimer.Tic();
+
+				//Jpg and ppm are written with 3 channels, but some renderers, such as OpenCL, always output 4.
+				if (opt.Format() != "png" && renderer->NumChannels() == 4)
+				{
+					rgbRows.resize(ember.m_FinalRasW * rowCount * 3);
+					RgbaToRgb(rows, rgbRows.data(), ember.m_FinalRasW, rowCount);
+					rows = rgbRows.data();
+				}
+
+				writeSuccess = rowWriter->WriteRows(rows, rowCount);
+				stageTimer.Toc(stats.m_WriteMs, stats.m_WriteCpuMs);
+
+				if (!writeSuccess)
+					cout << "Error writing " << filename << endl;
+
+				return writeSuccess;
+			};
+		}
+		else
+		{
+			renderer->PrepFinalAccumVector(finalImage);//Must manually call this first because it could be erroneously made smaller due to strips if called inside Renderer::Run().
+		}
+
 		//For testing incremental renderer.
 		//int sb = 1;
 		//bool resume = false, success = false;
@@ -227,7 +342,7 @@ bool EmberRender(EmberOptions& opt)
 		//}
 		//while (success && renderer->ProcessState() != ACCUM_DONE);
 
-		StripsRender<T>(renderer.get(), embers[i], finalImage, 0, strips, opt.YAxisUp(),
+		StripsRender<T>(renderer.get(), ember, finalImage, 0, strips, opt.YAxisUp(),
 		[&](size_t strip)//Pre strip.
 		{
 			if (opt.Verbose() && (strips > 1) && strip > 0)
@@ -240,33 +355,26 @@ bool EmberRender(EmberOptions& opt)
 		{
 			progress->Clear();
 			stats += renderer->Stats();
+
+			if (IterProfile::Enabled())
+				iterProfile += renderer->IterationProfile();
 		},
 		[&](size_t strip)//Error.
 		{
 			cout << "Error: image rendering failed, skipping to next image." << endl;
 			renderer->DumpErrorReport();//Something went wrong, print errors.
+
+			if (rowWriter.get())//Discard the partially written file.
+			{
+				rowWriter.reset();
+				remove(filename.c_str());
+			}
 		},
 		//Final strip.
 		//Original wrote every strip as a full image which could be very slow with many large images.
-		//Only write once all strips for this image are finished.
+		//Only write once all strips for this image are finished, unless they were already streamed to the file.
 		[&](Ember<T>& finalEmber)
 		{
-			if (!opt.Out().empty())
-			{
-				filename = opt.Out();
-			}
-			else if (opt.NameEnable() && !finalEmber.m_Name.empty())
-			{
-				filename = inputPath + opt.Prefix() + finalEmber.m_Name + opt.Suffix() + "." + opt.Format();
-			}
-			else
-			{
-				ostringstream fnstream;
-
-				fnstream << inputPath << opt.Prefix() << setfill('0') << setw(padding) << i << opt.Suffix() << "." << opt.Format();
-				filename = fnstream.str();
-			}
-
 			//TotalIterCount() is actually using ScaledQuality() which does not get reset upon ember assignment,
 			//so it ends up using the correct value for quality * strips.
 			iterCount = renderer->TotalIterCount(1);
@@ -276,19 +384,39 @@ bool EmberRender(EmberOptions& opt)
 
 			VerbosePrint("\nIters ran/requested: " + os.str());
 			VerbosePrint("Bad values: " << stats.m_Badvals);
+
+			if (comments.m_Noise != "")
+			{
+				VerbosePrint("Noise: " + comments.m_Noise);
+				VerbosePrint("Iters saved: " + comments.m_ItersSaved);
+			}
+
 			VerbosePrint("Render time: " + t.Format(stats.m_RenderMs));
 			VerbosePrint("Pure iter time: " + t.Format(stats.m_IterMs));
+			VerbosePrint("Huge page memory: explicit " << (HugePages::ExplicitBytes() / (1024 * 1024)) << "MB, transparent " << (HugePages::TransparentBytes() / (1024 * 1024)) << "MB");
 			VerbosePrint("Iters/sec: " << size_t(stats.m_Iters / (stats.m_IterMs / 1000.0)) << endl);
+
+			if (!iterProfile.Empty())
+				VerbosePrint(iterProfile.Report(finalEmber));
+
 			VerbosePrint("Writing " + filename);
+			stageTimer.Tic();
 
-			if ((opt.Format() == "jpg" || opt.Format() == "bmp") && renderer->NumChannels() == 4)
+			if ((opt.Format() == "jpg" || opt.Format() == "ppm" || opt.Format() == "bmp") && renderer->NumChannels() == 4 && !rowWriter.get())
 				RgbaToRgb(finalImage, finalImage, renderer->FinalRasW(), renderer->FinalRasH());
 
 			finalImagep = finalImage.data();
 			writeSuccess = false;
+			stageTimer.Toc(stats.m_EncodeMs, stats.m_EncodeCpuMs);
+			stageTimer.Tic();
 
-			if (opt.Format() == "png")
-				writeSuccess = WritePng(filename.c_str(), finalImagep, finalEmber.m_FinalRasW, finalEmber.m_FinalRasH, opt.BitsPerChannel() / 8, opt.PngComments(), comments, opt.Id(), opt.Url(), opt.Nick());
+			if (rowWriter.get())
+			{
+				writeSuccess = rowWriter->Finish(opt.Format() == "png" ? opt.PngComments() : opt.JpegComments(), comments, opt.Id(), opt.Url(), opt.Nick());
+				rowWriter.reset();
+			}
+			else if (opt.Format() == "png")
+				writeSuccess = WritePng(filename.c_str(), finalImagep, finalEmber.m_FinalRasW, finalEmber.m_FinalRasH, opt.BitsPerChannel() / 8, opt.PngComments(), comments, opt.Id(), opt.Url(), opt.Nick(), int(opt.PngCompression()));
 			else if (opt.Format() == "jpg")
 				writeSuccess = WriteJpeg(filename.c_str(), finalImagep, finalEmber.m_FinalRasW, finalEmber.m_FinalRasH, opt.JpegQuality(), opt.JpegComments(), comments, opt.Id(), opt.Url(), opt.Nick());
 			else if (opt.Format() == "ppm")
@@ -296,9 +424,13 @@ bool EmberRender(EmberOptions& opt)
 			else if (opt.Format() == "bmp")
 				writeSuccess = WriteBmp(filename.c_str(), finalImagep, finalEmber.m_FinalRasW, finalEmber.m_FinalRasH);
 
+			stageTimer.Toc(stats.m_WriteMs, stats.m_WriteCpuMs);
+
 			if (!writeSuccess)
 				cout << "Error writing " << filename << endl;
-		});
+
+			statsJson.Add(filename, i, stats);
+		}, writeRows);
 
 		if (opt.EmberCL() && opt.DumpKernel())
 			cout << "Iteration kernel: \n" << reinterpret_cast<RendererCL<T>*>(renderer.get())->IterKernel() << endl;
@@ -306,6 +438,16 @@ bool EmberRender(EmberOptions& opt)
 		VerbosePrint("Done.");
 	}
 
+	if (!emberStream.Finish())
+	{
+		cout << "Error parsing flame file " << opt.Input() << ", not all flames were rendered." << endl;
+		parser.DumpErrorReport();
+		return false;
+	}
+
+	if (!opt.StatsJson().empty() && !statsJson.Save(opt.StatsJson()))
+		cout << "Error writing stats to " << opt.StatsJson() << endl;
+
 	if (opt.Verbose())
 		t.Toc("\nTotal time: ", true);
 
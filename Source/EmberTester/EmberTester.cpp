@@ -1260,64 +1260,109 @@ static int SortPairByTime(const pair<string, double>& a, pair<string, double>& b
 	return a.second < b.second;
 }
 
+/// <summary>
+/// Time every variation in regular, pre and post form, and write one CSV row per variation with
+/// the columns precision,name,id,type,ns_per_call,bad_pct.
+/// Each variation is placed alone in an xform with its default parameters and a fixed affine, and
+/// the time is for all of Xform::Apply(), since that includes the precalcs and the pre/post assignment
+/// which the iterator pays for each form. The first row, named none, is an xform without variations
+/// which gives the overhead of Apply() itself.
+/// The inputs are points on the attractor of a basic flame rather than uniform noise, so the
+/// magnitudes and branches taken are close to what a render sees. They are all run once untimed
+/// to warm the caches, then timed in batches, keeping the fastest batch to filter out preemption.
+/// </summary>
+/// <param name="os">The stream to write the rows to</param>
+/// <param name="points">The number of input points</param>
+/// <param name="batches">The number of timed passes over the input points</param>
 template <typename T>
-void TestVarTime()
+void TestVarTime(ostream& os, size_t points, size_t batches)
 {
-	int i = 0, iters = 10;
-	Timing t;
-	VariationList<T> vlf;
-	IteratorHelper<T> helper;
+	size_t fuse = 0;
+	VariationList<T> varList;
 	QTIsaac<ISAAC_SIZE, ISAAC_INT> rand;
-	vector<pair<string, double>> times;
-
-	times.reserve(vlf.RegSize());
-
-	while (i < vlf.RegSize())
+	Ember<T> ember = CreateBasicEmber<T>(640, 480, 1, 1, 0, 0, 0);
+	vector<Point<T>> inPoints;
+	Point<T> p, out;
+	eVariationType types[] = { VARTYPE_REG, VARTYPE_PRE, VARTYPE_POST };
+	const char* typeNames[] = { "reg", "pre", "post" };
+	const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+	auto timeXform = [&](Xform<T>& xform, const string& name, intmax_t id, const char* typeName)
 	{
-		double sum = 0;
-		Xform<T> xform;
-		Variation<T>* var = vlf.GetVariationCopy(i, VARTYPE_REG);
-		
-		xform.AddVariation(var);
+		size_t bad = 0;
+		double best = std::numeric_limits<double>::max();
 
-		for (int iter = 0; iter < iters; iter++)
+		for (auto& in : inPoints)//Warm up.
+			bad += xform.Apply(&in, &out, rand);
+
+		for (size_t batch = 0; batch < batches; batch++)
 		{
-			Point<T> p;
-
-			xform.m_Affine.A(rand.Frand<T>(-5, 5));
-			xform.m_Affine.B(rand.Frand<T>(-5, 5));
-			xform.m_Affine.C(rand.Frand<T>(-5, 5));
-			xform.m_Affine.D(rand.Frand<T>(-5, 5));
-			xform.m_Affine.E(rand.Frand<T>(-5, 5));
-			xform.m_Affine.F(rand.Frand<T>(-5, 5));
-			p.m_X = rand.Frand<T>(-20, 20);
-			p.m_Y = rand.Frand<T>(-20, 20);
-			p.m_Z = rand.Frand<T>(-20, 20);
-			helper.In.x = helper.m_TransX = (xform.m_Affine.A() * p.m_X) + (xform.m_Affine.B() * p.m_Y) + xform.m_Affine.C();
-			helper.In.y = helper.m_TransY = (xform.m_Affine.D() * p.m_X) + (xform.m_Affine.E() * p.m_Y) + xform.m_Affine.F();
-			helper.In.z = helper.m_TransZ = p.m_Z;
-			helper.m_Color.x = p.m_ColorX = rand.Frand01<T>();
-			p.m_VizAdjusted = rand.Frand01<T>();
+			auto start = Clock::now();
 
-			helper.m_PrecalcSumSquares = SQR(helper.m_TransX) + SQR(helper.m_TransY);
-			helper.m_PrecalcSqrtSumSquares = sqrt(helper.m_PrecalcSumSquares);
-			helper.m_PrecalcSina = helper.m_TransX / helper.m_PrecalcSqrtSumSquares;
-			helper.m_PrecalcCosa = helper.m_TransY / helper.m_PrecalcSqrtSumSquares;	
-			helper.m_PrecalcAtanxy = atan2(helper.m_TransX, helper.m_TransY);
-			helper.m_PrecalcAtanyx = atan2(helper.m_TransY, helper.m_TransX);
+			for (auto& in : inPoints)
+				bad += xform.Apply(&in, &out, rand);
 
-			var->Random(rand);
-			t.Tic();
-			var->Func(helper, p, rand);
-			sum += t.Toc();
+			best = std::min(best, duration<double, std::nano>(Clock::now() - start).count());
 		}
 
-		i++;
-		times.push_back(pair<string, double>(var->Name(), sum / iters));
+		os << precision << "," << name << "," << id << "," << typeName << "," << (best / points) << "," << ((100.0 * bad) / (points * (batches + 1))) << endl;
+	};
+
+	ember.CacheXforms();
+	inPoints.reserve(points);
+	p.m_X = rand.Frand11<T>();
+	p.m_Y = rand.Frand11<T>();
+	p.m_Z = 0;
+	p.m_ColorX = rand.Frand01<T>();
+
+	while (inPoints.size() < points)
+	{
+		if (ember.GetXform(rand.Rand(ember.XformCount()))->Apply(&p, &out, rand))
+		{
+			out.m_X = rand.Frand11<T>();//Start over from a new random point, like the iterator does.
+			out.m_Y = rand.Frand11<T>();
+			fuse = 0;
+		}
+
+		p = out;
+
+		if (++fuse > 20)
+			inPoints.push_back(p);
+	}
+
+	Xform<T> none(1, T(0.5), T(0.5), 1, T(0.8), T(-0.3), T(0.3), T(0.8), T(0.1), T(-0.1));
+	timeXform(none, "none", -1, "none");
+
+	for (size_t type = 0; type < 3; type++)
+	{
+		size_t count = types[type] == VARTYPE_REG ? varList.RegSize() : types[type] == VARTYPE_PRE ? varList.PreSize() : varList.PostSize();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			Xform<T> xform(1, T(0.5), T(0.5), 1, T(0.8), T(-0.3), T(0.3), T(0.8), T(0.1), T(-0.1));
+			Variation<T>* var = varList.GetVariationCopy(i, types[type]);
+
+			xform.AddVariation(var);
+			timeXform(xform, var->Name(), intmax_t(var->VariationId()), typeNames[type]);
+		}
 	}
+}
 
-	std::sort(times.begin(), times.end(), &SortPairByTime);
-	//forr (auto& p : times) cout << p.first << "\t" << p.second << "" << endl;
+/// <summary>
+/// Run TestVarTime() for float and double, and save the results to a single CSV file.
+/// </summary>
+/// <param name="filename">The full path and name of the file to save</param>
+/// <param name="points">The number of input points</param>
+/// <param name="batches">The number of timed passes over the input points</param>
+void TestVarTimeCsv(const string& filename, size_t points = 4096, size_t batches = 10)
+{
+	ofstream file(filename);
+
+	file.imbue(std::locale::classic());
+	file << "precision,name,id,type,ns_per_call,bad_pct" << endl;
+	TestVarTime<float>(file, points, batches);
+#ifdef DO_DOUBLE
+	TestVarTime<double>(file, points, batches);
+#endif
 }
 
 void TestCasting()
@@ -1785,6 +1830,849 @@ void TestRandomAccess(size_t vsize, size_t ipp, bool cache)
 	}
 }
 
+/// <summary>
+/// Render the same large flame once with each huge page policy and print the iteration speed of each.
+/// The raster should be large enough that the histogram is far bigger than what the TLB covers with 4KB pages,
+/// such as 4000x4000 with a supersample of 2.
+/// Explicit huge pages require them to be reserved beforehand, such as with: echo 2048 > /proc/sys/vm/nr_hugepages
+/// </summary>
+/// <param name="width">The width of the final image</param>
+/// <param name="height">The height of the final image</param>
+/// <param name="ss">The supersample value</param>
+/// <param name="quality">The quality value</param>
+template <typename T>
+void TestHugePages(uint width, uint height, uint ss, T quality)
+{
+	Ember<T> ember = CreateBasicEmber<T>(width, height, ss, quality, 0, 0, 0);
+	eHugePagePolicy policies[] = { HUGE_PAGES_NONE, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT };
+	const char* names[] = { "None", "Transparent", "Explicit" };
+	eHugePagePolicy oldPolicy = HugePages::Policy();
+	vector<byte> finalImage;
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		HugePages::Policy(policies[i]);
+
+		//Use a new renderer each time so all buffers are allocated with the current policy.
+		unique_ptr<Renderer<T, T>> renderer(new Renderer<T, T>());
+
+		renderer->SetEmber(ember);
+
+		if (renderer->Run(finalImage) == RENDER_OK)
+		{
+			EmberStats stats = renderer->Stats();
+
+			cout << names[i] << " huge pages: explicit " << (HugePages::ExplicitBytes() / (1024 * 1024)) << "MB, transparent " << (HugePages::TransparentBytes() / (1024 * 1024)) << "MB" << endl;
+			cout << "\tIters/sec: " << size_t(stats.m_Iters / (stats.m_IterMs / 1000.0)) << ", render time: " << stats.m_RenderMs << "ms" << endl;
+		}
+		else
+			cout << names[i] << " huge pages: render failed" << endl;
+	}
+
+	HugePages::Policy(oldPolicy);
+}
+
+/// <summary>
+/// Measure how many embers per second can be copied, moved, and pushed onto a growing vector.
+/// The ember is given an edit history of the specified depth, the way one would have
+/// after many generations of mutation and saving, since copying it used to mean copying the whole doc.
+/// </summary>
+/// <param name="count">The number of copies to make for each measurement</param>
+/// <param name="editDepth">The number of nested edits to give the ember</param>
+template <typename T>
+void TestEmberCopy(size_t count, size_t editDepth)
+{
+	Timing t;
+	EmberToXml<T> writer;
+	Ember<T> ember = CreateBasicEmber<T>(640, 480, 1, 100, 0, 0, 0);
+	vector<Ember<T>> embers;
+
+	for (size_t i = 0; i < editDepth; i++)
+		ember.SetEdit(writer.CreateNewEditdoc(&ember, nullptr, "edit", "nick", "url", "id", "comment"));
+
+	embers.reserve(count);
+	t.Tic();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		Ember<T> copy(ember);
+		embers.push_back(copy);//Copy again rather than move.
+	}
+
+	double copyMs = t.Toc();
+
+	t.Tic();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		Ember<T> moved(std::move(embers[i]));
+		embers[i] = std::move(moved);
+	}
+
+	double moveMs = t.Toc();
+	vector<Ember<T>> grown;
+
+	t.Tic();
+
+	for (size_t i = 0; i < count; i++)
+		grown.push_back(embers[i]);//Growing moves the existing embers rather than copying them.
+
+	double growMs = t.Toc();
+
+	cout << "Ember<" << sizeof(T) * 8 << "> with " << ember.TotalXformCount() << " xforms and an edit depth of " << editDepth << ":" << endl;
+	cout << "\tCopies/sec: " << size_t((count * 2) / (copyMs / 1000.0)) << endl;
+	cout << "\tMoves/sec: " << size_t((count * 2) / (moveMs / 1000.0)) << endl;
+	cout << "\tVector push_back/sec: " << size_t(count / (growMs / 1000.0)) << endl;
+}
+
+/// <summary>
+/// Measure how many variations per second can be cloned and deleted the way xforms do when
+/// embers are copied, interpolated and mutated, and print how much memory VariationPool holds.
+/// To compare against the heap, remove operator new and delete from Variation and run again.
+/// </summary>
+/// <param name="rounds">The number of times to clone and delete every variation</param>
+template <typename T>
+void TestVariationPool(size_t rounds)
+{
+	Timing t;
+	VariationList<T> varList;
+	vector<Variation<T>*> vars;
+
+	vars.reserve(varList.Size());
+	t.Tic();
+
+	for (size_t i = 0; i < rounds; i++)
+	{
+		for (size_t j = 0; j < varList.Size(); j++)
+			vars.push_back(varList.GetVariationCopy(j));
+
+		ClearVec(vars);
+	}
+
+	double ms = t.Toc();
+
+	cout << "Variation<" << sizeof(T) * 8 << "> clone and delete/sec: " << size_t((rounds * varList.Size()) / (ms / 1000.0)) << endl;
+	cout << "\tPool blocks in use: " << VariationPool::BlocksInUse() << ", chunk memory: " << (VariationPool::ChunkBytes() / 1024) << "KB" << endl;
+}
+
+/// <summary>
+/// Measure how many small render jobs per second can be done when creating a new renderer
+/// for each, versus leasing a warm one from a RendererPool.
+/// </summary>
+/// <param name="jobs">The number of jobs to render each way</param>
+/// <param name="width">The width of each job</param>
+/// <param name="height">The height of each job</param>
+template <typename T>
+void TestRendererPool(size_t jobs, uint width, uint height)
+{
+	Timing t;
+	EmberReport report;
+	RendererPool<T, T> pool(CPU_RENDERER, 0, 0);
+	Ember<T> ember = CreateBasicEmber<T>(width, height, 1, 10, 0, 0, 0);
+	vector<byte> finalImage;
+
+	t.Tic();
+
+	for (size_t i = 0; i < jobs; i++)
+	{
+		unique_ptr<Renderer<T, T>> renderer(CreateRenderer<T, T>(CPU_RENDERER, 0, 0, false, 0, report));
+
+		renderer->SetEmber(ember);
+		renderer->Run(finalImage);
+	}
+
+	double newMs = t.Toc();
+
+	pool.Warm(1, width, height);
+	t.Tic();
+
+	for (size_t i = 0; i < jobs; i++)
+	{
+		Renderer<T, T>* renderer = pool.Lease(ember);
+
+		renderer->SetEmber(ember);
+		renderer->Run(finalImage);
+		pool.Return(renderer);
+	}
+
+	double poolMs = t.Toc();
+
+	cout << "Render jobs/sec at " << width << "x" << height << ", new renderer: " << (jobs / (newMs / 1000.0)) << ", pooled renderer: " << (jobs / (poolMs / 1000.0)) << endl;
+}
+
+template <typename T>
+void TestFilterCache(size_t frames, size_t settings)
+{
+	Timing t;
+	size_t hits = FilterCache<T>::Hits();
+
+	//Simulate an animation whose frames cycle through a few filter settings, first creating every filter, then using the cache.
+	t.Tic();
+
+	for (size_t i = 0; i < frames; i++)
+	{
+		T rad = T(i % settings) + 1;
+		DensityFilter<T> de(0, rad * 3, T(0.4), 2);
+		unique_ptr<SpatialFilter<T>> spatial(SpatialFilterCreator<T>::Create(GAUSSIAN_SPATIAL_FILTER, rad / 2, 2, 1));
+
+		de.Create();
+	}
+
+	double createMs = t.Toc();
+
+	t.Tic();
+
+	for (size_t i = 0; i < frames; i++)
+	{
+		T rad = T(i % settings) + 1;
+		auto de = FilterCache<T>::GetDensityFilter(0, rad * 3, T(0.4), 2);
+		auto spatial = FilterCache<T>::GetSpatialFilter(GAUSSIAN_SPATIAL_FILTER, rad / 2, 2, 1);
+	}
+
+	double cacheMs = t.Toc();
+
+	cout << "Filters for " << frames << " frames cycling through " << settings << " settings, created: " << createMs << "ms, cached: " << cacheMs << "ms, cache hits: " << (FilterCache<T>::Hits() - hits) << endl;
+}
+
+/// <summary>
+/// Parse a flame file, save it in the binary format, read it back and check that every ember
+/// produces exactly the same Xml as the one it was saved from, including edits.
+/// Also print how long parsing the Xml and reading the binary file took.
+/// </summary>
+/// <param name="filename">The flame file to test with</param>
+/// <param name="binFilename">The binary file to write, which is overwritten</param>
+/// <returns>True if all embers round tripped, else false.</returns>
+template <typename T>
+bool TestBinaryRoundTrip(const string& filename, const string& binFilename)
+{
+	bool b = true;
+	Timing t;
+	XmlToEmber<T> parser;
+	EmberToXml<T> writer;
+	EmberToBinary<T> binWriter;
+	BinaryToEmber<T> binReader;
+	vector<Ember<T>> embers, binEmbers;
+
+	if (!InitPaletteList<T>("flam3-palettes.xml"))
+		return false;
+
+	t.Tic();
+
+	if (!parser.Parse(filename.c_str(), embers))
+	{
+		cout << "Failed to parse " << filename << endl;
+		return false;
+	}
+
+	double xmlMs = t.Toc();
+
+	if (!binWriter.Save(binFilename, embers))
+	{
+		binWriter.DumpErrorReport();
+		return false;
+	}
+
+	t.Tic();
+
+	if (!binReader.Load(binFilename, binEmbers))
+	{
+		binReader.DumpErrorReport();
+		return false;
+	}
+
+	double binMs = t.Toc();
+
+	if (binEmbers.size() != embers.size())
+	{
+		cout << "Read " << binEmbers.size() << " embers from " << binFilename << ", expected " << embers.size() << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < embers.size(); i++)
+	{
+		string xml = writer.ToString(embers[i], "", 0, true, false, true);
+		string binXml = writer.ToString(binEmbers[i], "", 0, true, false, true);
+
+		if (xml != binXml || embers[i].m_Hue != binEmbers[i].m_Hue || embers[i].m_OrigFinalRasW != binEmbers[i].m_OrigFinalRasW)
+		{
+			cout << "Ember " << i << " (" << embers[i].m_Name << ") differs after the round trip:" << endl << xml << endl << binXml << endl;
+			b = false;
+		}
+	}
+
+	cout << embers.size() << " embers of " << sizeof(T) * 8 << " bits, parsing Xml: " << xmlMs << "ms, reading binary: " << binMs << "ms, round trip " << (b ? "succeeded" : "failed") << endl;
+	return b;
+}
+
+/// <summary>
+/// Test that the palettes read from a palette cache are the same as those parsed from the Xml,
+/// and print how long each took.
+/// The existing cache is deleted first, so the first read parses the Xml and writes it.
+/// </summary>
+/// <param name="filename">The Xml palette file to test with</param>
+/// <returns>True if all palettes matched, else false.</returns>
+template <typename T>
+bool TestPaletteCache(const string& filename)
+{
+	bool b = true;
+	Timing t;
+	PaletteList<T> paletteList;
+	vector<Palette<T>> parsed;
+
+	paletteList.Clear();
+	remove(PaletteCache::Filename(filename).c_str());
+	t.Tic();
+
+	if (!paletteList.Add(filename))
+	{
+		paletteList.DumpErrorReport();
+		return false;
+	}
+
+	double xmlMs = t.Toc();
+
+	for (size_t i = 0; i < paletteList.Size(filename); i++)
+		parsed.push_back(*paletteList.GetPalette(filename, int(i)));
+
+	paletteList.Clear();
+	t.Tic();
+
+	if (!paletteList.Add(filename))
+	{
+		paletteList.DumpErrorReport();
+		return false;
+	}
+
+	double cacheMs = t.Toc();
+
+	if (paletteList.Size(filename) != parsed.size())
+	{
+		cout << "Read " << paletteList.Size(filename) << " palettes from the cache, expected " << parsed.size() << endl;
+		return false;
+	}
+
+	t.Tic();
+
+	for (size_t i = 0; i < parsed.size(); i++)
+	{
+		Palette<T>* palette = paletteList.GetPalette(filename, int(i));
+
+		if (palette->m_Index != parsed[i].m_Index || palette->m_Name != parsed[i].m_Name || palette->m_Entries != parsed[i].m_Entries)
+		{
+			cout << "Palette " << i << " (" << parsed[i].m_Name << ") differs when read from the cache" << endl;
+			b = false;
+		}
+	}
+
+	double loadMs = t.Toc();
+	cout << parsed.size() << " palettes of " << sizeof(T) * 8 << " bits, parsing Xml: " << xmlMs << "ms, opening cache: " << cacheMs << "ms, loading all from cache: " << loadMs << "ms, " << (b ? "all matched" : "mismatch") << endl;
+	return b;
+}
+
+/// <summary>
+/// Test that embers saved to Xml read back as exactly the same values, and print how long
+/// converting them one at a time and saving them in parallel took.
+/// Every ember in the file is repeated so that there are enough of them to time.
+/// </summary>
+/// <param name="filename">The flame file to test with</param>
+/// <param name="outFilename">The file to save to, which is overwritten</param>
+/// <param name="repeat">The number of times to repeat the embers in the file</param>
+/// <returns>True if all embers round tripped, else false.</returns>
+template <typename T>
+bool TestXmlRoundTrip(const string& filename, const string& outFilename, size_t repeat)
+{
+	bool b = true;
+	size_t bytes = 0;
+	Timing t;
+	XmlToEmber<T> parser;
+	EmberToXml<T> writer;
+	vector<Ember<T>> embers, parsed, reparsed;
+
+	if (!InitPaletteList<T>("flam3-palettes.xml"))
+		return false;
+
+	if (!parser.Parse(filename.c_str(), parsed))
+	{
+		cout << "Failed to parse " << filename << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < repeat; i++)
+		embers.insert(embers.end(), parsed.begin(), parsed.end());
+
+	t.Tic();
+
+	for (auto& ember : embers)
+		bytes += writer.ToString(ember, "", 0, true, false, true).size();
+
+	double toStringMs = t.Toc();
+	t.Tic();
+
+	if (!writer.Save(outFilename, embers, 0, true, false, true))
+		return false;
+
+	double saveMs = t.Toc();
+
+	if (!parser.Parse(outFilename.c_str(), reparsed) || reparsed.size() != embers.size())
+	{
+		cout << "Failed to parse " << outFilename << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < embers.size(); i++)
+	{
+		string xml = writer.ToString(embers[i], "", 0, true, false, true);
+		string reXml = writer.ToString(reparsed[i], "", 0, true, false, true);
+
+		if (xml != reXml || embers[i].m_CenterX != reparsed[i].m_CenterX || embers[i].m_PixelsPerUnit != reparsed[i].m_PixelsPerUnit)
+		{
+			cout << "Ember " << i << " (" << embers[i].m_Name << ") differs after the round trip:" << endl << xml << endl << reXml << endl;
+			b = false;
+			break;
+		}
+	}
+
+	cout << embers.size() << " embers of " << sizeof(T) * 8 << " bits, " << bytes << " bytes, ToString(): " << toStringMs << "ms, Save(): " << saveMs << "ms, round trip " << (b ? "succeeded" : "failed") << endl;
+	return b;
+}
+
+/// <summary>
+/// Return the Xml for a file of embers with comments and CDATA sections before, between and after them,
+/// several of which contain flame elements that must not be parsed or counted.
+/// The first and second to last embers are set to smooth interpolation, which every parser must
+/// change to linear, so comparing the results also checks that the same fixups were applied.
+/// </summary>
+/// <param name="embers">The embers to write, whose interpolation is changed</param>
+/// <returns>The Xml text</returns>
+template <typename T>
+string CommentedFlamesXml(vector<Ember<T>>& embers)
+{
+	EmberToXml<T> writer;
+	ostringstream os;
+
+	if (!embers.empty())
+		embers[0].m_Interp = EMBER_INTERP_SMOOTH;
+
+	if (embers.size() > 1)
+		embers[embers.size() - 2].m_Interp = EMBER_INTERP_SMOOTH;
+
+	os << "<!-- Before the root. <flame name=\"prolog\"></flame> -->\n";
+	os << "<flames>\n";
+	os << "<![CDATA[ <flame name=\"cdata\"> </flame> ]]>\n";
+
+	for (size_t i = 0; i < embers.size(); i++)
+	{
+		os << writer.ToString(embers[i], "", 0, true, false, true);
+		os << "<!-- <flame name=\"commented out " << i << "\">\n</flame> -->\n";
+	}
+
+	os << "</flames>\n";
+	os << "<!-- After the root. <flame name=\"epilog\"/> -->\n";
+	return os.str();
+}
+
+/// <summary>
+/// Write text to a file, replacing it if it exists.
+/// </summary>
+/// <param name="filename">The file to write</param>
+/// <param name="text">The text to write</param>
+/// <returns>True if success, else false.</returns>
+bool WriteTextFile(const string& filename, const string& text)
+{
+	ofstream file(filename, ios::binary);
+
+	file << text;
+	return bool(file);
+}
+
+/// <summary>
+/// Return whether two sets of embers are the same, printing the first which differs.
+/// </summary>
+/// <param name="embers">The expected embers</param>
+/// <param name="other">The embers to check</param>
+/// <param name="name">The name of the method which produced other, for printing</param>
+/// <returns>True if they are the same, else false.</returns>
+template <typename T>
+bool SameEmbers(vector<Ember<T>>& embers, vector<Ember<T>>& other, const string& name)
+{
+	EmberToXml<T> writer;
+
+	if (other.size() != embers.size())
+	{
+		cout << name << " returned " << other.size() << " embers, expected " << embers.size() << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < embers.size(); i++)
+	{
+		string xml = writer.ToString(embers[i], "", 0, true, false, true);
+		string otherXml = writer.ToString(other[i], "", 0, true, false, true);
+
+		if (xml != otherXml || embers[i].m_Interp != other[i].m_Interp || embers[i].m_Index != other[i].m_Index || embers[i].m_ParentFilename != other[i].m_ParentFilename)
+		{
+			cout << "Ember " << i << " (" << embers[i].m_Name << ") from " << name << " differs from Parse():" << endl << xml << endl << otherXml << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Test that ParseStream(), EmberStream and CountEmbers() agree with Parse() on a file whose embers are
+/// surrounded by comments and CDATA sections containing flame elements, and that a truncated file is
+/// reported as an error by all of them.
+/// </summary>
+/// <param name="filename">The flame file to take the embers from, which should contain at least 3</param>
+/// <param name="outFilename">The file to write the test Xml to, which is overwritten</param>
+/// <returns>True if all agreed, else false.</returns>
+template <typename T>
+bool TestEmberStream(const string& filename, const string& outFilename)
+{
+	bool b = true;
+	XmlToEmber<T> parser, streamParser;
+	EmberToXml<T> writer;
+	vector<Ember<T>> source, embers, streamed, queued;
+	Ember<T> ember;
+
+	if (!InitPaletteList<T>("flam3-palettes.xml"))
+		return false;
+
+	if (!parser.Parse(filename.c_str(), source))
+	{
+		cout << "Failed to parse " << filename << endl;
+		return false;
+	}
+
+	string xml = CommentedFlamesXml(source);
+
+	if (!WriteTextFile(outFilename, xml) || !parser.Parse(outFilename.c_str(), embers))
+	{
+		cout << "Failed to parse " << outFilename << endl;
+		return false;
+	}
+
+	if (!parser.ParseStream(outFilename.c_str(), [&](Ember<T>& e) -> bool { streamed.push_back(e); return true; }))
+	{
+		cout << "ParseStream() failed on " << outFilename << endl;
+		b = false;
+	}
+
+	b &= SameEmbers(embers, streamed, "ParseStream()");
+	{
+		EmberStream<T> emberStream;
+
+		emberStream.Start(streamParser, outFilename);
+
+		while (emberStream.Next(ember))
+			queued.push_back(ember);
+
+		if (!emberStream.Finish())
+		{
+			cout << "EmberStream failed on " << outFilename << endl;
+			b = false;
+		}
+	}
+	b &= SameEmbers(embers, queued, "EmberStream");
+
+	if (XmlToEmber<T>::CountEmbers(outFilename.c_str()) != embers.size())
+	{
+		cout << "CountEmbers() returned " << XmlToEmber<T>::CountEmbers(outFilename.c_str()) << ", expected " << embers.size() << endl;
+		b = false;
+	}
+
+	//Cut the file off in the middle of the last ember. Search for its Xml rather than a start tag, since the comments contain those too.
+	string last = writer.ToString(source.back(), "", 0, true, false, true);
+	size_t cut = xml.rfind(last);
+
+	if (cut == string::npos || !WriteTextFile(outFilename, xml.substr(0, cut + last.size() / 2)))
+		return false;
+
+	streamed.clear();
+	queued.clear();
+
+	if (parser.Parse(outFilename.c_str(), embers))
+	{
+		cout << "Parse() succeeded on a truncated file" << endl;
+		b = false;
+	}
+
+	if (parser.ParseStream(outFilename.c_str(), [&](Ember<T>& e) -> bool { streamed.push_back(e); return true; }) || parser.ErrorReport().empty())
+	{
+		cout << "ParseStream() succeeded on a truncated file" << endl;
+		b = false;
+	}
+	{
+		EmberStream<T> emberStream;
+
+		emberStream.Start(streamParser, outFilename);
+
+		while (emberStream.Next(ember))
+			queued.push_back(ember);
+
+		if (emberStream.Finish())
+		{
+			cout << "EmberStream succeeded on a truncated file" << endl;
+			b = false;
+		}
+	}
+
+	cout << "ParseStream(), EmberStream and CountEmbers() with " << sizeof(T) * 8 << " bits " << (b ? "matched Parse()" : "failed") << endl;
+	return b;
+}
+
+/// <summary>
+/// Test that ParseParallel() gives the same embers and fixups as Parse() on a file with comments and
+/// CDATA sections between the embers, and that it fails, the same as Parse(), when an ember in the
+/// middle of the file is malformed, even though the embers in the other chunks parse fine.
+/// </summary>
+/// <param name="filename">The flame file to take the embers from, which should contain at least 3</param>
+/// <param name="outFilename">The file to write the test Xml to, which is overwritten</param>
+/// <param name="threads">The number of threads to parse with, which should be at least 3 so the malformed ember is in a middle chunk</param>
+/// <returns>True if all agreed, else false.</returns>
+template <typename T>
+bool TestParseParallel(const string& filename, const string& outFilename, size_t threads)
+{
+	bool b = true;
+	Timing t;
+	XmlToEmber<T> parser;
+	EmberToXml<T> writer;
+	vector<Ember<T>> source, embers, parallel;
+
+	if (!InitPaletteList<T>("flam3-palettes.xml"))
+		return false;
+
+	if (!parser.Parse(filename.c_str(), source) || source.size() < 3)
+	{
+		cout << "Failed to parse at least 3 embers from " << filename << endl;
+		return false;
+	}
+
+	string xml = CommentedFlamesXml(source);
+
+	if (!WriteTextFile(outFilename, xml))
+		return false;
+
+	t.Tic();
+
+	if (!parser.Parse(outFilename.c_str(), embers))
+	{
+		cout << "Failed to parse " << outFilename << endl;
+		return false;
+	}
+
+	double parseMs = t.Toc();
+	t.Tic();
+
+	if (!parser.ParseParallel(outFilename.c_str(), parallel, threads))
+	{
+		cout << "ParseParallel() failed on " << outFilename << endl;
+		b = false;
+	}
+
+	double parallelMs = t.Toc();
+	b &= SameEmbers(embers, parallel, "ParseParallel()");
+
+	//Break a tag inside the middle ember, which leaves the text outside of the flame elements well formed.
+	size_t middle = source.size() / 2;
+	string middleXml = writer.ToString(source[middle], "", 0, true, false, true);
+	size_t pos = xml.find(middleXml);
+	size_t tag = pos == string::npos ? pos : xml.find("<xform ", pos);
+
+	if (tag == string::npos || tag > pos + middleXml.size())
+	{
+		cout << "Couldn't find an xform in ember " << middle << endl;
+		return false;
+	}
+
+	xml.insert(tag + 1, "<");
+
+	if (!WriteTextFile(outFilename, xml))
+		return false;
+
+	if (parser.Parse(outFilename.c_str(), embers))
+	{
+		cout << "Parse() succeeded with a malformed ember" << endl;
+		b = false;
+	}
+
+	if (parser.ParseParallel(outFilename.c_str(), parallel, threads))
+	{
+		cout << "ParseParallel() succeeded with a malformed ember " << middle << ", returning " << parallel.size() << " embers" << endl;
+		b = false;
+	}
+	else if (parallel.size() != middle)
+	{
+		cout << "ParseParallel() kept " << parallel.size() << " embers before the malformed one, expected " << middle << endl;
+		b = false;
+	}
+
+	cout << source.size() << " embers of " << sizeof(T) * 8 << " bits, Parse(): " << parseMs << "ms, ParseParallel(): " << parallelMs << "ms, " << (b ? "matched" : "failed") << endl;
+	return b;
+}
+
+/// <summary>
+/// Test that FromChars() converts the same values and stops at the same characters as strtod() and strtol(),
+/// including exponents, signs, whitespace, strings which aren't numbers, and values which are out of range.
+/// Unlike those, FromChars() returns nullptr when the value is out of range, rather than setting errno.
+/// </summary>
+/// <returns>True if all agreed, else false.</returns>
+bool TestFromChars()
+{
+	bool b = true;
+	const char* doubles[] =
+	{
+		"0", "-0", "+0", "1", "-1", "0.5", "-.5", ".5", "5.", "1.25e3", "1.25E3", "-1.25e+3", "1.25e-3", "2e22", "2e23", "2e-22", "2e-23",
+		"1e", "1e+", "1e-", "1ex", "  3.25", "\t\n-7.5", "2.5  ", "2.5x", "- 1", "-", "+", ".", "", "abc", "e5",
+		"0.1", "0.30000000000000004", "123456789012345678", "0.000001234567890123456789", "1.7976931348623157e308", "4.9e-324", "1e-400",
+		"1e400", "-1e400", "0x1p3", "inf", "-infinity", "nan"
+	};
+
+	for (auto str : doubles)
+	{
+		char* strtodEnd;
+		double val = 0, expected = strtod(str, &strtodEnd);
+		const char* end = FromChars(str, val);
+
+		if (std::isinf(expected) && strtodEnd != str && isdigit(static_cast<unsigned char>(*(strtodEnd - 1))))
+		{
+			if (end != nullptr)
+			{
+				cout << "FromChars(\"" << str << "\") didn't report " << expected << " as out of range" << endl;
+				b = false;
+			}
+		}
+		else if (end != strtodEnd || (memcmp(&val, &expected, sizeof(val)) && !(std::isnan(val) && std::isnan(expected))))
+		{
+			cout << "FromChars(\"" << str << "\") returned " << val << " ending at " << (end ? end - str : -1) << ", strtod() returned " << expected << " ending at " << (strtodEnd - str) << endl;
+			b = false;
+		}
+	}
+
+	const char* ints[] = { "0", "-0", "42", "+42", "  -42", "42 ", "42x", "-", "", "x", "2147483647", "-2147483648", "2147483648", "-2147483649", "4294967295", "4294967296", "99999999999999999999" };
+
+	for (auto str : ints)
+	{
+		char* strtolEnd;
+		long long expected = strtoll(str, &strtolEnd, 10);
+		int intVal = 0;
+		uint uintVal = 0;
+		const char* intEnd = FromChars(str, intVal);
+		const char* uintEnd = FromChars(str, uintVal);
+		bool intRange = expected >= std::numeric_limits<int>::min() && expected <= std::numeric_limits<int>::max();
+		bool uintRange = expected >= std::numeric_limits<int>::min() && expected <= std::numeric_limits<uint>::max();
+
+		if (intRange ? (intEnd != strtolEnd || intVal != int(expected)) : intEnd != nullptr)
+		{
+			cout << "FromChars(\"" << str << "\", int) returned " << intVal << ", strtoll() returned " << expected << endl;
+			b = false;
+		}
+
+		if (uintRange ? (uintEnd != strtolEnd || uintVal != uint(expected)) : uintEnd != nullptr)
+		{
+			cout << "FromChars(\"" << str << "\", uint) returned " << uintVal << ", strtoll() returned " << expected << endl;
+			b = false;
+		}
+	}
+
+	cout << "FromChars() " << (b ? "matched" : "differed from") << " strtod() and strtoll()" << endl;
+	return b;
+}
+
+/// <summary>
+/// Read back the pixels of a PNG file written with 4 channels.
+/// </summary>
+/// <param name="filename">The file to read</param>
+/// <param name="bytesPerChannel">Bytes per channel the file was written with</param>
+/// <param name="image">The vector to store the pixels in, with 16-bit samples in native byte order</param>
+/// <returns>True if success, else false.</returns>
+bool ReadPngPixels(const string& filename, size_t bytesPerChannel, vector<byte>& image)
+{
+	FILE* file;
+	glm::uint16 testbe = 1;
+
+	if (fopen_s(&file, filename.c_str(), "rb") != 0)
+		return false;
+
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+		fclose(file);
+		return false;
+	}
+
+	png_init_io(png_ptr, file);
+	png_read_png(png_ptr, info_ptr, bytesPerChannel == 2 && testbe != htons(testbe) ? PNG_TRANSFORM_SWAP_ENDIAN : PNG_TRANSFORM_IDENTITY, nullptr);
+
+	size_t rowSize = png_get_rowbytes(png_ptr, info_ptr);
+	png_bytepp rows = png_get_rows(png_ptr, info_ptr);
+
+	image.resize(rowSize * png_get_image_height(png_ptr, info_ptr));
+
+	for (size_t i = 0; i < png_get_image_height(png_ptr, info_ptr); i++)
+		memcpy(image.data() + i * rowSize, rows[i], rowSize);
+
+	png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+	fclose(file);
+	return true;
+}
+
+/// <summary>
+/// Test that PNG files compressed in parallel, both from a whole image and streamed in strips,
+/// read back as exactly the pixels written, and print how long each compression level took.
+/// </summary>
+/// <param name="filename">The file to write, which is overwritten</param>
+/// <param name="width">Width of the image in pixels</param>
+/// <param name="height">Height of the image in pixels</param>
+/// <param name="bytesPerChannel">Bytes per channel, 1 or 2.</param>
+/// <param name="strips">The number of strips to stream the image in</param>
+/// <returns>True if all files read back the same, else false.</returns>
+bool TestPngWrite(const string& filename, size_t width, size_t height, size_t bytesPerChannel, size_t strips)
+{
+	bool b = true;
+	Timing t;
+	QTIsaac<ISAAC_SIZE, ISAAC_INT> rand;
+	EmberImageComments comments;
+	size_t rowSize = width * 4 * bytesPerChannel;
+	vector<byte> image(rowSize * height), readBack;
+
+	//Smooth gradients with some noise, roughly like a rendered flame.
+	for (size_t y = 0; y < height; y++)
+		for (size_t x = 0; x < rowSize; x++)
+			image[y * rowSize + x] = byte((x / 7 + y / 3) ^ (rand.Rand() & 7));
+
+	comments.m_Genome = "<flame />";
+
+	for (int level = 0; level <= 9; level += 3)
+	{
+		t.Tic();
+		b &= WritePng(filename.c_str(), image.data(), width, height, bytesPerChannel, true, comments, "", "", "", level);
+		double writeMs = t.Toc();
+		b &= ReadPngPixels(filename, bytesPerChannel, readBack) && readBack == image;
+
+		PngWriter writer;
+		size_t stripRows = (height + strips - 1) / strips;
+
+		t.Tic();
+		b &= writer.Open(filename.c_str(), width, height, bytesPerChannel, level);
+
+		for (size_t row = 0; row < height; row += stripRows)
+			b &= writer.WriteRows(image.data() + row * rowSize, std::min(stripRows, height - row));
+
+		b &= writer.Finish(true, comments, "", "", "");
+		double streamMs = t.Toc();
+		b &= ReadPngPixels(filename, bytesPerChannel, readBack) && readBack == image;
+
+		cout << width << "x" << height << ", " << bytesPerChannel * 8 << " bits per channel, level " << level << ", WritePng(): " << writeMs << "ms, " << strips << " strips: " << streamMs << "ms" << endl;
+	}
+
+	cout << "Png write " << (b ? "succeeded" : "failed") << endl;
+	return b;
+}
+
 template <typename T>
 void TestCross(T x, T y, T weight)
 {
@@ -1991,6 +2879,28 @@ int _tmain(int argc, _TCHAR* argv[])
 	//TestCross<double>(rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5));
 	//TestCross<double>(rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5));
 	//TestCross<double>(rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5), rand.Frand<double>(-5, 5));
+	//TestHugePages<float>(4000, 4000, 2, 100);
+	//TestHugePages<double>(4000, 4000, 2, 100);
+	//TestEmberCopy<float>(100000, 20);
+	//TestEmberCopy<double>(100000, 20);
+	//TestVariationPool<float>(1000);
+	//TestVariationPool<double>(1000);
+	//TestRendererPool<float>(100, 320, 240);
+	//TestFilterCache<float>(1000, 4);
+	//TestFilterCache<double>(1000, 4);
+	//TestBinaryRoundTrip<float>("testallvarsout.flame", "testallvarsout.emberbin");
+	//TestBinaryRoundTrip<double>("testallvarsout.flame", "testallvarsout.emberbin");
+	//TestPaletteCache<float>("flam3-palettes.xml");
+	//TestPaletteCache<double>("flam3-palettes.xml");
+	//TestXmlRoundTrip<float>("testallvarsout.flame", "testallvarsout_rt.flame", 100);
+	//TestXmlRoundTrip<double>("testallvarsout.flame", "testallvarsout_rt.flame", 100);
+	//TestEmberStream<float>("testallvarsout.flame", "testemberstream.flame");
+	//TestEmberStream<double>("testallvarsout.flame", "testemberstream.flame");
+	//TestParseParallel<float>("testallvarsout.flame", "testparseparallel.flame", 4);
+	//TestParseParallel<double>("testallvarsout.flame", "testparseparallel.flame", 4);
+	//TestFromChars();
+	//TestPngWrite("testpngwrite.png", 7680, 4320, 2, 7);
+	//TestVarTimeCsv("vartime.csv");
 	//MakeTestAllVarsRegPrePostComboFile("testallvarsout.flame");
 	//return 0;
 
@@ -2082,7 +2992,7 @@ int _tmain(int argc, _TCHAR* argv[])
 	t.Toc("TestXformsInOutPoints()");
 	
 	t.Tic();
-	TestVarTime<float>();
+	TestVarTime<float>(cout, 4096, 10);//Print rather than write vartime.csv, which TestVarTimeCsv() above does.
 	t.Toc("TestVarTime()");
 	
 	t.Tic();
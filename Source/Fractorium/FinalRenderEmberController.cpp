@@ -680,13 +680,8 @@ void FinalRenderEmberController<T>::RenderComplete(Ember<T>& ember)
 	{
 		QFileInfo xmlFileInfo(filename);//Create another one in case it was modified for batch rendering.
 		QString newPath = xmlFileInfo.absolutePath() + '/' + xmlFileInfo.completeBaseName() + ".flame";
-		xmlDocPtr tempEdit = ember.m_Edits;
-
-		ember.m_Edits = m_XmlWriter.CreateNewEditdoc(&ember, nullptr, "edit", m_Settings->Nick().toStdString(), m_Settings->Url().toStdString(), m_Settings->Id().toStdString(), "", 0, 0);
+		ember.SetEdit(m_XmlWriter.CreateNewEditdoc(&ember, nullptr, "edit", m_Settings->Nick().toStdString(), m_Settings->Url().toStdString(), m_Settings->Id().toStdString(), "", 0, 0));
 		m_XmlWriter.Save(newPath.toStdString().c_str(), ember, 0, true, false, true);//Note that the ember passed is used, rather than m_Ember because it's what was actually rendered.
-
-		if (tempEdit != nullptr)
-			xmlFreeDoc(tempEdit);
 	}
 
 	m_FinishedImageCount++;
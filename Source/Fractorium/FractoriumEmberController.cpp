@@ -23,6 +23,11 @@ FractoriumEmberControllerBase::FractoriumEmberControllerBase(Fractorium* fractor
 	m_RenderType = CPU_RENDERER;
 	m_OutputTexID = 0;
 	m_SubBatchCount = 1;//Will be ovewritten by the options on first render.
+	m_ProgressiveScale = 1;
+	m_IterMsPerSubBatch = 0;//Measured as rendering proceeds.
+	m_ItersPerSubBatch = 0;
+	m_FilterMsPerPixel = 0;
+	m_AccumMsPerPixel = 0;
 	m_FinalImageIndex = 0;
 	m_Fractorium = fractorium;
 	m_RenderTimer = nullptr;
@@ -150,7 +155,7 @@ FractoriumEmberController<T>::~FractoriumEmberController() { }
 /// These are used to preserve the current ember/file when switching between renderers.
 /// Note that some precision will be lost when going from double to float.
 /// </summary>
-template <typename T> void FractoriumEmberController<T>::SetEmber(const Ember<float>& ember, bool verbatim) { SetEmberPrivate<float>(ember, verbatim); }
+template <typename T> void FractoriumEmberController<T>::SetEmber(const Ember<float>& ember, bool verbatim, eProcessAction action) { SetEmberPrivate<float>(ember, verbatim, action); }
 template <typename T> void FractoriumEmberController<T>::CopyEmber(Ember<float>& ember, std::function<void(Ember<float>& ember)> perEmberOperation) { ember = m_Ember; perEmberOperation(ember); }
 template <typename T> void FractoriumEmberController<T>::SetEmberFile(const EmberFile<float>& emberFile) { m_EmberFile = emberFile; }
 template <typename T> void FractoriumEmberController<T>::CopyEmberFile(EmberFile<float>& emberFile, std::function<void(Ember<float>& ember)> perEmberOperation)
@@ -162,7 +167,7 @@ template <typename T> void FractoriumEmberController<T>::CopyEmberFile(EmberFile
 template <typename T> void FractoriumEmberController<T>::SetTempPalette(const Palette<float>& palette) { m_TempPalette = palette; }
 template <typename T> void FractoriumEmberController<T>::CopyTempPalette(Palette<float>& palette) { palette = m_TempPalette; }
 #ifdef DO_DOUBLE
-template <typename T> void FractoriumEmberController<T>::SetEmber(const Ember<double>& ember, bool verbatim) { SetEmberPrivate<double>(ember, verbatim); }
+template <typename T> void FractoriumEmberController<T>::SetEmber(const Ember<double>& ember, bool verbatim, eProcessAction action) { SetEmberPrivate<double>(ember, verbatim, action); }
 template <typename T> void FractoriumEmberController<T>::CopyEmber(Ember<double>& ember, std::function<void(Ember<double>& ember)> perEmberOperation) { ember = m_Ember; perEmberOperation(ember); }
 template <typename T> void FractoriumEmberController<T>::SetEmberFile(const EmberFile<double>& emberFile) { m_EmberFile = emberFile; }
 template <typename T> void FractoriumEmberController<T>::CopyEmberFile(EmberFile<double>& emberFile, std::function<void(Ember<double>& ember)> perEmberOperation)
@@ -303,12 +308,14 @@ void FractoriumEmberController<T>::UpdateXform(std::function<void(Xform<T>*)> fu
 /// Set the current ember, but use GUI values for the fields which make sense to
 /// keep the same between ember selection changes.
 /// Note the extra template parameter U allows for assigning ember of different types.
-/// Resets the rendering process.
+/// Resets the rendering process using the specified action.
 /// </summary>
 /// <param name="ember">The ember to set as the current</param>
+/// <param name="verbatim">True to use all values of the ember as-is, else false to keep the GUI values for quality, supersample and temporal samples.</param>
+/// <param name="action">The action for the renderer to take</param>
 template <typename T>
 template <typename U>
-void FractoriumEmberController<T>::SetEmberPrivate(const Ember<U>& ember, bool verbatim)
+void FractoriumEmberController<T>::SetEmberPrivate(const Ember<U>& ember, bool verbatim, eProcessAction action)
 {
 	if (ember.m_Name != m_Ember.m_Name)
 		m_LastSaveCurrent = "";
@@ -342,6 +349,8 @@ void FractoriumEmberController<T>::SetEmberPrivate(const Ember<U>& ember, bool v
 	//This is for when a new ember with the same size was loaded. If it was larger than the scroll area, and was scrolled, re-center it.
 	if (m_Ember.m_FinalRasW == w && m_Ember.m_FinalRasH == h)
 		m_Fractorium->CenterScrollbars();
+
+	UpdateRender(action);//Filling the palette above does not request an action, so the caller decides how much must be redone.
 }
 
 template class FractoriumEmberController<float>;
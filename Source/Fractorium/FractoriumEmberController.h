@@ -25,6 +25,8 @@ enum eXformUpdate : uint { UPDATE_CURRENT, UPDATE_SELECTED, UPDATE_SELECTED_EXCE
 class Fractorium;
 #define PREVIEW_SIZE 256
 #define UNDO_SIZE 128
+#define SUB_BATCH_BUDGET_MS 33.0//Target wall time of each interactive rendering slice, about 30 frames per second.
+#define PROGRESSIVE_IDLE_MS 200//Milliseconds without edits before a reduced resolution preview is replaced with a full resolution render.
 
 /// <summary>
 /// FractoriumEmberControllerBase serves as a non-templated base class with virtual
@@ -45,14 +47,14 @@ public:
 	virtual ~FractoriumEmberControllerBase();
 
 	//Embers.
-	virtual void SetEmber(const Ember<float>& ember, bool verbatim = false) { }
+	virtual void SetEmber(const Ember<float>& ember, bool verbatim = false, eProcessAction action = FULL_RENDER) { }
 	virtual void CopyEmber(Ember<float>& ember, std::function<void(Ember<float>& ember)> perEmberOperation/* = [&](Ember<float>& ember) { }*/) { }//Uncomment default lambdas once LLVM fixes a crash in their compiler with default lambda parameters.//TODO
 	virtual void SetEmberFile(const EmberFile<float>& emberFile) { }
 	virtual void CopyEmberFile(EmberFile<float>& emberFile, std::function<void(Ember<float>& ember)> perEmberOperation/* = [&](Ember<float>& ember) { }*/) { }
 	virtual void SetTempPalette(const Palette<float>& palette) { }
 	virtual void CopyTempPalette(Palette<float>& palette) { }
 #ifdef DO_DOUBLE
-	virtual void SetEmber(const Ember<double>& ember, bool verbatim = false) { }
+	virtual void SetEmber(const Ember<double>& ember, bool verbatim = false, eProcessAction action = FULL_RENDER) { }
 	virtual void CopyEmber(Ember<double>& ember, std::function<void(Ember<double>& ember)> perEmberOperation/* = [&](Ember<double>& ember) { }*/) { }
 	virtual void SetEmberFile(const EmberFile<double>& emberFile) { }
 	virtual void CopyEmberFile(EmberFile<double>& emberFile, std::function<void(Ember<double>& ember)> perEmberOperation/* = [&](Ember<double>& ember) { }*/) { }
@@ -214,6 +216,7 @@ public:
 	void ClearFinalImages();
 	void Shutdown();
 	void UpdateRender(eProcessAction action = FULL_RENDER);
+	eProcessAction PaletteProcessAction();
 	void DeleteRenderer();
 	void SaveCurrentRender(const QString& filename, bool forcePull);
 	RendererBase* Renderer() { return m_Renderer.get(); }
@@ -225,6 +228,8 @@ protected:
 	void AddProcessAction(eProcessAction action);
 	eProcessAction CondenseAndClearProcessActions();
 	eProcessState ProcessState() { return m_Renderer.get() ? m_Renderer->ProcessState() : NONE; }
+	void UpdateSubBatchCount(const EmberStats& before);
+	uint BudgetedSubBatchCount(bool forceOutput);
 
 	//Non-templated members.
 	bool m_Rendering;
@@ -234,12 +239,18 @@ protected:
 	uint m_Platform;
 	uint m_Device;
 	uint m_SubBatchCount;
+	uint m_ProgressiveScale;
 	uint m_FailedRenders;
 	uint m_UndoIndex;
 	eRendererType m_RenderType;
 	eEditUndoState m_EditState;
 	GLuint m_OutputTexID;
+	double m_IterMsPerSubBatch;
+	double m_ItersPerSubBatch;
+	double m_FilterMsPerPixel;
+	double m_AccumMsPerPixel;
 	Timing m_RenderElapsedTimer;
+	Timing m_LastEditTimer;
 	EmberStats m_Stats;
 	QImage m_FinalPaletteImage;
 	QString m_LastSaveAll;
@@ -271,14 +282,14 @@ public:
 	virtual ~FractoriumEmberController();
 
 	//Embers.
-	virtual void SetEmber(const Ember<float>& ember, bool verbatim = false) override;
+	virtual void SetEmber(const Ember<float>& ember, bool verbatim = false, eProcessAction action = FULL_RENDER) override;
 	virtual void CopyEmber(Ember<float>& ember, std::function<void(Ember<float>& ember)> perEmberOperation/* = [&](Ember<float>& ember) { }*/) override;
 	virtual void SetEmberFile(const EmberFile<float>& emberFile) override;
 	virtual void CopyEmberFile(EmberFile<float>& emberFile, std::function<void(Ember<float>& ember)> perEmberOperation/* = [&](Ember<float>& ember) { }*/) override;
 	virtual void SetTempPalette(const Palette<float>& palette) override;
 	virtual void CopyTempPalette(Palette<float>& palette) override;
 #ifdef DO_DOUBLE
-	virtual void SetEmber(const Ember<double>& ember, bool verbatim = false) override;
+	virtual void SetEmber(const Ember<double>& ember, bool verbatim = false, eProcessAction action = FULL_RENDER) override;
 	virtual void CopyEmber(Ember<double>& ember, std::function<void(Ember<double>& ember)> perEmberOperation/* = [&](Ember<double>& ember) { }*/) override;
 	virtual void SetEmberFile(const EmberFile<double>& emberFile) override;
 	virtual void CopyEmberFile(EmberFile<double>& emberFile, std::function<void(Ember<double>& ember)> perEmberOperation/* = [&](Ember<double>& ember) { }*/) override;
@@ -443,7 +454,7 @@ public:
 private:
 	//Embers.
 	void ApplyXmlSavingTemplate(Ember<T>& ember);
-	template <typename U> void SetEmberPrivate(const Ember<U>& ember, bool verbatim);
+	template <typename U> void SetEmberPrivate(const Ember<U>& ember, bool verbatim, eProcessAction action);
 
 	//Params.
 	void ParamsToEmber(Ember<T>& ember);
@@ -463,7 +474,8 @@ private:
 	void UpdateXform(std::function<void(Xform<T>*)> func, eXformUpdate updateType = eXformUpdate::UPDATE_CURRENT, bool updateRender = true, eProcessAction action = FULL_RENDER);
 
 	//Palette.
-	void UpdateAdjustedPaletteGUI(Palette<T>& palette);
+	void UpdateAdjustedPaletteGUI(Palette<T>& palette, eProcessAction action = FULL_RENDER);
+	void ApplyPaletteRow(int row, eProcessAction action);
 
 	//Rendering/progress.
 	void Update(std::function<void (void)> func, bool updateRender = true, eProcessAction action = FULL_RENDER);
@@ -475,6 +487,7 @@ private:
 	vector<T> m_TempOpacities;
 	vector<T> m_NormalizedWeights;
 	Ember<T> m_Ember;
+	Ember<T> m_ScaledEmber;
 	EmberFile<T> m_EmberFile;
 	deque<Ember<T>> m_UndoList;
 	Palette<T> m_TempPalette;
@@ -273,14 +273,10 @@ void FractoriumEmberController<T>::SaveCurrentAsXml()
 		Ember<T> ember = m_Ember;
 		EmberToXml<T> writer;
 		QFileInfo fileInfo(filename);
-		xmlDocPtr tempEdit = ember.m_Edits;
 
 		SaveCurrentToOpenedFile();//Save the current ember back to the opened file before writing to disk.
 		ApplyXmlSavingTemplate(ember);
-		ember.m_Edits = writer.CreateNewEditdoc(&ember, nullptr, "edit", s->Nick().toStdString(), s->Url().toStdString(), s->Id().toStdString(), "", 0, 0);
-
-		if (tempEdit != nullptr)
-			xmlFreeDoc(tempEdit);
+		ember.SetEdit(writer.CreateNewEditdoc(&ember, nullptr, "edit", s->Nick().toStdString(), s->Url().toStdString(), s->Id().toStdString(), "", 0, 0));
 
 		if (writer.Save(filename.toStdString().c_str(), ember, 0, true, false, true))
 		{
@@ -160,12 +160,12 @@ void FractoriumEmberController<T>::ApplyPaletteToEmber()
 
 /// <summary>
 /// Use adjusted palette to update all related GUI controls with new color values.
-/// Resets the rendering process.
+/// Resets the rendering process using the specified action.
 /// </summary>
 /// <param name="palette">The palette to use</param>
-/// <param name="paletteName">Name of the palette</param>
+/// <param name="action">The action for the renderer to take, NOTHING to let the caller request it. Default: FULL_RENDER.</param>
 template <typename T>
-void FractoriumEmberController<T>::UpdateAdjustedPaletteGUI(Palette<T>& palette)
+void FractoriumEmberController<T>::UpdateAdjustedPaletteGUI(Palette<T>& palette, eProcessAction action)
 {
 	Xform<T>* xform = CurrentXform();
 	QTableWidget* palettePreviewTable = m_Fractorium->ui.PalettePreviewTable;
@@ -189,8 +189,14 @@ void FractoriumEmberController<T>::UpdateAdjustedPaletteGUI(Palette<T>& palette)
 	}
 
 	//Update the current xform's color and reset the rendering process.
+	//The color index itself is unchanged, so only the palette needs to be re-applied if the renderer supports it.
 	if (xform)
-		XformColorIndexChanged(xform->m_ColorX, true);
+	{
+		XformColorIndexChanged(xform->m_ColorX, false);
+
+		if (action != NOTHING)
+			UpdateRender(action);
+	}
 }
 
 /// <summary>
@@ -205,8 +211,8 @@ void FractoriumEmberController<T>::PaletteAdjust()
 	Update([&]()
 	{
 		ApplyPaletteToEmber();
-		UpdateAdjustedPaletteGUI(m_Ember.m_Palette);
-	});
+		UpdateAdjustedPaletteGUI(m_Ember.m_Palette, NOTHING);//Update() below requests the render.
+	}, true, PaletteProcessAction());
 }
 
 void Fractorium::OnPaletteAdjust(int d) { m_Controller->PaletteAdjust(); }
@@ -225,14 +231,24 @@ void Fractorium::OnPaletteAdjust(int d) { m_Controller->PaletteAdjust(); }
 template <typename T>
 void FractoriumEmberController<T>::PaletteCellClicked(int row, int col)
 {
-	Palette<T>* palette = m_PaletteList.GetPalette(m_CurrentPaletteFilePath, row);
-	QTableWidgetItem* nameItem = m_Fractorium->ui.PaletteListTable->item(row, 0);
+	ApplyPaletteRow(row, PaletteProcessAction());
+}
 
-	if (palette)
+/// <summary>
+/// Set the palette at the specified row of the palette table as the current one,
+/// applying any adjustments previously specified.
+/// Resets the rendering process using the specified action.
+/// </summary>
+/// <param name="row">The table row of the palette</param>
+/// <param name="action">The action for the renderer to take, NOTHING to let the caller request it.</param>
+template <typename T>
+void FractoriumEmberController<T>::ApplyPaletteRow(int row, eProcessAction action)
+{
+	if (Palette<T>* palette = m_PaletteList.GetPalette(m_CurrentPaletteFilePath, row))
 	{
 		m_TempPalette = *palette;//Deep copy.
 		ApplyPaletteToEmber();//Copy temp palette to ember palette and apply adjustments.
-		UpdateAdjustedPaletteGUI(m_Ember.m_Palette);//Show the adjusted palette.
+		UpdateAdjustedPaletteGUI(m_Ember.m_Palette, action);//Show the adjusted palette.
 	}
 }
 
@@ -207,7 +207,7 @@ void Fractorium::OnColorSelected(const QColor& color) { m_Controller->Background
 /// Resets the rendering process.
 /// </summary>
 /// <param name="index">The index of the palette mode combo box</param>
-template <typename T> void FractoriumEmberController<T>::PaletteModeChanged(uint i) { Update([&] { m_Ember.m_PaletteMode = i == 0 ? PALETTE_STEP : PALETTE_LINEAR; }); }
+template <typename T> void FractoriumEmberController<T>::PaletteModeChanged(uint i) { Update([&] { m_Ember.m_PaletteMode = i == 0 ? PALETTE_STEP : PALETTE_LINEAR; }, true, PaletteProcessAction()); }
 void Fractorium::OnPaletteModeComboCurrentIndexChanged(int index) { m_Controller->PaletteModeChanged(index); }
 
 /// <summary>
@@ -559,14 +559,17 @@ void FractoriumEmberController<T>::FillParamTablesAndPalette()
 	//to just use the values "as-is" without looking them up in the list.
 	if (m_Ember.m_Palette.m_Index >= 0)
 	{
-		m_Fractorium->OnPaletteCellClicked(Clamp<int>(m_Ember.m_Palette.m_Index, 0, m_Fractorium->ui.PaletteListTable->rowCount() - 1), 1);
+		int row = Clamp<int>(m_Ember.m_Palette.m_Index, 0, m_Fractorium->ui.PaletteListTable->rowCount() - 1);
+
+		m_Fractorium->m_PreviousPaletteRow = row;
+		ApplyPaletteRow(row, NOTHING);//The caller requests the render.
 	}
 	else
 	{
 		//An ember with an embedded palette was loaded, rather than one from the list, so assign it directly to the controls without applying adjustments.
 		//Normally, temp palette is assigned whenever the user clicks on a palette cell. But since that is skipped here just make a copy of the ember's palette.
 		m_TempPalette = m_Ember.m_Palette;
-		UpdateAdjustedPaletteGUI(m_Ember.m_Palette);//Will clear name string since embedded palettes have no name. This will trigger a full render.
+		UpdateAdjustedPaletteGUI(m_Ember.m_Palette, NOTHING);//Will clear name string since embedded palettes have no name. The caller requests the render.
 	}
 
 	//Xaos.
@@ -14,6 +14,7 @@
 #include "OpenCLWrapper.h"
 #include "XmlToEmber.h"
 #include "EmberToXml.h"
+#include "EmberBinary.h"
 #include "SheepTools.h"
 #include "JpegUtils.h"
 #include "EmberCommon.h"
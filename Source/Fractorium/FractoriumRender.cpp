@@ -87,11 +87,12 @@ void FractoriumEmberControllerBase::ClearFinalImages()
 /// Update the state of the renderer.
 /// Upon changing values, some intelligence is used to avoid blindly restarting the
 /// entire iteration proceess every time a value changes. This is because some values don't affect the
-/// iteration, and only affect filtering and final accumulation. They are broken into three categories:
+/// iteration, and only affect filtering and final accumulation. They are broken into five categories:
 /// 1) Restart the entire process.
-/// 2) Log/density filter, then final accum.
-/// 3) Final accum only.
-/// 4) Continue iterating.
+/// 2) Re-apply the palette to the color index bins, then log/density filter, then final accum.
+/// 3) Log/density filter, then final accum.
+/// 4) Final accum only.
+/// 5) Continue iterating.
 /// </summary>
 /// <param name="action">The action to take</param>
 void FractoriumEmberControllerBase::UpdateRender(eProcessAction action)
@@ -100,6 +101,17 @@ void FractoriumEmberControllerBase::UpdateRender(eProcessAction action)
 	m_RenderElapsedTimer.Tic();
 }
 
+/// <summary>
+/// Get the action to take when only the palette or palette mode has changed.
+/// If the renderer keeps color index bins, the palette can be re-applied without
+/// iterating again, else the entire process must be restarted.
+/// </summary>
+/// <returns>PALETTE_AND_ACCUM if the renderer keeps color index bins, else FULL_RENDER.</returns>
+eProcessAction FractoriumEmberControllerBase::PaletteProcessAction()
+{
+	return m_Renderer.get() && m_Renderer->PaletteBins() > 0 ? PALETTE_AND_ACCUM : FULL_RENDER;
+}
+
 /// <summary>
 /// Call Shutdown() then delete the renderer and clear the textures in the output window if there is one.
 /// </summary>
@@ -118,6 +130,7 @@ void FractoriumEmberControllerBase::DeleteRenderer()
 /// severely lacking. A Png file comes out larger than a bitmap, so instead use the
 /// Png and Jpg wrapper functions from the command line programs.
 /// This will embed the id, url and nick fields from the options in the image comments.
+/// Nothing is saved while a reduced resolution preview is being shown.
 /// </summary>
 /// <param name="filename">The full path and filename</param>
 void FractoriumEmberControllerBase::SaveCurrentRender(const QString& filename, bool forcePull)
@@ -135,6 +148,13 @@ void FractoriumEmberControllerBase::SaveCurrentRender(const QString& filename, b
 		FractoriumSettings* settings = m_Fractorium->m_Settings;
 		RendererCLBase* rendererCL = dynamic_cast<RendererCLBase*>(m_Renderer.get());
 
+		//The renderer only holds a fraction of the final image while a reduced resolution preview is shown.
+		if (m_ProgressiveScale > 1)
+		{
+			m_Fractorium->ShowCritical("Save Failed", "The image is still being previewed at reduced resolution. Wait for the full resolution render to start, then save again.", true);
+			return;
+		}
+
 		if (forcePull && rendererCL && m_Renderer->PrepFinalAccumVector(m_FinalImage[m_FinalImageIndex]))
 		{
 			if (!rendererCL->ReadFinal(m_FinalImage[m_FinalImageIndex].data()))
@@ -296,6 +316,62 @@ bool FractoriumEmberController<T>::SyncSizes()
 	return changed;
 }
 
+/// <summary>
+/// Update the stage cost estimates with the time spent in the last call to Run(),
+/// then size the next slice to fit within the UI frame budget.
+/// Iteration cost is measured per sub batch, which doesn't depend on the resolution.
+/// Density filtering and final accumulation are measured per output pixel so the estimates
+/// remain valid when switching between a progressive preview and a full resolution render.
+/// Each estimate is a moving average to smooth out jitter from the rest of the system.
+/// </summary>
+/// <param name="before">The renderer stats from before the last call to Run()</param>
+void FractoriumEmberControllerBase::UpdateSubBatchCount(const EmberStats& before)
+{
+	EmberStats after = m_Renderer->Stats();
+	double pixels = double(std::max<size_t>(1, m_Renderer->FinalRasW() * m_Renderer->FinalRasH()));
+	auto smooth = [&](double& estimate, double val) { estimate = estimate > 0 ? (estimate * 0.75) + (val * 0.25) : val; };
+
+	//Only a slice which ran its full sub batch count gives an accurate per sub batch measurement.
+	if (ProcessState() == ITER_STARTED && after.m_Iters > before.m_Iters)
+	{
+		smooth(m_IterMsPerSubBatch, (after.m_IterMs - before.m_IterMs) / m_SubBatchCount);
+		smooth(m_ItersPerSubBatch, double(after.m_Iters - before.m_Iters) / m_SubBatchCount);
+	}
+
+	if (after.m_FilterMs > before.m_FilterMs)
+		smooth(m_FilterMsPerPixel, (after.m_FilterMs - before.m_FilterMs) / pixels);
+
+	if (after.m_AccumMs > before.m_AccumMs)
+		smooth(m_AccumMsPerPixel, (after.m_AccumMs - before.m_AccumMs) / pixels);
+
+	m_SubBatchCount = BudgetedSubBatchCount(false);
+}
+
+/// <summary>
+/// Return the number of sub batches to run in the next slice so that it takes about SUB_BATCH_BUDGET_MS.
+/// The slice which forces output, and the one which completes iteration, also pay for
+/// density filtering and final accumulation, so that time is subtracted from their budget.
+/// </summary>
+/// <param name="forceOutput">True if the next slice will force output, else false.</param>
+/// <returns>The sub batch count, which is at least 1. The current count if nothing has been measured yet.</returns>
+uint FractoriumEmberControllerBase::BudgetedSubBatchCount(bool forceOutput)
+{
+	if (m_IterMsPerSubBatch <= 0)
+		return m_SubBatchCount;
+
+	double budget = SUB_BATCH_BUDGET_MS;
+	double outputMs = (m_FilterMsPerPixel + m_AccumMsPerPixel) * m_Renderer->FinalRasW() * m_Renderer->FinalRasH();
+	double count = budget / m_IterMsPerSubBatch;
+	size_t total = m_Renderer->TotalIterCount(1);
+	size_t done = m_Renderer->Stats().m_Iters;
+	bool last = (count * m_ItersPerSubBatch) >= double(total > done ? total - done : 0);
+
+	if (forceOutput || last)
+		count = (budget - outputMs) / m_IterMsPerSubBatch;
+
+	return uint(Clamp<double>(count, 1, 10000));
+}
+
 /// <summary>
 /// The main rendering function.
 /// Called whenever the event loop is idle.
@@ -317,6 +393,29 @@ bool FractoriumEmberController<T>::Render()
 	//Force temporal samples to always be 1. Perhaps change later when animation is implemented.
 	m_Ember.m_TemporalSamples = 1;
 
+	//Determine the resolution to render at. Edits which require re-iterating are first
+	//previewed at a fraction of the display resolution, and the full resolution render
+	//starts once no edits have been made for a short period.
+	uint scale = m_ProgressiveScale;
+
+	if (action != NOTHING)
+	{
+		uint previewScale = m_Fractorium->m_Settings->PreviewScale();
+
+		m_LastEditTimer.Tic();
+		scale = (previewScale > 1 && (action == FULL_RENDER || m_ProgressiveScale > 1)) ? previewScale : 1;
+	}
+	else if (m_ProgressiveScale > 1 && m_LastEditTimer.Toc() >= PROGRESSIVE_IDLE_MS)
+	{
+		scale = 1;
+	}
+
+	if (scale != m_ProgressiveScale)//The histogram can't be reused across a resolution change.
+	{
+		m_ProgressiveScale = scale;
+		action = FULL_RENDER;
+	}
+
 	//Take care of solo xforms and set the current ember and action.
 	if (action != NOTHING)
 	{
@@ -333,7 +432,20 @@ bool FractoriumEmberController<T>::Render()
 			}
 		}
 
-		m_Renderer->SetEmber(m_Ember, action);
+		if (m_ProgressiveScale > 1)
+		{
+			size_t w = std::max<size_t>(1, m_Ember.m_FinalRasW / m_ProgressiveScale);
+			size_t h = std::max<size_t>(1, m_Ember.m_FinalRasH / m_ProgressiveScale);
+
+			//Keep the same view of the cartesian plane, just with fewer pixels.
+			m_ScaledEmber = m_Ember;
+			m_ScaledEmber.m_PixelsPerUnit *= T(w) / T(m_Ember.m_FinalRasW);
+			m_ScaledEmber.m_FinalRasW = w;
+			m_ScaledEmber.m_FinalRasH = h;
+			m_Renderer->SetEmber(m_ScaledEmber, action);
+		}
+		else
+			m_Renderer->SetEmber(m_Ember, action);
 
 		if (solo != -1)
 		{
@@ -356,10 +468,20 @@ bool FractoriumEmberController<T>::Render()
 
 	if (iterBegin)
 	{
-		if (m_Renderer->RendererType() == CPU_RENDERER)
-			m_SubBatchCount = m_Fractorium->m_Settings->CpuSubBatch();
-		else if (m_Renderer->RendererType() == OPENCL_RENDERER)
-			m_SubBatchCount = m_Fractorium->m_Settings->OpenCLSubBatch();
+		if (m_IterMsPerSubBatch > 0)//Size the first slice from the measured costs, leaving room for the forced output.
+		{
+			m_SubBatchCount = BudgetedSubBatchCount(true);
+		}
+		else//Nothing measured yet, so start with the values from the options.
+		{
+			if (m_Renderer->RendererType() == CPU_RENDERER)
+				m_SubBatchCount = m_Fractorium->m_Settings->CpuSubBatch();
+			else if (m_Renderer->RendererType() == OPENCL_RENDERER)
+				m_SubBatchCount = m_Fractorium->m_Settings->OpenCLSubBatch();
+
+			//A reduced resolution preview needs proportionally fewer iterations to show the same detail.
+			m_SubBatchCount = std::max(1u, m_SubBatchCount / (m_ProgressiveScale * m_ProgressiveScale));
+		}
 
 		m_Fractorium->m_ProgressBar->setValue(0);
 		m_Fractorium->m_RenderStatusLabel->setText("Starting");
@@ -368,23 +490,13 @@ bool FractoriumEmberController<T>::Render()
 	//If the rendering process hasn't finished, render with the current specified action.
 	if (ProcessState() != ACCUM_DONE)
 	{
+		EmberStats before = iterBegin ? EmberStats() : m_Renderer->Stats();//Stats are cleared when a new rendering process starts.
+
 		//if (m_Renderer->Run(m_FinalImage, 0) == RENDER_OK)//Full, non-incremental render for debugging.
 		if (m_Renderer->Run(m_FinalImage[m_FinalImageIndex], 0, m_SubBatchCount, iterBegin) == RENDER_OK)//Force output on iterBegin.
 		{
-			//The amount to increment sub batch while rendering proceeds is purely empirical.
-			//Change later if better values can be derived/observed.
-			if (m_Renderer->RendererType() == OPENCL_RENDERER)
-			{
-				if (m_SubBatchCount < 3)//More than 3 with OpenCL gives a sluggish UI.
-					m_SubBatchCount++;
-			}
-			else
-			{
-				if (m_SubBatchCount < 5)
-					m_SubBatchCount++;
-				else if (m_SubBatchCount < 105)//More than 105 with CPU gives a sluggish UI.
-					m_SubBatchCount += 25;
-			}
+			//Size the next slice from how long each stage of this one took.
+			UpdateSubBatchCount(before);
 
 			//Rendering has finished, update final stats.
 			if (ProcessState() == ACCUM_DONE)
@@ -410,33 +522,38 @@ bool FractoriumEmberController<T>::Render()
 					m_Fractorium->m_RenderStatusLabel->setText("Iters: " + iters + ". Scaled quality: " + scaledQuality + ". Bad values: " + badVals + " (" + badPercent + "%). Total time: " + QString::fromStdString(renderTime));
 				}
 				
-				if (m_LastEditWasUndoRedo && (m_UndoIndex == m_UndoList.size() - 1))//Traversing through undo list, reached the end, so put back in regular edit mode.
+				//A reduced resolution preview is not added to the undo list, the full resolution render that follows it will be.
+				if (m_ProgressiveScale == 1)
 				{
-					m_EditState = REGULAR_EDIT;
+					if (m_LastEditWasUndoRedo && (m_UndoIndex == m_UndoList.size() - 1))//Traversing through undo list, reached the end, so put back in regular edit mode.
+					{
+						m_EditState = REGULAR_EDIT;
+					}
+					else if (m_EditState == REGULAR_EDIT)//Regular edit, just add to the end of the undo list.
+					{
+						m_UndoList.push_back(m_Ember);
+						m_UndoIndex = m_UndoList.size() - 1;
+						m_Fractorium->ui.ActionUndo->setEnabled(m_UndoList.size() > 1);
+						m_Fractorium->ui.ActionRedo->setEnabled(false);
+
+						if (m_UndoList.size() >= UNDO_SIZE)
+							m_UndoList.pop_front();
+					}
+					else if (!m_LastEditWasUndoRedo && m_UndoIndex < m_UndoList.size() - 1)//They were anywhere but the end of the undo list, then did a manual edit, so clear the undo list.
+					{
+						Ember<T> ember(m_UndoList[m_UndoIndex]);
+
+						ClearUndo();
+						m_UndoList.push_back(ember);
+						m_UndoList.push_back(m_Ember);
+						m_UndoIndex = m_UndoList.size() - 1;
+						m_Fractorium->ui.ActionUndo->setEnabled(true);
+						m_Fractorium->ui.ActionRedo->setEnabled(false);
+					}
+
+					m_LastEditWasUndoRedo = false;
 				}
-				else if (m_EditState == REGULAR_EDIT)//Regular edit, just add to the end of the undo list.
-				{
-					m_UndoList.push_back(m_Ember);
-					m_UndoIndex = m_UndoList.size() - 1;
-					m_Fractorium->ui.ActionUndo->setEnabled(m_UndoList.size() > 1);
-					m_Fractorium->ui.ActionRedo->setEnabled(false);
 
-					if (m_UndoList.size() >= UNDO_SIZE)
-						m_UndoList.pop_front();
-				}
-				else if (!m_LastEditWasUndoRedo && m_UndoIndex < m_UndoList.size() - 1)//They were anywhere but the end of the undo list, then did a manual edit, so clear the undo list.
-				{
-					Ember<T> ember(m_UndoList[m_UndoIndex]);
-
-					ClearUndo();
-					m_UndoList.push_back(ember);
-					m_UndoList.push_back(m_Ember);
-					m_UndoIndex = m_UndoList.size() - 1;
-					m_Fractorium->ui.ActionUndo->setEnabled(true);
-					m_Fractorium->ui.ActionRedo->setEnabled(false);
-				}
-
-				m_LastEditWasUndoRedo = false;
 				m_Fractorium->UpdateHistogramBounds();//Mostly of engineering interest.
 			}
 			
@@ -447,6 +564,11 @@ bool FractoriumEmberController<T>::Render()
 				if (m_FinalImage[m_FinalImageIndex].size() == m_Renderer->FinalBufferSize())//Make absolutely sure the correct amount of data is passed.
 					gl->update();
 					//gl->repaint();
+
+#ifdef ITER_PROFILE
+				if (ProcessState() == ACCUM_DONE)//Show the iteration profile of the finished render on the info tab.
+					QMetaObject::invokeMethod(m_Fractorium->ui.InfoRenderingTextEdit, "setText", Qt::QueuedConnection, Q_ARG(const QString&, QString::fromStdString(m_Renderer->IterationProfileReport())));
+#endif
 				
 				//m_Fractorium->update();
 				//m_Fractorium->ui.GLParentScrollArea->update();
@@ -521,6 +643,10 @@ bool FractoriumEmberController<T>::CreateRenderer(eRendererType renderType, uint
 		vector<string> errorReport;
 
 		DeleteRenderer();//Delete the renderer and refresh the textures.
+		m_IterMsPerSubBatch = 0;//Costs measured on the old renderer don't apply to the new one, so measure again.
+		m_ItersPerSubBatch = 0;
+		m_FilterMsPerPixel = 0;
+		m_AccumMsPerPixel = 0;
 		//Before starting, must take care of allocations.
 		gl->Allocate(true);//Forcing a realloc of the texture is necessary on AMD, but not on nVidia.
 		m_Renderer = unique_ptr<EmberNs::RendererBase>(::CreateRenderer<T, T>(renderType, platform, device, shared, gl->OutputTexID(), emberReport));
@@ -570,6 +696,7 @@ bool FractoriumEmberController<T>::CreateRenderer(eRendererType renderType, uint
 		m_Renderer->YAxisUp(s->YAxisUp());
 		m_Renderer->ThreadCount(s->ThreadCount());
 		m_Renderer->Transparency(s->Transparency());
+		m_Renderer->PaletteBins(s->CpuPaletteBins());//Ignored by OpenCL.
 		
 		if (m_Renderer->RendererType() == CPU_RENDERER)
 			m_Renderer->InteractiveFilter(s->CpuDEFilter() ? FILTER_DE : FILTER_LOG);
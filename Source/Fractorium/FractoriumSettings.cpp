@@ -50,6 +50,12 @@ void FractoriumSettings::EnsureDefaults()
 	if (OpenCLSubBatch() < 1)
 		OpenCLSubBatch(1);
 
+	if (CpuPaletteBins() > 64)
+		CpuPaletteBins(0);
+
+	if (PreviewScale() < 1 || PreviewScale() > 4)
+		PreviewScale(2);
+
 	//There normally wouldn't be any more than 10 OpenCL platforms and devices
 	//on the system, so if a value greater than that is read, then the settings file
 	//was corrupted.
@@ -135,6 +141,12 @@ void FractoriumSettings::OpenCLDEFilter(bool b)               { setValue(OPENCLD
 uint FractoriumSettings::CpuSubBatch()				  { return value(CPUSUBBATCH).toUInt();		     }
 void FractoriumSettings::CpuSubBatch(uint b)		  { setValue(CPUSUBBATCH, b);					 }
 															  
+uint FractoriumSettings::CpuPaletteBins()			  { return value(CPUPALETTEBINS).toUInt();	     }
+void FractoriumSettings::CpuPaletteBins(uint b)		  { setValue(CPUPALETTEBINS, b);				 }
+															  
+uint FractoriumSettings::PreviewScale()				  { return value(PREVIEWSCALE).toUInt();	     }
+void FractoriumSettings::PreviewScale(uint b)		  { setValue(PREVIEWSCALE, b);					 }
+															  
 uint FractoriumSettings::OpenCLSubBatch()			  { return value(OPENCLSUBBATCH).toUInt();	     }
 void FractoriumSettings::OpenCLSubBatch(uint b)		  { setValue(OPENCLSUBBATCH, b);				 }
 
@@ -18,6 +18,8 @@
 #define CPUDEFILTER			 "render/cpudefilter"
 #define OPENCLDEFILTER       "render/opencldefilter"
 #define CPUSUBBATCH		     "render/cpusubbatch"
+#define CPUPALETTEBINS	     "render/cpupalettebins"
+#define PREVIEWSCALE	     "render/previewscale"
 #define OPENCLSUBBATCH	     "render/openclsubbatch"
 
 #define FINALEARLYCLIP       "finalrender/earlyclip"
@@ -106,6 +108,12 @@ public:
 	uint CpuSubBatch();
 	void CpuSubBatch(uint b);
 
+	uint CpuPaletteBins();
+	void CpuPaletteBins(uint b);
+
+	uint PreviewScale();
+	void PreviewScale(uint b);
+
 	uint OpenCLSubBatch();
 	void OpenCLSubBatch(uint b);
 	
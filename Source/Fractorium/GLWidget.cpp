@@ -63,6 +63,9 @@ void GLWidget::InitGL()
 /// For CPU, the output image buffer must be copied to OpenGL every time it's drawn.
 /// For OpenCL, the output image and the texture are the same thing, so no copying is necessary
 /// and all image memory remains on the card.
+/// When a reduced resolution progressive preview is being rendered, the image only occupies
+/// the upper left portion of the texture, so only that portion is copied and it is stretched
+/// to fill the quad.
 /// </summary>
 void GLWidget::DrawQuad()
 {
@@ -76,11 +79,19 @@ void GLWidget::DrawQuad()
 	//Ensure all allocation has taken place first.
 	if (m_OutputTexID != 0 && finalImage && !finalImage->empty())
 	{
+		GLint imageWidth = GLint(renderer->FinalRasW());
+		GLint imageHeight = GLint(renderer->FinalRasH());
+
 		glBindTexture(GL_TEXTURE_2D, m_OutputTexID);//The texture to draw to.
 		
-		//Only draw if the dimensions match exactly.
-		if (m_TexWidth == width() && m_TexHeight == height() && ((m_TexWidth * m_TexHeight * 4) == GLint(finalImage->size())))
+		//Only draw if the texture matches the window, and the image fits within the texture.
+		if (m_TexWidth == width() && m_TexHeight == height() &&
+			imageWidth > 0 && imageHeight > 0 && imageWidth <= m_TexWidth && imageHeight <= m_TexHeight &&
+			((imageWidth * imageHeight * 4) == GLint(finalImage->size())))
 		{
+			GLfloat texRight = GLfloat(imageWidth) / GLfloat(m_TexWidth);
+			GLfloat texBottom = GLfloat(imageHeight) / GLfloat(m_TexHeight);
+
 			glMatrixMode(GL_PROJECTION);
 			glPushMatrix();
 			glLoadIdentity();
@@ -91,14 +102,14 @@ void GLWidget::DrawQuad()
 
 			//Copy data from CPU to OpenGL if using a CPU renderer. This is not needed when using OpenCL.
 			if (renderer->RendererType() == CPU_RENDERER)
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_TexWidth, m_TexHeight, GL_RGBA, GL_UNSIGNED_BYTE, finalImage->data());
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageWidth, imageHeight, GL_RGBA, GL_UNSIGNED_BYTE, finalImage->data());
 
 			glBegin(GL_QUADS);//This will need to be converted to a shader at some point in the future.
 
-			glTexCoord2f(0.0, 0.0); glVertex2f(0.0, 0.0);
-			glTexCoord2f(0.0, 1.0); glVertex2f(0.0, 1.0);
-			glTexCoord2f(1.0, 1.0); glVertex2f(1.0, 1.0);
-			glTexCoord2f(1.0, 0.0); glVertex2f(1.0, 0.0);
+			glTexCoord2f(0.0, 0.0);             glVertex2f(0.0, 0.0);
+			glTexCoord2f(0.0, texBottom);       glVertex2f(0.0, 1.0);
+			glTexCoord2f(texRight, texBottom);  glVertex2f(1.0, 1.0);
+			glTexCoord2f(texRight, 0.0);        glVertex2f(1.0, 0.0);
 			
 			glEnd();
 			glMatrixMode(GL_PROJECTION);
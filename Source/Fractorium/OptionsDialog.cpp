@@ -84,6 +84,8 @@ FractoriumOptionsDialog::FractoriumOptionsDialog(FractoriumSettings* settings, Q
 
 	ui.CpuSubBatchSpin->setValue(m_Settings->CpuSubBatch());
 	ui.OpenCLSubBatchSpin->setValue(m_Settings->OpenCLSubBatch());
+	ui.CpuPaletteBinsSpin->setValue(m_Settings->CpuPaletteBins());
+	ui.PreviewScaleSpin->setValue(m_Settings->PreviewScale());
 
 	m_XmlTemporalSamplesSpin->setValue(m_Settings->XmlTemporalSamples());
 	m_XmlQualitySpin->setValue(m_Settings->XmlQuality());
@@ -120,6 +122,7 @@ void FractoriumOptionsDialog::OnOpenCLCheckBoxStateChanged(int state)
 	ui.PlatformCombo->setEnabled(checked);
 	ui.DeviceCombo->setEnabled(checked);
 	ui.ThreadCountSpin->setEnabled(!checked);
+	ui.CpuPaletteBinsSpin->setEnabled(!checked);
 }
 
 /// <summary>
@@ -160,6 +163,8 @@ void FractoriumOptionsDialog::accept()
 	m_Settings->ThreadCount(ThreadCount());
 	m_Settings->CpuSubBatch(ui.CpuSubBatchSpin->value());
 	m_Settings->OpenCLSubBatch(ui.OpenCLSubBatchSpin->value());
+	m_Settings->CpuPaletteBins(ui.CpuPaletteBinsSpin->value());
+	m_Settings->PreviewScale(ui.PreviewScaleSpin->value());
 	m_Settings->CpuDEFilter(ui.CpuFilteringDERadioButton->isChecked());
 	m_Settings->OpenCLDEFilter(ui.OpenCLFilteringDERadioButton->isChecked());
 
@@ -195,6 +200,8 @@ void FractoriumOptionsDialog::reject()
 	ui.ThreadCountSpin->setValue(m_Settings->ThreadCount());
 	ui.CpuSubBatchSpin->setValue(m_Settings->CpuSubBatch());
 	ui.OpenCLSubBatchSpin->setValue(m_Settings->OpenCLSubBatch());
+	ui.CpuPaletteBinsSpin->setValue(m_Settings->CpuPaletteBins());
+	ui.PreviewScaleSpin->setValue(m_Settings->PreviewScale());
 	ui.CpuFilteringDERadioButton->setChecked(m_Settings->CpuDEFilter());
 	ui.OpenCLFilteringDERadioButton->setChecked(m_Settings->OpenCLDEFilter());
 